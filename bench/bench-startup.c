@@ -0,0 +1,394 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mock-server.h"
+
+// the CLI built alongside the benchmark, see CMakeLists.txt
+#ifndef BENCH_CLI_PATH
+#define BENCH_CLI_PATH "chatgpt_cli"
+#endif
+
+#define BENCH_DEFAULT_RUNS 50
+#define BENCH_DEFAULT_CONFIG_KEYS 5000
+
+// short responses, so starting up is most of what's measured
+#define BENCH_DEFAULT_DELTAS 20
+
+// bytes of each generated config value
+#define BENCH_CONFIG_VALUE_LENGTH 200
+
+// how long a daemon gets to start listening
+#define BENCH_DAEMON_START_TIMEOUT_MS 5000
+
+typedef struct {
+	const char* cli_path;
+	size_t runs;
+	size_t config_keys;
+	bool json;
+} bench_options;
+
+// one way of invoking the CLI, times in milliseconds from starting the process
+typedef struct {
+	const char* name;
+	double* first_byte_ms;
+	double* exit_ms;
+	size_t count; // successful invocations, the only ones timed
+	size_t failed;
+} bench_case;
+
+static void print_help() {
+	printf("Usage: bench_startup [OPTIONS]\n");
+	printf("\n");
+	printf("Times cold invocations of the CLI against a local mock of the Responses API: each one is a new process,\n");
+	printf("timed to its first byte of output and to its exit. Every case has an app folder of its own (as HOME),\n");
+	printf("one without a config file, one with a generated config of many keys and one with a daemon running\n");
+	printf("(--daemon), which the invocations hand their request to instead of connecting themselves.\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("  -b, --cli PATH             The CLI to invoke (default %s)\n", BENCH_CLI_PATH);
+	printf("  -n, --runs N               Invocations per case (default %d)\n", BENCH_DEFAULT_RUNS);
+	printf("  -k, --config-keys N        Keys in the generated config, %d bytes of value each (default %d)\n",
+	       BENCH_CONFIG_VALUE_LENGTH, BENCH_DEFAULT_CONFIG_KEYS);
+	printf("  -j, --json                 Print the results as one JSON object, for comparing runs\n");
+	printf("  -h, --help                 Show this help message and exit\n");
+	printf("\n");
+	printf("Mock server (default %d deltas per response):\n", BENCH_DEFAULT_DELTAS);
+	mock_server_print_options_help();
+}
+
+static double timespec_seconds(const struct timespec* time) {
+	return (double)time->tv_sec + (double)time->tv_nsec / 1e9;
+}
+
+static double bench_ms_since(const struct timespec* start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (timespec_seconds(&now) - timespec_seconds(start)) * 1e3;
+}
+
+static int compare_double(const void* a, const void* b) {
+	const double difference = *(const double*)a - *(const double*)b;
+	return difference < 0 ? -1 : difference > 0;
+}
+
+static double percentile(const double* sorted, const size_t count, const double fraction) {
+	if (count == 0) return 0;
+	size_t index = (size_t)(fraction * (double)count);
+	if (index >= count) index = count - 1;
+	return sorted[index];
+}
+
+// deletes a folder the CLI filled in, and everything in it
+static void bench_remove_tree(const char* path) {
+	DIR* dir = opendir(path);
+	if (dir) {
+		struct dirent* dir_entry;
+		while ((dir_entry = readdir(dir)) != NULL) {
+			if (strcmp(dir_entry->d_name, ".") == 0 || strcmp(dir_entry->d_name, "..") == 0) continue;
+
+			const size_t length = strlen(path) + strlen(dir_entry->d_name) + 2;
+			char* child = malloc(length);
+			snprintf(child, length, "%s/%s", path, dir_entry->d_name);
+			struct stat child_stat;
+			if (lstat(child, &child_stat) == 0 && S_ISDIR(child_stat.st_mode)) bench_remove_tree(child);
+			else unlink(child);
+			free(child);
+		}
+		closedir(dir);
+	}
+	rmdir(path);
+}
+
+// a fresh folder to use as HOME, NULL on failure (caller frees)
+static char* bench_make_home() {
+	char* home = strdup("/tmp/bench_startup.XXXXXX");
+	if (!home || !mkdtemp(home)) {
+		free(home);
+		return NULL;
+	}
+
+	const size_t length = strlen(home) + strlen("/.chatgpt-cli") + 1;
+	char* app_folder = malloc(length);
+	snprintf(app_folder, length, "%s/.chatgpt-cli", home);
+	const bool made = mkdir(app_folder, 0700) == 0;
+	free(app_folder);
+	if (!made) {
+		rmdir(home);
+		free(home);
+		return NULL;
+	}
+	return home;
+}
+
+static bool bench_write_config(const char* home, const size_t keys) {
+	const size_t length = strlen(home) + strlen("/.chatgpt-cli/.config") + 1;
+	char* path = malloc(length);
+	snprintf(path, length, "%s/.chatgpt-cli/.config", home);
+	FILE* file = fopen(path, "w");
+	free(path);
+	if (!file) return false;
+
+	char value[BENCH_CONFIG_VALUE_LENGTH + 1];
+	memset(value, 'v', BENCH_CONFIG_VALUE_LENGTH);
+	value[BENCH_CONFIG_VALUE_LENGTH] = '\0';
+
+	// what the CLI looks up comes last, after everything it has to get past
+	fprintf(file, "# generated by bench_startup\n");
+	for (size_t i = 0; i < keys; i++) fprintf(file, "bench-key-%zu=%s\n", i, value);
+	fprintf(file, "model=mock\n");
+	return fclose(file) == 0;
+}
+
+// the environment every invocation of the CLI gets, in the child after fork
+static void bench_set_environment(const char* home, const char* url) {
+	setenv("HOME", home, 1);
+	setenv("CHATGPT_CLI_API_KEY", "bench", 1);
+	setenv("CHATGPT_CLI_API_URL", url, 1);
+}
+
+// starts the CLI as a daemon with home as HOME and waits until it accepts connections, -1 on failure
+static pid_t bench_start_daemon(const bench_options* options, const char* home, const char* url) {
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	snprintf(address.sun_path, sizeof(address.sun_path), "%s/.chatgpt-cli/daemon.sock", home);
+
+	const pid_t daemon_pid = fork();
+	if (daemon_pid < 0) return -1;
+	if (daemon_pid == 0) {
+		// it announces where it's listening, that's not output of the benchmark
+		const int null_fd = open("/dev/null", O_WRONLY);
+		if (null_fd >= 0) dup2(null_fd, STDERR_FILENO);
+		bench_set_environment(home, url);
+		execl(options->cli_path, options->cli_path, "--daemon", (char*)NULL);
+		_exit(127);
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (bench_ms_since(&start) < BENCH_DAEMON_START_TIMEOUT_MS) {
+		const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0) break;
+		const bool connected = connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+		close(fd);
+		if (connected) return daemon_pid;
+
+		if (waitpid(daemon_pid, NULL, WNOHANG) == daemon_pid) return -1; // it gave up
+		usleep(10000);
+	}
+
+	kill(daemon_pid, SIGTERM);
+	waitpid(daemon_pid, NULL, 0);
+	return -1;
+}
+
+// runs the CLI once with home as HOME, false if it failed or printed nothing
+static bool bench_invoke(const bench_options* options, const char* home, const char* url, double* first_byte_ms,
+                         double* exit_ms) {
+	int output[2];
+	if (pipe(output) != 0) return false;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	const pid_t child = fork();
+	if (child < 0) {
+		close(output[0]);
+		close(output[1]);
+		return false;
+	}
+	if (child == 0) {
+		dup2(output[1], STDOUT_FILENO);
+		close(output[0]);
+		close(output[1]);
+		bench_set_environment(home, url);
+		execl(options->cli_path, options->cli_path, "-m", "mock", "Say something.", (char*)NULL);
+		_exit(127);
+	}
+	close(output[1]);
+
+	*first_byte_ms = -1;
+	size_t total = 0;
+	char buffer[4096];
+	while (true) {
+		const ssize_t result = read(output[0], buffer, sizeof(buffer));
+		if (result < 0 && errno == EINTR) continue;
+		if (result <= 0) break;
+		if (total == 0) *first_byte_ms = bench_ms_since(&start);
+		total += (size_t)result;
+	}
+	close(output[0]);
+
+	int status = 0;
+	while (waitpid(child, &status, 0) < 0 && errno == EINTR) {}
+	*exit_ms = bench_ms_since(&start);
+	return total > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void bench_run_case(const bench_options* options, bench_case* current, const char* home, const char* url) {
+	current->first_byte_ms = malloc(options->runs * sizeof(double));
+	current->exit_ms = malloc(options->runs * sizeof(double));
+	for (size_t i = 0; i < options->runs; i++) {
+		double first_byte_ms, exit_ms;
+		if (!bench_invoke(options, home, url, &first_byte_ms, &exit_ms)) {
+			current->failed++;
+			continue;
+		}
+		current->first_byte_ms[current->count] = first_byte_ms;
+		current->exit_ms[current->count] = exit_ms;
+		current->count++;
+	}
+	qsort(current->first_byte_ms, current->count, sizeof(double), compare_double);
+	qsort(current->exit_ms, current->count, sizeof(double), compare_double);
+}
+
+int main(int argc, char* argv[]) {
+	bench_options options = {
+		.cli_path = BENCH_CLI_PATH,
+		.runs = BENCH_DEFAULT_RUNS,
+		.config_keys = BENCH_DEFAULT_CONFIG_KEYS,
+	};
+	mock_server_options server_options = MOCK_SERVER_OPTIONS_DEFAULT;
+	server_options.deltas = BENCH_DEFAULT_DELTAS;
+
+	const struct option long_options[] = {
+		MOCK_SERVER_LONG_OPTIONS,
+		{"cli", required_argument, 0, 'b'},
+		{"runs", required_argument, 0, 'n'},
+		{"config-keys", required_argument, 0, 'k'},
+		{"json", no_argument, 0, 'j'},
+		{"help", no_argument, 0, 'h'},
+		{0, 0, 0, 0}
+	};
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, MOCK_SERVER_SHORT_OPTIONS "b:n:k:jh", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'b':
+			options.cli_path = optarg;
+			break;
+		case 'n':
+			options.runs = strtoul(optarg, NULL, 10);
+			break;
+		case 'k':
+			options.config_keys = strtoul(optarg, NULL, 10);
+			break;
+		case 'j':
+			options.json = true;
+			break;
+		case 'h':
+			print_help();
+			return EXIT_SUCCESS;
+		default:
+			if (!mock_server_parse_option(&server_options, opt, optarg)) return EXIT_FAILURE;
+		}
+	}
+	if (options.runs == 0) {
+		fprintf(stderr, "Nothing to run\n");
+		return EXIT_FAILURE;
+	}
+	if (access(options.cli_path, X_OK) != 0) {
+		fprintf(stderr, "Can't run %s: %s\n", options.cli_path, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	const int listen_fd = mock_server_listen(&server_options);
+	if (listen_fd < 0) {
+		perror("Could not start the mock server");
+		return EXIT_FAILURE;
+	}
+
+	const pid_t server = fork();
+	if (server < 0) {
+		perror("fork");
+		return EXIT_FAILURE;
+	}
+	if (server == 0) {
+		mock_server_serve(listen_fd, &server_options, NULL);
+		_exit(EXIT_FAILURE);
+	}
+	close(listen_fd);
+
+	char url[64];
+	snprintf(url, sizeof(url), "http://127.0.0.1:%u/v1/responses", server_options.port);
+
+	char config_name[64];
+	snprintf(config_name, sizeof(config_name), "%zu-key config", options.config_keys);
+	bench_case cases[] = {
+		{.name = "no config"},
+		{.name = config_name},
+		{.name = "daemon"},
+	};
+	const size_t case_count = sizeof(cases) / sizeof(cases[0]);
+	const size_t config_case = 1, daemon_case = 2;
+
+	const char* setup_error = NULL;
+	for (size_t i = 0; !setup_error && i < case_count; i++) {
+		char* home = bench_make_home();
+		if (!home || (i == config_case && !bench_write_config(home, options.config_keys))) {
+			setup_error = "Could not set up an app folder in /tmp";
+		}
+
+		pid_t daemon_pid = -1;
+		if (!setup_error && i == daemon_case) {
+			daemon_pid = bench_start_daemon(&options, home, url);
+			if (daemon_pid < 0) setup_error = "Could not start the daemon";
+		}
+
+		if (!setup_error) bench_run_case(&options, &cases[i], home, url);
+		if (daemon_pid > 0) {
+			kill(daemon_pid, SIGTERM);
+			waitpid(daemon_pid, NULL, 0);
+		}
+		if (home) bench_remove_tree(home);
+		free(home);
+	}
+
+	kill(server, SIGTERM);
+	waitpid(server, NULL, 0);
+
+	if (setup_error) {
+		fprintf(stderr, "%s\n", setup_error);
+		return EXIT_FAILURE;
+	}
+
+	size_t failed = 0;
+	if (options.json) printf("{\"runs\":%zu,\"config_keys\":%zu,\"cases\":[", options.runs, options.config_keys);
+	for (size_t i = 0; i < case_count; i++) {
+		const bench_case* current = &cases[i];
+		failed += current->failed;
+		if (options.json) {
+			printf("%s{\"name\":\"%s\",\"failed\":%zu,\"first_byte_p50_ms\":%.3f,\"first_byte_p99_ms\":%.3f,"
+			       "\"exit_p50_ms\":%.3f,\"exit_p99_ms\":%.3f}", i ? "," : "", current->name, current->failed,
+			       percentile(current->first_byte_ms, current->count, 0.5),
+			       percentile(current->first_byte_ms, current->count, 0.99),
+			       percentile(current->exit_ms, current->count, 0.5),
+			       percentile(current->exit_ms, current->count, 0.99));
+		} else {
+			printf("%-18s first byte p50 %.3f ms, p99 %.3f ms; exit p50 %.3f ms, p99 %.3f ms (%zu failed)\n",
+			       current->name, percentile(current->first_byte_ms, current->count, 0.5),
+			       percentile(current->first_byte_ms, current->count, 0.99),
+			       percentile(current->exit_ms, current->count, 0.5),
+			       percentile(current->exit_ms, current->count, 0.99), current->failed);
+		}
+	}
+	if (options.json) printf("]}\n");
+
+	for (size_t i = 0; i < case_count; i++) {
+		free(cases[i].first_byte_ms);
+		free(cases[i].exit_ms);
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,756 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include <curl/curl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
+
+#include "mock-server.h"
+#include "openai-wrapper.h"
+
+#define BENCH_DEFAULT_REQUESTS 20
+
+// dimensions of the mock response when none are given, big enough for the parser to dominate
+#define BENCH_DEFAULT_DELTAS 5000
+
+// events at the start of a replayed stream which are split at every byte offset, each split replays all of them
+#define BENCH_SPLIT_EVENTS 64
+
+// deltas streamed through one parser to check its memory stays flat, and by how much the heap may still grow after
+// the first pass over the stream (which sizes the buffers)
+#define BENCH_FLAT_DELTAS 100000
+#define BENCH_FLAT_HEAP_SLACK (64 * 1024)
+
+// chunks the flat memory check feeds, about what a TLS record delivers
+#define BENCH_FLAT_CHUNK_LENGTH 4096
+
+typedef struct {
+	size_t requests;
+	size_t parallel; // 0 or 1 sends requests one after another through a session, otherwise through a scheduler
+	bool epoll; // the scheduler is driven from an epoll loop here rather than openai_scheduler_run
+	bool replay; // one recorded response through the parser alone, requests is how often
+	bool json;
+} bench_options;
+
+// one request being streamed
+typedef struct {
+	struct timespec sent; // set when it completes for scheduled requests, from their total_us
+	struct timespec first_delta; // tv_sec is -1 until a delta arrives
+	bool failed;
+} bench_request;
+
+typedef struct {
+	bench_request* requests;
+	size_t deltas;
+	size_t delta_bytes;
+} bench_run;
+
+typedef struct {
+	bench_run* run;
+	bench_request* request;
+} bench_callback_data;
+
+static void print_help() {
+	printf("Usage: bench_stream [OPTIONS]\n");
+	printf("\n");
+	printf("Streams responses from a local mock of the Responses API through the CLI's parser, and reports\n");
+	printf("throughput, client CPU per delta, peak RSS and time to first delta.\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("  -n, --requests N           Requests to send (default %d)\n", BENCH_DEFAULT_REQUESTS);
+	printf("  -P, --parallel N           Keep up to N requests in flight through a scheduler, instead of sending\n");
+	printf("                             them one after another through a session\n");
+	printf("  -E, --epoll                Drive the scheduler from an epoll loop of the benchmark's own, the way a\n");
+	printf("                             program embedding libchatgpt would, with every request in flight unless\n");
+	printf("                             --parallel says otherwise (Linux only)\n");
+	printf("  -R, --replay               Record one response from the mock server and replay it through the parser\n");
+	printf("                             alone, without a network: whole --requests times (with and without the fast\n");
+	printf("                             path for deltas, leaving them to json-c), then a byte at a time,\n");
+	printf("                             then split at every byte offset of its first %d events. fails unless\n",
+	       BENCH_SPLIT_EVENTS);
+	printf("                             every way of splitting it gives the same deltas. last, it's streamed through\n");
+	printf("                             one parser until %d deltas have passed, failing if the heap grows\n",
+	       BENCH_FLAT_DELTAS);
+	printf("  -j, --json                 Print the results as one JSON object, for comparing runs\n");
+	printf("  -h, --help                 Show this help message and exit\n");
+	printf("\n");
+	printf("Mock server (default %d deltas per response):\n", BENCH_DEFAULT_DELTAS);
+	mock_server_print_options_help();
+}
+
+static double timespec_seconds(const struct timespec* time) {
+	return (double)time->tv_sec + (double)time->tv_nsec / 1e9;
+}
+
+static double rusage_cpu_seconds(const struct rusage* usage) {
+	return (double)usage->ru_utime.tv_sec + (double)usage->ru_utime.tv_usec / 1e6 +
+		(double)usage->ru_stime.tv_sec + (double)usage->ru_stime.tv_usec / 1e6;
+}
+
+static void bench_delta_callback(const openai_delta_type type, const char* delta, const size_t length,
+                                 void* user_data) {
+	const bench_callback_data* data = user_data;
+	if (type == OPENAI_DELTA_RESPONSE_ID || type == OPENAI_DELTA_FLUSH) return;
+
+	if (data->request->first_delta.tv_sec < 0) clock_gettime(CLOCK_MONOTONIC, &data->request->first_delta);
+	data->run->deltas++;
+	data->run->delta_bytes += length;
+	(void)delta;
+}
+
+static void bench_completion_callback(const openai_completion* completion, void* user_data) {
+	const bench_callback_data* data = user_data;
+
+	// when it was sent isn't known until now, it may have waited for admission (or retried) before
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	const double sent = timespec_seconds(&now) - (double)completion->total_us / 1e6;
+	data->request->sent.tv_sec = (time_t)sent;
+	data->request->sent.tv_nsec = (long)((sent - (double)(time_t)sent) * 1e9);
+	data->request->failed = completion->error != NULL;
+}
+
+static int compare_double(const void* a, const void* b) {
+	const double difference = *(const double*)a - *(const double*)b;
+	return difference < 0 ? -1 : difference > 0;
+}
+
+static double percentile(const double* sorted, const size_t count, const double fraction) {
+	if (count == 0) return 0;
+	size_t index = (size_t)(fraction * (double)count);
+	if (index >= count) index = count - 1;
+	return sorted[index];
+}
+
+#ifdef __linux__
+typedef struct {
+	int epoll_fd;
+	int timer_fd;
+} bench_event_loop;
+
+static void bench_watch_socket(const int fd, const int events, void* user_data) {
+	const bench_event_loop* loop = user_data;
+	if (events & OPENAI_POLL_REMOVE) {
+		epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+		return;
+	}
+
+	struct epoll_event event = {
+		.events = (events & OPENAI_POLL_IN ? EPOLLIN : 0) | (events & OPENAI_POLL_OUT ? EPOLLOUT : 0),
+		.data.fd = fd,
+	};
+	if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &event) != 0 && errno == ENOENT) {
+		epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+	}
+}
+
+static void bench_set_timer(const long timeout_ms, void* user_data) {
+	const bench_event_loop* loop = user_data;
+	struct itimerspec timer = {0}; // all zero disarms it
+	if (timeout_ms > 0) {
+		timer.it_value.tv_sec = timeout_ms / 1000;
+		timer.it_value.tv_nsec = (timeout_ms % 1000) * 1000000;
+	} else if (timeout_ms == 0) {
+		timer.it_value.tv_nsec = 1; // as soon as possible
+	}
+	timerfd_settime(loop->timer_fd, 0, &timer, NULL);
+}
+
+// the event loop, until every request has completed
+static char* bench_run_epoll(openai_scheduler* scheduler, const bench_event_loop* loop) {
+	char* error = NULL;
+	while (!error && openai_scheduler_active(scheduler) > 0) {
+		struct epoll_event events[64];
+		const int count = epoll_wait(loop->epoll_fd, events, 64, 1000);
+		if (count < 0 && errno != EINTR) return strdup(strerror(errno));
+
+		for (int i = 0; !error && i < count; i++) {
+			if (events[i].data.fd == loop->timer_fd) {
+				uint64_t expirations;
+				if (read(loop->timer_fd, &expirations, sizeof(expirations)) < 0) continue;
+				error = openai_scheduler_timeout(scheduler);
+				continue;
+			}
+
+			const uint32_t ready = events[i].events;
+			error = openai_scheduler_socket_action(scheduler, events[i].data.fd,
+			                                       (ready & EPOLLIN ? OPENAI_POLL_IN : 0) |
+			                                       (ready & EPOLLOUT ? OPENAI_POLL_OUT : 0) |
+			                                       (ready & (EPOLLERR | EPOLLHUP) ? OPENAI_POLL_ERROR : 0));
+		}
+	}
+	return error;
+}
+#endif
+
+// ---- replay ----
+
+typedef struct {
+	char* data;
+	size_t length;
+} bench_recording;
+
+static size_t bench_record_callback(const char* data, const size_t size, const size_t count, void* recording_ptr) {
+	bench_recording* recording = recording_ptr;
+	char* new_data = realloc(recording->data, recording->length + size * count);
+	if (!new_data) return 0;
+
+	memcpy(new_data + recording->length, data, size * count);
+	recording->data = new_data;
+	recording->length += size * count;
+	return size * count;
+}
+
+// the event stream of one response, exactly as the server sent it
+static bool bench_record(const char* url, bench_recording* recording) {
+	CURL* curl = curl_easy_init();
+	if (!curl) return false;
+
+	curl_easy_setopt(curl, CURLOPT_URL, url);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "{}");
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, bench_record_callback);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, recording);
+	const CURLcode result = curl_easy_perform(curl);
+	curl_easy_cleanup(curl);
+	return result == CURLE_OK && recording->length > 0;
+}
+
+// what a replay delivered, to check every way of splitting the stream up gives the same deltas
+typedef struct {
+	size_t deltas;
+	size_t delta_bytes;
+	uint64_t hash; // FNV-1a over every delta's type and bytes, in order
+} bench_replay_result;
+
+static void bench_replay_callback(const openai_delta_type type, const char* delta, const size_t length,
+                                  void* user_data) {
+	bench_replay_result* result = user_data;
+	if (type == OPENAI_DELTA_FLUSH) return; // once per chunk, which differs with the splits
+
+	result->deltas++;
+	result->delta_bytes += length;
+	uint64_t hash = (result->hash ^ (uint64_t)type) * 1099511628211ULL;
+	for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)delta[i]) * 1099511628211ULL;
+	result->hash = hash;
+}
+
+// feeds the first first_length bytes of the stream as one chunk, then the rest chunk_length at a time. false if the
+// parser failed
+static bool bench_replay_chunks(openai_request* request, const char* stream, const size_t length,
+                                const size_t first_length, const size_t chunk_length, const bool fast_path,
+                                bench_replay_result* result) {
+	*result = (bench_replay_result){.hash = 14695981039346656037ULL};
+	openai_stream_parser* parser = openai_stream_parser_new(request, bench_replay_callback, result);
+	if (!parser) return false;
+	openai_stream_parser_set_fast_path(parser, fast_path);
+
+	bool fed = first_length == 0 || openai_stream_parser_feed(parser, stream, first_length);
+	for (size_t offset = first_length; fed && offset < length; offset += chunk_length) {
+		fed = openai_stream_parser_feed(parser, stream + offset, length - offset < chunk_length
+			                                                         ? length - offset : chunk_length);
+	}
+
+	char* error = openai_stream_parser_finish(parser);
+	if (error) fprintf(stderr, "Replay failed: %s\n", error);
+	free(error);
+	return fed && !error;
+}
+
+// bytes of heap in use, 0 where that can't be measured
+static size_t bench_heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	const struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+// streams the recording through one parser over and over until BENCH_FLAT_DELTAS deltas have passed, sets how much
+// the heap grew after the first pass. false if the parser failed
+static bool bench_replay_flat(openai_request* request, const bench_recording* recording, bench_replay_result* result,
+                              long long* heap_growth) {
+	*result = (bench_replay_result){.hash = 14695981039346656037ULL};
+	openai_stream_parser* parser = openai_stream_parser_new(request, bench_replay_callback, result);
+	if (!parser) return false;
+
+	size_t first_pass_heap = 0;
+	bool fed = true;
+	for (size_t pass = 0; fed && result->deltas < BENCH_FLAT_DELTAS; pass++) {
+		for (size_t offset = 0; fed && offset < recording->length; offset += BENCH_FLAT_CHUNK_LENGTH) {
+			const size_t left = recording->length - offset;
+			fed = openai_stream_parser_feed(parser, recording->data + offset,
+			                                left < BENCH_FLAT_CHUNK_LENGTH ? left : BENCH_FLAT_CHUNK_LENGTH);
+		}
+		if (pass == 0) first_pass_heap = bench_heap_in_use();
+		if (result->deltas == 0) break; // nothing to count
+	}
+	*heap_growth = (long long)bench_heap_in_use() - (long long)first_pass_heap;
+
+	char* error = openai_stream_parser_finish(parser);
+	if (error) fprintf(stderr, "Replay failed: %s\n", error);
+	free(error);
+	return fed && !error;
+}
+
+static bool bench_replay_matches(const bench_replay_result* result, const bench_replay_result* expected) {
+	return result->deltas == expected->deltas && result->delta_bytes == expected->delta_bytes &&
+		result->hash == expected->hash;
+}
+
+static double bench_seconds_since(const struct timespec* start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return timespec_seconds(&now) - timespec_seconds(start);
+}
+
+// raw events (the lines --raw=stream prints) which came through, and whether one had a line break of its own
+typedef struct {
+	size_t lines;
+	bool broken;
+} bench_raw_lines;
+
+static void bench_raw_lines_callback(const openai_delta_type type, const char* delta, const size_t length,
+                                     void* user_data) {
+	bench_raw_lines* lines = user_data;
+	if (type != OPENAI_DELTA_RAW_EVENT) return;
+
+	lines->lines++;
+	if (memchr(delta, '\n', length)) lines->broken = true;
+}
+
+// deletes a folder the cache filled in, and everything in it
+static void bench_remove_tree(const char* path) {
+	DIR* dir = opendir(path);
+	if (dir) {
+		struct dirent* dir_entry;
+		while ((dir_entry = readdir(dir)) != NULL) {
+			if (strcmp(dir_entry->d_name, ".") == 0 || strcmp(dir_entry->d_name, "..") == 0) continue;
+
+			const size_t length = strlen(path) + strlen(dir_entry->d_name) + 2;
+			char* child = malloc(length);
+			snprintf(child, length, "%s/%s", path, dir_entry->d_name);
+			struct stat child_stat;
+			if (lstat(child, &child_stat) == 0 && S_ISDIR(child_stat.st_mode)) bench_remove_tree(child);
+			else unlink(child);
+			free(child);
+		}
+		closedir(dir);
+	}
+	rmdir(path);
+}
+
+// sends a --raw=stream request with the cache on and then once more from the cache alone, in an app folder of its own
+// (as HOME). false if either request failed
+static bool bench_replay_cached(const openai_request* request, bench_raw_lines* streamed, bench_raw_lines* replayed) {
+	*streamed = *replayed = (bench_raw_lines){0};
+	char home[] = "/tmp/bench_stream.XXXXXX";
+	if (!mkdtemp(home)) return false;
+
+	char* previous_home = getenv("HOME") ? strdup(getenv("HOME")) : NULL;
+	setenv("HOME", home, 1);
+
+	openai_request raw_request = *request;
+	raw_request.raw = OPENAI_RAW_STREAM;
+	raw_request.cache = OPENAI_CACHE_ON;
+	char* error = openai_stream_response(&raw_request, bench_raw_lines_callback, streamed);
+	if (!error) {
+		raw_request.cache = OPENAI_CACHE_ONLY;
+		error = openai_stream_response(&raw_request, bench_raw_lines_callback, replayed);
+	}
+
+	if (previous_home) setenv("HOME", previous_home, 1);
+	else unsetenv("HOME");
+	free(previous_home);
+	bench_remove_tree(home);
+
+	if (error) fprintf(stderr, "Raw stream through the cache: %s\n", error);
+	free(error);
+	return !error;
+}
+
+// the length of the stream's first count events, or all of it if it has fewer
+static size_t bench_events_length(const bench_recording* recording, const size_t count, size_t* events) {
+	*events = 0;
+	for (size_t i = 0; i + 1 < recording->length; i++) {
+		if (recording->data[i] != '\n' || recording->data[i + 1] != '\n') continue;
+		if (++*events == count) return i + 2;
+	}
+	return recording->length;
+}
+
+// the replay cases, false if any of them failed or didn't match. cached_* are the raw stream sent through the cache
+static bool bench_replay(const bench_options* options, openai_request* request, const bench_recording* recording,
+                         const bench_raw_lines* cached_streamed, const bench_raw_lines* cached_replayed) {
+	const char* stream = recording->data;
+	const size_t length = recording->length;
+	size_t events;
+	bench_events_length(recording, SIZE_MAX, &events);
+
+	// whole, as if it all arrived at once
+	bench_replay_result expected;
+	bool ok = true;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (size_t i = 0; ok && i < options->requests; i++) {
+		bench_replay_result result;
+		ok = bench_replay_chunks(request, stream, length, 0, length, true, &result);
+		if (i == 0) expected = result;
+	}
+	const double whole_seconds = bench_seconds_since(&start);
+
+	// the same, with json-c taking every delta out of its event
+	bench_replay_result result;
+	bool json_c_matched = true;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (size_t i = 0; ok && i < options->requests; i++) {
+		ok = bench_replay_chunks(request, stream, length, 0, length, false, &result);
+		json_c_matched = json_c_matched && ok && bench_replay_matches(&result, &expected);
+	}
+	const double json_c_seconds = bench_seconds_since(&start);
+
+	// every byte a chunk of its own, so every offset is a boundary at once
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	ok = ok && bench_replay_chunks(request, stream, length, 0, 1, true, &result);
+	const double byte_seconds = bench_seconds_since(&start);
+	const bool byte_matched = ok && bench_replay_matches(&result, &expected);
+
+	// two chunks, split at each byte offset in turn
+	size_t split_events;
+	const size_t split_length = bench_events_length(recording, BENCH_SPLIT_EVENTS, &split_events);
+	bench_replay_result split_expected;
+	ok = ok && bench_replay_chunks(request, stream, split_length, 0, split_length, true, &split_expected);
+	size_t split_mismatches = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (size_t split = 1; ok && split < split_length; split++) {
+		ok = bench_replay_chunks(request, stream, split_length, split, split_length, true, &result);
+		if (ok && !bench_replay_matches(&result, &split_expected)) split_mismatches++;
+	}
+	const double split_seconds = bench_seconds_since(&start);
+	const size_t splits = split_length > 0 ? split_length - 1 : 0;
+
+	// borrowed deltas and a framer which only keeps the event it's in the middle of: nothing grows with the output
+	long long heap_growth = 0;
+	ok = ok && bench_replay_flat(request, recording, &result, &heap_growth);
+	const bool heap_measured = bench_heap_in_use() > 0;
+	const bool heap_flat = !heap_measured || heap_growth <= BENCH_FLAT_HEAP_SLACK;
+
+	if (!ok) return false;
+
+	// each event a line of its own, the same as when it was streamed
+	const bool cached_matched = cached_streamed->lines > 0 && cached_replayed->lines == cached_streamed->lines &&
+		!cached_streamed->broken && !cached_replayed->broken;
+
+	const double whole_bytes = (double)length * (double)options->requests;
+	const double events_per_second = (double)events * (double)options->requests / whole_seconds;
+	const double json_c_events_per_second = (double)events * (double)options->requests / json_c_seconds;
+	const double split_bytes = (double)split_length * (double)splits;
+	if (options->json) {
+		printf("{\"replays\":%zu,\"events\":%zu,\"deltas\":%zu,\"bytes\":%zu,\"events_per_second\":%.0f,"
+		       "\"bytes_per_second\":%.0f,\"json_c_events_per_second\":%.0f,\"json_c_matched\":%s,"
+		       "\"byte_chunks_bytes_per_second\":%.0f,\"byte_chunks_matched\":%s,"
+		       "\"splits\":%zu,\"split_events\":%zu,\"split_bytes_per_second\":%.0f,\"split_mismatches\":%zu,"
+		       "\"flat_deltas\":%zu,\"heap_growth_bytes\":%lld,\"cached_raw_lines\":%zu,"
+		       "\"cached_raw_replayed_lines\":%zu,\"cached_raw_matched\":%s}\n",
+		       options->requests, events, expected.deltas, length, events_per_second, whole_bytes / whole_seconds,
+		       json_c_events_per_second, json_c_matched ? "true" : "false", (double)length / byte_seconds,
+		       byte_matched ? "true" : "false", splits, split_events, split_bytes / split_seconds, split_mismatches,
+		       result.deltas, heap_measured ? heap_growth : -1, cached_streamed->lines, cached_replayed->lines,
+		       cached_matched ? "true" : "false");
+	} else {
+		printf("Recorded:     %zu events, %zu deltas, %.1f KiB of event stream\n", events, expected.deltas,
+		       (double)length / 1024);
+		printf("Whole:        %.0f events/s, %.1f MiB/s (%zu replays)\n", events_per_second,
+		       whole_bytes / whole_seconds / (1024 * 1024), options->requests);
+		printf("json-c only:  %.0f events/s, the fast path is %.2fx that, %s\n", json_c_events_per_second,
+		       events_per_second / json_c_events_per_second, json_c_matched ? "same deltas" : "DIFFERENT DELTAS");
+		printf("Byte chunks:  %.1f MiB/s, %s\n", (double)length / byte_seconds / (1024 * 1024),
+		       byte_matched ? "same deltas" : "DIFFERENT DELTAS");
+		printf("Every split:  %zu splits of the first %zu events, %.1f MiB/s, %zu with different deltas\n", splits,
+		       split_events, split_bytes / split_seconds / (1024 * 1024), split_mismatches);
+		if (heap_measured) {
+			printf("Flat memory:  %zu deltas through one parser, heap %+.1f KiB after the first pass (%s)\n",
+			       result.deltas, (double)heap_growth / 1024, heap_flat ? "flat" : "GROWING");
+		} else printf("Flat memory:  %zu deltas through one parser, heap not measurable here\n", result.deltas);
+		printf("Cached raw:   %zu lines streamed with --raw=stream, %zu replayed from the cache (%s)\n",
+		       cached_streamed->lines, cached_replayed->lines, cached_matched ? "same lines" : "DIFFERENT LINES");
+	}
+
+	return json_c_matched && byte_matched && split_mismatches == 0 && heap_flat && cached_matched;
+}
+
+// sends every request, false if the client couldn't be set up at all
+static bool bench_send(const bench_options* options, bench_run* run, openai_request* request) {
+	bench_callback_data* callback_data = calloc(options->requests, sizeof(bench_callback_data));
+	for (size_t i = 0; i < options->requests; i++) {
+		callback_data[i] = (bench_callback_data){.run = run, .request = &run->requests[i]};
+	}
+
+	if (options->parallel <= 1) {
+		openai_session* session = openai_session_new(request->api_key);
+		if (!session) {
+			free(callback_data);
+			return false;
+		}
+
+		for (size_t i = 0; i < options->requests; i++) {
+			clock_gettime(CLOCK_MONOTONIC, &run->requests[i].sent);
+			char* error = openai_session_stream_response(session, request, bench_delta_callback, &callback_data[i]);
+			run->requests[i].failed = error != NULL;
+			free(error);
+		}
+
+		openai_session_free(session);
+		free(callback_data);
+		return true;
+	}
+
+	openai_scheduler* scheduler = openai_scheduler_new(request->api_key, options->parallel);
+	if (!scheduler) {
+		free(callback_data);
+		return false;
+	}
+
+#ifdef __linux__
+	bench_event_loop loop = {.epoll_fd = -1, .timer_fd = -1};
+	if (options->epoll) {
+		loop.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		loop.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		struct epoll_event timer_event = {.events = EPOLLIN, .data.fd = loop.timer_fd};
+		if (loop.epoll_fd < 0 || loop.timer_fd < 0 ||
+			epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, loop.timer_fd, &timer_event) != 0) {
+			perror("Could not set up the event loop");
+			openai_scheduler_free(scheduler);
+			free(callback_data);
+			return false;
+		}
+		openai_scheduler_set_event_callbacks(scheduler, bench_watch_socket, bench_set_timer, &loop);
+	}
+#endif
+
+	for (size_t i = 0; i < options->requests; i++) {
+		openai_scheduler_submit(scheduler, request, bench_delta_callback, bench_completion_callback, &callback_data[i]);
+	}
+#ifdef __linux__
+	char* error = options->epoll ? bench_run_epoll(scheduler, &loop) : openai_scheduler_run(scheduler);
+#else
+	char* error = openai_scheduler_run(scheduler);
+#endif
+	if (error) {
+		fprintf(stderr, "Scheduler failed: %s\n", error);
+		free(error);
+	}
+
+	openai_scheduler_free(scheduler);
+#ifdef __linux__
+	if (loop.epoll_fd >= 0) close(loop.epoll_fd);
+	if (loop.timer_fd >= 0) close(loop.timer_fd);
+#endif
+	free(callback_data);
+	return error == NULL;
+}
+
+int main(int argc, char* argv[]) {
+	bench_options options = {.requests = BENCH_DEFAULT_REQUESTS};
+	mock_server_options server_options = MOCK_SERVER_OPTIONS_DEFAULT;
+	server_options.deltas = BENCH_DEFAULT_DELTAS;
+
+	const struct option long_options[] = {
+		MOCK_SERVER_LONG_OPTIONS,
+		{"requests", required_argument, 0, 'n'},
+		{"parallel", required_argument, 0, 'P'},
+		{"epoll", no_argument, 0, 'E'},
+		{"replay", no_argument, 0, 'R'},
+		{"json", no_argument, 0, 'j'},
+		{"help", no_argument, 0, 'h'},
+		{0, 0, 0, 0}
+	};
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, MOCK_SERVER_SHORT_OPTIONS "n:P:ERjh", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'n':
+			options.requests = strtoul(optarg, NULL, 10);
+			break;
+		case 'P':
+			options.parallel = strtoul(optarg, NULL, 10);
+			break;
+		case 'E':
+#ifdef __linux__
+			options.epoll = true;
+			break;
+#else
+			fprintf(stderr, "--epoll is only available on Linux\n");
+			return EXIT_FAILURE;
+#endif
+		case 'R':
+			options.replay = true;
+			break;
+		case 'j':
+			options.json = true;
+			break;
+		case 'h':
+			print_help();
+			return EXIT_SUCCESS;
+		default:
+			if (!mock_server_parse_option(&server_options, opt, optarg)) return EXIT_FAILURE;
+		}
+	}
+	if (options.requests == 0) {
+		fprintf(stderr, "Nothing to send\n");
+		return EXIT_FAILURE;
+	}
+	if (options.epoll && options.parallel <= 1) options.parallel = options.requests; // it's always a scheduler
+
+	const int listen_fd = mock_server_listen(&server_options);
+	if (listen_fd < 0) {
+		perror("Could not start the mock server");
+		return EXIT_FAILURE;
+	}
+
+	// the server runs in its own process, so the CPU time and memory measured below are only the client's
+	mock_server_counters* counters = mmap(NULL, sizeof(mock_server_counters), PROT_READ | PROT_WRITE,
+	                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (counters == MAP_FAILED) {
+		perror("mmap");
+		return EXIT_FAILURE;
+	}
+	memset(counters, 0, sizeof(mock_server_counters));
+
+	const pid_t server = fork();
+	if (server < 0) {
+		perror("fork");
+		return EXIT_FAILURE;
+	}
+	if (server == 0) {
+		mock_server_serve(listen_fd, &server_options, counters);
+		_exit(EXIT_FAILURE);
+	}
+	close(listen_fd);
+
+	char url[64];
+	snprintf(url, sizeof(url), "http://127.0.0.1:%u/v1/responses", server_options.port);
+	openai_set_api_url(url);
+
+	openai_request request = {
+		.input = "Say something long.",
+		.model = "mock",
+		.api_key = "bench",
+		.temperature = OPENAI_REQUEST_TEMPERATURE_NOT_SET,
+		.max_tokens = OPENAI_REQUEST_MAX_TOKENS_NOT_SET,
+		.cache = OPENAI_CACHE_OFF,
+	};
+
+	if (options.replay) {
+		bench_recording recording = {0};
+		const bool recorded = bench_record(url, &recording);
+		bench_raw_lines cached_streamed, cached_replayed;
+		const bool cached = recorded && bench_replay_cached(&request, &cached_streamed, &cached_replayed);
+		kill(server, SIGTERM);
+		waitpid(server, NULL, 0);
+		munmap(counters, sizeof(mock_server_counters));
+		if (!recorded || !cached) {
+			if (!recorded) fprintf(stderr, "Could not record a response from the mock server\n");
+			free(recording.data);
+			return EXIT_FAILURE;
+		}
+
+		const bool matched = bench_replay(&options, &request, &recording, &cached_streamed, &cached_replayed);
+		free(recording.data);
+		return matched ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	bench_run run = {.requests = calloc(options.requests, sizeof(bench_request))};
+	for (size_t i = 0; i < options.requests; i++) run.requests[i].first_delta.tv_sec = -1;
+
+	struct rusage usage_before, usage_after;
+	struct timespec start, end;
+	getrusage(RUSAGE_SELF, &usage_before);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	const bool sent = bench_send(&options, &run, &request);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	getrusage(RUSAGE_SELF, &usage_after);
+
+	kill(server, SIGTERM);
+	waitpid(server, NULL, 0);
+
+	if (!sent) {
+		fprintf(stderr, "Could not initialize CURL\n");
+		return EXIT_FAILURE;
+	}
+
+	const double seconds = timespec_seconds(&end) - timespec_seconds(&start);
+	const double cpu_seconds = rusage_cpu_seconds(&usage_after) - rusage_cpu_seconds(&usage_before);
+
+	size_t failed = 0;
+	size_t first_delta_count = 0;
+	double* first_delta_ms = malloc(options.requests * sizeof(double));
+	for (size_t i = 0; i < options.requests; i++) {
+		const bench_request* current = &run.requests[i];
+		if (current->failed) failed++;
+		if (current->first_delta.tv_sec < 0) continue;
+		first_delta_ms[first_delta_count++] =
+			(timespec_seconds(&current->first_delta) - timespec_seconds(&current->sent)) * 1e3;
+	}
+	qsort(first_delta_ms, first_delta_count, sizeof(double), compare_double);
+
+	const uint64_t events = atomic_load(&counters->events);
+	const uint64_t bytes = atomic_load(&counters->bytes);
+	const double events_per_second = (double)events / seconds;
+	const double bytes_per_second = (double)bytes / seconds;
+	const double cpu_us_per_delta = run.deltas ? cpu_seconds * 1e6 / (double)run.deltas : 0;
+	const long peak_rss_kib = usage_after.ru_maxrss; // KiB on Linux, bytes on macOS
+	const uint64_t rate_limited = atomic_load(&counters->rate_limited);
+	const double requests_per_second = (double)options.requests / seconds;
+
+	if (options.json) {
+		printf("{\"requests\":%zu,\"failed\":%zu,\"server_errors\":%llu,\"rate_limited\":%llu,"
+		       "\"requests_per_second\":%.3f,\"deltas\":%zu,\"delta_bytes\":%zu,\"events\":%llu,\"bytes\":%llu,"
+		       "\"seconds\":%.6f,\"events_per_second\":%.0f,"
+		       "\"bytes_per_second\":%.0f,\"cpu_seconds\":%.6f,\"cpu_us_per_delta\":%.4f,"
+		       "\"first_delta_p50_ms\":%.3f,\"first_delta_p99_ms\":%.3f,\"peak_rss_kib\":%ld}\n",
+		       options.requests, failed, (unsigned long long)atomic_load(&counters->errors),
+		       (unsigned long long)rate_limited, requests_per_second, run.deltas, run.delta_bytes,
+		       (unsigned long long)events, (unsigned long long)bytes, seconds, events_per_second,
+		       bytes_per_second, cpu_seconds, cpu_us_per_delta, percentile(first_delta_ms, first_delta_count, 0.5),
+		       percentile(first_delta_ms, first_delta_count, 0.99), peak_rss_kib);
+	} else {
+		printf("Requests:     %zu, %.1f/s (%zu failed, %llu errors injected, %llu over the request limit)\n",
+		       options.requests, requests_per_second, failed, (unsigned long long)atomic_load(&counters->errors),
+		       (unsigned long long)rate_limited);
+		printf("Deltas:       %zu (%.1f KiB of text)\n", run.deltas, (double)run.delta_bytes / 1024);
+		printf("Events/s:     %.0f (%llu events in %.3f s)\n", events_per_second, (unsigned long long)events,
+		       seconds);
+		printf("Throughput:   %.1f MiB/s of event stream\n", bytes_per_second / (1024 * 1024));
+		printf("CPU:          %.3f us per delta (%.3f s user+sys, whole client)\n", cpu_us_per_delta, cpu_seconds);
+		printf("First delta:  p50 %.3f ms, p99 %.3f ms\n", percentile(first_delta_ms, first_delta_count, 0.5),
+		       percentile(first_delta_ms, first_delta_count, 0.99));
+		printf("Peak RSS:     %.1f MiB\n", (double)peak_rss_kib / 1024);
+	}
+
+	free(first_delta_ms);
+	free(run.requests);
+	munmap(counters, sizeof(mock_server_counters));
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
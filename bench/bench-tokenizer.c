@@ -0,0 +1,243 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tokenizer.h"
+
+#define BENCH_DEFAULT_ITERATIONS 5
+
+typedef struct {
+	chatgpt_cli_tokenizer_encoding encoding;
+	const char* source_path;
+	const char* reference_path;
+	size_t iterations;
+	bool json;
+} bench_options;
+
+typedef struct {
+	char* path;
+	char* text;
+	size_t length;
+	size_t count;
+	long expected; // -1 without a reference
+} bench_file;
+
+static void print_help() {
+	printf("Usage: bench_tokenizer [OPTIONS] FILE...\n");
+	printf("\n");
+	printf("Counts the tokens in each file with the CLI's tokenizer, and reports the time to compile and open the\n");
+	printf("encoding and the counting throughput. With a reference, counts are checked against it, e.g. from\n");
+	printf("tiktoken:\n");
+	printf("  python3 -c 'import sys,tiktoken;e=tiktoken.get_encoding(sys.argv[1])\n");
+	printf("    [print(len(e.encode_ordinary(open(f,encoding=\"utf-8\").read())),f) for f in sys.argv[2:]]' \\\n");
+	printf("    o200k_base FILE... > reference.txt\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("  -e, --encoding NAME        o200k_base or cl100k_base (default o200k_base)\n");
+	printf("  -t, --tiktoken PATH        The encoding's .tiktoken file, compiled to a temporary file first\n");
+	printf("                             (default: the one in the app folder, compiled next to it)\n");
+	printf("  -r, --reference PATH       Lines of \"COUNT FILE\", the expected counts\n");
+	printf("  -n, --iterations N         Times to count every file (default %d)\n", BENCH_DEFAULT_ITERATIONS);
+	printf("  -j, --json                 Print the results as one JSON object, for comparing runs\n");
+	printf("  -h, --help                 Show this help message and exit\n");
+}
+
+static double timespec_seconds(const struct timespec* time) {
+	return (double)time->tv_sec + (double)time->tv_nsec / 1e9;
+}
+
+static double bench_seconds_since(const struct timespec* start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return timespec_seconds(&now) - timespec_seconds(start);
+}
+
+static char* bench_read_file(const char* path, size_t* length) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return NULL;
+
+	fseek(file, 0, SEEK_END);
+	const long file_length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char* data = malloc(file_length > 0 ? file_length : 1);
+	*length = fread(data, 1, file_length, file);
+	fclose(file);
+	return data;
+}
+
+// the reference's count for path, or -1
+static long bench_expected_count(const char* reference_path, const char* path) {
+	FILE* file = fopen(reference_path, "r");
+	if (!file) return -1;
+
+	long expected = -1;
+	char line[4096];
+	while (fgets(line, sizeof(line), file)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		char* name;
+		const long count = strtol(line, &name, 10);
+		if (name == line || *name != ' ') continue;
+		if (strcmp(name + 1, path) == 0) {
+			expected = count;
+			break;
+		}
+	}
+	fclose(file);
+	return expected;
+}
+
+int main(int argc, char* argv[]) {
+	bench_options options = {.encoding = CHATGPT_CLI_TOKENIZER_O200K_BASE, .iterations = BENCH_DEFAULT_ITERATIONS};
+
+	const struct option long_options[] = {
+		{"encoding", required_argument, 0, 'e'},
+		{"tiktoken", required_argument, 0, 't'},
+		{"reference", required_argument, 0, 'r'},
+		{"iterations", required_argument, 0, 'n'},
+		{"json", no_argument, 0, 'j'},
+		{"help", no_argument, 0, 'h'},
+		{0, 0, 0, 0}
+	};
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, "e:t:r:n:jh", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'e':
+			if (strcmp(optarg, "cl100k_base") == 0) options.encoding = CHATGPT_CLI_TOKENIZER_CL100K_BASE;
+			else if (strcmp(optarg, "o200k_base") == 0) options.encoding = CHATGPT_CLI_TOKENIZER_O200K_BASE;
+			else {
+				fprintf(stderr, "Unknown encoding: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 't':
+			options.source_path = optarg;
+			break;
+		case 'r':
+			options.reference_path = optarg;
+			break;
+		case 'n':
+			options.iterations = strtoul(optarg, NULL, 10);
+			break;
+		case 'j':
+			options.json = true;
+			break;
+		case 'h':
+			print_help();
+			return EXIT_SUCCESS;
+		default:
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind >= argc || options.iterations == 0) {
+		fprintf(stderr, "Nothing to count\n");
+		return EXIT_FAILURE;
+	}
+
+	const size_t file_count = argc - optind;
+	bench_file* files = calloc(file_count, sizeof(bench_file));
+	size_t total_length = 0;
+	for (size_t i = 0; i < file_count; i++) {
+		files[i].path = argv[optind + i];
+		files[i].text = bench_read_file(files[i].path, &files[i].length);
+		if (!files[i].text) {
+			perror(files[i].path);
+			return EXIT_FAILURE;
+		}
+		files[i].expected = options.reference_path ? bench_expected_count(options.reference_path, files[i].path) : -1;
+		total_length += files[i].length;
+	}
+
+	// compiled from scratch once, then opened again the way later runs find it
+	char compiled_path[] = "/tmp/bench_tokenizer_XXXXXX";
+	if (options.source_path) {
+		const int fd = mkstemp(compiled_path);
+		if (fd < 0) {
+			perror("Could not create the compiled encoding");
+			return EXIT_FAILURE;
+		}
+		close(fd);
+		unlink(compiled_path);
+	}
+
+	char* error = NULL;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	chatgpt_cli_tokenizer* tokenizer = options.source_path
+		                                   ? chatgpt_cli_tokenizer_open_file(options.encoding, options.source_path,
+		                                                                     compiled_path, &error)
+		                                   : chatgpt_cli_tokenizer_open(options.encoding, &error);
+	const double first_open_seconds = bench_seconds_since(&start);
+	if (!tokenizer) {
+		fprintf(stderr, "%s\n", error);
+		free(error);
+		return EXIT_FAILURE;
+	}
+	chatgpt_cli_tokenizer_close(tokenizer);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	tokenizer = options.source_path
+		            ? chatgpt_cli_tokenizer_open_file(options.encoding, options.source_path, compiled_path, &error)
+		            : chatgpt_cli_tokenizer_open(options.encoding, &error);
+	const double open_seconds = bench_seconds_since(&start);
+	if (!tokenizer) {
+		fprintf(stderr, "%s\n", error);
+		free(error);
+		return EXIT_FAILURE;
+	}
+
+	size_t tokens = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+		for (size_t i = 0; i < file_count; i++) {
+			files[i].count = chatgpt_cli_tokenizer_count(tokenizer, files[i].text, files[i].length);
+			if (iteration == 0) tokens += files[i].count;
+		}
+	}
+	const double count_seconds = bench_seconds_since(&start);
+	chatgpt_cli_tokenizer_close(tokenizer);
+	if (options.source_path) unlink(compiled_path);
+
+	size_t checked = 0;
+	size_t mismatched = 0;
+	for (size_t i = 0; i < file_count; i++) {
+		if (files[i].expected < 0) continue;
+		checked++;
+		if ((long)files[i].count != files[i].expected) {
+			mismatched++;
+			fprintf(stderr, "%s: %zu tokens, expected %ld\n", files[i].path, files[i].count, files[i].expected);
+		}
+	}
+
+	const double mib = (double)total_length * options.iterations / (1024 * 1024);
+	const double mib_per_second = mib / count_seconds;
+	const double tokens_per_second = (double)tokens * options.iterations / count_seconds;
+	if (options.json) {
+		printf("{\"encoding\":\"%s\",\"files\":%zu,\"bytes\":%zu,\"tokens\":%zu,\"first_open_ms\":%.3f,"
+		       "\"open_ms\":%.3f,\"mib_per_second\":%.1f,\"tokens_per_second\":%.0f,\"checked\":%zu,"
+		       "\"mismatched\":%zu}\n",
+		       chatgpt_cli_tokenizer_encoding_name(options.encoding), file_count, total_length, tokens,
+		       first_open_seconds * 1e3, open_seconds * 1e3, mib_per_second, tokens_per_second, checked,
+		       mismatched);
+	} else {
+		printf("Encoding:     %s\n", chatgpt_cli_tokenizer_encoding_name(options.encoding));
+		printf("Counted:      %zu tokens in %zu files, %.1f MiB\n", tokens, file_count,
+		       (double)total_length / (1024 * 1024));
+		printf("Open:         %.3f ms the first time, %.3f ms after\n", first_open_seconds * 1e3, open_seconds * 1e3);
+		printf("Throughput:   %.1f MiB/s, %.1f M tokens/s\n", mib_per_second, tokens_per_second / 1e6);
+		if (options.reference_path) printf("Reference:    %zu of %zu files match\n", checked - mismatched,
+		                                   checked);
+	}
+
+	for (size_t i = 0; i < file_count; i++) free(files[i].text);
+	free(files);
+	return mismatched ? EXIT_FAILURE : EXIT_SUCCESS;
+}
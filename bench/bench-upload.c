@@ -0,0 +1,247 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mock-server.h"
+#include "openai-wrapper.h"
+
+#define BENCH_DEFAULT_REQUESTS 3
+#define BENCH_DEFAULT_ATTACHMENT_MIB 100
+
+// the response hardly matters here, it's the request body being measured
+#define BENCH_DEFAULT_DELTAS 10
+
+typedef struct {
+	size_t requests;
+	size_t attachment_mib;
+	bool json;
+} bench_options;
+
+static void print_help() {
+	printf("Usage: bench_upload [OPTIONS]\n");
+	printf("\n");
+	printf("Sends requests with a large attachment to a local mock of the Responses API, and reports upload\n");
+	printf("throughput, client CPU per MiB of attachment and peak RSS.\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("  -n, --requests N           Requests to send, one after another (default %d)\n", BENCH_DEFAULT_REQUESTS);
+	printf("  -S, --size MIB             Size of the attachment (default %d)\n", BENCH_DEFAULT_ATTACHMENT_MIB);
+	printf("  -j, --json                 Print the results as one JSON object, for comparing runs\n");
+	printf("  -h, --help                 Show this help message and exit\n");
+	printf("\n");
+	printf("Mock server (default %d deltas per response):\n", BENCH_DEFAULT_DELTAS);
+	mock_server_print_options_help();
+}
+
+static double timespec_seconds(const struct timespec* time) {
+	return (double)time->tv_sec + (double)time->tv_nsec / 1e9;
+}
+
+static double rusage_cpu_seconds(const struct rusage* usage) {
+	return (double)usage->ru_utime.tv_sec + (double)usage->ru_utime.tv_usec / 1e6 +
+		(double)usage->ru_stime.tv_sec + (double)usage->ru_stime.tv_usec / 1e6;
+}
+
+static void bench_delta_callback(const openai_delta_type type, const char* delta, const size_t length,
+                                 void* user_data) {
+	(void)type;
+	(void)delta;
+	(void)length;
+	(void)user_data;
+}
+
+// a temporary file of incompressible bytes, like most images and PDFs. false if it couldn't be written
+static bool bench_create_attachment(char* path, const size_t size) {
+	const int fd = mkstemp(path);
+	if (fd < 0) return false;
+
+	static uint64_t chunk[128 * 1024];
+	uint64_t state = 0x2545f4914f6cdd1dull;
+	size_t written = 0;
+	while (written < size) {
+		for (size_t i = 0; i < sizeof(chunk) / sizeof(chunk[0]); i++) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			chunk[i] = state;
+		}
+
+		size_t count = size - written < sizeof(chunk) ? size - written : sizeof(chunk);
+		if (write(fd, chunk, count) != (ssize_t)count) {
+			close(fd);
+			unlink(path);
+			return false;
+		}
+		written += count;
+	}
+
+	close(fd);
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	bench_options options = {.requests = BENCH_DEFAULT_REQUESTS, .attachment_mib = BENCH_DEFAULT_ATTACHMENT_MIB};
+	mock_server_options server_options = MOCK_SERVER_OPTIONS_DEFAULT;
+	server_options.deltas = BENCH_DEFAULT_DELTAS;
+
+	const struct option long_options[] = {
+		MOCK_SERVER_LONG_OPTIONS,
+		{"requests", required_argument, 0, 'n'},
+		{"size", required_argument, 0, 'S'},
+		{"json", no_argument, 0, 'j'},
+		{"help", no_argument, 0, 'h'},
+		{0, 0, 0, 0}
+	};
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, MOCK_SERVER_SHORT_OPTIONS "n:S:jh", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'n':
+			options.requests = strtoul(optarg, NULL, 10);
+			break;
+		case 'S':
+			options.attachment_mib = strtoul(optarg, NULL, 10);
+			break;
+		case 'j':
+			options.json = true;
+			break;
+		case 'h':
+			print_help();
+			return EXIT_SUCCESS;
+		default:
+			if (!mock_server_parse_option(&server_options, opt, optarg)) return EXIT_FAILURE;
+		}
+	}
+	if (options.requests == 0) {
+		fprintf(stderr, "Nothing to send\n");
+		return EXIT_FAILURE;
+	}
+
+	char attachment_path[] = "/tmp/bench_upload_XXXXXX";
+	if (!bench_create_attachment(attachment_path, options.attachment_mib * 1024 * 1024)) {
+		perror("Could not create the attachment");
+		return EXIT_FAILURE;
+	}
+
+	const int listen_fd = mock_server_listen(&server_options);
+	if (listen_fd < 0) {
+		perror("Could not start the mock server");
+		unlink(attachment_path);
+		return EXIT_FAILURE;
+	}
+
+	// the server runs in its own process, so the CPU time and memory measured below are only the client's
+	mock_server_counters* counters = mmap(NULL, sizeof(mock_server_counters), PROT_READ | PROT_WRITE,
+	                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (counters == MAP_FAILED) {
+		perror("mmap");
+		unlink(attachment_path);
+		return EXIT_FAILURE;
+	}
+	memset(counters, 0, sizeof(mock_server_counters));
+
+	const pid_t server = fork();
+	if (server < 0) {
+		perror("fork");
+		unlink(attachment_path);
+		return EXIT_FAILURE;
+	}
+	if (server == 0) {
+		mock_server_serve(listen_fd, &server_options, counters);
+		_exit(EXIT_FAILURE);
+	}
+	close(listen_fd);
+
+	char url[64];
+	snprintf(url, sizeof(url), "http://127.0.0.1:%u/v1/responses", server_options.port);
+	openai_set_api_url(url);
+
+	openai_request* request = calloc(1, sizeof(openai_request));
+	request->input = strdup("Summarize the attachment.");
+	request->model = strdup("mock");
+	request->api_key = strdup("bench");
+	request->temperature = OPENAI_REQUEST_TEMPERATURE_NOT_SET;
+	request->max_tokens = OPENAI_REQUEST_MAX_TOKENS_NOT_SET;
+
+	char* error = openai_request_attach(request, attachment_path);
+	unlink(attachment_path); // it stays mapped
+	if (error) {
+		fprintf(stderr, "%s\n", error);
+		free(error);
+		kill(server, SIGTERM);
+		waitpid(server, NULL, 0);
+		return EXIT_FAILURE;
+	}
+
+	openai_session* session = openai_session_new(request->api_key);
+	if (!session) {
+		fprintf(stderr, "Could not initialize CURL\n");
+		kill(server, SIGTERM);
+		waitpid(server, NULL, 0);
+		return EXIT_FAILURE;
+	}
+
+	struct rusage usage_before, usage_after;
+	struct timespec start, end;
+	getrusage(RUSAGE_SELF, &usage_before);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	size_t failed = 0;
+	for (size_t i = 0; i < options.requests; i++) {
+		error = openai_session_stream_response(session, request, bench_delta_callback, NULL);
+		if (error) {
+			fprintf(stderr, "Request failed: %s\n", error);
+			failed++;
+		}
+		free(error);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	getrusage(RUSAGE_SELF, &usage_after);
+
+	openai_session_free(session);
+	openai_request_free(request);
+	kill(server, SIGTERM);
+	waitpid(server, NULL, 0);
+
+	const double seconds = timespec_seconds(&end) - timespec_seconds(&start);
+	const double cpu_seconds = rusage_cpu_seconds(&usage_after) - rusage_cpu_seconds(&usage_before);
+	const double attachment_mib = (double)(options.attachment_mib * options.requests);
+	const uint64_t request_bytes = atomic_load(&counters->request_bytes);
+	const double request_mib_per_second = (double)request_bytes / (1024 * 1024) / seconds;
+	const double attachment_mib_per_second = attachment_mib / seconds;
+	const double cpu_ms_per_mib = attachment_mib > 0 ? cpu_seconds * 1e3 / attachment_mib : 0;
+	const long peak_rss_kib = usage_after.ru_maxrss; // KiB on Linux, bytes on macOS
+
+	if (options.json) {
+		printf("{\"requests\":%zu,\"failed\":%zu,\"attachment_mib\":%zu,\"request_bytes\":%llu,\"seconds\":%.6f,"
+		       "\"request_mib_per_second\":%.1f,\"attachment_mib_per_second\":%.1f,\"cpu_seconds\":%.6f,"
+		       "\"cpu_ms_per_mib\":%.3f,\"peak_rss_kib\":%ld}\n",
+		       options.requests, failed, options.attachment_mib, (unsigned long long)request_bytes, seconds,
+		       request_mib_per_second, attachment_mib_per_second, cpu_seconds, cpu_ms_per_mib, peak_rss_kib);
+	} else {
+		printf("Requests:     %zu (%zu failed), each with a %zu MiB attachment\n", options.requests, failed,
+		       options.attachment_mib);
+		printf("Uploaded:     %.1f MiB of request bodies in %.3f s\n", (double)request_bytes / (1024 * 1024),
+		       seconds);
+		printf("Throughput:   %.1f MiB/s of request body, %.1f MiB/s of attachment\n", request_mib_per_second,
+		       attachment_mib_per_second);
+		printf("CPU:          %.3f ms per MiB of attachment (%.3f s user+sys, whole client)\n", cpu_ms_per_mib,
+		       cpu_seconds);
+		printf("Peak RSS:     %.1f MiB\n", (double)peak_rss_kib / 1024);
+	}
+
+	munmap(counters, sizeof(mock_server_counters));
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
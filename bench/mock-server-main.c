@@ -0,0 +1,59 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mock-server.h"
+
+#define MOCK_SERVER_DEFAULT_PORT 18080
+
+static void print_help() {
+	printf("Usage: mock_server [OPTIONS]\n");
+	printf("\n");
+	printf("Serves streamed responses like the OpenAI Responses API on 127.0.0.1, for the CLI's --api-url.\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("  -l, --port PORT            Port to listen on, 0 picks a free one (default %d)\n",
+	       MOCK_SERVER_DEFAULT_PORT);
+	mock_server_print_options_help();
+	printf("  -h, --help                 Show this help message and exit\n");
+}
+
+int main(int argc, char* argv[]) {
+	mock_server_options options = MOCK_SERVER_OPTIONS_DEFAULT;
+	options.port = MOCK_SERVER_DEFAULT_PORT;
+
+	const struct option long_options[] = {
+		MOCK_SERVER_LONG_OPTIONS,
+		{"port", required_argument, 0, 'l'},
+		{"help", no_argument, 0, 'h'},
+		{0, 0, 0, 0}
+	};
+
+	int opt;
+	while ((opt = getopt_long(argc, argv, MOCK_SERVER_SHORT_OPTIONS "l:h", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'l':
+			options.port = (uint16_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'h':
+			print_help();
+			return EXIT_SUCCESS;
+		default:
+			if (!mock_server_parse_option(&options, opt, optarg)) return EXIT_FAILURE;
+		}
+	}
+
+	const int fd = mock_server_listen(&options);
+	if (fd < 0) {
+		perror("Could not listen");
+		return EXIT_FAILURE;
+	}
+
+	printf("Listening on http://127.0.0.1:%u/v1/responses\n", options.port);
+	fflush(stdout);
+	mock_server_serve(fd, &options, NULL);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,709 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "mock-server.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+// request lines and headers have to fit, bodies are streamed through it
+#define MOCK_SERVER_READ_BUFFER_SIZE (64 * 1024)
+
+// an SSE comment is sent every this many deltas when noise is on
+#define MOCK_SERVER_COMMENT_INTERVAL 64
+
+// told to clients which were rate limited
+#define MOCK_SERVER_RETRY_AFTER_MS 20
+
+// the request limit counts requests in windows this long, the headers say what's left of the current one
+#define MOCK_SERVER_LIMIT_WINDOW_MS 1000
+
+// pieces deltas are made of, already escaped for a JSON string
+static const char* mock_server_plain_words[] = {
+	"Lorem", " ipsum", " dolor", " sit", " amet,", " consectetur", " adipiscing", " elit.", " Sed", " do",
+	" eiusmod", " tempor", " incididunt", " ut", " labore", " et", " dolore", " magna", " aliqua.", "\\n\\n",
+};
+
+static const char* mock_server_escaped_words[] = {
+	" \\\"quoted\\\"", " w\xc3\xb6rld", "\\n", " \\u00e9t\\u00e9", " back\\\\slash", " \xf0\x9f\x98\x80",
+	"\\t", " \\ud83d\\ude00", " caf\\u00e9", " \\/path",
+};
+
+#define MOCK_SERVER_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+void mock_server_print_options_help() {
+	printf("  -d, --deltas N             Deltas in each response (default 1000)\n");
+	printf("  -s, --delta-size BYTES     Bytes of text in each delta (default 4)\n");
+	printf("  -r, --rate N               Deltas per second in each response, 0 for as fast as possible (default 0)\n");
+	printf("  -c, --chunk-size BYTES     Bytes of event stream per write, 0 writes every event on its own (default 0)\n");
+	printf("  -m, --mix LIST             Comma separated kinds of events: text, refusal, reasoning, function,\n");
+	printf("                             escapes, noise (default text)\n");
+	printf("  -e, --error-rate FRACTION  Fraction of requests which fail, taking turns between HTTP 500, HTTP 429,\n");
+	printf("                             an error event and a dropped connection (default 0)\n");
+	printf("  -p, --padding BYTES        Filler bytes in every delta event (default 0)\n");
+	printf("  -q, --request-limit N      Requests allowed per second, with what's left reported in the\n");
+	printf("                             x-ratelimit-*-requests headers and HTTP 429 past it (default 0, no limit)\n");
+}
+
+static bool mock_server_parse_mix(const char* list, unsigned* mix) {
+	static const struct {
+		const char* name;
+		mock_server_event event;
+	} names[] = {
+		{"text", MOCK_SERVER_EVENT_TEXT},
+		{"refusal", MOCK_SERVER_EVENT_REFUSAL},
+		{"reasoning", MOCK_SERVER_EVENT_REASONING},
+		{"function", MOCK_SERVER_EVENT_FUNCTION_CALL},
+		{"escapes", MOCK_SERVER_EVENT_ESCAPES},
+		{"noise", MOCK_SERVER_EVENT_NOISE},
+	};
+
+	*mix = 0;
+	const char* current = list;
+	while (*current) {
+		const size_t length = strcspn(current, ",");
+		bool found = false;
+		for (size_t i = 0; i < MOCK_SERVER_COUNT(names); i++) {
+			if (strlen(names[i].name) == length && strncmp(names[i].name, current, length) == 0) {
+				*mix |= names[i].event;
+				found = true;
+			}
+		}
+		if (!found) {
+			fprintf(stderr, "Unknown kind of event '%.*s'\n", (int)length, current);
+			return false;
+		}
+		current += length + (current[length] == ',');
+	}
+
+	// escapes and noise change what deltas look like, there still have to be some
+	if (!(*mix & MOCK_SERVER_EVENT_DELTAS)) *mix |= MOCK_SERVER_EVENT_TEXT;
+	return true;
+}
+
+bool mock_server_parse_option(mock_server_options* options, const int option, const char* argument) {
+	char* end;
+	switch (option) {
+	case 'd':
+		options->deltas = strtoul(argument, &end, 10);
+		break;
+	case 's':
+		options->delta_size = strtoul(argument, &end, 10);
+		break;
+	case 'r':
+		options->rate = strtod(argument, &end);
+		if (options->rate < 0) end = (char*)argument;
+		break;
+	case 'c':
+		options->chunk_size = strtoul(argument, &end, 10);
+		break;
+	case 'm':
+		return mock_server_parse_mix(argument, &options->event_mix);
+	case 'e':
+		options->error_rate = strtod(argument, &end);
+		if (options->error_rate < 0 || options->error_rate > 1) end = (char*)argument;
+		break;
+	case 'p':
+		options->padding = strtoul(argument, &end, 10);
+		break;
+	case 'q':
+		options->request_limit = strtoul(argument, &end, 10);
+		break;
+	default:
+		return false;
+	}
+
+	if (end == argument || *end) {
+		fprintf(stderr, "Invalid value '%s' for -%c\n", argument, option);
+		return false;
+	}
+	return true;
+}
+
+int mock_server_listen(mock_server_options* options) {
+	const int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+
+	const int one = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	struct sockaddr_in address = {
+		.sin_family = AF_INET,
+		.sin_port = htons(options->port),
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	socklen_t address_length = sizeof(address);
+	if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0 ||
+		getsockname(fd, (struct sockaddr*)&address, &address_length) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	options->port = ntohs(address.sin_port);
+	return fd;
+}
+
+typedef struct {
+	char* data;
+	size_t length;
+	size_t capacity;
+} mock_buffer;
+
+static void mock_buffer_reserve(mock_buffer* buffer, const size_t extra) {
+	if (buffer->length + extra + 1 <= buffer->capacity) return;
+
+	size_t new_capacity = buffer->capacity ? buffer->capacity : 4096;
+	while (new_capacity < buffer->length + extra + 1) new_capacity *= 2;
+
+	buffer->data = realloc(buffer->data, new_capacity);
+	if (!buffer->data) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	buffer->capacity = new_capacity;
+}
+
+static void mock_buffer_append(mock_buffer* buffer, const char* data, const size_t length) {
+	mock_buffer_reserve(buffer, length);
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+	buffer->data[buffer->length] = '\0';
+}
+
+static void mock_buffer_printf(mock_buffer* buffer, const char* format, ...) {
+	va_list arguments;
+	va_start(arguments, format);
+	const int length = vsnprintf(NULL, 0, format, arguments);
+	va_end(arguments);
+
+	mock_buffer_reserve(buffer, (size_t)length);
+	va_start(arguments, format);
+	vsnprintf(buffer->data + buffer->length, (size_t)length + 1, format, arguments);
+	va_end(arguments);
+	buffer->length += (size_t)length;
+}
+
+// buffered reads of one connection
+typedef struct {
+	int fd;
+	char data[MOCK_SERVER_READ_BUFFER_SIZE];
+	size_t start;
+	size_t end;
+} mock_reader;
+
+static bool mock_reader_fill(mock_reader* reader) {
+	if (reader->start == reader->end) {
+		reader->start = reader->end = 0;
+	} else if (reader->end == sizeof(reader->data)) {
+		if (reader->start == 0) return false; // a line longer than the buffer
+		memmove(reader->data, reader->data + reader->start, reader->end - reader->start);
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
+
+	ssize_t result;
+	do {
+		result = read(reader->fd, reader->data + reader->end, sizeof(reader->data) - reader->end);
+	} while (result < 0 && errno == EINTR);
+	if (result <= 0) return false;
+
+	reader->end += (size_t)result;
+	return true;
+}
+
+// next line without its line ending, NULL at the end of the connection. only valid until the next read
+static char* mock_reader_line(mock_reader* reader) {
+	while (true) {
+		char* line = reader->data + reader->start;
+		char* line_end = memchr(line, '\n', reader->end - reader->start);
+		if (line_end) {
+			reader->start = (size_t)(line_end - reader->data) + 1;
+			if (line_end > line && line_end[-1] == '\r') line_end--;
+			*line_end = '\0';
+			return line;
+		}
+		if (!mock_reader_fill(reader)) return NULL;
+	}
+}
+
+static bool mock_reader_skip(mock_reader* reader, size_t length) {
+	while (length) {
+		if (reader->start == reader->end && !mock_reader_fill(reader)) return false;
+
+		size_t available = reader->end - reader->start;
+		if (available > length) available = length;
+		reader->start += available;
+		length -= available;
+	}
+	return true;
+}
+
+typedef struct {
+	const mock_server_options* options;
+	mock_server_counters* counters;
+	int fd;
+	mock_reader reader;
+
+	mock_buffer pending; // event stream which wasn't written yet
+	mock_buffer event; // data of the event being built
+	mock_buffer output_text; // of the whole response, for the events which repeat it
+	size_t sequence_number;
+} mock_connection;
+
+static bool mock_send_all(const int fd, struct iovec* iov, int iov_count) {
+	while (iov_count > 0) {
+		struct msghdr message = {.msg_iov = iov, .msg_iovlen = (size_t)iov_count};
+		const ssize_t result = sendmsg(fd, &message, MSG_NOSIGNAL);
+		if (result < 0 && errno == EINTR) continue;
+		if (result < 0) return false;
+
+		size_t written = (size_t)result;
+		while (iov_count > 0 && written >= iov->iov_len) {
+			written -= iov->iov_len;
+			iov++;
+			iov_count--;
+		}
+		if (iov_count > 0) {
+			iov->iov_base = (char*)iov->iov_base + written;
+			iov->iov_len -= written;
+		}
+	}
+	return true;
+}
+
+static bool mock_send_string(const int fd, const char* string) {
+	struct iovec iov = {.iov_base = (void*)string, .iov_len = strlen(string)};
+	return mock_send_all(fd, &iov, 1);
+}
+
+static bool mock_send_chunk(const int fd, const char* data, const size_t length) {
+	char size_line[32];
+	snprintf(size_line, sizeof(size_line), "%zx\r\n", length);
+
+	struct iovec iov[3] = {
+		{.iov_base = size_line, .iov_len = strlen(size_line)},
+		{.iov_base = (void*)data, .iov_len = length},
+		{.iov_base = "\r\n", .iov_len = 2},
+	};
+	return mock_send_all(fd, iov, 3);
+}
+
+// writes pending event stream in pieces of chunk_size, anything smaller waits for more events unless forced
+static bool mock_flush(mock_connection* connection, const bool force) {
+	const size_t chunk_size = connection->options->chunk_size ? connection->options->chunk_size : SIZE_MAX;
+
+	size_t written = 0;
+	while (connection->pending.length - written >= chunk_size ||
+		(connection->pending.length > written && (force || chunk_size == SIZE_MAX))) {
+		size_t length = connection->pending.length - written;
+		if (length > chunk_size) length = chunk_size;
+
+		if (!mock_send_chunk(connection->fd, connection->pending.data + written, length)) return false;
+		written += length;
+	}
+
+	if (written) {
+		memmove(connection->pending.data, connection->pending.data + written, connection->pending.length - written);
+		connection->pending.length -= written;
+	}
+	return true;
+}
+
+// sends the event built in connection->event
+static bool mock_emit(mock_connection* connection, const char* name) {
+	const size_t start = connection->pending.length;
+	if (name) mock_buffer_printf(&connection->pending, "event: %s\n", name);
+	mock_buffer_append(&connection->pending, "data: ", 6);
+	mock_buffer_append(&connection->pending, connection->event.data, connection->event.length);
+	mock_buffer_append(&connection->pending, "\n\n", 2);
+	connection->event.length = 0;
+
+	if (connection->counters) {
+		atomic_fetch_add(&connection->counters->events, 1);
+		atomic_fetch_add(&connection->counters->bytes, connection->pending.length - start);
+	}
+	return mock_flush(connection, false);
+}
+
+static bool mock_emit_comment(mock_connection* connection) {
+	mock_buffer_append(&connection->pending, ": keep-alive\n\n", 14);
+	if (connection->counters) atomic_fetch_add(&connection->counters->bytes, 14);
+	return mock_flush(connection, false);
+}
+
+static bool mock_send_json_error(const int fd, const int status, const char* reason, const char* extra_headers,
+                                 const char* message) {
+	char body[256];
+	snprintf(body, sizeof(body), "{\"error\":{\"message\":\"%s\",\"type\":\"server_error\",\"code\":null}}", message);
+
+	char response[1024];
+	snprintf(response, sizeof(response),
+	         "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n%s\r\n%s",
+	         status, reason, strlen(body), extra_headers, body);
+	return mock_send_string(fd, response);
+}
+
+// text of the delta at index, whole words until it's at least delta_size bytes
+static void mock_delta_text(const mock_connection* connection, const size_t index, mock_buffer* text) {
+	const bool escapes = connection->options->event_mix & MOCK_SERVER_EVENT_ESCAPES;
+	const char** words = escapes ? mock_server_escaped_words : mock_server_plain_words;
+	const size_t word_count = escapes ? MOCK_SERVER_COUNT(mock_server_escaped_words)
+		                              : MOCK_SERVER_COUNT(mock_server_plain_words);
+
+	const size_t start = text->length;
+	size_t word = index * 7;
+	do {
+		const char* current = words[word++ % word_count];
+		mock_buffer_append(text, current, strlen(current));
+	} while (text->length - start < connection->options->delta_size);
+}
+
+// kind of the delta at index, taking turns between the kinds in the mix
+static mock_server_event mock_delta_kind(const unsigned mix, const size_t index) {
+	size_t kinds = 0;
+	for (unsigned kind = MOCK_SERVER_EVENT_TEXT; kind <= MOCK_SERVER_EVENT_FUNCTION_CALL; kind <<= 1) {
+		if (mix & kind) kinds++;
+	}
+	if (kinds == 0) return MOCK_SERVER_EVENT_TEXT;
+
+	size_t turn = index % kinds;
+	for (unsigned kind = MOCK_SERVER_EVENT_TEXT; kind <= MOCK_SERVER_EVENT_FUNCTION_CALL; kind <<= 1) {
+		if ((mix & kind) && turn-- == 0) return (mock_server_event)kind;
+	}
+	return MOCK_SERVER_EVENT_TEXT;
+}
+
+static const char* mock_delta_event_name(const mock_server_event kind) {
+	switch (kind) {
+	case MOCK_SERVER_EVENT_REFUSAL: return "response.refusal.delta";
+	case MOCK_SERVER_EVENT_REASONING: return "response.reasoning_summary_text.delta";
+	case MOCK_SERVER_EVENT_FUNCTION_CALL: return "response.function_call_arguments.delta";
+	default: return "response.output_text.delta";
+	}
+}
+
+static bool mock_emit_noise(mock_connection* connection, const char* name, const char* fields) {
+	mock_buffer_printf(&connection->event, "{\"type\":\"%s\",\"sequence_number\":%zu,%s}", name,
+	                   connection->sequence_number++, fields);
+	return mock_emit(connection, name);
+}
+
+static void mock_sleep_until(const struct timespec* start, const double seconds) {
+	struct timespec deadline = *start;
+	const long long nanoseconds = (long long)(seconds * 1e9);
+	deadline.tv_sec += nanoseconds / 1000000000;
+	deadline.tv_nsec += nanoseconds % 1000000000;
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+}
+
+typedef enum {
+	MOCK_FAILURE_NONE,
+	MOCK_FAILURE_SERVER_ERROR, // HTTP 500 before anything was streamed
+	MOCK_FAILURE_RATE_LIMITED, // HTTP 429 with retry-after-ms
+	MOCK_FAILURE_ERROR_EVENT, // an error event half way through the stream
+	MOCK_FAILURE_DROPPED, // the connection closes half way through the stream
+} mock_failure;
+
+static atomic_uint_fast64_t mock_server_request_count;
+static atomic_uint_fast64_t mock_server_failure_count;
+
+// the request limit's current window, shared by every connection
+static pthread_mutex_t mock_limit_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct timespec mock_limit_window_start; // tv_sec is 0 before the first request
+static size_t mock_limit_used;
+
+// counts a request against the limit, false if it's over it. remaining and reset_ms are what's left of the window
+static bool mock_limit_admit(const size_t limit, size_t* remaining, long* reset_ms) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	pthread_mutex_lock(&mock_limit_lock);
+	long elapsed_ms = (long)(now.tv_sec - mock_limit_window_start.tv_sec) * 1000 +
+		(now.tv_nsec - mock_limit_window_start.tv_nsec) / 1000000;
+	if (mock_limit_window_start.tv_sec == 0 || elapsed_ms >= MOCK_SERVER_LIMIT_WINDOW_MS) {
+		mock_limit_window_start = now;
+		mock_limit_used = 0;
+		elapsed_ms = 0;
+	}
+
+	const bool admitted = mock_limit_used < limit;
+	if (admitted) mock_limit_used++;
+	*remaining = limit - mock_limit_used;
+	*reset_ms = MOCK_SERVER_LIMIT_WINDOW_MS - elapsed_ms;
+	pthread_mutex_unlock(&mock_limit_lock);
+	return admitted;
+}
+
+// every request whose share of error_rate crosses a whole number fails, so failures are spread out evenly
+static mock_failure mock_next_failure(const double error_rate, uint64_t* request_number) {
+	*request_number = atomic_fetch_add(&mock_server_request_count, 1);
+	if ((uint64_t)((double)(*request_number + 1) * error_rate) == (uint64_t)((double)*request_number * error_rate)) {
+		return MOCK_FAILURE_NONE;
+	}
+	return (mock_failure)(MOCK_FAILURE_SERVER_ERROR + atomic_fetch_add(&mock_server_failure_count, 1) % 4);
+}
+
+// false if the connection has to be closed
+static bool mock_respond(mock_connection* connection) {
+	const mock_server_options* options = connection->options;
+
+	uint64_t request_number;
+	const mock_failure failure = mock_next_failure(options->error_rate, &request_number);
+	if (connection->counters) {
+		atomic_fetch_add(&connection->counters->requests, 1);
+		if (failure != MOCK_FAILURE_NONE) atomic_fetch_add(&connection->counters->errors, 1);
+	}
+
+	if (failure == MOCK_FAILURE_SERVER_ERROR) {
+		return mock_send_json_error(connection->fd, 500, "Internal Server Error", "",
+		                            "The server had an error while processing your request.");
+	}
+	if (failure == MOCK_FAILURE_RATE_LIMITED) {
+		char headers[128];
+		snprintf(headers, sizeof(headers), "retry-after-ms: %d\r\nx-ratelimit-remaining-requests: 0\r\n",
+		         MOCK_SERVER_RETRY_AFTER_MS);
+		return mock_send_json_error(connection->fd, 429, "Too Many Requests", headers,
+		                            "Rate limit reached for requests");
+	}
+
+	// without a limit the quota is practically endless, the way it looks to a client far below its own
+	size_t remaining = 9999;
+	long reset_ms = 6;
+	if (options->request_limit && !mock_limit_admit(options->request_limit, &remaining, &reset_ms)) {
+		if (connection->counters) atomic_fetch_add(&connection->counters->rate_limited, 1);
+
+		char headers[256];
+		snprintf(headers, sizeof(headers), "retry-after-ms: %ld\r\nx-ratelimit-limit-requests: %zu\r\n"
+		         "x-ratelimit-remaining-requests: 0\r\nx-ratelimit-reset-requests: %ldms\r\n", reset_ms,
+		         options->request_limit, reset_ms);
+		return mock_send_json_error(connection->fd, 429, "Too Many Requests", headers,
+		                            "Rate limit reached for requests");
+	}
+
+	char headers[512];
+	snprintf(headers, sizeof(headers),
+	         "HTTP/1.1 200 OK\r\n"
+	         "Content-Type: text/event-stream; charset=utf-8\r\n"
+	         "Transfer-Encoding: chunked\r\n"
+	         "x-ratelimit-remaining-requests: %zu\r\n"
+	         "x-ratelimit-reset-requests: %ldms\r\n"
+	         "x-ratelimit-remaining-tokens: 9999999\r\n"
+	         "x-ratelimit-reset-tokens: 0s\r\n"
+	         "\r\n", remaining, reset_ms);
+	if (!mock_send_string(connection->fd, headers)) return false;
+
+	char id[64];
+	snprintf(id, sizeof(id), "resp_mock%016llx", (unsigned long long)request_number);
+	const bool noise = options->event_mix & MOCK_SERVER_EVENT_NOISE;
+	connection->sequence_number = 0;
+	connection->output_text.length = 0;
+
+	mock_buffer_printf(&connection->event,
+	                   "{\"type\":\"response.created\",\"sequence_number\":%zu,\"response\":{\"id\":\"%s\","
+	                   "\"object\":\"response\",\"created_at\":%lld,\"status\":\"in_progress\",\"model\":\"mock\","
+	                   "\"output\":[]}}", connection->sequence_number++, id, (long long)time(NULL));
+	if (!mock_emit(connection, "response.created")) return false;
+
+	if (noise && (!mock_emit_noise(connection, "response.output_item.added",
+	                               "\"output_index\":0,\"item\":{\"id\":\"msg_mock\",\"type\":\"message\","
+	                               "\"status\":\"in_progress\",\"content\":[],\"role\":\"assistant\"}") ||
+		!mock_emit_noise(connection, "response.content_part.added",
+		                 "\"item_id\":\"msg_mock\",\"output_index\":0,\"content_index\":0,"
+		                 "\"part\":{\"type\":\"output_text\",\"annotations\":[],\"text\":\"\"}"))) {
+		return false;
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	mock_buffer text = {0};
+	for (size_t i = 0; i < options->deltas; i++) {
+		if (options->rate > 0) mock_sleep_until(&start, (double)i / options->rate);
+
+		if (failure != MOCK_FAILURE_NONE && i == options->deltas / 2) {
+			free(text.data);
+			if (failure == MOCK_FAILURE_DROPPED) {
+				mock_flush(connection, true);
+				return false;
+			}
+
+			mock_buffer_printf(&connection->event,
+			                   "{\"type\":\"error\",\"sequence_number\":%zu,\"code\":\"server_error\","
+			                   "\"message\":\"The server had an error while processing your request.\","
+			                   "\"param\":null}", connection->sequence_number++);
+			return mock_emit(connection, "error") && mock_flush(connection, true) &&
+				mock_send_string(connection->fd, "0\r\n\r\n");
+		}
+
+		const mock_server_event kind = mock_delta_kind(options->event_mix, i);
+		text.length = 0;
+		mock_delta_text(connection, i, &text);
+		if (kind == MOCK_SERVER_EVENT_TEXT) mock_buffer_append(&connection->output_text, text.data, text.length);
+
+		const char* name = mock_delta_event_name(kind);
+		mock_buffer_printf(&connection->event,
+		                   "{\"type\":\"%s\",\"sequence_number\":%zu,\"item_id\":\"msg_mock\",\"output_index\":0,"
+		                   "\"content_index\":0,\"delta\":\"%s\",\"logprobs\":[]", name,
+		                   connection->sequence_number++, text.data);
+		if (options->padding) {
+			mock_buffer_append(&connection->event, ",\"obfuscation\":\"", 16);
+			mock_buffer_reserve(&connection->event, options->padding);
+			memset(connection->event.data + connection->event.length, 'x', options->padding);
+			connection->event.length += options->padding;
+			mock_buffer_append(&connection->event, "\"", 1);
+		}
+		mock_buffer_append(&connection->event, "}", 1);
+		if (!mock_emit(connection, name)) {
+			free(text.data);
+			return false;
+		}
+
+		if (noise && (i + 1) % MOCK_SERVER_COMMENT_INTERVAL == 0 && !mock_emit_comment(connection)) {
+			free(text.data);
+			return false;
+		}
+	}
+	free(text.data);
+
+	const char* output = connection->output_text.length ? connection->output_text.data : "";
+	if (noise) {
+		mock_buffer_printf(&connection->event,
+		                   "{\"type\":\"response.output_text.done\",\"sequence_number\":%zu,\"item_id\":\"msg_mock\","
+		                   "\"output_index\":0,\"content_index\":0,\"text\":\"%s\",\"logprobs\":[]}",
+		                   connection->sequence_number++, output);
+		if (!mock_emit(connection, "response.output_text.done")) return false;
+
+		mock_buffer_printf(&connection->event,
+		                   "{\"type\":\"response.output_item.done\",\"sequence_number\":%zu,\"output_index\":0,"
+		                   "\"item\":{\"id\":\"msg_mock\",\"type\":\"message\",\"status\":\"completed\",\"content\":"
+		                   "[{\"type\":\"output_text\",\"annotations\":[],\"text\":\"%s\"}],\"role\":\"assistant\"}}",
+		                   connection->sequence_number++, output);
+		if (!mock_emit(connection, "response.output_item.done")) return false;
+	}
+
+	mock_buffer_printf(&connection->event,
+	                   "{\"type\":\"response.completed\",\"sequence_number\":%zu,\"response\":{\"id\":\"%s\","
+	                   "\"object\":\"response\",\"created_at\":%lld,\"status\":\"completed\",\"model\":\"mock\","
+	                   "\"output\":[{\"id\":\"msg_mock\",\"type\":\"message\",\"status\":\"completed\",\"content\":"
+	                   "[{\"type\":\"output_text\",\"annotations\":[],\"text\":\"%s\"}],\"role\":\"assistant\"}],"
+	                   "\"usage\":{\"input_tokens\":1,\"output_tokens\":%zu,\"total_tokens\":%zu}}}",
+	                   connection->sequence_number++, id, (long long)time(NULL), output, options->deltas,
+	                   options->deltas + 1);
+	return mock_emit(connection, "response.completed") && mock_flush(connection, true) &&
+		mock_send_string(connection->fd, "0\r\n\r\n");
+}
+
+// reads a request up to the end of its body, false at the end of the connection
+static bool mock_read_request(mock_connection* connection, bool* is_post) {
+	const char* request_line = mock_reader_line(&connection->reader);
+	if (!request_line) return false;
+	*is_post = strncmp(request_line, "POST ", 5) == 0;
+
+	size_t content_length = 0;
+	bool chunked = false;
+	bool expect_continue = false;
+
+	const char* header;
+	while ((header = mock_reader_line(&connection->reader)) && *header) {
+		if (strncasecmp(header, "content-length:", 15) == 0) {
+			content_length = strtoul(header + 15, NULL, 10);
+		} else if (strncasecmp(header, "transfer-encoding:", 18) == 0) {
+			chunked = strstr(header + 18, "chunked") != NULL;
+		} else if (strncasecmp(header, "expect:", 7) == 0) {
+			expect_continue = strstr(header + 7, "100") != NULL;
+		}
+	}
+	if (!header) return false;
+
+	if (expect_continue && !mock_send_string(connection->fd, "HTTP/1.1 100 Continue\r\n\r\n")) return false;
+
+	if (!chunked) {
+		if (connection->counters) atomic_fetch_add(&connection->counters->request_bytes, content_length);
+		return mock_reader_skip(&connection->reader, content_length);
+	}
+
+	while (true) {
+		const char* size_line = mock_reader_line(&connection->reader);
+		if (!size_line) return false;
+
+		const size_t size = strtoul(size_line, NULL, 16);
+		if (size == 0) {
+			// trailers, up to an empty line
+			const char* trailer;
+			while ((trailer = mock_reader_line(&connection->reader)) && *trailer) {}
+			return trailer != NULL;
+		}
+		if (connection->counters) atomic_fetch_add(&connection->counters->request_bytes, size);
+		if (!mock_reader_skip(&connection->reader, size) || !mock_reader_line(&connection->reader)) return false;
+	}
+}
+
+static void* mock_serve_connection(void* connection_ptr) {
+	mock_connection* connection = connection_ptr;
+
+	const int one = 1;
+	setsockopt(connection->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	bool is_post;
+	while (mock_read_request(connection, &is_post)) {
+		// HEAD requests are how clients warm their connection up
+		if (!is_post) {
+			if (!mock_send_string(connection->fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n")) break;
+			continue;
+		}
+		if (!mock_respond(connection)) break;
+	}
+
+	close(connection->fd);
+	free(connection->pending.data);
+	free(connection->event.data);
+	free(connection->output_text.data);
+	free(connection);
+	return NULL;
+}
+
+void mock_server_serve(const int listen_fd, const mock_server_options* options, mock_server_counters* counters) {
+	while (true) {
+		const int fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE) continue;
+			perror("accept");
+			return;
+		}
+
+		mock_connection* connection = calloc(1, sizeof(mock_connection));
+		if (!connection) {
+			close(fd);
+			continue;
+		}
+		connection->options = options;
+		connection->counters = counters;
+		connection->fd = fd;
+		connection->reader.fd = fd;
+
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, mock_serve_connection, connection) != 0) {
+			close(fd);
+			free(connection);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+}
@@ -0,0 +1,73 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef CHATGPT_CLI_MOCK_SERVER_H
+#define CHATGPT_CLI_MOCK_SERVER_H
+#include <getopt.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// kinds of events mock responses are made of, combined into a mask
+typedef enum {
+	MOCK_SERVER_EVENT_TEXT = 1 << 0, // response.output_text.delta
+	MOCK_SERVER_EVENT_REFUSAL = 1 << 1, // response.refusal.delta
+	MOCK_SERVER_EVENT_REASONING = 1 << 2, // response.reasoning_summary_text.delta
+	MOCK_SERVER_EVENT_FUNCTION_CALL = 1 << 3, // response.function_call_arguments.delta
+	MOCK_SERVER_EVENT_ESCAPES = 1 << 4, // deltas full of JSON escapes and non-ASCII text, off the parser's fast path
+	MOCK_SERVER_EVENT_NOISE = 1 << 5, // events the client ignores (items/parts added and done) and SSE comments
+} mock_server_event;
+
+#define MOCK_SERVER_EVENT_DELTAS \
+	(MOCK_SERVER_EVENT_TEXT | MOCK_SERVER_EVENT_REFUSAL | MOCK_SERVER_EVENT_REASONING | MOCK_SERVER_EVENT_FUNCTION_CALL)
+
+typedef struct {
+	uint16_t port; // 0 picks a free one
+	size_t deltas; // per response
+	size_t delta_size; // bytes of (escaped) text in each delta, at least
+	double rate; // deltas per second in each response, 0 sends them as fast as possible
+	size_t chunk_size; // bytes of event stream per write, 0 writes every event on its own
+	unsigned event_mix; // of mock_server_event, deltas take turns between the kinds which are set
+	double error_rate; // fraction of requests which fail, taking turns between the ways the API fails
+	size_t padding; // filler bytes in every delta event, like the API's obfuscation field
+	size_t request_limit; // requests allowed per second, more get a 429 like the API's. 0 doesn't limit them
+} mock_server_options;
+
+#define MOCK_SERVER_OPTIONS_DEFAULT {.deltas = 1000, .delta_size = 4, .event_mix = MOCK_SERVER_EVENT_TEXT}
+
+// what the server sent so far, can be shared with the process which forked it
+typedef struct {
+	atomic_uint_fast64_t requests;
+	atomic_uint_fast64_t errors; // requests answered with one of the injected failures
+	atomic_uint_fast64_t rate_limited; // requests answered with a 429 for going over the request limit
+	atomic_uint_fast64_t events;
+	atomic_uint_fast64_t bytes; // of event stream, without the HTTP framing
+	atomic_uint_fast64_t request_bytes; // of request bodies received, without the HTTP framing
+} mock_server_counters;
+
+// options shared by everything which runs the server
+#define MOCK_SERVER_SHORT_OPTIONS "d:s:r:c:m:e:p:q:"
+#define MOCK_SERVER_LONG_OPTIONS \
+	{"deltas", required_argument, 0, 'd'}, \
+	{"delta-size", required_argument, 0, 's'}, \
+	{"rate", required_argument, 0, 'r'}, \
+	{"chunk-size", required_argument, 0, 'c'}, \
+	{"mix", required_argument, 0, 'm'}, \
+	{"error-rate", required_argument, 0, 'e'}, \
+	{"padding", required_argument, 0, 'p'}, \
+	{"request-limit", required_argument, 0, 'q'}
+
+void mock_server_print_options_help();
+
+// applies one of MOCK_SERVER_SHORT_OPTIONS, false if it isn't one or its argument is invalid (after printing why)
+bool mock_server_parse_option(mock_server_options* options, int option, const char* argument);
+
+// listening socket on 127.0.0.1, -1 on failure. options->port is set to the port it's bound to
+int mock_server_listen(mock_server_options* options);
+
+// accepts connections until the process is killed, one thread each. counters may be NULL
+void mock_server_serve(int listen_fd, const mock_server_options* options, mock_server_counters* counters);
+
+#endif //CHATGPT_CLI_MOCK_SERVER_H
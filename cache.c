@@ -0,0 +1,510 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "cache.h"
+
+#include <dirent.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "config.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#include <sys/locking.h>
+#include <sys/utime.h>
+#else
+	#include <sys/file.h>
+	#include <unistd.h>
+	#include <utime.h>
+#endif
+
+// every entry starts with this, followed by the key, the response id and then the records
+#define CACHE_ENTRY_MAGIC "CGC1"
+#define CACHE_ENTRY_MAGIC_LENGTH 4
+
+// a record is 1 byte delta type, 4 byte little-endian length and the delta
+#define CACHE_RECORD_HEADER_LENGTH 5
+
+// eviction goes a bit below the cap, so the next few writes don't have to scan the folder again
+#define CACHE_EVICT_TARGET_PERCENT 90
+
+// temporary files older than this belong to a process which died mid-write
+#define CACHE_STALE_TMP_SECONDS 3600
+
+static void cache_mkdir(const char* path) {
+	#ifdef _WIN32
+	_mkdir(path);
+	#else
+	mkdir(path, 0700);
+	#endif
+}
+
+static void cache_create_folder(const char* folder) {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	cache_mkdir(app_folder);
+	free(app_folder);
+	cache_mkdir(folder);
+}
+
+char* chatgpt_cli_cache_get_folder() {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	const size_t len = strlen(app_folder) + strlen(CHATGPT_CLI_CACHE_FOLDER_NAME) + 2;
+	// 2 for path separator and \0
+
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s", app_folder, PATH_SEPARATOR, CHATGPT_CLI_CACHE_FOLDER_NAME);
+	free(app_folder);
+	return path;
+}
+
+static char* cache_path(const char* folder, const char* name) {
+	const size_t len = strlen(folder) + strlen(name) + 2;
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s", folder, PATH_SEPARATOR, name);
+	return path;
+}
+
+// entries are named after the FNV-1a hash of their key, collisions are caught by comparing the stored key
+static char* cache_entry_path(const char* folder, const char* key, const size_t key_length) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < key_length; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 1099511628211ULL;
+	}
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+	return cache_path(folder, name);
+}
+
+static uint32_t cache_read_u32(const char* bytes) {
+	const unsigned char* b = (const unsigned char*)bytes;
+	return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static void cache_write_u32(char* bytes, const uint32_t value) {
+	bytes[0] = (char)value;
+	bytes[1] = (char)(value >> 8);
+	bytes[2] = (char)(value >> 16);
+	bytes[3] = (char)(value >> 24);
+}
+
+static uint64_t cache_max_size_mib = CHATGPT_CLI_CACHE_DEFAULT_MAX_SIZE_MIB;
+
+void chatgpt_cli_cache_set_max_size(const uint64_t max_size_mib) {
+	cache_max_size_mib = max_size_mib;
+}
+
+static uint64_t cache_max_size() {
+	return cache_max_size_mib * 1024 * 1024;
+}
+
+// ---- stats ----
+
+typedef struct {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t size; // only approximate between evictions, overwritten entries are counted twice
+} cache_stats_record;
+
+// the stats file, locked until cache_stats_close. every open takes a lock of its own, so it keeps other threads out
+// (e.g. the daemon's clients) as well as other processes
+static FILE* cache_stats_open(const char* folder, cache_stats_record* record) {
+	char* path = cache_path(folder, CHATGPT_CLI_CACHE_STATS_FILE_NAME);
+	FILE* file = fopen(path, "r+b");
+	if (!file) {
+		cache_create_folder(folder);
+		file = fopen(path, "w+b");
+	}
+	free(path);
+	if (!file) return NULL;
+
+	#ifdef _WIN32
+	_locking(_fileno(file), _LK_LOCK, sizeof(cache_stats_record));
+	#else
+	flock(fileno(file), LOCK_EX);
+	#endif
+
+	if (fread(record, sizeof(cache_stats_record), 1, file) != 1) {
+		memset(record, 0, sizeof(cache_stats_record));
+	}
+	return file;
+}
+
+static void cache_stats_close(FILE* file, const cache_stats_record* record) {
+	fseek(file, 0, SEEK_SET);
+	fwrite(record, sizeof(cache_stats_record), 1, file);
+	fflush(file);
+
+	#ifdef _WIN32
+	fseek(file, 0, SEEK_SET);
+	_locking(_fileno(file), _LK_UNLCK, sizeof(cache_stats_record));
+	#endif
+	fclose(file); // also drops the flock
+}
+
+static void cache_stats_count(const char* folder, const bool hit) {
+	cache_stats_record record;
+	FILE* file = cache_stats_open(folder, &record);
+	if (!file) return;
+
+	if (hit) record.hits++;
+	else record.misses++;
+
+	cache_stats_close(file, &record);
+}
+
+// ---- eviction ----
+
+typedef struct {
+	char* path;
+	time_t last_used;
+	uint64_t size;
+} cache_file;
+
+static int cache_file_compare_last_used(const void* a, const void* b) {
+	const time_t a_last_used = ((const cache_file*)a)->last_used;
+	const time_t b_last_used = ((const cache_file*)b)->last_used;
+	return (a_last_used > b_last_used) - (a_last_used < b_last_used);
+}
+
+// every entry in the folder (stale temporary files are removed on the way), caller frees
+static cache_file* cache_list(const char* folder, size_t* count_out) {
+	*count_out = 0;
+	DIR* dir = opendir(folder);
+	if (!dir) return NULL;
+
+	cache_file* files = NULL;
+	size_t count = 0;
+	size_t capacity = 0;
+	const time_t now = time(NULL);
+
+	struct dirent* dir_entry;
+	while ((dir_entry = readdir(dir))) {
+		if (dir_entry->d_name[0] == '.') continue; // ., .. and the stats file
+
+		char* path = cache_path(folder, dir_entry->d_name);
+		struct stat file_stat;
+		if (stat(path, &file_stat) != 0) {
+			free(path);
+			continue;
+		}
+
+		if (strstr(dir_entry->d_name, ".tmp")) {
+			if (now - file_stat.st_mtime > CACHE_STALE_TMP_SECONDS) remove(path);
+			free(path);
+			continue;
+		}
+
+		if (count == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			cache_file* new_files = realloc(files, capacity * sizeof(cache_file));
+			if (!new_files) {
+				free(path);
+				break;
+			}
+			files = new_files;
+		}
+		files[count++] = (cache_file){
+			.path = path,
+			.last_used = file_stat.st_mtime, // bumped on every hit
+			.size = (uint64_t)file_stat.st_size,
+		};
+	}
+	closedir(dir);
+
+	*count_out = count;
+	return files;
+}
+
+static void cache_list_free(cache_file* files, const size_t count) {
+	for (size_t i = 0; i < count; i++) free(files[i].path);
+	free(files);
+}
+
+// removes the least recently used entries until the cache is below its target size, returns the size left
+static uint64_t cache_evict(const char* folder, const uint64_t max_size) {
+	size_t count;
+	cache_file* files = cache_list(folder, &count);
+
+	uint64_t size = 0;
+	for (size_t i = 0; i < count; i++) size += files[i].size;
+
+	const uint64_t target_size = max_size / 100 * CACHE_EVICT_TARGET_PERCENT;
+	if (size > target_size) {
+		qsort(files, count, sizeof(cache_file), cache_file_compare_last_used);
+		for (size_t i = 0; i < count && size > target_size; i++) {
+			if (remove(files[i].path) == 0) size -= files[i].size;
+		}
+	}
+
+	cache_list_free(files, count);
+	return size;
+}
+
+// ---- reading ----
+
+struct chatgpt_cli_cache_entry {
+	char* data;
+	size_t length;
+	size_t records_offset;
+	char* response_id;
+};
+
+static bool cache_entry_parse(chatgpt_cli_cache_entry* entry, const char* key, const size_t key_length) {
+	const char* data = entry->data;
+	const size_t length = entry->length;
+
+	if (length < CACHE_ENTRY_MAGIC_LENGTH + 8 || memcmp(data, CACHE_ENTRY_MAGIC, CACHE_ENTRY_MAGIC_LENGTH) != 0) {
+		return false;
+	}
+	size_t offset = CACHE_ENTRY_MAGIC_LENGTH;
+
+	const size_t stored_key_length = cache_read_u32(data + offset);
+	offset += 4;
+	if (stored_key_length != key_length || length - offset < key_length + 4) return false;
+	if (memcmp(data + offset, key, key_length) != 0) return false; // another key with the same hash
+	offset += key_length;
+
+	const size_t response_id_length = cache_read_u32(data + offset);
+	offset += 4;
+	if (length - offset < response_id_length) return false;
+	if (response_id_length > 0) entry->response_id = openai_delta_copy(data + offset, response_id_length);
+	offset += response_id_length;
+
+	entry->records_offset = offset;
+	return true;
+}
+
+chatgpt_cli_cache_entry* chatgpt_cli_cache_get(const char* key, const size_t key_length) {
+	char* folder = chatgpt_cli_cache_get_folder();
+	char* path = cache_entry_path(folder, key, key_length);
+
+	chatgpt_cli_cache_entry* entry = NULL;
+	FILE* file = fopen(path, "rb");
+	if (file) {
+		entry = calloc(1, sizeof(chatgpt_cli_cache_entry));
+
+		fseek(file, 0, SEEK_END);
+		const long file_length = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		entry->length = file_length > 0 ? (size_t)file_length : 0;
+		entry->data = malloc(entry->length + 1);
+		const bool read = entry->data && fread(entry->data, 1, entry->length, file) == entry->length;
+		fclose(file);
+
+		if (!read || !cache_entry_parse(entry, key, key_length)) {
+			chatgpt_cli_cache_entry_free(entry);
+			entry = NULL;
+		} else {
+			// the modification time doubles as the last time it was used
+			#ifdef _WIN32
+			_utime(path, NULL);
+			#else
+			utime(path, NULL);
+			#endif
+		}
+	}
+
+	cache_stats_count(folder, entry != NULL);
+
+	free(path);
+	free(folder);
+	return entry;
+}
+
+const char* chatgpt_cli_cache_entry_get_response_id(const chatgpt_cli_cache_entry* entry) {
+	return entry->response_id;
+}
+
+void chatgpt_cli_cache_entry_replay(const chatgpt_cli_cache_entry* entry, const openai_delta_callback callback,
+                                    void* user_data) {
+	size_t offset = entry->records_offset;
+	while (entry->length - offset >= CACHE_RECORD_HEADER_LENGTH) {
+		const openai_delta_type type = (unsigned char)entry->data[offset];
+		const size_t length = cache_read_u32(entry->data + offset + 1);
+		offset += CACHE_RECORD_HEADER_LENGTH;
+		if (entry->length - offset < length) break; // truncated, can't happen short of disk corruption
+
+		callback(type, entry->data + offset, length, user_data);
+		offset += length;
+	}
+}
+
+void chatgpt_cli_cache_entry_free(chatgpt_cli_cache_entry* entry) {
+	if (!entry) return;
+	free(entry->data);
+	free(entry->response_id);
+	free(entry);
+}
+
+// ---- writing ----
+
+struct chatgpt_cli_cache_writer {
+	char* records;
+	size_t length;
+	size_t capacity;
+
+	bool has_last_record;
+	openai_delta_type last_type;
+	size_t last_record_offset;
+
+	bool failed; // out of memory, nothing gets committed
+};
+
+chatgpt_cli_cache_writer* chatgpt_cli_cache_writer_new() {
+	return calloc(1, sizeof(chatgpt_cli_cache_writer));
+}
+
+static bool cache_writer_reserve(chatgpt_cli_cache_writer* writer, const size_t additional) {
+	if (writer->length + additional <= writer->capacity) return true;
+
+	size_t new_capacity = writer->capacity ? writer->capacity : 4096;
+	while (new_capacity < writer->length + additional) new_capacity *= 2;
+
+	char* new_records = realloc(writer->records, new_capacity);
+	if (!new_records) return false;
+	writer->records = new_records;
+	writer->capacity = new_capacity;
+	return true;
+}
+
+void chatgpt_cli_cache_writer_append(chatgpt_cli_cache_writer* writer, const openai_delta_type type,
+                                     const char* delta, const size_t length) {
+	if (writer->failed) return;
+
+	// text arrives a few characters at a time, one record per run of a type keeps entries (and replays) small.
+	// raw events are whole lines of NDJSON though, they stay one record each or a replay runs them together
+	const bool merge = writer->has_last_record && writer->last_type == type && type != OPENAI_DELTA_RAW_EVENT;
+	if (!cache_writer_reserve(writer, length + (merge ? 0 : CACHE_RECORD_HEADER_LENGTH))) {
+		writer->failed = true;
+		return;
+	}
+
+	if (merge) {
+		char* length_ptr = writer->records + writer->last_record_offset + 1;
+		cache_write_u32(length_ptr, cache_read_u32(length_ptr) + (uint32_t)length);
+	} else {
+		writer->last_record_offset = writer->length;
+		writer->last_type = type;
+		writer->has_last_record = true;
+
+		writer->records[writer->length] = (char)type;
+		cache_write_u32(writer->records + writer->length + 1, (uint32_t)length);
+		writer->length += CACHE_RECORD_HEADER_LENGTH;
+	}
+
+	memcpy(writer->records + writer->length, delta, length);
+	writer->length += length;
+}
+
+static bool cache_write_entry(const char* path, const chatgpt_cli_cache_writer* writer, const char* key,
+                              const size_t key_length, const char* response_id) {
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+
+	const size_t response_id_length = response_id ? strlen(response_id) : 0;
+	char length_bytes[4];
+
+	bool written = fwrite(CACHE_ENTRY_MAGIC, 1, CACHE_ENTRY_MAGIC_LENGTH, file) == CACHE_ENTRY_MAGIC_LENGTH;
+	cache_write_u32(length_bytes, (uint32_t)key_length);
+	written = written && fwrite(length_bytes, 1, 4, file) == 4;
+	written = written && fwrite(key, 1, key_length, file) == key_length;
+	cache_write_u32(length_bytes, (uint32_t)response_id_length);
+	written = written && fwrite(length_bytes, 1, 4, file) == 4;
+	written = written && fwrite(response_id, 1, response_id_length, file) == response_id_length;
+	written = written && fwrite(writer->records, 1, writer->length, file) == writer->length;
+
+	return fclose(file) == 0 && written;
+}
+
+void chatgpt_cli_cache_writer_commit(chatgpt_cli_cache_writer* writer, const char* key, const size_t key_length,
+                                     const char* response_id) {
+	if (writer->failed) {
+		chatgpt_cli_cache_writer_free(writer);
+		return;
+	}
+
+	char* folder = chatgpt_cli_cache_get_folder();
+	cache_create_folder(folder);
+
+	// written next to the entry and renamed over it, so readers never see half an entry.
+	// the name only has to be unique among writers which are alive right now
+	static atomic_uint tmp_counter = 0;
+	char* path = cache_entry_path(folder, key, key_length);
+	const size_t tmp_path_length = strlen(path) + 48;
+	char* tmp_path = malloc(tmp_path_length);
+	#ifdef _WIN32
+	snprintf(tmp_path, tmp_path_length, "%s.%d.%u.tmp", path, _getpid(), atomic_fetch_add(&tmp_counter, 1));
+	#else
+	snprintf(tmp_path, tmp_path_length, "%s.%d.%u.tmp", path, (int)getpid(), atomic_fetch_add(&tmp_counter, 1));
+	#endif
+
+	bool published = cache_write_entry(tmp_path, writer, key, key_length, response_id);
+	// rename doesn't replace existing files on Windows, but an entry which already exists has the same content
+	published = published && rename(tmp_path, path) == 0;
+	if (!published) remove(tmp_path);
+
+	if (published) {
+		cache_stats_record record;
+		FILE* stats_file = cache_stats_open(folder, &record);
+		if (stats_file) {
+			record.size += CACHE_ENTRY_MAGIC_LENGTH + 8 + key_length + (response_id ? strlen(response_id) : 0) +
+				writer->length;
+
+			const uint64_t max_size = cache_max_size();
+			if (record.size > max_size) record.size = cache_evict(folder, max_size);
+
+			cache_stats_close(stats_file, &record);
+		}
+	}
+
+	free(tmp_path);
+	free(path);
+	free(folder);
+	chatgpt_cli_cache_writer_free(writer);
+}
+
+void chatgpt_cli_cache_writer_free(chatgpt_cli_cache_writer* writer) {
+	if (!writer) return;
+	free(writer->records);
+	free(writer);
+}
+
+void chatgpt_cli_cache_get_stats(chatgpt_cli_cache_stats* stats) {
+	memset(stats, 0, sizeof(chatgpt_cli_cache_stats));
+	stats->max_size = cache_max_size();
+
+	char* folder = chatgpt_cli_cache_get_folder();
+
+	cache_stats_record record;
+	FILE* stats_file = cache_stats_open(folder, &record);
+	if (!stats_file) {
+		free(folder);
+		return;
+	}
+
+	size_t count;
+	cache_file* files = cache_list(folder, &count);
+	record.size = 0; // the exact size while we're at it
+	for (size_t i = 0; i < count; i++) record.size += files[i].size;
+	cache_list_free(files, count);
+
+	stats->hits = record.hits;
+	stats->misses = record.misses;
+	stats->entries = count;
+	stats->size = record.size;
+
+	cache_stats_close(stats_file, &record);
+	free(folder);
+}
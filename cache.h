@@ -0,0 +1,66 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef CACHE_H
+#define CACHE_H
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openai-wrapper.h"
+
+// folder (in the app folder) which holds one file per cached response
+#define CHATGPT_CLI_CACHE_FOLDER_NAME "cache"
+
+// hit/miss counters and the approximate size of all entries, shared by every process using the cache
+#define CHATGPT_CLI_CACHE_STATS_FILE_NAME ".stats"
+
+// size cap in MiB when the config doesn't set 'cache-max-size'
+#define CHATGPT_CLI_CACHE_DEFAULT_MAX_SIZE_MIB 64
+
+char* chatgpt_cli_cache_get_folder();
+
+// caps the cache at max_size_mib (the config's 'cache-max-size'), set it before using the cache
+void chatgpt_cli_cache_set_max_size(uint64_t max_size_mib);
+
+// a cached response, read into memory at once
+typedef struct chatgpt_cli_cache_entry chatgpt_cli_cache_entry;
+
+// NULL on a miss. the key is compared in full, so it can be anything that identifies the response
+chatgpt_cli_cache_entry* chatgpt_cli_cache_get(const char* key, size_t key_length);
+
+// owned by the entry, NULL if the response had no id
+const char* chatgpt_cli_cache_entry_get_response_id(const chatgpt_cli_cache_entry* entry);
+
+// sends the deltas through the callback just like the stream did (consecutive deltas of one type arrive merged,
+// apart from raw events which arrive one at a time)
+void chatgpt_cli_cache_entry_replay(const chatgpt_cli_cache_entry* entry, openai_delta_callback callback,
+                                    void* user_data);
+
+void chatgpt_cli_cache_entry_free(chatgpt_cli_cache_entry* entry);
+
+// collects the deltas of a response while it streams, nothing is written until it's committed
+typedef struct chatgpt_cli_cache_writer chatgpt_cli_cache_writer;
+
+chatgpt_cli_cache_writer* chatgpt_cli_cache_writer_new();
+void chatgpt_cli_cache_writer_append(chatgpt_cli_cache_writer* writer, openai_delta_type type, const char* delta,
+                                     size_t length);
+
+// publishes the entry atomically (concurrent readers see either the old entry or the new one) and evicts the least
+// recently used entries if the cache grew past its cap. the writer is freed either way.
+void chatgpt_cli_cache_writer_commit(chatgpt_cli_cache_writer* writer, const char* key, size_t key_length,
+                                     const char* response_id);
+
+void chatgpt_cli_cache_writer_free(chatgpt_cli_cache_writer* writer);
+
+typedef struct {
+	uint64_t hits;
+	uint64_t misses;
+	size_t entries;
+	uint64_t size; // bytes
+	uint64_t max_size; // bytes
+} chatgpt_cli_cache_stats;
+
+void chatgpt_cli_cache_get_stats(chatgpt_cli_cache_stats* stats);
+
+#endif //CACHE_H
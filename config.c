@@ -5,6 +5,7 @@
 #include "config.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -52,119 +53,198 @@ char* chatgpt_cli_config_get_config_path() {
 	return path;
 }
 
-char* chatgpt_cli_config_read_value(const char* key) {
-	char* config_path = chatgpt_cli_config_get_config_path();
-
-	FILE* config_file = fopen(config_path, "rb");
-	free(config_path);
-
-	if (!config_file) {
-		return NULL;
+typedef struct {
+	const char* key;
+	const char* value;
+	size_t key_length;
+	uint32_t hash;
+} chatgpt_cli_config_entry;
+
+struct chatgpt_cli_config {
+	char* content; // keys and values point into here
+
+	chatgpt_cli_config_entry* entries;
+	size_t entry_count;
+
+	// open addressing, entry index + 1 (0 if empty). always a power of two and at most half full
+	size_t* index;
+	size_t index_size;
+};
+
+// FNV-1a
+static uint32_t config_hash(const char* key, const size_t key_length) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < key_length; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 16777619u;
 	}
+	return hash;
+}
 
-	// formatted as KEY=VALUE pairs on lines, with \ to go onto next line
-	// if a line starts with '#' and isn't inside a value, consider it as a comment.
-
-	fseek(config_file, 0, SEEK_END);
-	size_t file_length = ftell(config_file);
-	fseek(config_file, 0, SEEK_SET); // back to start
+static const chatgpt_cli_config_entry* config_find(const chatgpt_cli_config* config, const char* key,
+                                                   const size_t key_length, const uint32_t hash) {
+	if (config->index_size == 0) return NULL;
 
-	char* config_content = malloc(file_length + 1);
-	fread(config_content, sizeof(char), file_length, config_file);
+	size_t slot = hash & (config->index_size - 1);
+	while (config->index[slot] != 0) {
+		const chatgpt_cli_config_entry* entry = &config->entries[config->index[slot] - 1];
+		if (entry->hash == hash && entry->key_length == key_length && memcmp(entry->key, key, key_length) == 0) {
+			return entry;
+		}
+		slot = (slot + 1) & (config->index_size - 1);
+	}
+	return NULL;
+}
 
-	fclose(config_file);
+static void config_build_index(chatgpt_cli_config* config) {
+	size_t index_size = 16;
+	while (index_size < config->entry_count * 2) index_size *= 2;
 
-	if (!config_content) {
-		return NULL;
+	config->index = calloc(index_size, sizeof(size_t));
+	if (!config->index) {
+		fprintf(stderr, "\nMemory allocation failed!\n");
+		exit(EXIT_FAILURE);
 	}
+	config->index_size = index_size;
 
-	config_content[file_length] = '\0'; // fread doesn't automatically null-terminate
+	// the first definition of a key wins, later ones are dropped from the index
+	for (size_t i = 0; i < config->entry_count; i++) {
+		const chatgpt_cli_config_entry* entry = &config->entries[i];
+		if (config_find(config, entry->key, entry->key_length, entry->hash)) continue;
 
-	// reset per-line and depending on if we're reading the key or value.
-	char* current_part = malloc(1);
-	current_part[0] = '\0';
-	size_t current_part_length = 0;
+		size_t slot = entry->hash & (index_size - 1);
+		while (config->index[slot] != 0) slot = (slot + 1) & (index_size - 1);
+		config->index[slot] = i + 1;
+	}
+}
 
-	bool equals_seen = false; // has an = been seen on the current line (are we writing to key or value)
-	bool key_found = false; // if the current value is being assigned to the key which we want to read from
-	bool skip_line = false; // if the line is a comment line
+// formatted as KEY=VALUE pairs on lines, with \ to go onto next line
+// if a line starts with '#' and isn't inside a value, consider it as a comment.
+// keys and values are unescaped and NUL-terminated in place, which never needs more room than the original text.
+static void config_parse(chatgpt_cli_config* config, const size_t content_length) {
+	char* content = config->content;
+	size_t entry_capacity = 0;
+
+	size_t read = 0;
+	size_t write = 0;
+	while (read < content_length) {
+		// start of a line
+		if (content[read] == '#') {
+			while (read < content_length && content[read] != '\n') read++;
+			read++;
+			continue;
+		}
 
-	for (int i = 0; i < file_length; i++) {
-		const char current_char = config_content[i];
-		if (current_char == '\r') continue;
+		const size_t key_start = write;
+		while (read < content_length && content[read] != '=' && content[read] != '\n') {
+			if (content[read] != '\r') content[write++] = content[read];
+			read++;
+		}
 
-		if (current_char == '\n') {
-			if (key_found) break;
+		if (read >= content_length || content[read] == '\n') {
+			// no '=' on this line, ignore it
+			read++;
+			write = key_start;
+			continue;
+		}
 
-			// reset current part
-			free(current_part);
-			current_part = strdup("");
-			current_part_length = 0;
+		const size_t key_length = write - key_start;
+		content[write++] = '\0';
+		read++; // '='
 
-			equals_seen = false;
-			skip_line = false;
+		const size_t value_start = write;
+		while (read < content_length && content[read] != '\n') {
+			const char current_char = content[read];
 
-			if (file_length > i+1 && config_content[i+1] == '#') {
-				skip_line = true;
+			// value is going onto a new line, continue
+			if (current_char == '\\' &&
+				((content_length > read + 1 && content[read + 1] == '\n')
+				|| (content_length > read + 2 && content[read + 1] == '\r' && content[read + 2] == '\n'))) {
+				read += content[read + 1] == '\r' ? 3 : 2;
+				continue;
 			}
 
-			continue;
+			if (current_char != '\r') content[write++] = current_char;
+			read++;
 		}
-
-		if (skip_line) {
-			continue;
+		content[write++] = '\0';
+		read++;
+
+		if (config->entry_count == entry_capacity) {
+			entry_capacity = entry_capacity ? entry_capacity * 2 : 8;
+			chatgpt_cli_config_entry* new_entries = realloc(config->entries,
+			                                                entry_capacity * sizeof(chatgpt_cli_config_entry));
+			if (new_entries == NULL) {
+				fprintf(stderr, "\nMemory allocation failed!\n");
+				exit(EXIT_FAILURE);
+			}
+			config->entries = new_entries;
 		}
 
-		if (current_char == '=' && !equals_seen) {
-			equals_seen = true;
+		chatgpt_cli_config_entry* entry = &config->entries[config->entry_count++];
+		entry->key = content + key_start;
+		entry->key_length = key_length;
+		entry->value = content + value_start;
+		entry->hash = config_hash(entry->key, key_length);
+	}
+}
+
+chatgpt_cli_config* chatgpt_cli_config_load() {
+	chatgpt_cli_config* config = calloc(1, sizeof(chatgpt_cli_config));
+	if (!config) {
+		fprintf(stderr, "\nMemory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
 
-			// check for match
-			if(strcmp(current_part, key) == 0) {
-				key_found = true;
-			}
+	char* config_path = chatgpt_cli_config_get_config_path();
+	FILE* config_file = fopen(config_path, "rb");
+	free(config_path);
 
-			// reset current part
-			free(current_part);
-			current_part = strdup("");
-			current_part_length = 0;
+	if (!config_file) {
+		return config;
+	}
 
-			continue;
-		}
+	fseek(config_file, 0, SEEK_END);
+	const long file_length = ftell(config_file);
+	fseek(config_file, 0, SEEK_SET); // back to start
 
-		// input is going onto a new line, continue
-		if (current_char == '\\' && equals_seen &&
-			((file_length > i+1 && config_content[i+1] == '\n')
-			|| (file_length > i+2 && config_content[i+1] == '\r' && config_content[i+2] == '\n'))) {
-			i++; // skip newline character
-			if (config_content[i] == '\r') i++; // extra skip for windows because \r\n
-			continue;
-		}
+	config->content = file_length > 0 ? malloc(file_length + 1) : NULL;
+	if (!config->content) {
+		fclose(config_file);
+		return config;
+	}
 
+	const size_t read_length = fread(config->content, sizeof(char), file_length, config_file);
+	fclose(config_file);
+	config->content[read_length] = '\0'; // fread doesn't automatically null-terminate
 
-		if (!key_found && equals_seen) {
-			// writing to this value would be pointless
-			continue;
-		}
+	config_parse(config, read_length);
+	config_build_index(config);
 
-		char* new_current_part = realloc(current_part, current_part_length+2);
-		if (new_current_part == NULL) {
-			fprintf(stderr, "\nMemory allocation failed!\n");
-			free(current_part);
-			exit(EXIT_FAILURE);
-		}
-		current_part = new_current_part;
-		current_part[current_part_length] = config_content[i];
-		current_part[current_part_length+1] = '\0';
-		current_part_length++;
+	return config;
+}
 
-	}
+const char* chatgpt_cli_config_get(const chatgpt_cli_config* config, const char* key) {
+	const size_t key_length = strlen(key);
+	const chatgpt_cli_config_entry* entry = config_find(config, key, key_length, config_hash(key, key_length));
+	return entry ? entry->value : NULL;
+}
 
-	free(config_content);
+void chatgpt_cli_config_free(chatgpt_cli_config* config) {
+	if (!config) return;
 
-	if (!key_found) {
-		free(current_part); // contains some un-needed key or value
-		return NULL;
-	}
+	free(config->index);
+	free(config->entries);
+	free(config->content);
+	free(config);
+}
 
-	return current_part;
-}
\ No newline at end of file
+char* chatgpt_cli_config_read_value(const char* key) {
+	chatgpt_cli_config* config = chatgpt_cli_config_load();
+
+	const char* value = chatgpt_cli_config_get(config, key);
+	char* ret_value = value ? strdup(value) : NULL;
+
+	chatgpt_cli_config_free(config);
+	return ret_value;
+}
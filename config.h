@@ -15,7 +15,19 @@ char* chatgpt_cli_config_get_app_folder();
 
 char* chatgpt_cli_config_get_config_path();
 
-// returns the value or NULL if not found or config file doesn't exist
+// every key of the config file, parsed once
+typedef struct chatgpt_cli_config chatgpt_cli_config;
+
+// reads the config file, an empty config is returned if it doesn't exist
+chatgpt_cli_config* chatgpt_cli_config_load();
+
+// returns the value or NULL if not found, owned by the config
+const char* chatgpt_cli_config_get(const chatgpt_cli_config* config, const char* key);
+
+void chatgpt_cli_config_free(chatgpt_cli_config* config);
+
+// returns the value or NULL if not found or config file doesn't exist (caller frees).
+// loads the whole file, use chatgpt_cli_config_load when reading more than one key.
 char* chatgpt_cli_config_read_value(const char* key);
 
 #endif //CONFIG_H
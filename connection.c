@@ -0,0 +1,554 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "connection.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <threads.h>
+#include <time.h>
+
+#include "config.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define strtok_r strtok_s
+#else
+	#include <arpa/inet.h>
+	#include <unistd.h>
+#endif
+
+// CURL only lets TLS sessions out of (and back into) its cache from 8.12 on, older versions just remember addresses
+#if LIBCURL_VERSION_NUM >= 0x080c00
+#define CONNECTION_TLS_EXPORT
+#endif
+
+#define CONNECTION_FILE_MAGIC "chatgpt-cli connections 1"
+
+// the file is rewritten whole, so it's kept small. the API is one host, anything past that is another --api-url
+#define CONNECTION_MAX_HOSTS 8
+#define CONNECTION_MAX_TLS_SESSIONS 8
+
+typedef struct {
+	char host[256];
+	long port;
+	char address[INET6_ADDRSTRLEN];
+	int64_t expires; // unix time, 0 if it's been forgotten (and mustn't come back from the file)
+} connection_host;
+
+typedef struct {
+	char* key; // CURL's peer key, NULL if it only gave a salted hash
+	unsigned char* hmac;
+	size_t hmac_length;
+	unsigned char* data;
+	size_t data_length;
+	int64_t valid_until; // unix time
+} connection_tls_session;
+
+typedef struct {
+	connection_host hosts[CONNECTION_MAX_HOSTS];
+	size_t host_count;
+	connection_tls_session sessions[CONNECTION_MAX_TLS_SESSIONS];
+	size_t session_count;
+} connection_table;
+
+// everything this process knows, loaded from the file on first use. the daemon's clients and a warm-up stream on
+// threads of their own, each through its own session, so the table is only touched with connections_lock held
+static connection_table connections;
+static bool connections_loaded = false;
+static bool connections_enabled = true; // see chatgpt_cli_connection_set_enabled
+static mtx_t connections_lock;
+static once_flag connections_lock_once = ONCE_FLAG_INIT;
+
+static void connection_lock_init() {
+	mtx_init(&connections_lock, mtx_plain);
+}
+
+static void connection_lock() {
+	call_once(&connections_lock_once, connection_lock_init);
+	mtx_lock(&connections_lock);
+}
+
+void chatgpt_cli_connection_set_enabled(const bool enabled) {
+	connection_lock();
+	connections_enabled = enabled;
+	mtx_unlock(&connections_lock);
+}
+
+static char* connection_file_path() {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	const size_t len = strlen(app_folder) + strlen(CHATGPT_CLI_CONNECTION_FILE_NAME) + 2;
+	// 2 for path separator and \0
+
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s", app_folder, PATH_SEPARATOR, CHATGPT_CLI_CONNECTION_FILE_NAME);
+	free(app_folder);
+	return path;
+}
+
+static void connection_tls_session_free(connection_tls_session* session) {
+	free(session->key);
+	free(session->hmac);
+	free(session->data);
+	memset(session, 0, sizeof(connection_tls_session));
+}
+
+static void connection_table_clear(connection_table* table) {
+	for (size_t i = 0; i < table->session_count; i++) connection_tls_session_free(&table->sessions[i]);
+	memset(table, 0, sizeof(connection_table));
+}
+
+// ---- hex, for the binary parts of TLS sessions ----
+
+static char* hex_encode(const unsigned char* bytes, const size_t length) {
+	static const char digits[] = "0123456789abcdef";
+	char* hex = malloc(length * 2 + 2);
+	if (!hex) return NULL;
+
+	// an empty field would be lost between the spaces
+	if (length == 0) return strcpy(hex, "-");
+
+	for (size_t i = 0; i < length; i++) {
+		hex[i * 2] = digits[bytes[i] >> 4];
+		hex[i * 2 + 1] = digits[bytes[i] & 0xf];
+	}
+	hex[length * 2] = '\0';
+	return hex;
+}
+
+static int hex_digit(const char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	return -1;
+}
+
+// NULL (with a length of 0) for "-", false if it isn't hex
+static bool hex_decode(const char* hex, unsigned char** bytes_out, size_t* length_out) {
+	*bytes_out = NULL;
+	*length_out = 0;
+	if (strcmp(hex, "-") == 0) return true;
+
+	const size_t hex_length = strlen(hex);
+	if (hex_length % 2 != 0) return false;
+
+	unsigned char* bytes = malloc(hex_length / 2 + 1);
+	if (!bytes) return false;
+	for (size_t i = 0; i < hex_length / 2; i++) {
+		const int high = hex_digit(hex[i * 2]);
+		const int low = hex_digit(hex[i * 2 + 1]);
+		if (high < 0 || low < 0) {
+			free(bytes);
+			return false;
+		}
+		bytes[i] = (unsigned char)(high << 4 | low);
+	}
+
+	*bytes_out = bytes;
+	*length_out = hex_length / 2;
+	return true;
+}
+
+// ---- the file ----
+
+// one line into *line (grown as needed) including its newline, false at the end of the file. getline, which
+// Windows doesn't have
+static bool connection_read_line(FILE* file, char** line, size_t* capacity) {
+	size_t length = 0;
+	while (true) {
+		if (*capacity - length < 2) {
+			const size_t new_capacity = *capacity ? *capacity * 2 : 256;
+			char* new_line = realloc(*line, new_capacity);
+			if (!new_line) return false;
+			*line = new_line;
+			*capacity = new_capacity;
+		}
+		if (!fgets(*line + length, (int)(*capacity - length), file)) return length > 0;
+
+		length += strlen(*line + length);
+		if ((*line)[length - 1] == '\n') return true;
+	}
+}
+
+// dns HOST PORT ADDRESS EXPIRES
+// tls KEY HMAC DATA VALID_UNTIL, with KEY, HMAC and DATA in hex (- if empty)
+static bool connection_parse_tls(char* line, connection_tls_session* session) {
+	char* save = NULL;
+	const char* key = strtok_r(line, " \n", &save);
+	const char* hmac = strtok_r(NULL, " \n", &save);
+	const char* data = strtok_r(NULL, " \n", &save);
+	const char* valid_until = strtok_r(NULL, " \n", &save);
+	if (!key || !hmac || !data || !valid_until) return false;
+
+	unsigned char* key_bytes;
+	size_t key_length;
+	bool parsed = hex_decode(key, &key_bytes, &key_length);
+	if (parsed && key_bytes) {
+		key_bytes[key_length] = '\0'; // decoded with room to spare
+		session->key = (char*)key_bytes;
+	}
+	parsed = parsed && hex_decode(hmac, &session->hmac, &session->hmac_length);
+	parsed = parsed && hex_decode(data, &session->data, &session->data_length);
+	session->valid_until = strtoll(valid_until, NULL, 10);
+
+	if (!parsed || !session->data) {
+		connection_tls_session_free(session);
+		return false;
+	}
+	return true;
+}
+
+// fills the table with the entries which haven't expired, empty if the file is missing or from another version
+static void connection_file_read(const char* path, connection_table* table, const int64_t now) {
+	FILE* file = fopen(path, "r");
+	if (!file) return;
+
+	char* line = NULL;
+	size_t line_capacity = 0;
+	if (!connection_read_line(file, &line, &line_capacity) || strncmp(line, CONNECTION_FILE_MAGIC "\n",
+	                                                         strlen(CONNECTION_FILE_MAGIC) + 1) != 0) {
+		free(line);
+		fclose(file);
+		return;
+	}
+
+	while (connection_read_line(file, &line, &line_capacity)) {
+		if (strncmp(line, "dns ", 4) == 0 && table->host_count < CONNECTION_MAX_HOSTS) {
+			connection_host* host = &table->hosts[table->host_count];
+			long long expires;
+			if (sscanf(line + 4, "%255s %ld %45s %lld", host->host, &host->port, host->address, &expires) != 4) {
+				continue;
+			}
+			host->expires = expires;
+			if (host->expires > now) table->host_count++;
+		} else if (strncmp(line, "tls ", 4) == 0 && table->session_count < CONNECTION_MAX_TLS_SESSIONS) {
+			connection_tls_session* session = &table->sessions[table->session_count];
+			if (!connection_parse_tls(line + 4, session)) continue;
+			if (session->valid_until > now) table->session_count++;
+			else connection_tls_session_free(session);
+		}
+	}
+
+	free(line);
+	fclose(file);
+}
+
+static bool connection_file_write_table(FILE* file, const connection_table* table, const int64_t now) {
+	bool written = fprintf(file, "%s\n", CONNECTION_FILE_MAGIC) > 0;
+
+	for (size_t i = 0; i < table->host_count; i++) {
+		const connection_host* host = &table->hosts[i];
+		if (host->expires <= now) continue;
+		written = written && fprintf(file, "dns %s %ld %s %lld\n", host->host, host->port, host->address,
+		                             (long long)host->expires) > 0;
+	}
+
+	for (size_t i = 0; i < table->session_count; i++) {
+		const connection_tls_session* session = &table->sessions[i];
+		if (session->valid_until <= now) continue;
+
+		char* key = session->key
+			? hex_encode((const unsigned char*)session->key, strlen(session->key))
+			: hex_encode(NULL, 0);
+		char* hmac = hex_encode(session->hmac, session->hmac_length);
+		char* data = hex_encode(session->data, session->data_length);
+		written = written && key && hmac && data &&
+			fprintf(file, "tls %s %s %s %lld\n", key, hmac, data, (long long)session->valid_until) > 0;
+		free(key);
+		free(hmac);
+		free(data);
+	}
+
+	return written;
+}
+
+static connection_host* connection_find_host(connection_table* table, const char* host, const long port) {
+	for (size_t i = 0; i < table->host_count; i++) {
+		if (table->hosts[i].port == port && strcmp(table->hosts[i].host, host) == 0) return &table->hosts[i];
+	}
+	return NULL;
+}
+
+static bool connection_same_tls_session(const connection_tls_session* a, const connection_tls_session* b) {
+	if (a->key || b->key) return a->key && b->key && strcmp(a->key, b->key) == 0;
+	return a->hmac_length == b->hmac_length && memcmp(a->hmac, b->hmac, a->hmac_length) == 0;
+}
+
+static connection_tls_session* connection_find_tls_session(connection_table* table,
+                                                           const connection_tls_session* session) {
+	for (size_t i = 0; i < table->session_count; i++) {
+		if (connection_same_tls_session(&table->sessions[i], session)) return &table->sessions[i];
+	}
+	return NULL;
+}
+
+// a free slot, or the one closest to expiring when the table is full
+static connection_host* connection_host_slot(connection_table* table) {
+	if (table->host_count < CONNECTION_MAX_HOSTS) return &table->hosts[table->host_count++];
+
+	connection_host* oldest = &table->hosts[0];
+	for (size_t i = 1; i < table->host_count; i++) {
+		if (table->hosts[i].expires < oldest->expires) oldest = &table->hosts[i];
+	}
+	return oldest;
+}
+
+static connection_tls_session* connection_tls_session_slot(connection_table* table) {
+	if (table->session_count < CONNECTION_MAX_TLS_SESSIONS) return &table->sessions[table->session_count++];
+
+	connection_tls_session* oldest = &table->sessions[0];
+	for (size_t i = 1; i < table->session_count; i++) {
+		if (table->sessions[i].valid_until < oldest->valid_until) oldest = &table->sessions[i];
+	}
+	connection_tls_session_free(oldest);
+	return oldest;
+}
+
+// picks up what other processes wrote since we loaded (unless we know better), then replaces the file. it's written
+// next to the file and renamed over it, so readers never see half of it. two processes saving at once can lose the
+// other's additions, which only costs a cold start later
+static void connection_file_save(const int64_t now) {
+	char* path = connection_file_path();
+
+	connection_table disk = {0};
+	connection_file_read(path, &disk, now);
+	for (size_t i = 0; i < disk.host_count; i++) {
+		const connection_host* host = &disk.hosts[i];
+		if (!connection_find_host(&connections, host->host, host->port)) *connection_host_slot(&connections) = *host;
+	}
+	for (size_t i = 0; i < disk.session_count; i++) {
+		connection_tls_session* session = &disk.sessions[i];
+		if (connection_find_tls_session(&connections, session)) continue;
+		*connection_tls_session_slot(&connections) = *session;
+		memset(session, 0, sizeof(connection_tls_session)); // now owned by connections
+	}
+	connection_table_clear(&disk);
+
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	// fine if it already exists
+	#ifdef _WIN32
+	_mkdir(app_folder);
+	#else
+	mkdir(app_folder, 0700);
+	#endif
+	free(app_folder);
+
+	const size_t tmp_path_length = strlen(path) + 8;
+	char* tmp_path = malloc(tmp_path_length);
+	#ifdef _WIN32
+	// the app folder is under the user's profile, which only they can read
+	snprintf(tmp_path, tmp_path_length, "%s.tmp", path);
+	FILE* file = fopen(tmp_path, "w");
+	#else
+	// mkstemp creates it readable only by us, which matters with TLS session secrets in it
+	snprintf(tmp_path, tmp_path_length, "%s.XXXXXX", path);
+	const int fd = mkstemp(tmp_path);
+	FILE* file = fd >= 0 ? fdopen(fd, "w") : NULL;
+	if (!file && fd >= 0) {
+		close(fd);
+		remove(tmp_path);
+	}
+	#endif
+	if (!file) {
+		free(tmp_path);
+		free(path);
+		return;
+	}
+
+	bool written = connection_file_write_table(file, &connections, now);
+	written = fclose(file) == 0 && written;
+	#ifdef _WIN32
+	if (written) remove(path); // rename doesn't replace files here
+	#endif
+	if (!written || rename(tmp_path, path) != 0) remove(tmp_path);
+
+	free(tmp_path);
+	free(path);
+}
+
+// false if the cache is turned off
+static bool connection_load() {
+	if (connections_loaded) return connections_enabled;
+	connections_loaded = true;
+
+	if (!connections_enabled) return false;
+
+	char* path = connection_file_path();
+	connection_file_read(path, &connections, (int64_t)time(NULL));
+	free(path);
+	return true;
+}
+
+// host and port the url connects to, false for IP literals (nothing to resolve) and urls CURL can't parse
+static bool connection_parse_url(const char* url, char* host_out, const size_t host_size, long* port_out) {
+	CURLU* parsed = curl_url();
+	if (!parsed) return false;
+
+	char* host = NULL;
+	char* port = NULL;
+	bool valid = curl_url_set(parsed, CURLUPART_URL, url, 0) == CURLUE_OK &&
+		curl_url_get(parsed, CURLUPART_HOST, &host, 0) == CURLUE_OK &&
+		curl_url_get(parsed, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT) == CURLUE_OK;
+
+	unsigned char address[sizeof(struct in6_addr)];
+	valid = valid && host[0] != '[' && inet_pton(AF_INET, host, address) != 1 && strlen(host) < host_size;
+	if (valid) {
+		strcpy(host_out, host);
+		*port_out = strtol(port, NULL, 10);
+	}
+
+	curl_free(host);
+	curl_free(port);
+	curl_url_cleanup(parsed);
+	return valid;
+}
+
+void chatgpt_cli_connection_prepare(chatgpt_cli_connection_hint* hint, CURL* curl, const char* url) {
+	char host[256];
+	long port;
+	if (!connection_parse_url(url, host, sizeof(host), &port)) return;
+
+	connection_lock();
+	if (!connection_load()) {
+		mtx_unlock(&connections_lock);
+		return;
+	}
+
+	// '+' lets the entry age out of CURL's DNS cache as usual, so a long-lived session still resolves now and then
+	char entry[sizeof(host) + INET6_ADDRSTRLEN + 32];
+	const connection_host* known = connection_find_host(&connections, host, port);
+	struct curl_slist* resolve = NULL;
+	hint->pinned = false;
+	if (known && known->expires > (int64_t)time(NULL)) {
+		const bool ipv6 = strchr(known->address, ':') != NULL;
+		snprintf(entry, sizeof(entry), ipv6 ? "+%s:%ld:[%s]" : "+%s:%ld:%s", host, port, known->address);
+		resolve = curl_slist_append(NULL, entry);
+		hint->pinned = resolve != NULL;
+	} else if (known && known->expires == 0) {
+		// forgotten, and CURL's DNS cache (shared by a session or a scheduler's handles) may still have it
+		snprintf(entry, sizeof(entry), "-%s:%ld", host, port);
+		resolve = curl_slist_append(NULL, entry);
+	}
+
+	curl_easy_setopt(curl, CURLOPT_RESOLVE, resolve);
+	curl_slist_free_all(hint->resolve);
+	hint->resolve = resolve;
+
+	#ifdef CONNECTION_TLS_EXPORT
+	if (!hint->imported) {
+		const int64_t now = (int64_t)time(NULL);
+		for (size_t i = 0; i < connections.session_count; i++) {
+			const connection_tls_session* session = &connections.sessions[i];
+			if (session->valid_until <= now) continue;
+			curl_easy_ssls_import(curl, session->key, session->hmac, session->hmac_length, session->data,
+			                      session->data_length);
+		}
+	}
+	#endif
+	hint->imported = true;
+	mtx_unlock(&connections_lock);
+}
+
+#ifdef CONNECTION_TLS_EXPORT
+static CURLcode connection_tls_export(CURL* curl, void* changed_ptr, const char* session_key,
+                                      const unsigned char* hmac, const size_t hmac_length, const unsigned char* data,
+                                      const size_t data_length, const curl_off_t valid_until, const int ietf_tls_id,
+                                      const char* alpn, const size_t early_data_max) {
+	bool* changed = changed_ptr;
+	if (!data || data_length == 0) return CURLE_OK;
+
+	const connection_tls_session exported = {
+		.key = (char*)session_key,
+		.hmac = (unsigned char*)hmac,
+		.hmac_length = hmac_length,
+	};
+	connection_tls_session* session = connection_find_tls_session(&connections, &exported);
+	if (session && session->data_length == data_length && memcmp(session->data, data, data_length) == 0) {
+		return CURLE_OK;
+	}
+
+	if (session) connection_tls_session_free(session);
+	else session = connection_tls_session_slot(&connections);
+
+	session->key = session_key ? strdup(session_key) : NULL;
+	session->hmac = hmac_length ? malloc(hmac_length) : NULL;
+	session->data = malloc(data_length);
+	if ((session_key && !session->key) || (hmac_length && !session->hmac) || !session->data) {
+		connection_tls_session_free(session);
+		return CURLE_OK;
+	}
+	if (hmac_length) memcpy(session->hmac, hmac, hmac_length);
+	memcpy(session->data, data, data_length);
+	session->hmac_length = hmac_length;
+	session->data_length = data_length;
+	session->valid_until = (int64_t)valid_until;
+
+	*changed = true;
+	return CURLE_OK;
+}
+#endif
+
+// chatgpt_cli_connection_learn with connections_lock held
+static bool connection_learn_locked(chatgpt_cli_connection_hint* hint, CURL* curl, const char* host, const long port,
+                                    const CURLcode result) {
+	const int64_t now = (int64_t)time(NULL);
+	connection_host* known = connection_find_host(&connections, host, port);
+
+	// the address moved, forget it until it's been resolved again (even if another process still has it on disk)
+	if (hint->pinned && result == CURLE_COULDNT_CONNECT) {
+		if (known) known->expires = 0;
+		hint->pinned = false;
+		connection_file_save(now);
+		return true;
+	}
+
+	// only a new connection tells us anything, a reused one was resolved (and handshaken) long ago
+	long new_connections = 0;
+	curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connections);
+	const char* address = NULL;
+	curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &address);
+	if (new_connections == 0 || !address || !address[0] || result == CURLE_COULDNT_CONNECT) return false;
+
+	bool changed = false;
+
+	// a remembered address keeps its expiry, it has to be resolved again once that's up
+	if (!hint->pinned && strlen(address) < INET6_ADDRSTRLEN) {
+		if (!known) {
+			known = connection_host_slot(&connections);
+			strcpy(known->host, host);
+			known->port = port;
+		}
+		strcpy(known->address, address);
+		known->expires = now + CHATGPT_CLI_CONNECTION_DNS_TTL_SECONDS;
+		changed = true;
+	}
+
+	#ifdef CONNECTION_TLS_EXPORT
+	if (result == CURLE_OK) curl_easy_ssls_export(curl, connection_tls_export, &changed);
+	#endif
+
+	if (changed) connection_file_save(now);
+	return false;
+}
+
+bool chatgpt_cli_connection_learn(chatgpt_cli_connection_hint* hint, CURL* curl, const char* url,
+                                  const CURLcode result) {
+	char host[256];
+	long port;
+	if (!connection_parse_url(url, host, sizeof(host), &port)) return false;
+
+	connection_lock();
+	const bool reconnect = connection_load() && connection_learn_locked(hint, curl, host, port, result);
+	mtx_unlock(&connections_lock);
+	return reconnect;
+}
+
+void chatgpt_cli_connection_hint_free(chatgpt_cli_connection_hint* hint) {
+	curl_slist_free_all(hint->resolve);
+	memset(hint, 0, sizeof(chatgpt_cli_connection_hint));
+}
@@ -0,0 +1,36 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef CONNECTION_H
+#define CONNECTION_H
+#include <curl/curl.h>
+#include <stdbool.h>
+
+// what earlier processes learned about reaching the API (addresses, and TLS sessions where CURL can export them),
+// kept in the app folder so a fresh invocation doesn't start cold. 'connection-cache=false' in the config turns it off
+#define CHATGPT_CLI_CONNECTION_FILE_NAME "connections"
+
+// the resolver doesn't tell us the record's TTL, so an address is trusted for this long after it last worked
+#define CHATGPT_CLI_CONNECTION_DNS_TTL_SECONDS 300
+
+// one per handle, the list given to CURLOPT_RESOLVE has to outlive its transfer
+typedef struct {
+	struct curl_slist* resolve;
+	bool pinned; // the address was remembered rather than resolved
+	bool imported; // remembered TLS sessions were handed to the handle
+} chatgpt_cli_connection_hint;
+
+// on unless turned off (the config's 'connection-cache'), before the first connection is prepared
+void chatgpt_cli_connection_set_enabled(bool enabled);
+
+// points the handle at what's remembered for the url's host, call before each transfer
+void chatgpt_cli_connection_prepare(chatgpt_cli_connection_hint* hint, CURL* curl, const char* url);
+
+// remembers what the finished transfer learned, written to disk if anything changed. true if it couldn't connect to
+// a remembered address, which is now forgotten: nothing was sent, so it's worth trying again after another prepare
+bool chatgpt_cli_connection_learn(chatgpt_cli_connection_hint* hint, CURL* curl, const char* url, CURLcode result);
+
+void chatgpt_cli_connection_hint_free(chatgpt_cli_connection_hint* hint);
+
+#endif //CONNECTION_H
@@ -0,0 +1,585 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "daemon.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+char* chatgpt_cli_daemon_get_socket_path() {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	const size_t len = strlen(app_folder) + strlen(CHATGPT_CLI_DAEMON_SOCKET_FILE_NAME) + 2;
+	// 2 for path separator and \0
+
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s", app_folder, PATH_SEPARATOR, CHATGPT_CLI_DAEMON_SOCKET_FILE_NAME);
+	free(app_folder);
+	return path;
+}
+
+#ifdef _WIN32
+
+int chatgpt_cli_daemon_run(const char* api_key, size_t pool_size) {
+	fprintf(stderr, "The daemon isn't supported on Windows\n");
+	return EXIT_FAILURE;
+}
+
+bool chatgpt_cli_daemon_stream_response(openai_request* request, openai_delta_callback callback, void* user_data,
+                                        char** response_id, char** error) {
+	return false;
+}
+
+#else
+
+#include <curl/curl.h>
+#include <errno.h>
+#include <json-c/json.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// warm connections are refreshed when idle for this long, so the server doesn't close them on us
+#define DAEMON_KEEP_WARM_INTERVAL_MS 30000
+
+// requests are a single JSON line, anything bigger than this is refused
+#define DAEMON_MAX_REQUEST_LENGTH (64 * 1024 * 1024)
+
+// every message from the daemon is a frame: 1 byte type, 4 byte big-endian payload length, then the payload
+#define DAEMON_FRAME_HEADER_LENGTH 5
+
+typedef enum {
+	DAEMON_FRAME_DELTA = 'd', // 1 byte openai_delta_type, then the delta
+	DAEMON_FRAME_ERROR = 'e', // error message, last frame
+	DAEMON_FRAME_FINISHED = 'f', // response id (may be empty), last frame
+	DAEMON_FRAME_REJECTED = 'r', // the daemon can't serve this request, nothing was sent. last frame
+} daemon_frame_type;
+
+static void daemon_frame_header(unsigned char* header, const daemon_frame_type type, const size_t payload_length) {
+	header[0] = (unsigned char)type;
+	header[1] = (unsigned char)(payload_length >> 24);
+	header[2] = (unsigned char)(payload_length >> 16);
+	header[3] = (unsigned char)(payload_length >> 8);
+	header[4] = (unsigned char)payload_length;
+}
+
+// writes every byte of the iovecs, false if the other side went away
+static bool daemon_write_all(const int fd, struct iovec* iov, int iov_count) {
+	while (iov_count > 0) {
+		struct msghdr message = {.msg_iov = iov, .msg_iovlen = iov_count};
+		const ssize_t written = sendmsg(fd, &message, MSG_NOSIGNAL);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+
+		size_t remaining = (size_t)written;
+		while (iov_count > 0 && remaining >= iov->iov_len) {
+			remaining -= iov->iov_len;
+			iov++;
+			iov_count--;
+		}
+		if (iov_count > 0) {
+			iov->iov_base = (char*)iov->iov_base + remaining;
+			iov->iov_len -= remaining;
+		}
+	}
+	return true;
+}
+
+// frames are read through a buffer, so a burst of small deltas doesn't cost two reads each
+#define DAEMON_READ_BUFFER_SIZE (64 * 1024)
+
+typedef struct {
+	int fd;
+	size_t start; // unread bytes are buffer[start, end)
+	size_t end;
+	char buffer[DAEMON_READ_BUFFER_SIZE];
+} daemon_reader;
+
+static bool daemon_read_all(daemon_reader* reader, void* buffer, const size_t length) {
+	size_t read_length = 0;
+	while (read_length < length) {
+		if (reader->start == reader->end) {
+			const ssize_t result = read(reader->fd, reader->buffer, sizeof(reader->buffer));
+			if (result < 0 && errno == EINTR) continue;
+			if (result <= 0) return false;
+			reader->start = 0;
+			reader->end = (size_t)result;
+		}
+
+		size_t available = reader->end - reader->start;
+		if (available > length - read_length) available = length - read_length;
+		memcpy((char*)buffer + read_length, reader->buffer + reader->start, available);
+		reader->start += available;
+		read_length += available;
+	}
+	return true;
+}
+
+static bool daemon_send_frame(const int fd, const daemon_frame_type type, const char* payload, const size_t length) {
+	unsigned char header[DAEMON_FRAME_HEADER_LENGTH];
+	daemon_frame_header(header, type, length);
+
+	struct iovec iov[2] = {
+		{.iov_base = header, .iov_len = sizeof(header)},
+		{.iov_base = (void*)payload, .iov_len = length},
+	};
+	return daemon_write_all(fd, iov, length ? 2 : 1);
+}
+
+static json_object* daemon_request_to_json(const openai_request* request) {
+	json_object* request_json = json_object_new_object();
+
+	#define DAEMON_STRING_FIELD(field) \
+		if (request->field) json_object_object_add(request_json, #field, json_object_new_string(request->field))
+
+	DAEMON_STRING_FIELD(input);
+	DAEMON_STRING_FIELD(model);
+	DAEMON_STRING_FIELD(instructions);
+	DAEMON_STRING_FIELD(previous_response_id);
+	DAEMON_STRING_FIELD(api_key);
+
+	#undef DAEMON_STRING_FIELD
+
+	json_object_object_add(request_json, "temperature", json_object_new_double(request->temperature));
+	json_object_object_add(request_json, "max_tokens", json_object_new_uint64(request->max_tokens));
+	json_object_object_add(request_json, "raw", json_object_new_int(request->raw));
+	json_object_object_add(request_json, "echo_response_id", json_object_new_boolean(request->echo_response_id));
+	json_object_object_add(request_json, "cache", json_object_new_int(request->cache));
+	json_object_object_add(request_json, "timings", json_object_new_int(request->timings));
+	json_object_object_add(request_json, "hedge_after_us", json_object_new_int64(request->hedge_after_us));
+	json_object_object_add(request_json, "api_url", json_object_new_string(openai_get_api_url()));
+
+	// attachments go as their (absolute) paths, the daemon maps them itself
+	if (request->attachment_count > 0) {
+		json_object* attachments = json_object_new_array();
+		for (size_t i = 0; i < request->attachment_count; i++) {
+			json_object_array_add(attachments, json_object_new_string(request->attachments[i].path));
+		}
+		json_object_object_add(request_json, "attachments", attachments);
+	}
+
+	return request_json;
+}
+
+static openai_request* daemon_request_from_json(json_object* request_json) {
+	openai_request* request = calloc(1, sizeof(openai_request));
+	json_object* value;
+
+	#define DAEMON_STRING_FIELD(field) \
+		if (json_object_object_get_ex(request_json, #field, &value)) request->field = strdup(json_object_get_string(value))
+
+	DAEMON_STRING_FIELD(input);
+	DAEMON_STRING_FIELD(model);
+	DAEMON_STRING_FIELD(instructions);
+	DAEMON_STRING_FIELD(previous_response_id);
+	DAEMON_STRING_FIELD(api_key);
+
+	#undef DAEMON_STRING_FIELD
+
+	request->temperature = json_object_object_get_ex(request_json, "temperature", &value)
+		? json_object_get_double(value) : OPENAI_REQUEST_TEMPERATURE_NOT_SET;
+	request->max_tokens = json_object_object_get_ex(request_json, "max_tokens", &value)
+		? json_object_get_uint64(value) : OPENAI_REQUEST_MAX_TOKENS_NOT_SET;
+	request->raw = json_object_object_get_ex(request_json, "raw", &value)
+		? (openai_raw_mode)json_object_get_int(value) : OPENAI_RAW_OFF;
+	request->echo_response_id = json_object_object_get_ex(request_json, "echo_response_id", &value) &&
+		json_object_get_boolean(value);
+	request->cache = json_object_object_get_ex(request_json, "cache", &value)
+		? (openai_cache_mode)json_object_get_int(value) : OPENAI_CACHE_OFF;
+	request->timings = json_object_object_get_ex(request_json, "timings", &value)
+		? (openai_timings_mode)json_object_get_int(value) : OPENAI_TIMINGS_OFF;
+	request->hedge_after_us = json_object_object_get_ex(request_json, "hedge_after_us", &value)
+		? json_object_get_int64(value) : 0;
+
+	return request;
+}
+
+// maps the files a request came with, NULL if successful, or the error (caller frees)
+static char* daemon_request_attach_from_json(openai_request* request, json_object* request_json) {
+	json_object* attachments;
+	if (!json_object_object_get_ex(request_json, "attachments", &attachments)) return NULL;
+
+	for (size_t i = 0; i < json_object_array_length(attachments); i++) {
+		char* error = openai_request_attach(request, json_object_get_string(json_object_array_get_idx(attachments, i)));
+		if (error) return error;
+	}
+	return NULL;
+}
+
+static int daemon_connect(const char* socket_path) {
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	if (strlen(socket_path) >= sizeof(address.sun_path)) return -1;
+	strcpy(address.sun_path, socket_path);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+
+	if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// ---- client ----
+
+bool chatgpt_cli_daemon_stream_response(openai_request* request, openai_delta_callback callback, void* user_data,
+                                        char** response_id, char** error) {
+	char* socket_path = chatgpt_cli_daemon_get_socket_path();
+	const int fd = daemon_connect(socket_path);
+	free(socket_path);
+	if (fd < 0) return false;
+
+	json_object* request_json = daemon_request_to_json(request);
+	const char* request_string = json_object_to_json_string_ext(request_json, JSON_C_TO_STRING_PLAIN);
+	struct iovec iov[2] = {
+		{.iov_base = (void*)request_string, .iov_len = strlen(request_string)},
+		{.iov_base = "\n", .iov_len = 1},
+	};
+	const bool sent = daemon_write_all(fd, iov, 2);
+	json_object_put(request_json);
+	if (!sent) {
+		close(fd);
+		return false;
+	}
+
+	bool handled = false; // once anything was streamed, the request can't be retried without the daemon
+	*response_id = NULL;
+	*error = NULL;
+
+	// frames are read into one buffer which only ever grows, deltas are borrowed from it
+	char* payload = NULL;
+	size_t payload_capacity = 0;
+	daemon_reader* reader = malloc(sizeof(daemon_reader));
+	if (!reader) {
+		close(fd);
+		return false;
+	}
+	reader->fd = fd;
+	reader->start = reader->end = 0;
+
+	while (true) {
+		unsigned char header[DAEMON_FRAME_HEADER_LENGTH];
+		if (!daemon_read_all(reader, header, sizeof(header))) {
+			if (handled) *error = strdup("Lost connection to the daemon");
+			break;
+		}
+
+		const size_t length = (size_t)header[1] << 24 | (size_t)header[2] << 16 | (size_t)header[3] << 8 | header[4];
+		if (length + 1 > payload_capacity) {
+			char* new_payload = realloc(payload, length + 1);
+			if (!new_payload) {
+				*error = strdup("Failed to allocate memory for delta");
+				handled = true;
+				break;
+			}
+			payload = new_payload;
+			payload_capacity = length + 1;
+		}
+		if (!daemon_read_all(reader, payload, length)) {
+			if (handled) *error = strdup("Lost connection to the daemon");
+			break;
+		}
+		payload[length] = '\0';
+
+		const daemon_frame_type type = header[0];
+		if (type == DAEMON_FRAME_REJECTED) break;
+
+		handled = true;
+		if (type == DAEMON_FRAME_DELTA && length >= 1) {
+			callback((openai_delta_type)payload[0], payload + 1, length - 1, user_data);
+			continue;
+		}
+		if (type == DAEMON_FRAME_ERROR) *error = strdup(payload);
+		else if (length > 0) *response_id = strdup(payload);
+		break; // finished
+	}
+
+	free(payload);
+	free(reader);
+	close(fd);
+	return handled;
+}
+
+// ---- daemon ----
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t available_changed;
+
+	openai_session** available; // stack of idle sessions
+	size_t available_count;
+
+	char* api_key;
+} daemon_pool;
+
+typedef struct {
+	daemon_pool* pool;
+	openai_session* session; // while streaming
+	int fd;
+	bool disconnected; // the client went away, stop writing to it (and streaming for it)
+
+	// frames waiting to be sent, written together whenever the response goes quiet
+	unsigned char* pending;
+	size_t pending_length;
+	size_t pending_capacity;
+} daemon_client;
+
+static openai_session* daemon_pool_acquire(daemon_pool* pool) {
+	pthread_mutex_lock(&pool->lock);
+	while (pool->available_count == 0) pthread_cond_wait(&pool->available_changed, &pool->lock);
+	openai_session* session = pool->available[--pool->available_count];
+	pthread_mutex_unlock(&pool->lock);
+	return session;
+}
+
+static void daemon_pool_release(daemon_pool* pool, openai_session* session) {
+	pthread_mutex_lock(&pool->lock);
+	pool->available[pool->available_count++] = session;
+	pthread_cond_signal(&pool->available_changed);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static void daemon_client_flush(daemon_client* client) {
+	if (client->pending_length == 0 || client->disconnected) return;
+
+	struct iovec iov = {.iov_base = client->pending, .iov_len = client->pending_length};
+	if (!daemon_write_all(client->fd, &iov, 1)) client->disconnected = true;
+	client->pending_length = 0;
+}
+
+// forwards deltas as they are, gathered up until the wrapper says the chunk they came in is done
+static void daemon_delta_callback(const openai_delta_type type, const char* delta, const size_t length,
+                                  void* user_data) {
+	daemon_client* client = user_data;
+	if (client->disconnected) return;
+
+	const size_t frame_length = DAEMON_FRAME_HEADER_LENGTH + 1 + length;
+	if (client->pending_length + frame_length > client->pending_capacity) {
+		size_t new_capacity = client->pending_capacity ? client->pending_capacity : 4096;
+		while (new_capacity < client->pending_length + frame_length) new_capacity *= 2;
+
+		unsigned char* new_pending = realloc(client->pending, new_capacity);
+		if (!new_pending) {
+			client->disconnected = true; // can't forward it, and the client mustn't miss a delta
+			openai_session_cancel(client->session);
+			return;
+		}
+		client->pending = new_pending;
+		client->pending_capacity = new_capacity;
+	}
+
+	unsigned char* frame = client->pending + client->pending_length;
+	daemon_frame_header(frame, DAEMON_FRAME_DELTA, length + 1);
+	frame[DAEMON_FRAME_HEADER_LENGTH] = (unsigned char)type;
+	memcpy(frame + DAEMON_FRAME_HEADER_LENGTH + 1, delta, length);
+	client->pending_length += frame_length;
+
+	if (type == OPENAI_DELTA_FLUSH || client->pending_length >= DAEMON_READ_BUFFER_SIZE) daemon_client_flush(client);
+
+	// nobody is reading the rest of the response, don't keep paying for it
+	if (client->disconnected) openai_session_cancel(client->session);
+}
+
+// reads the request line, NULL if the client sent something unusable
+static char* daemon_read_request_line(const int fd) {
+	char* line = NULL;
+	size_t length = 0;
+	size_t capacity = 0;
+
+	while (true) {
+		if (length + 4096 + 1 > capacity) {
+			capacity = capacity ? capacity * 2 : 8192;
+			if (capacity > DAEMON_MAX_REQUEST_LENGTH) break;
+
+			char* new_line = realloc(line, capacity);
+			if (!new_line) break;
+			line = new_line;
+		}
+
+		const ssize_t result = read(fd, line + length, capacity - length - 1);
+		if (result < 0 && errno == EINTR) continue;
+		if (result <= 0) break;
+
+		char* newline = memchr(line + length, '\n', (size_t)result);
+		length += (size_t)result;
+		if (newline) {
+			*newline = '\0';
+			return line;
+		}
+	}
+
+	free(line);
+	return NULL;
+}
+
+// runs on a thread of its own per client. besides their pooled sessions, the clients share the wrapper's process-wide
+// state: the API url is set once before the daemon starts listening and only read afterwards (a client asking for a
+// different one is rejected, never switched over to), and the response cache is files: entries are renamed into place
+// and the stats are locked around every update (see cache.c), which keeps threads apart the same as processes
+static void* daemon_serve_client(void* client_ptr) {
+	daemon_client* client = client_ptr;
+
+	char* line = daemon_read_request_line(client->fd);
+	json_object* request_json = line ? json_tokener_parse(line) : NULL;
+	free(line);
+
+	if (!request_json) {
+		daemon_send_frame(client->fd, DAEMON_FRAME_REJECTED, NULL, 0);
+		close(client->fd);
+		free(client);
+		return NULL;
+	}
+
+	openai_request* request = daemon_request_from_json(request_json);
+	char* attach_error = daemon_request_attach_from_json(request, request_json);
+	json_object* api_url;
+	const bool same_api_url = json_object_object_get_ex(request_json, "api_url", &api_url) &&
+		strcmp(json_object_get_string(api_url), openai_get_api_url()) == 0;
+	json_object_put(request_json);
+
+	// the pooled connections are authenticated with the daemon's key (and connected to its server),
+	// anyone else has to go direct
+	if (!same_api_url || !request->api_key || strcmp(request->api_key, client->pool->api_key) != 0 ||
+		!request->model || !request->input) {
+		daemon_send_frame(client->fd, DAEMON_FRAME_REJECTED, NULL, 0);
+	} else if (attach_error) {
+		daemon_send_frame(client->fd, DAEMON_FRAME_ERROR, attach_error, strlen(attach_error));
+	} else {
+		openai_session* session = daemon_pool_acquire(client->pool);
+		client->session = session;
+		char* error = openai_session_stream_response(session, request, daemon_delta_callback, client);
+		daemon_client_flush(client); // e.g. the timings, which come after the last chunk
+
+		if (error) {
+			daemon_send_frame(client->fd, DAEMON_FRAME_ERROR, error, strlen(error));
+		} else {
+			const char* response_id = openai_session_get_last_response_id(session);
+			daemon_send_frame(client->fd, DAEMON_FRAME_FINISHED, response_id, response_id ? strlen(response_id) : 0);
+		}
+
+		free(error);
+		daemon_pool_release(client->pool, session);
+	}
+
+	free(attach_error);
+	openai_request_free(request);
+	close(client->fd);
+	free(client->pending);
+	free(client);
+	return NULL;
+}
+
+// re-warms every idle session so their connections stay open
+static void daemon_pool_keep_warm(daemon_pool* pool) {
+	pthread_mutex_lock(&pool->lock);
+	const size_t count = pool->available_count;
+	openai_session** sessions = malloc(count * sizeof(openai_session*));
+	memcpy(sessions, pool->available, count * sizeof(openai_session*));
+	pool->available_count = 0;
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i < count; i++) {
+		openai_session_warm(sessions[i]);
+		daemon_pool_release(pool, sessions[i]);
+	}
+	free(sessions);
+}
+
+int chatgpt_cli_daemon_run(const char* api_key, const size_t pool_size) {
+	curl_global_init(CURL_GLOBAL_DEFAULT); // not thread safe, so before any clients are served
+
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	mkdir(app_folder, 0700); // fine if it already exists
+	free(app_folder);
+
+	char* socket_path = chatgpt_cli_daemon_get_socket_path();
+
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	if (strlen(socket_path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "Daemon socket path %s is too long\n", socket_path);
+		free(socket_path);
+		return EXIT_FAILURE;
+	}
+	strcpy(address.sun_path, socket_path);
+
+	// a socket file nobody is listening on is left over from a daemon which didn't exit cleanly
+	const int existing_fd = daemon_connect(socket_path);
+	if (existing_fd >= 0) {
+		close(existing_fd);
+		fprintf(stderr, "A daemon is already running on %s\n", socket_path);
+		free(socket_path);
+		return EXIT_FAILURE;
+	}
+	unlink(socket_path);
+
+	const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	const mode_t previous_umask = umask(0177); // the socket hands out an authenticated connection, owner only
+	const bool bound = listen_fd >= 0 && bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+	umask(previous_umask);
+
+	if (!bound || listen(listen_fd, 64) != 0) {
+		fprintf(stderr, "Unable to listen on %s: %s\n", socket_path, strerror(errno));
+		free(socket_path);
+		return EXIT_FAILURE;
+	}
+
+	daemon_pool pool = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.available_changed = PTHREAD_COND_INITIALIZER,
+		.available = calloc(pool_size, sizeof(openai_session*)),
+		.api_key = strdup(api_key),
+	};
+
+	for (size_t i = 0; i < pool_size; i++) {
+		openai_session* session = openai_session_new(api_key);
+		if (!session) {
+			fprintf(stderr, "Could not initialize CURL\n");
+			return EXIT_FAILURE;
+		}
+		if (!openai_session_warm(session)) {
+			fprintf(stderr, "Warning: couldn't open a connection to the API yet\n");
+		}
+		pool.available[pool.available_count++] = session;
+	}
+
+	fprintf(stderr, "Listening on %s with %zu warm connections\n", socket_path, pool_size);
+	free(socket_path);
+
+	while (true) {
+		struct pollfd listen_poll = {.fd = listen_fd, .events = POLLIN};
+		const int ready = poll(&listen_poll, 1, DAEMON_KEEP_WARM_INTERVAL_MS);
+		if (ready == 0) {
+			daemon_pool_keep_warm(&pool);
+			continue;
+		}
+		if (ready < 0) continue; // EINTR
+
+		const int client_fd = accept(listen_fd, NULL, NULL);
+		if (client_fd < 0) continue;
+
+		daemon_client* client = malloc(sizeof(daemon_client));
+		*client = (daemon_client){.pool = &pool, .fd = client_fd};
+
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, daemon_serve_client, client) != 0) {
+			close(client_fd);
+			free(client);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+}
+
+#endif
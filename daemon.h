@@ -0,0 +1,29 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef DAEMON_H
+#define DAEMON_H
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "openai-wrapper.h"
+
+// name of the unix socket (in the app folder) which the daemon listens on
+#define CHATGPT_CLI_DAEMON_SOCKET_FILE_NAME "daemon.sock"
+
+// warm connections kept by the daemon, each one serves a single client at a time
+#define CHATGPT_CLI_DAEMON_DEFAULT_POOL_SIZE 4
+
+char* chatgpt_cli_daemon_get_socket_path();
+
+// serves requests on the daemon socket until killed, only returns (with an exit code) if it couldn't start
+int chatgpt_cli_daemon_run(const char* api_key, size_t pool_size);
+
+// sends a request through a running daemon. returns false if there's no daemon to take it (and nothing was
+// streamed), otherwise *error is set just like openai_stream_response's return value and *response_id to the
+// completed response's id (both NULL if not set, caller frees).
+bool chatgpt_cli_daemon_stream_response(openai_request* request, openai_delta_callback callback, void* user_data,
+                                        char** response_id, char** error);
+
+#endif //DAEMON_H
@@ -0,0 +1,201 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "fanout.h"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+// every delta is a record in the ring: this header, then the delta padded to a multiple of 8
+typedef struct {
+	uint32_t length;
+	uint32_t type; // openai_delta_type, or one of the markers below
+} fanout_record;
+
+#define FANOUT_RECORD_WRAP UINT32_MAX // the rest of the ring is unused, carry on from the start
+#define FANOUT_RECORD_STOP (UINT32_MAX - 1) // nothing comes after this, the writer stops
+
+#define FANOUT_RECORD_SIZE(length) (sizeof(fanout_record) + (((length) + 7) & ~(size_t)7))
+
+typedef struct {
+	openai_delta_callback callback;
+	void* user_data;
+} fanout_sink;
+
+struct chatgpt_cli_fanout {
+	unsigned char* ring;
+	size_t capacity; // power of 2
+
+	// positions only ever grow, the ring index is position & (capacity - 1).
+	// head is only written by the stream, tail only by the writer once the sinks are done with a record
+	alignas(64) _Atomic size_t head;
+	alignas(64) _Atomic size_t tail;
+
+	// the lock and condition variables are only for sleeping, when one side has nothing to do
+	mtx_t lock;
+	cnd_t pushed;
+	cnd_t popped;
+	atomic_bool writer_waiting;
+	atomic_bool stream_waiting;
+
+	fanout_sink sinks[CHATGPT_CLI_FANOUT_MAX_SINKS];
+	size_t sink_count;
+
+	thrd_t writer;
+};
+
+static void fanout_call_sinks(const chatgpt_cli_fanout* fanout, const openai_delta_type type, const char* delta,
+                              const size_t length) {
+	for (size_t i = 0; i < fanout->sink_count; i++) {
+		fanout->sinks[i].callback(type, delta, length, fanout->sinks[i].user_data);
+	}
+}
+
+static void fanout_wake(chatgpt_cli_fanout* fanout, atomic_bool* waiting, cnd_t* condition) {
+	if (!atomic_load(waiting)) return;
+	mtx_lock(&fanout->lock);
+	cnd_signal(condition);
+	mtx_unlock(&fanout->lock);
+}
+
+static int fanout_writer(void* fanout_ptr) {
+	chatgpt_cli_fanout* fanout = fanout_ptr;
+	size_t tail = atomic_load_explicit(&fanout->tail, memory_order_relaxed);
+
+	while (true) {
+		if (atomic_load_explicit(&fanout->head, memory_order_acquire) == tail) {
+			// announce the nap before the last look, so the stream either sees it or we see its record
+			mtx_lock(&fanout->lock);
+			atomic_store(&fanout->writer_waiting, true);
+			if (atomic_load(&fanout->head) == tail) cnd_wait(&fanout->pushed, &fanout->lock);
+			atomic_store(&fanout->writer_waiting, false);
+			mtx_unlock(&fanout->lock);
+			continue;
+		}
+
+		const size_t offset = tail & (fanout->capacity - 1);
+		const fanout_record* record = (const fanout_record*)(fanout->ring + offset);
+
+		if (record->type == FANOUT_RECORD_WRAP) {
+			tail += fanout->capacity - offset;
+		} else if (record->type == FANOUT_RECORD_STOP) {
+			atomic_store_explicit(&fanout->tail, tail + sizeof(fanout_record), memory_order_release);
+			return 0;
+		} else {
+			fanout_call_sinks(fanout, (openai_delta_type)record->type, (const char*)(record + 1), record->length);
+			tail += FANOUT_RECORD_SIZE(record->length);
+		}
+
+		atomic_store(&fanout->tail, tail);
+		fanout_wake(fanout, &fanout->stream_waiting, &fanout->popped);
+	}
+}
+
+chatgpt_cli_fanout* chatgpt_cli_fanout_new(const size_t capacity) {
+	// head and tail each get a cache line of their own
+	chatgpt_cli_fanout* fanout = aligned_alloc(alignof(chatgpt_cli_fanout), sizeof(chatgpt_cli_fanout));
+	if (!fanout) return NULL;
+	memset(fanout, 0, sizeof(chatgpt_cli_fanout));
+
+	fanout->capacity = 4096;
+	while (fanout->capacity < capacity) fanout->capacity *= 2;
+	fanout->ring = aligned_alloc(alignof(fanout_record), fanout->capacity);
+	if (!fanout->ring) {
+		free(fanout);
+		return NULL;
+	}
+
+	mtx_init(&fanout->lock, mtx_plain);
+	cnd_init(&fanout->pushed);
+	cnd_init(&fanout->popped);
+	if (thrd_create(&fanout->writer, fanout_writer, fanout) != thrd_success) {
+		mtx_destroy(&fanout->lock);
+		cnd_destroy(&fanout->pushed);
+		cnd_destroy(&fanout->popped);
+		free(fanout->ring);
+		free(fanout);
+		return NULL;
+	}
+	return fanout;
+}
+
+bool chatgpt_cli_fanout_add_sink(chatgpt_cli_fanout* fanout, const openai_delta_callback sink, void* user_data) {
+	if (fanout->sink_count == CHATGPT_CLI_FANOUT_MAX_SINKS) return false;
+	fanout->sinks[fanout->sink_count++] = (fanout_sink){.callback = sink, .user_data = user_data};
+	return true;
+}
+
+// blocks the stream until the writer has made room for size more bytes after head. this is the back-pressure: the
+// network isn't read while the sinks are a whole ring behind
+static void fanout_wait_for_room(chatgpt_cli_fanout* fanout, const size_t head, const size_t size) {
+	while (head + size - atomic_load_explicit(&fanout->tail, memory_order_acquire) > fanout->capacity) {
+		mtx_lock(&fanout->lock);
+		atomic_store(&fanout->stream_waiting, true);
+		if (head + size - atomic_load(&fanout->tail) > fanout->capacity) {
+			cnd_signal(&fanout->pushed); // it's full, the writer had better be awake
+			cnd_wait(&fanout->popped, &fanout->lock);
+		}
+		atomic_store(&fanout->stream_waiting, false);
+		mtx_unlock(&fanout->lock);
+	}
+}
+
+static void fanout_publish(chatgpt_cli_fanout* fanout, size_t head, const uint32_t type, const char* delta,
+                           const size_t length) {
+	const size_t size = FANOUT_RECORD_SIZE(length);
+	const size_t offset = head & (fanout->capacity - 1);
+
+	// records are never split, skip whatever's left at the end if it doesn't fit
+	if (size > fanout->capacity - offset) {
+		const size_t skipped = fanout->capacity - offset;
+		fanout_wait_for_room(fanout, head, skipped + size);
+		((fanout_record*)(fanout->ring + offset))->type = FANOUT_RECORD_WRAP;
+		head += skipped;
+	} else {
+		fanout_wait_for_room(fanout, head, size);
+	}
+
+	fanout_record* record = (fanout_record*)(fanout->ring + (head & (fanout->capacity - 1)));
+	record->length = (uint32_t)length;
+	record->type = type;
+	if (length) memcpy(record + 1, delta, length);
+	atomic_store(&fanout->head, head + size);
+}
+
+void chatgpt_cli_fanout_push(const openai_delta_type type, const char* delta, const size_t length, void* fanout_ptr) {
+	chatgpt_cli_fanout* fanout = fanout_ptr;
+	const size_t head = atomic_load_explicit(&fanout->head, memory_order_relaxed);
+
+	// too big for the ring (a whole raw response, say): once the writer has caught up, hand it over directly
+	if (FANOUT_RECORD_SIZE(length) > fanout->capacity / 2) {
+		fanout_wait_for_room(fanout, head, fanout->capacity);
+		fanout_call_sinks(fanout, type, delta, length);
+		return;
+	}
+
+	fanout_publish(fanout, head, type, delta, length);
+
+	// the sinks would rather have a chunk's worth of deltas at once
+	const size_t used = atomic_load_explicit(&fanout->head, memory_order_relaxed) -
+		atomic_load_explicit(&fanout->tail, memory_order_relaxed);
+	if (type == OPENAI_DELTA_FLUSH || type == OPENAI_DELTA_TIMINGS || used >= fanout->capacity / 2) {
+		fanout_wake(fanout, &fanout->writer_waiting, &fanout->pushed);
+	}
+}
+
+void chatgpt_cli_fanout_finish(chatgpt_cli_fanout* fanout) {
+	fanout_publish(fanout, atomic_load_explicit(&fanout->head, memory_order_relaxed), FANOUT_RECORD_STOP, NULL, 0);
+	fanout_wake(fanout, &fanout->writer_waiting, &fanout->pushed);
+	thrd_join(fanout->writer, NULL);
+
+	mtx_destroy(&fanout->lock);
+	cnd_destroy(&fanout->pushed);
+	cnd_destroy(&fanout->popped);
+	free(fanout->ring);
+	free(fanout);
+}
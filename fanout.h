@@ -0,0 +1,34 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef FANOUT_H
+#define FANOUT_H
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "openai-wrapper.h"
+
+// bytes of deltas which can be waiting for the sinks, the stream stops reading from the network once it's full
+#define CHATGPT_CLI_FANOUT_DEFAULT_CAPACITY (1024 * 1024)
+#define CHATGPT_CLI_FANOUT_MAX_SINKS 4
+
+// takes deltas off the thread receiving the stream: they're copied into a ring and a writer thread passes them on to
+// every sink in turn, so a slow terminal or disk doesn't hold up reading from the network until the ring fills up.
+// the writer is woken once per network chunk (OPENAI_DELTA_FLUSH) or when the ring is half full, not per delta
+typedef struct chatgpt_cli_fanout chatgpt_cli_fanout;
+
+// NULL if the writer thread couldn't be started
+chatgpt_cli_fanout* chatgpt_cli_fanout_new(size_t capacity);
+
+// sinks are called on the writer thread, in the order they were added, with deltas borrowed from the ring.
+// add them all before the first delta. false if there are too many
+bool chatgpt_cli_fanout_add_sink(chatgpt_cli_fanout* fanout, openai_delta_callback sink, void* user_data);
+
+// an openai_delta_callback with the fanout as user_data, only ever call it from one thread
+void chatgpt_cli_fanout_push(openai_delta_type type, const char* delta, size_t length, void* fanout);
+
+// waits until every sink has had every delta, then stops the writer thread and frees the fanout
+void chatgpt_cli_fanout_finish(chatgpt_cli_fanout* fanout);
+
+#endif //FANOUT_H
@@ -5,6 +5,7 @@
 #include "history.h"
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -13,11 +14,56 @@
 
 #ifdef _WIN32
 #include <direct.h>
+#include <io.h>
+#include <sys/locking.h>
 #else
+	#include <fcntl.h>
+	#include <sys/file.h>
+	#include <sys/mman.h>
 	#include <sys/stat.h>
 	#include <unistd.h>
 #endif
 
+// held while appending, so turns from concurrent processes don't interleave
+#define HISTORY_LOCK_FILE_NAME "history.lock"
+
+#define HISTORY_RECORD_MAGIC 0x54524843 // "CHRT"
+#define HISTORY_ID_TABLE_MAGIC 0x53444948 // "HIDS"
+
+// the table is grown (and rebuilt) once it's half full
+#define HISTORY_ID_TABLE_MIN_CAPACITY 1024
+
+// records start on a multiple of this, so their headers can be read in place
+#define HISTORY_RECORD_ALIGNMENT 8
+
+// id, parent id, model, prompt, output
+#define HISTORY_FIELD_COUNT 5
+
+typedef struct {
+	uint32_t magic;
+	uint32_t length; // the whole record, header and padding included
+	int64_t created_at;
+	int64_t first_delta_us;
+	int64_t total_us;
+	uint32_t field_lengths[HISTORY_FIELD_COUNT]; // the fields follow the header in order, each one \0 terminated
+	uint32_t has_parent; // tells an empty parent id apart from none
+} history_record_header;
+
+typedef struct {
+	uint64_t offset; // of the record in the log
+	uint64_t id_hash;
+} history_index_entry;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t reserved;
+	uint64_t capacity; // slots, a power of 2
+	uint64_t indexed_count; // index entries which are in the table, later ones have to be searched for
+} history_id_table_header;
+
+// slots are empty (0) or the index position + 1 in the low half and the top half of the id's hash in the high half
+typedef uint64_t history_id_table_slot;
+
 // recursive mkdir
 static void r_mkdir(char* path) {
 	// mkdir simply fails if directory exists, so go through all subdirs.
@@ -56,51 +102,441 @@ static void r_mkdir(char* path) {
 	#endif
 }
 
-FILE* chatgpt_cli_history_get_previous_response_id_file(const char* mode) {
+static char* history_path(const char* file_name) {
 	char* app_folder = chatgpt_cli_config_get_app_folder();
-	const size_t len = strlen(CHATGPT_CLI_HISTORY_PREVIOUS_NODE_FILE_NAME) + strlen(app_folder) + 2;
+	const size_t len = strlen(file_name) + strlen(app_folder) + 2;
 	// 2 for path separator and \0
 
 	char* path = malloc(len);
-	snprintf(path, len, "%s%c%s", app_folder, PATH_SEPARATOR, CHATGPT_CLI_HISTORY_PREVIOUS_NODE_FILE_NAME);
+	snprintf(path, len, "%s%c%s", app_folder, PATH_SEPARATOR, file_name);
+	free(app_folder);
+	return path;
+}
 
-	FILE* ret_file = fopen(path, mode); // read/write
+static uint64_t history_hash_id(const char* id) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (; *id; id++) {
+		hash ^= (unsigned char)*id;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
 
-	if (ret_file == NULL) {
-		// create subdirs and file
-		r_mkdir(app_folder);
+// ---- reading ----
 
-		ret_file = fopen(path, "w+"); // read/write, clears/creates
-		if (ret_file == NULL) {
-			fprintf(stderr, "\nUnable to open history file!\n");
-			exit(1);
-		}
+typedef struct {
+	char* data;
+	size_t length;
+} history_map;
+
+// an empty map if the file doesn't exist
+static history_map history_map_file(const char* file_name) {
+	history_map map = {0};
+	char* path = history_path(file_name);
+
+	#ifdef _WIN32
+	// no mmap here, read it whole instead
+	FILE* file = fopen(path, "rb");
+	free(path);
+	if (!file) return map;
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (length > 0 && (map.data = malloc(length))) {
+		map.length = fread(map.data, 1, length, file);
 	}
+	fclose(file);
+	#else
+	const int fd = open(path, O_RDONLY);
 	free(path);
+	if (fd < 0) return map;
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+		void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED) {
+			map.data = data;
+			map.length = file_stat.st_size;
+		}
+	}
+	close(fd); // the mapping stays valid
+	#endif
+
+	return map;
+}
+
+static void history_unmap(history_map* map) {
+	if (!map->data) return;
+	#ifdef _WIN32
+	free(map->data);
+	#else
+	munmap(map->data, map->length);
+	#endif
+	map->data = NULL;
+	map->length = 0;
+}
+
+struct chatgpt_cli_history {
+	history_map log;
+	history_map index;
+	history_map id_table;
+	size_t count;
+};
+
+chatgpt_cli_history* chatgpt_cli_history_open() {
+	chatgpt_cli_history* history = calloc(1, sizeof(chatgpt_cli_history));
 
-	return ret_file;
+	// the index first: anything it points to was fully written before the entry was
+	history->index = history_map_file(CHATGPT_CLI_HISTORY_INDEX_FILE_NAME);
+	history->log = history_map_file(CHATGPT_CLI_HISTORY_LOG_FILE_NAME);
+	history->id_table = history_map_file(CHATGPT_CLI_HISTORY_ID_TABLE_FILE_NAME);
+	history->count = history->index.length / sizeof(history_index_entry); // a torn last entry doesn't count
+
+	return history;
+}
+
+void chatgpt_cli_history_close(chatgpt_cli_history* history) {
+	if (!history) return;
+	history_unmap(&history->log);
+	history_unmap(&history->index);
+	history_unmap(&history->id_table);
+	free(history);
+}
+
+size_t chatgpt_cli_history_count(const chatgpt_cli_history* history) {
+	return history->count;
+}
+
+static history_index_entry history_index_entry_at(const chatgpt_cli_history* history, const size_t position) {
+	history_index_entry entry;
+	memcpy(&entry, history->index.data + position * sizeof(history_index_entry), sizeof(entry));
+	return entry;
+}
+
+static bool history_read_turn(const chatgpt_cli_history* history, const history_index_entry* entry,
+                              chatgpt_cli_history_turn* turn) {
+	const history_map* log = &history->log;
+	if (entry->offset > log->length || log->length - entry->offset < sizeof(history_record_header)) return false;
+
+	history_record_header header;
+	memcpy(&header, log->data + entry->offset, sizeof(header));
+	if (header.magic != HISTORY_RECORD_MAGIC || header.length < sizeof(header) ||
+		header.length > log->length - entry->offset) {
+		return false;
+	}
+
+	const char* fields[HISTORY_FIELD_COUNT];
+	size_t field_offset = sizeof(history_record_header);
+	for (int i = 0; i < HISTORY_FIELD_COUNT; i++) {
+		if (header.field_lengths[i] >= header.length - field_offset) return false;
+
+		fields[i] = log->data + entry->offset + field_offset;
+		if (fields[i][header.field_lengths[i]] != '\0') return false;
+		field_offset += header.field_lengths[i] + 1;
+	}
+
+	// also weeds out index entries padded in after a torn write
+	if (history_hash_id(fields[0]) != entry->id_hash) return false;
+
+	*turn = (chatgpt_cli_history_turn){
+		.id = fields[0],
+		.parent_id = header.has_parent ? fields[1] : NULL,
+		.model = fields[2],
+		.prompt = fields[3],
+		.output = fields[4],
+		.created_at = header.created_at,
+		.first_delta_us = header.first_delta_us,
+		.total_us = header.total_us,
+	};
+	return true;
+}
+
+bool chatgpt_cli_history_get(const chatgpt_cli_history* history, const size_t position,
+                             chatgpt_cli_history_turn* turn) {
+	if (position >= history->count) return false;
+
+	const history_index_entry entry = history_index_entry_at(history, position);
+	return history_read_turn(history, &entry, turn);
+}
+
+static bool history_match(const chatgpt_cli_history* history, const size_t position, const char* id,
+                          const uint64_t id_hash, chatgpt_cli_history_turn* turn) {
+	const history_index_entry entry = history_index_entry_at(history, position);
+	return entry.id_hash == id_hash && history_read_turn(history, &entry, turn) && strcmp(turn->id, id) == 0;
+}
+
+bool chatgpt_cli_history_find(const chatgpt_cli_history* history, const char* id, chatgpt_cli_history_turn* turn) {
+	const uint64_t id_hash = history_hash_id(id);
+	size_t indexed_count = 0;
+
+	history_id_table_header header;
+	if (history->id_table.length >= sizeof(header)) {
+		memcpy(&header, history->id_table.data, sizeof(header));
+		const size_t slots_length = history->id_table.length - sizeof(header);
+		const bool valid = header.magic == HISTORY_ID_TABLE_MAGIC && header.capacity > 0 &&
+			(header.capacity & (header.capacity - 1)) == 0 &&
+			header.capacity <= slots_length / sizeof(history_id_table_slot);
+
+		if (valid) {
+			indexed_count = header.indexed_count < history->count ? header.indexed_count : history->count;
+
+			const history_id_table_slot* slots = (const history_id_table_slot*)(history->id_table.data +
+				sizeof(header));
+			const uint64_t mask = header.capacity - 1;
+			for (uint64_t i = 0; i <= mask; i++) {
+				const history_id_table_slot slot = slots[(id_hash + i) & mask];
+				if (slot == 0) break;
+
+				const size_t position = (size_t)(slot & 0xFFFFFFFF) - 1;
+				if (slot >> 32 == id_hash >> 32 && position < history->count &&
+					history_match(history, position, id, id_hash, turn)) {
+					return true;
+				}
+			}
+		}
+	}
+
+	// appended after the table was last updated (only if a process died in between), newest first
+	for (size_t position = history->count; position > indexed_count; position--) {
+		if (history_match(history, position - 1, id, id_hash, turn)) return true;
+	}
+	return false;
 }
 
 char* chatgpt_cli_history_get_previous_response_id() {
-	FILE* file = chatgpt_cli_history_get_previous_response_id_file("r+"); // read/write
+	chatgpt_cli_history* history = chatgpt_cli_history_open();
+
+	char* id = NULL;
+	chatgpt_cli_history_turn turn;
+	for (size_t position = history->count; position > 0 && !id; position--) {
+		if (chatgpt_cli_history_get(history, position - 1, &turn)) id = strdup(turn.id);
+	}
+	chatgpt_cli_history_close(history);
+	if (id) return id;
+
+	// nothing logged yet, maybe an older version left its last id behind
+	char* path = history_path(CHATGPT_CLI_HISTORY_PREVIOUS_NODE_FILE_NAME);
+	FILE* file = fopen(path, "rb");
+	free(path);
+	if (!file) return NULL;
 
 	fseek(file, 0, SEEK_END);
-	const size_t file_length = ftell(file);
+	const long file_length = ftell(file);
 	fseek(file, 0, SEEK_SET); // back to start
 
-	if (file_length == 0) return NULL;
+	if (file_length > 0) {
+		id = malloc(file_length + 1);
+		const size_t read_length = fread(id, sizeof(char), file_length, file);
+		id[read_length] = '\0'; // fread doesn't automatically null-terminate
+	}
+	fclose(file);
+	return id;
+}
 
-	char* content = malloc(file_length + 1);
-	fread(content, sizeof(char), file_length, file);
-	content[file_length] = '\0'; // fread doesn't automatically null-terminate
+// ---- writing ----
 
-	fclose(file);
-	return content;
+static void history_lock(FILE* file) {
+	#ifdef _WIN32
+	fseek(file, 0, SEEK_SET);
+	_locking(_fileno(file), _LK_LOCK, 1);
+	#else
+	flock(fileno(file), LOCK_EX);
+	#endif
+}
+
+static void history_unlock(FILE* file) {
+	#ifdef _WIN32
+	fseek(file, 0, SEEK_SET);
+	_locking(_fileno(file), _LK_UNLCK, 1);
+	#endif
+	fclose(file); // also drops the flock
+}
+
+static bool history_write_record(const chatgpt_cli_history_turn* turn, uint64_t* offset_out) {
+	char* path = history_path(CHATGPT_CLI_HISTORY_LOG_FILE_NAME);
+	FILE* file = fopen(path, "ab");
+	free(path);
+	if (!file) return false;
+
+	fseek(file, 0, SEEK_END);
+	long offset = ftell(file);
+
+	// a torn record from a process which died mid-write, start after it
+	static const char padding[HISTORY_RECORD_ALIGNMENT] = {0};
+	bool written = true;
+	if (offset % HISTORY_RECORD_ALIGNMENT) {
+		const size_t padding_length = HISTORY_RECORD_ALIGNMENT - offset % HISTORY_RECORD_ALIGNMENT;
+		written = fwrite(padding, 1, padding_length, file) == padding_length;
+		offset += (long)padding_length;
+	}
+
+	const char* fields[HISTORY_FIELD_COUNT] = {
+		turn->id, turn->parent_id ? turn->parent_id : "", turn->model ? turn->model : "", turn->prompt, turn->output
+	};
+
+	history_record_header header = {
+		.magic = HISTORY_RECORD_MAGIC,
+		.length = sizeof(history_record_header),
+		.created_at = turn->created_at,
+		.first_delta_us = turn->first_delta_us,
+		.total_us = turn->total_us,
+		.has_parent = turn->parent_id != NULL,
+	};
+	for (int i = 0; i < HISTORY_FIELD_COUNT; i++) {
+		header.field_lengths[i] = (uint32_t)strlen(fields[i]);
+		header.length += header.field_lengths[i] + 1;
+	}
+	const size_t padding_length = (HISTORY_RECORD_ALIGNMENT - header.length % HISTORY_RECORD_ALIGNMENT) %
+		HISTORY_RECORD_ALIGNMENT;
+	header.length += (uint32_t)padding_length;
+
+	written = written && fwrite(&header, sizeof(header), 1, file) == 1;
+	for (int i = 0; i < HISTORY_FIELD_COUNT; i++) {
+		written = written && fwrite(fields[i], 1, header.field_lengths[i] + 1, file) == header.field_lengths[i] + 1;
+	}
+	written = written && fwrite(padding, 1, padding_length, file) == padding_length;
+
+	*offset_out = (uint64_t)offset;
+	return fclose(file) == 0 && written;
 }
 
-void chatgpt_cli_history_set_previous_response_id(const char* id) {
-	// "w+" acts like read/write but automatically empties the file
-	FILE* file = chatgpt_cli_history_get_previous_response_id_file("w+");
-	fwrite(id, sizeof(char), strlen(id), file);
+// the number of entries in the index afterward, 0 on failure
+static size_t history_write_index_entry(const history_index_entry* entry) {
+	char* path = history_path(CHATGPT_CLI_HISTORY_INDEX_FILE_NAME);
+	FILE* file = fopen(path, "ab");
+	free(path);
+	if (!file) return 0;
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+
+	// a torn entry, pad it out to a whole one. it won't match the record it points to, so it's skipped when read
+	static const char padding[sizeof(history_index_entry)] = {0};
+	const size_t padding_length = (sizeof(history_index_entry) - length % sizeof(history_index_entry)) %
+		sizeof(history_index_entry);
+
+	bool written = fwrite(padding, 1, padding_length, file) == padding_length;
+	written = written && fwrite(entry, sizeof(history_index_entry), 1, file) == 1;
+
+	if (fclose(file) != 0 || !written) return 0;
+	return (length + padding_length) / sizeof(history_index_entry) + 1;
+}
+
+static void history_id_table_insert(history_id_table_slot* slots, const uint64_t capacity, const uint64_t id_hash,
+                                    const size_t position) {
+	const uint64_t mask = capacity - 1;
+	uint64_t slot_position = id_hash & mask;
+	while (slots[slot_position] != 0) slot_position = (slot_position + 1) & mask;
+	slots[slot_position] = (id_hash >> 32 << 32) | (uint64_t)(position + 1);
+}
+
+// writes a fresh table for every index entry next to the old one and swaps it in
+static void history_id_table_rebuild(const history_map* index, const size_t count) {
+	uint64_t capacity = HISTORY_ID_TABLE_MIN_CAPACITY;
+	while (capacity < count * 4) capacity *= 2; // a quarter full, so it takes a while until the next rebuild
+
+	history_id_table_slot* slots = calloc(capacity, sizeof(history_id_table_slot));
+	if (!slots) return;
+
+	for (size_t position = 0; position < count; position++) {
+		history_index_entry entry;
+		memcpy(&entry, index->data + position * sizeof(history_index_entry), sizeof(entry));
+		history_id_table_insert(slots, capacity, entry.id_hash, position);
+	}
+
+	const history_id_table_header header = {
+		.magic = HISTORY_ID_TABLE_MAGIC,
+		.capacity = capacity,
+		.indexed_count = count,
+	};
+
+	char* path = history_path(CHATGPT_CLI_HISTORY_ID_TABLE_FILE_NAME);
+	char* tmp_path = history_path(CHATGPT_CLI_HISTORY_ID_TABLE_FILE_NAME ".tmp");
+	FILE* file = fopen(tmp_path, "wb");
+	if (file) {
+		bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+		written = written && fwrite(slots, sizeof(history_id_table_slot), capacity, file) == capacity;
+		written = fclose(file) == 0 && written;
+
+		#ifdef _WIN32
+		if (written) remove(path); // rename doesn't replace files here, readers fall back to the linear search
+		#endif
+		if (!written || rename(tmp_path, path) != 0) remove(tmp_path);
+	}
+
+	free(tmp_path);
+	free(path);
+	free(slots);
+}
+
+// adds the index entries the table is missing, only called with the lock held
+static void history_id_table_update(const size_t count) {
+	history_map index = history_map_file(CHATGPT_CLI_HISTORY_INDEX_FILE_NAME);
+	if (index.length < count * sizeof(history_index_entry)) {
+		history_unmap(&index);
+		return;
+	}
+
+	char* path = history_path(CHATGPT_CLI_HISTORY_ID_TABLE_FILE_NAME);
+	FILE* file = fopen(path, "r+b");
+	free(path);
+
+	history_id_table_header header = {0};
+	if (file && fread(&header, sizeof(header), 1, file) != 1) header.magic = 0;
+
+	if (!file || header.magic != HISTORY_ID_TABLE_MAGIC || header.indexed_count > count ||
+		count * 2 > header.capacity) {
+		if (file) fclose(file);
+		history_id_table_rebuild(&index, count);
+		history_unmap(&index);
+		return;
+	}
+
+	// usually just the entry which was appended, probed on disk rather than loading the whole table
+	const uint64_t mask = header.capacity - 1;
+	for (size_t position = header.indexed_count; position < count; position++) {
+		history_index_entry entry;
+		memcpy(&entry, index.data + position * sizeof(history_index_entry), sizeof(entry));
+
+		uint64_t slot_position = entry.id_hash & mask;
+		while (true) {
+			history_id_table_slot slot;
+			fseek(file, (long)(sizeof(header) + slot_position * sizeof(slot)), SEEK_SET);
+			if (fread(&slot, sizeof(slot), 1, file) != 1 || slot == 0) break;
+			slot_position = (slot_position + 1) & mask;
+		}
+
+		const history_id_table_slot slot = (entry.id_hash >> 32 << 32) | (uint64_t)(position + 1);
+		fseek(file, (long)(sizeof(header) + slot_position * sizeof(slot)), SEEK_SET);
+		fwrite(&slot, sizeof(slot), 1, file);
+	}
+
+	header.indexed_count = count;
+	fseek(file, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, file);
 	fclose(file);
+
+	history_unmap(&index);
+}
+
+bool chatgpt_cli_history_append(const chatgpt_cli_history_turn* turn) {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	r_mkdir(app_folder);
+	free(app_folder);
+
+	char* lock_path = history_path(HISTORY_LOCK_FILE_NAME);
+	FILE* lock_file = fopen(lock_path, "ab");
+	free(lock_path);
+	if (!lock_file) return false;
+	history_lock(lock_file);
+
+	// record before index entry, so readers never see an entry for a record which isn't there yet
+	history_index_entry entry = {.id_hash = history_hash_id(turn->id)};
+	const bool written = history_write_record(turn, &entry.offset);
+	const size_t count = written ? history_write_index_entry(&entry) : 0;
+	if (count > 0) history_id_table_update(count);
+
+	history_unlock(lock_file);
+	return count > 0;
 }
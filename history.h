@@ -4,14 +4,52 @@
 
 #ifndef HISTORY_H
 #define HISTORY_H
-#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-// name of the file which specifies the path of the last history node created
+// every turn, appended one after another and never rewritten
+#define CHATGPT_CLI_HISTORY_LOG_FILE_NAME "history.log"
+
+// fixed size entry per turn pointing into the log, in the same order
+#define CHATGPT_CLI_HISTORY_INDEX_FILE_NAME "history.idx"
+
+// hash table from response id to index entry
+#define CHATGPT_CLI_HISTORY_ID_TABLE_FILE_NAME "history.ids"
+
+// where older versions kept the last response id, still read if the log is empty
 #define CHATGPT_CLI_HISTORY_PREVIOUS_NODE_FILE_NAME ".prev"
 
-// if file doesn't exist after trying with the given, mode defaults to w+
-FILE* chatgpt_cli_history_get_previous_response_id_file(const char* mode);
+// one request and its response. when read from the history, strings are borrowed from it (and NUL-terminated)
+typedef struct {
+	const char* id;
+	const char* parent_id; // previous_response_id of the request, NULL if it started a conversation
+	const char* model;
+	const char* prompt;
+	const char* output;
+	int64_t created_at; // unix time
+	int64_t first_delta_us; // -1 if nothing was streamed
+	int64_t total_us;
+} chatgpt_cli_history_turn;
+
+// the log mapped into memory, a snapshot of the turns at the time it was opened
+typedef struct chatgpt_cli_history chatgpt_cli_history;
+
+// never NULL, an empty history is returned if nothing was logged yet
+chatgpt_cli_history* chatgpt_cli_history_open();
+void chatgpt_cli_history_close(chatgpt_cli_history* history);
+
+size_t chatgpt_cli_history_count(const chatgpt_cli_history* history);
+
+// position 0 is the oldest turn, false if it's out of range (or the log is damaged there)
+bool chatgpt_cli_history_get(const chatgpt_cli_history* history, size_t position, chatgpt_cli_history_turn* turn);
+
+// false if no turn has that id
+bool chatgpt_cli_history_find(const chatgpt_cli_history* history, const char* id, chatgpt_cli_history_turn* turn);
+
+// appends a turn, safe to call from many processes at once. false if it couldn't be written
+bool chatgpt_cli_history_append(const chatgpt_cli_history_turn* turn);
 
+// id of the last turn, NULL if there is none (caller frees)
 char* chatgpt_cli_history_get_previous_response_id();
-void chatgpt_cli_history_set_previous_response_id(const char* id);
 #endif //HISTORY_H
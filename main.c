@@ -1,20 +1,97 @@
 #include "main.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <getopt.h>
 #include <string.h>
-#include <json-c/json_tokener.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <json-c/json.h>
 
+#include "cache.h"
 #include "config.h"
+#include "connection.h"
+#include "daemon.h"
+#include "fanout.h"
 #include "history.h"
 #include "openai-wrapper.h"
+#include "output.h"
+#include "search.h"
+#include "stats.h"
+#include "tokenizer.h"
 #include "curl/curl.h"
 #include "version.h"
 
 #define ENV_API_KEY "CHATGPT_CLI_API_KEY"
+#define ENV_API_URL "CHATGPT_CLI_API_URL"
 #define CHATGPT_CLI_PROGRAM_NAME "chatgpt-cli"
 
+// turns listed by --log without a count
+#define CHATGPT_CLI_HISTORY_LOG_DEFAULT_COUNT 20
+
+// results listed by --search
+#define CHATGPT_CLI_SEARCH_DEFAULT_RESULT_COUNT 10
+
+// --hedge without a deadline waits for the model's p95 time to first delta, once it has this many samples. until
+// then it waits CHATGPT_CLI_HEDGE_DEFAULT_MS
+#define CHATGPT_CLI_HEDGE_MIN_SAMPLES 20
+#define CHATGPT_CLI_HEDGE_DEFAULT_MS 2000
+
+// options without a short form
+enum {
+	CHATGPT_CLI_OPTION_CACHE = 256, // past any char
+	CHATGPT_CLI_OPTION_NO_CACHE,
+	CHATGPT_CLI_OPTION_CACHE_ONLY,
+	CHATGPT_CLI_OPTION_CACHE_STATS,
+	CHATGPT_CLI_OPTION_SEARCH,
+	CHATGPT_CLI_OPTION_API_URL,
+	CHATGPT_CLI_OPTION_TIMINGS,
+	CHATGPT_CLI_OPTION_STATS,
+	CHATGPT_CLI_OPTION_TRANSCRIPT,
+	CHATGPT_CLI_OPTION_JSONL,
+	CHATGPT_CLI_OPTION_HEDGE,
+	CHATGPT_CLI_OPTION_COUNT_TOKENS,
+	CHATGPT_CLI_OPTION_MAX_INPUT_TOKENS,
+};
+
+#define SHORT_OPTIONS "m:k:i:t:T:r::RhvH::l::s:b:P:dDf:a:"
+
+static const struct option long_options[] = {
+	{"model", required_argument, 0, 'm'},
+	{"key", required_argument, 0, 'k'},
+	{"instructions", required_argument, 0, 'i'},
+	{"temperature", required_argument, 0, 't'},
+	{"max-tokens", required_argument, 0, 'T'},
+	{"raw", optional_argument, 0, 'r'},
+	{"help", no_argument, 0, 'h'},
+	{"version", no_argument, 0, 'v'},
+	{"history", optional_argument, 0, 'H'},
+	{"response-id", no_argument, 0, 'R'},
+	{"log", optional_argument, 0, 'l'},
+	{"show", required_argument, 0, 's'},
+	{"search", required_argument, 0, CHATGPT_CLI_OPTION_SEARCH},
+	{"batch", required_argument, 0, 'b'},
+	{"parallel", required_argument, 0, 'P'},
+	{"daemon", no_argument, 0, 'd'},
+	{"no-daemon", no_argument, 0, 'D'},
+	{"cache", no_argument, 0, CHATGPT_CLI_OPTION_CACHE},
+	{"no-cache", no_argument, 0, CHATGPT_CLI_OPTION_NO_CACHE},
+	{"cache-only", no_argument, 0, CHATGPT_CLI_OPTION_CACHE_ONLY},
+	{"cache-stats", no_argument, 0, CHATGPT_CLI_OPTION_CACHE_STATS},
+	{"api-url", required_argument, 0, CHATGPT_CLI_OPTION_API_URL},
+	{"timings", optional_argument, 0, CHATGPT_CLI_OPTION_TIMINGS},
+	{"stats", optional_argument, 0, CHATGPT_CLI_OPTION_STATS},
+	{"transcript", required_argument, 0, CHATGPT_CLI_OPTION_TRANSCRIPT},
+	{"jsonl", required_argument, 0, CHATGPT_CLI_OPTION_JSONL},
+	{"input-file", required_argument, 0, 'f'},
+	{"attach", required_argument, 0, 'a'},
+	{"hedge", optional_argument, 0, CHATGPT_CLI_OPTION_HEDGE},
+	{"count-tokens", no_argument, 0, CHATGPT_CLI_OPTION_COUNT_TOKENS},
+	{"max-input-tokens", required_argument, 0, CHATGPT_CLI_OPTION_MAX_INPUT_TOKENS},
+	{0, 0, 0, 0}
+};
+
 static void print_help() {
 	printf("Usage: %s [OPTIONS] PROMPT...\n", CHATGPT_CLI_PROGRAM_NAME);
 	printf("\n");
@@ -23,17 +100,54 @@ static void print_help() {
 	printf("  -m, --model MODEL          OpenAI model to use (overrides 'model' config option)\n");
 	printf("\n");
 	printf("Optional:\n");
-	printf("  -H, --history [ID]         Specify an OpenAI previous_response_id (default is last output)\n");
+	printf("  -H, --history [ID]         Continue from a previous response, any from --log (default is last output)\n");
 	printf("  -R, --response-id          Print the response id after completion (use with -H later)\n");
+	printf("  -l, --log[=N]              List the last N requests in the history (default 20), then exit\n");
+	printf("  -s, --show ID              Show the conversation leading up to a response in the history, then exit\n");
+	printf("      --search QUERY         Find past requests and responses in the history by their words, then exit\n");
+	printf("  -f, --input-file FILE      Send the contents of FILE (- for stdin) as the prompt, after any PROMPT words.\n");
+	printf("                             A lone - as the PROMPT reads it from stdin too\n");
+	printf("  -a, --attach FILE          Send FILE along with the prompt, as an image for PNG, JPEG, GIF and WebP files\n");
+	printf("                             and as a file otherwise. Can be given more than once\n");
 	printf("  -i, --instructions TEXT    System instructions for the model (overrides 'instructions' config option)\n");
 	printf("  -t, --temperature DOUBLE   Sampling temperature for the model, must be in [0,2] (overrides 'temperature' config option)\n");
 	printf("  -T, --max-tokens UINT64    Upper bound for output tokens in the response (overrides 'max-tokens' config option)\n");
-	printf("  -r, --raw                  Print raw JSON response instead of parsed text\n");
+	printf("  -r, --raw[=stream]         Print the raw JSON response instead of parsed text. With stream, print the data\n");
+	printf("                             of every event as one JSON line as soon as it arrives\n");
+	printf("  -b, --batch FILE           Send each line of FILE (- for stdin) as its own request over one connection.\n");
+	printf("                             Lines are JSON objects with any of: input, model, instructions, temperature,\n");
+	printf("                             max_tokens, previous_response_id. Results are printed as JSON lines.\n");
+	printf("  -P, --parallel N           With --batch, keep up to N requests in flight, paced by the API's rate limits\n");
+	printf("  -d, --daemon               Keep warm API connections open and serve requests from other invocations.\n");
+	printf("                             Use --parallel to change how many connections are kept (default %d)\n",
+	       CHATGPT_CLI_DAEMON_DEFAULT_POOL_SIZE);
+	printf("  -D, --no-daemon            Connect to the API directly even if a daemon is running\n");
+	printf("      --cache                Replay responses to requests which were sent before, cache new ones\n");
+	printf("      --no-cache             Always send the request (overrides 'cache' config option)\n");
+	printf("      --cache-only           Only replay cached responses, fail if the request isn't cached\n");
+	printf("      --cache-stats          Show response cache hits, misses and size, then exit\n");
+	printf("      --timings[=json]       Print how long each part of the request took to stderr (DNS, connect, TLS,\n");
+	printf("                             first byte, first delta, gaps between deltas, parsing), as text or one JSON line\n");
+	printf("      --stats[=MODEL]        Show latency percentiles of past requests per model, then exit\n");
+	printf("      --transcript FILE      Also append the prompt and response to FILE as text\n");
+	printf("      --jsonl FILE           Also append every delta of the response to FILE as a JSON line, with when it\n");
+	printf("                             arrived\n");
+	printf("      --hedge[=MS|off]       If no text has arrived MS after sending the request (default: the model's p95\n");
+	printf("                             time to first delta in --stats), send it again and keep whichever answers\n");
+	printf("                             first (overrides 'hedge' config option)\n");
+	printf("      --count-tokens         Print how many tokens the prompt, instructions and text attachments are for\n");
+	printf("                             the model, counted locally, then exit without sending anything\n");
+	printf("      --max-input-tokens N   Refuse to send a prompt of more than N tokens, counted the same way\n");
+	printf("                             (overrides 'max-input-tokens' config option)\n");
+	printf("      --api-url URL          Send requests to URL instead of the OpenAI Responses API, e.g. a local mock\n");
+	printf("                             server (overrides %s env variable and 'api-url' config option)\n",
+	       ENV_API_URL);
 	printf("  -h, --help                 Show this help message and exit\n");
 	printf("  -v, --version              Show program version\n");
 	printf("\n");
 	printf("Environment:\n");
 	printf("  %s  API key if not provided with --key\n", ENV_API_KEY);
+	printf("  %s  Responses API endpoint if not provided with --api-url\n", ENV_API_URL);
 	printf("\n");
 
 	char* config_path = chatgpt_cli_config_get_config_path();
@@ -43,34 +157,970 @@ static void print_help() {
 		printf("  Keys in the config file can include 'model' and 'instructions',\n");
 		printf("  which are used if not provided via command-line or environment.\n");
 		printf("  Each key is stored as KEY=VALUE on a separate line. Use | to escape newlines.\n");
+		printf("  'cache=true' turns on the response cache, 'cache-max-size' caps it in MiB (default %d).\n",
+		       CHATGPT_CLI_CACHE_DEFAULT_MAX_SIZE_MIB);
+		printf("  'hedge=true' (or a deadline in ms) hedges every request, see --hedge.\n");
+		printf("  'connection-cache=false' stops remembering the API's address (and TLS sessions) between runs.\n");
 		printf("\n");
 		free(config_path);
+
+		char* app_folder = chatgpt_cli_config_get_app_folder();
+		printf("Token counting:\n");
+		printf("  --count-tokens and --max-input-tokens need the model's encoding in\n");
+		printf("  %s%c%s, e.g. o200k_base.tiktoken from\n", app_folder, PATH_SEPARATOR,
+		       CHATGPT_CLI_TOKENIZER_FOLDER_NAME);
+		printf("  %so200k_base.tiktoken (cl100k_base for gpt-4 and gpt-3.5).\n", CHATGPT_CLI_TOKENIZER_DOWNLOAD_URL);
+		printf("\n");
+		free(app_folder);
+	}
+}
+
+typedef struct {
+	char* text;
+	size_t length;
+	size_t capacity;
+
+	struct timespec start;
+	int64_t first_delta_us; // < 0 until the first delta arrives
+
+	char* timings; // JSON object, NULL if the request didn't go to the API (or didn't ask for timings)
+} stream_output;
+
+static int64_t stream_elapsed_us(const struct timespec* start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)(now.tv_sec - start->tv_sec) * 1000000 + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+static void openai_stream_callback_collect(const openai_delta_type type, const char* delta, const size_t length,
+                                           void* user_data) {
+	stream_output* output = user_data;
+	if (type == OPENAI_DELTA_TIMINGS) {
+		free(output->timings);
+		output->timings = openai_delta_copy(delta, length);
+		return;
+	}
+	if (type != OPENAI_DELTA_OUTPUT_TEXT && type != OPENAI_DELTA_REFUSAL && type != OPENAI_DELTA_RAW_RESPONSE) return;
+
+	if (output->first_delta_us < 0) {
+		output->first_delta_us = stream_elapsed_us(&output->start);
+	}
+
+	if (output->length + length + 1 > output->capacity) {
+		size_t new_capacity = output->capacity ? output->capacity : 256;
+		while (new_capacity < output->length + length + 1) new_capacity *= 2;
+
+		char* new_text = realloc(output->text, new_capacity);
+		if (new_text == NULL) {
+			fprintf(stderr, "Memory allocation failed!\n");
+			exit(EXIT_FAILURE);
+		}
+		output->text = new_text;
+		output->capacity = new_capacity;
+	}
+
+	memcpy(output->text + output->length, delta, length);
+	output->length += length;
+	output->text[output->length] = '\0';
+}
+
+static void openai_stream_callback_print(const openai_delta_type type, const char* delta, const size_t length,
+                                         void* user_data) {
+	switch (type) {
+	case OPENAI_DELTA_OUTPUT_TEXT:
+	case OPENAI_DELTA_REFUSAL:
+	case OPENAI_DELTA_RAW_RESPONSE:
+		chatgpt_cli_output_write(delta, length);
+		openai_stream_callback_collect(type, delta, length, user_data); // for the history
+		break;
+	case OPENAI_DELTA_REASONING_SUMMARY:
+		// keep stdout to the answer itself
+		fprintf(stderr, "%.*s", (int)length, delta);
+		break;
+	case OPENAI_DELTA_FUNCTION_CALL_ARGUMENTS:
+		break; // no tools are ever offered to the model
+	case OPENAI_DELTA_RESPONSE_ID:
+		printf("# Response ID: %.*s\n", (int)length, delta);
+		chatgpt_cli_output_flush(); // deltas may be a while yet
+		break;
+	case OPENAI_DELTA_TIMINGS:
+		openai_stream_callback_collect(type, delta, length, user_data); // printed once the output is done
+		break;
+	case OPENAI_DELTA_RAW_EVENT:
+		// NDJSON, not kept for the history: it's every event of the response
+		chatgpt_cli_output_write(delta, length);
+		chatgpt_cli_output_write("\n", 1);
+		break;
+	case OPENAI_DELTA_FLUSH:
+		chatgpt_cli_output_idle();
+		break;
+	}
+}
+
+// --transcript, the response's text as it's printed
+static void transcript_sink(const openai_delta_type type, const char* delta, const size_t length, void* user_data) {
+	if (type == OPENAI_DELTA_OUTPUT_TEXT || type == OPENAI_DELTA_REFUSAL) fwrite(delta, 1, length, user_data);
+}
+
+static const char* const delta_type_names[] = {
+	[OPENAI_DELTA_OUTPUT_TEXT] = "output_text",
+	[OPENAI_DELTA_REFUSAL] = "refusal",
+	[OPENAI_DELTA_REASONING_SUMMARY] = "reasoning_summary",
+	[OPENAI_DELTA_FUNCTION_CALL_ARGUMENTS] = "function_call_arguments",
+	[OPENAI_DELTA_RAW_RESPONSE] = "raw_response",
+	[OPENAI_DELTA_RESPONSE_ID] = "response_id",
+	[OPENAI_DELTA_TIMINGS] = "timings",
+	[OPENAI_DELTA_FLUSH] = "flush",
+	[OPENAI_DELTA_RAW_EVENT] = "raw_event",
+};
+
+typedef struct {
+	FILE* file;
+	const struct timespec* start;
+} jsonl_sink_data;
+
+// --jsonl, one line per delta: {"us":...,"type":"output_text","delta":"..."}, timings as an object
+static void jsonl_sink(const openai_delta_type type, const char* delta, const size_t length, void* user_data) {
+	const jsonl_sink_data* data = user_data;
+	if (type == OPENAI_DELTA_FLUSH) return;
+
+	fprintf(data->file, "{\"us\":%lld,\"type\":\"%s\",", (long long)stream_elapsed_us(data->start),
+	        delta_type_names[type]);
+	if (type == OPENAI_DELTA_TIMINGS) {
+		fprintf(data->file, "\"timings\":%.*s}\n", (int)length, delta);
+		return;
 	}
+
+	json_object* delta_json = json_object_new_string_len(delta, (int)length);
+	fprintf(data->file, "\"delta\":%s}\n", json_object_to_json_string_ext(delta_json, JSON_C_TO_STRING_PLAIN |
+	                                                                   JSON_C_TO_STRING_NOSLASHESCAPE));
+	json_object_put(delta_json);
 }
 
-static void openai_stream_callback_print(const char* delta, const size_t length, void* user_data) {
-	fprintf(stdout, "%.*s", (int)length, delta);
+static FILE* sink_file_open(const char* path) {
+	FILE* file = fopen(path, "ab");
+	if (!file) {
+		fprintf(stderr, "Unable to open %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+	return file;
+}
+
+// one line of the timings report, skipped if the request never got that far
+static void timings_print_line(json_object* timings, const char* label, const char* key) {
+	json_object* value;
+	if (!json_object_object_get_ex(timings, key, &value)) return;
+	fprintf(stderr, "  %-16s %10.3f ms\n", label, (double)json_object_get_int64(value) / 1000);
+}
+
+static int64_t timings_get(json_object* timings, const char* key) {
+	json_object* value;
+	return json_object_object_get_ex(timings, key, &value) ? json_object_get_int64(value) : -1;
+}
+
+static void timings_print(const char* timings_json, const chatgpt_cli_timings_format format) {
+	if (format == CHATGPT_CLI_TIMINGS_OFF) return;
+	if (!timings_json) {
+		fprintf(stderr, "No timings, nothing was sent to the API (replayed from the cache?)\n");
+		return;
+	}
+
+	if (format == CHATGPT_CLI_TIMINGS_JSON) {
+		fprintf(stderr, "%s\n", timings_json);
+		return;
+	}
+
+	json_object* timings = json_tokener_parse(timings_json);
+	if (!timings) return;
+
+	fprintf(stderr, "\nTimings:\n");
+	timings_print_line(timings, "DNS", "dns_us");
+	timings_print_line(timings, "Connect", "connect_us");
+	timings_print_line(timings, "TLS", "tls_us");
+	timings_print_line(timings, "First byte", "ttfb_us");
+	timings_print_line(timings, "Created", "created_us");
+	timings_print_line(timings, "First delta", "first_delta_us");
+	timings_print_line(timings, "Total", "total_us");
+	if (timings_get(timings, "hedge_us") >= 0) {
+		fprintf(stderr, "  %-16s %10.3f ms, %s\n", "Hedge sent", (double)timings_get(timings, "hedge_us") / 1000,
+		        timings_get(timings, "hedge_won") == 1 ? "won" : "lost");
+	}
+	if (timings_get(timings, "warmup_us") >= 0) {
+		// opened while the request was being put together, only what was still left by then held it up
+		fprintf(stderr, "  %-16s %10.3f ms, %.3f ms of it hidden\n", "Warm-up",
+		        (double)timings_get(timings, "warmup_us") / 1000,
+		        (double)timings_get(timings, "warmup_hidden_us") / 1000);
+	}
+	if (timings_get(timings, "delta_gap_max_us") >= 0) {
+		fprintf(stderr, "  %-16s p50 %.3f ms, p95 %.3f ms, max %.3f ms\n", "Delta gaps",
+		        (double)timings_get(timings, "delta_gap_p50_us") / 1000,
+		        (double)timings_get(timings, "delta_gap_p95_us") / 1000,
+		        (double)timings_get(timings, "delta_gap_max_us") / 1000);
+	}
+	fprintf(stderr, "  %-16s %lld deltas in %lld events, %.1f KiB\n", "Received",
+	        (long long)timings_get(timings, "deltas"), (long long)timings_get(timings, "events"),
+	        (double)timings_get(timings, "bytes") / 1024);
+	timings_print_line(timings, "Parser CPU", "parser_cpu_us");
+	if (timings_get(timings, "output_tokens") >= 0) {
+		fprintf(stderr, "  %-16s %lld in, %lld out\n", "Tokens", (long long)timings_get(timings, "input_tokens"),
+		        (long long)timings_get(timings, "output_tokens"));
+	}
+
+	json_object_put(timings);
+}
+
+// adds a completed request to the history, so it can be listed, shown and continued from later
+static void history_record(const openai_request* request, const char* response_id, const stream_output* output,
+                           const int64_t total_us) {
+	if (!response_id) return;
+
+	// replayed from the response cache, it's already there
+	chatgpt_cli_history* history = chatgpt_cli_history_open();
+	chatgpt_cli_history_turn existing;
+	const bool logged = chatgpt_cli_history_find(history, response_id, &existing);
+	chatgpt_cli_history_close(history);
+	if (logged) return;
+
+	const chatgpt_cli_history_turn turn = {
+		.id = response_id,
+		.parent_id = request->previous_response_id,
+		.model = request->model,
+		.prompt = request->input,
+		.output = output->text ? output->text : "",
+		.created_at = time(NULL),
+		.first_delta_us = output->first_delta_us,
+		.total_us = total_us,
+	};
+	if (!chatgpt_cli_history_append(&turn)) {
+		fprintf(stderr, "\nUnable to write history!\n");
+		return;
+	}
+
+	// the stream is over by now, so indexing it doesn't hold anything up
+	history = chatgpt_cli_history_open();
+	chatgpt_cli_search_update(history);
+	chatgpt_cli_history_close(history);
+}
+
+// adds a completed request to the model's latency histograms, for --stats
+static void stats_record(const openai_request* request, const stream_output* output) {
+	json_object* timings = output->timings ? json_tokener_parse(output->timings) : NULL;
+	if (!timings) return; // replayed from the response cache, nothing was measured
+
+	chatgpt_cli_stats_sample sample;
+	sample.values[CHATGPT_CLI_STATS_TTFB] = timings_get(timings, "ttfb_us");
+	sample.values[CHATGPT_CLI_STATS_FIRST_DELTA] = timings_get(timings, "first_delta_us");
+	sample.values[CHATGPT_CLI_STATS_TOTAL] = timings_get(timings, "total_us");
+
+	// generation speed, once the first delta is out of the way
+	const int64_t output_tokens = timings_get(timings, "output_tokens");
+	const int64_t first_delta_us = sample.values[CHATGPT_CLI_STATS_FIRST_DELTA];
+	const int64_t generation_us = sample.values[CHATGPT_CLI_STATS_TOTAL] - first_delta_us;
+	sample.values[CHATGPT_CLI_STATS_TOKENS_PER_SECOND] = output_tokens > 0 && first_delta_us >= 0 && generation_us > 0
+		? (int64_t)((double)output_tokens * 1e9 / (double)generation_us) : -1;
+
+	// what became of the hedge, if it was hedged
+	if (request->hedge_after_us <= 0) sample.hedge = CHATGPT_CLI_STATS_HEDGE_OFF;
+	else if (timings_get(timings, "hedge_us") < 0) sample.hedge = CHATGPT_CLI_STATS_HEDGE_NOT_SENT;
+	else if (timings_get(timings, "hedge_won") == 1) sample.hedge = CHATGPT_CLI_STATS_HEDGE_WON;
+	else sample.hedge = CHATGPT_CLI_STATS_HEDGE_LOST;
+
+	json_object_put(timings);
+	chatgpt_cli_stats_record(request->model, &sample);
+}
+
+// one row of a --stats table
+static void stats_print_row(const char* label, const chatgpt_cli_stats_summary* summary, const double scale) {
+	if (summary->count == 0) return;
+	printf("  %-12s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", label, (double)summary->p50 / scale,
+	       (double)summary->p90 / scale, (double)summary->p99 / scale, (double)summary->p999 / scale,
+	       (double)summary->max / scale, summary->mean / scale);
+}
+
+typedef struct {
+	const char* model; // NULL for every model
+	size_t printed;
+} stats_print_data;
+
+static void stats_print_model(const char* model, const chatgpt_cli_stats_summary* summaries,
+                              const chatgpt_cli_stats_hedges* hedges, void* user_data) {
+	stats_print_data* data = user_data;
+	if (data->model && strcmp(model, data->model) != 0) return;
+
+	if (data->printed++ == 0) printf("Times in ms, tokens/s after the first delta\n\n");
+	printf("%s, %llu requests\n", model, (unsigned long long)summaries[CHATGPT_CLI_STATS_TOTAL].count);
+	printf("  %-12s %10s %10s %10s %10s %10s %10s\n", "", "p50", "p90", "p99", "p99.9", "max", "mean");
+	stats_print_row("First byte", &summaries[CHATGPT_CLI_STATS_TTFB], 1000);
+	stats_print_row("First delta", &summaries[CHATGPT_CLI_STATS_FIRST_DELTA], 1000);
+	stats_print_row("Total", &summaries[CHATGPT_CLI_STATS_TOTAL], 1000);
+	stats_print_row("Tokens/s", &summaries[CHATGPT_CLI_STATS_TOKENS_PER_SECOND], 1000);
+	if (hedges->armed > 0) {
+		printf("  Hedged %llu requests, sent a hedge for %llu (%.1f%%), the hedge won %llu (%.1f%% of those sent)\n",
+		       (unsigned long long)hedges->armed, (unsigned long long)hedges->sent,
+		       100.0 * (double)hedges->sent / (double)hedges->armed, (unsigned long long)hedges->won,
+		       hedges->sent ? 100.0 * (double)hedges->won / (double)hedges->sent : 0.0);
+	}
+	printf("\n");
+}
+
+// percentile tables of every model (or just one), returns the exit code
+static int stats_print(const char* model) {
+	stats_print_data data = {.model = model};
+	chatgpt_cli_stats_for_each(stats_print_model, &data);
+	if (data.printed == 0) {
+		if (model) fprintf(stderr, "No requests to %s recorded yet\n", model);
+		else fprintf(stderr, "No requests recorded yet\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// how long --hedge waits for the first delta before sending the request again, in microseconds
+static int64_t hedge_deadline_us(const char* model, const int64_t hedge_ms) {
+	if (hedge_ms > 0) return hedge_ms * 1000;
+
+	chatgpt_cli_stats_summary summaries[CHATGPT_CLI_STATS_METRIC_COUNT];
+	if (model && chatgpt_cli_stats_get(model, summaries) &&
+		summaries[CHATGPT_CLI_STATS_FIRST_DELTA].count >= CHATGPT_CLI_HEDGE_MIN_SAMPLES) {
+		return summaries[CHATGPT_CLI_STATS_FIRST_DELTA].p95;
+	}
+	return CHATGPT_CLI_HEDGE_DEFAULT_MS * 1000;
+}
+
+// most recent turns, oldest first so the latest ends up right above the prompt
+static void history_print_log(const size_t count) {
+	chatgpt_cli_history* history = chatgpt_cli_history_open();
+	const size_t total = chatgpt_cli_history_count(history);
+
+	for (size_t position = count < total ? total - count : 0; position < total; position++) {
+		chatgpt_cli_history_turn turn;
+		if (!chatgpt_cli_history_get(history, position, &turn)) continue;
+
+		char date[32];
+		const time_t created_at = (time_t)turn.created_at;
+		strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&created_at));
+
+		// first line of the prompt, cut short without splitting a UTF-8 character
+		size_t preview_length = strcspn(turn.prompt, "\r\n");
+		const bool cut = preview_length > 60 || turn.prompt[preview_length] != '\0';
+		if (preview_length > 60) {
+			preview_length = 60;
+			while (preview_length > 0 && (turn.prompt[preview_length] & 0xC0) == 0x80) preview_length--;
+		}
+
+		printf("%s  %s  %-16s %.*s%s\n", turn.id, date, turn.model, (int)preview_length, turn.prompt,
+		       cut ? "..." : "");
+	}
+
+	chatgpt_cli_history_close(history);
+}
+
+// the conversation leading up to a turn, returns the exit code
+static int history_print_thread(const char* id) {
+	chatgpt_cli_history* history = chatgpt_cli_history_open();
+
+	// walk up to the first turn of the conversation, the history can't contain cycles but a broken one mustn't hang
+	const size_t max_depth = chatgpt_cli_history_count(history);
+	chatgpt_cli_history_turn* thread = malloc((max_depth + 1) * sizeof(chatgpt_cli_history_turn));
+	size_t depth = 0;
+	const char* next_id = id;
+	while (next_id && depth < max_depth && chatgpt_cli_history_find(history, next_id, &thread[depth])) {
+		next_id = thread[depth++].parent_id;
+	}
+
+	if (depth == 0) {
+		fprintf(stderr, "No response with id %s in the history. Use --log to list them.\n", id);
+		free(thread);
+		chatgpt_cli_history_close(history);
+		return EXIT_FAILURE;
+	}
+
+	if (next_id) printf("# Continues %s, which isn't in the history\n\n", next_id);
+
+	for (size_t i = depth; i > 0; i--) {
+		const chatgpt_cli_history_turn* turn = &thread[i - 1];
+
+		char date[32];
+		const time_t created_at = (time_t)turn->created_at;
+		strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&created_at));
+		printf("# %s (%s, %s, %.2fs)\n", turn->id, turn->model, date, (double)turn->total_us / 1e6);
+
+		// quote the prompt, line by line
+		const char* line = turn->prompt;
+		while (true) {
+			const size_t line_length = strcspn(line, "\n");
+			printf("> %.*s\n", (int)line_length, line);
+			if (line[line_length] == '\0') break;
+			line += line_length + 1;
+		}
+		printf("\n%s\n\n", turn->output);
+	}
+
+	free(thread);
+	chatgpt_cli_history_close(history);
+	return EXIT_SUCCESS;
+}
+
+typedef struct {
+	const uint64_t* query_hashes;
+	size_t query_count;
+	const char* match; // first word of the text which is in the query
+} search_snippet_match;
+
+static void search_snippet_find(const char* term, const size_t length, const uint64_t hash, void* user_data) {
+	(void)length;
+	search_snippet_match* match = user_data;
+	if (match->match) return;
+	for (size_t i = 0; i < match->query_count; i++) {
+		if (match->query_hashes[i] == hash) match->match = term;
+	}
+}
+
+static void search_query_collect(const char* term, const size_t length, const uint64_t hash, void* user_data) {
+	(void)term;
+	(void)length;
+	uint64_t** hashes = user_data;
+	**hashes = hash;
+	(*hashes)++;
+}
+
+// a line of text around the first word of the query, from the output if it's in there
+static void search_print_snippet(const chatgpt_cli_history_turn* turn, const uint64_t* query_hashes,
+                                 const size_t query_count) {
+	search_snippet_match match = {.query_hashes = query_hashes, .query_count = query_count};
+	const char* text = turn->output;
+	chatgpt_cli_search_terms(text, search_snippet_find, &match);
+	if (!match.match) {
+		text = turn->prompt;
+		chatgpt_cli_search_terms(text, search_snippet_find, &match);
+	}
+
+	const size_t text_length = strlen(text);
+	const char* start = match.match && match.match - text > 40 ? match.match - 40 : text;
+	while (start > text && (*start & 0xC0) == 0x80) start--; // don't split a UTF-8 character
+	size_t length = text_length - (start - text);
+	if (length > 120) {
+		length = 120;
+		while (length > 0 && (start[length] & 0xC0) == 0x80) length--;
+	}
+
+	printf("    %s", start > text ? "..." : "");
+	for (size_t i = 0; i < length; i++) {
+		putchar(start[i] == '\n' || start[i] == '\r' || start[i] == '\t' ? ' ' : start[i]); // keep it to one line
+	}
+	printf("%s\n", start + length < text + text_length ? "..." : "");
+}
+
+// ranked turns of the history matching the query, returns the exit code
+static int search_print_results(const char* query) {
+	chatgpt_cli_history* history = chatgpt_cli_history_open();
+
+	chatgpt_cli_search_result* results;
+	const size_t result_count = chatgpt_cli_search(history, query, CHATGPT_CLI_SEARCH_DEFAULT_RESULT_COUNT, &results);
+
+	// the query's words again, to find them in each result
+	uint64_t* query_hashes = malloc((strlen(query) + 1) * sizeof(uint64_t)); // can't have more words than chars
+	uint64_t* query_hashes_end = query_hashes;
+	chatgpt_cli_search_terms(query, search_query_collect, &query_hashes_end);
+
+	for (size_t i = 0; i < result_count; i++) {
+		chatgpt_cli_history_turn turn;
+		if (!chatgpt_cli_history_get(history, results[i].position, &turn)) continue;
+
+		char date[32];
+		const time_t created_at = (time_t)turn.created_at;
+		strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&created_at));
+		printf("%s  %s  %s\n", turn.id, date, turn.model);
+		search_print_snippet(&turn, query_hashes, query_hashes_end - query_hashes);
+	}
+
+	free(query_hashes);
+	free(results);
+	chatgpt_cli_history_close(history);
+	if (result_count == 0) {
+		fprintf(stderr, "Nothing in the history matches %s\n", query);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+static char* batch_strdup_or_null(const char* str) {
+	return str ? strdup(str) : NULL;
+}
+
+// request for one batch line, anything the line doesn't set comes from the command line/config
+static openai_request* batch_request_from_json(const openai_request* defaults, json_object* line_json) {
+	openai_request* request = malloc(sizeof(openai_request));
+	*request = *defaults;
+	request->raw = OPENAI_RAW_OFF; // results are always collected as text
+	request->echo_response_id = false; // the id is part of each result anyway
+	request->api_key = NULL; // the session already has it
+	request->attachments = NULL; // they belong to the prompt on the command line, not the batch
+	request->attachment_count = 0;
+
+	json_object* value;
+	#define BATCH_STRING_FIELD(field) \
+		request->field = batch_strdup_or_null(json_object_object_get_ex(line_json, #field, &value) \
+			? json_object_get_string(value) : defaults->field)
+
+	BATCH_STRING_FIELD(input);
+	BATCH_STRING_FIELD(model);
+	BATCH_STRING_FIELD(instructions);
+	BATCH_STRING_FIELD(previous_response_id);
+
+	#undef BATCH_STRING_FIELD
+
+	if (json_object_object_get_ex(line_json, "temperature", &value)) {
+		request->temperature = json_object_get_double(value);
+	}
+	if (json_object_object_get_ex(line_json, "max_tokens", &value)) {
+		request->max_tokens = json_object_get_uint64(value);
+	}
+
+	return request;
+}
+
+// checks that would otherwise happen during option parsing, NULL if the request can be sent
+static const char* batch_request_validate(const openai_request* request) {
+	if (!request->input || request->input[0] == '\0') return "Prompt not specified";
+	if (!request->model) return "Model not specified";
+	if (request->temperature != OPENAI_REQUEST_TEMPERATURE_NOT_SET &&
+		(request->temperature < 0 || request->temperature > 2)) {
+		return "Temperature is not in required interval [0,2]";
+	}
+	return NULL;
+}
+
+static void batch_print_result(const size_t line_number, const char* response_id, const stream_output* output,
+                               const int64_t total_us, const char* error, const bool with_timings) {
+	json_object* result = json_object_new_object();
+	json_object_object_add(result, "line", json_object_new_uint64(line_number));
+	if (response_id) json_object_object_add(result, "id", json_object_new_string(response_id));
+	json_object_object_add(result, "output",
+	                       json_object_new_string_len(output->text ? output->text : "", (int)output->length));
+	if (error) json_object_object_add(result, "error", json_object_new_string(error));
+	if (output->first_delta_us >= 0) {
+		json_object_object_add(result, "first_delta_us", json_object_new_int64(output->first_delta_us));
+	}
+	json_object_object_add(result, "total_us", json_object_new_int64(total_us));
+	json_object* timings = with_timings && output->timings ? json_tokener_parse(output->timings) : NULL;
+	if (timings) json_object_object_add(result, "timings", timings);
+
+	printf("%s\n", json_object_to_json_string_ext(result, JSON_C_TO_STRING_PLAIN | JSON_C_TO_STRING_NOSLASHESCAPE));
 	fflush(stdout);
+
+	json_object_put(result);
+}
+
+// request for one line of a batch file, NULL if there's nothing to send (invalid lines are reported straight away)
+static openai_request* batch_parse_line(const openai_request* defaults, const char* line, const size_t line_number,
+                                        int* exit_code) {
+	const char* first_char = line;
+	while (*first_char == ' ' || *first_char == '\t' || *first_char == '\r' || *first_char == '\n') first_char++;
+	if (*first_char == '\0') return NULL; // blank lines don't count as prompts
+
+	const stream_output no_output = {.first_delta_us = -1};
+
+	json_object* line_json = json_tokener_parse(line);
+	if (!line_json || !json_object_is_type(line_json, json_type_object)) {
+		batch_print_result(line_number, NULL, &no_output, 0, "Line is not a JSON object", false);
+		json_object_put(line_json);
+		*exit_code = EXIT_FAILURE;
+		return NULL;
+	}
+
+	openai_request* request = batch_request_from_json(defaults, line_json);
+	json_object_put(line_json);
+
+	const char* invalid = batch_request_validate(request);
+	if (invalid) {
+		batch_print_result(line_number, NULL, &no_output, 0, invalid, false);
+		openai_request_free(request);
+		*exit_code = EXIT_FAILURE;
+		return NULL;
+	}
+
+	return request;
+}
+
+// one request at a time over a single connection, results come out in input order
+static int run_batch_sequential(const openai_request* defaults, FILE* batch_file) {
+	openai_session* session = openai_session_new(defaults->api_key);
+	if (!session) {
+		fprintf(stderr, "Could not initialize CURL\n");
+		return EXIT_FAILURE;
+	}
+
+	int exit_code = EXIT_SUCCESS;
+
+	char* line = NULL;
+	size_t line_capacity = 0;
+	size_t line_number = 0;
+	while (getline(&line, &line_capacity, batch_file) != -1) {
+		line_number++;
+
+		openai_request* request = batch_parse_line(defaults, line, line_number, &exit_code);
+		if (!request) continue;
+
+		stream_output output = {.first_delta_us = -1};
+		clock_gettime(CLOCK_MONOTONIC, &output.start);
+
+		char* error = openai_session_stream_response(session, request, openai_stream_callback_collect, &output);
+
+		const int64_t total_us = stream_elapsed_us(&output.start);
+		const char* response_id = openai_session_get_last_response_id(session);
+		batch_print_result(line_number, response_id, &output, total_us, error,
+		                   request->timings == OPENAI_TIMINGS_DETAILED);
+		if (error) exit_code = EXIT_FAILURE;
+		else {
+			history_record(request, response_id, &output, total_us);
+			stats_record(request, &output);
+		}
+
+		free(error);
+		free(output.text);
+		free(output.timings);
+		openai_request_free(request);
+	}
+
+	free(line);
+	openai_session_free(session);
+
+	return exit_code;
+}
+
+typedef struct {
+	stream_output output; // first, so an entry can be passed straight to openai_stream_callback_collect
+	size_t line_number;
+	openai_request* request;
+	int* exit_code;
+} batch_entry;
+
+static void openai_completion_callback_print(const openai_completion* completion, void* user_data) {
+	batch_entry* entry = user_data;
+
+	// the output's clock started when the line was queued, report delta timing from when it was actually sent
+	if (entry->output.first_delta_us >= 0) entry->output.first_delta_us -= completion->queued_us;
+
+	batch_print_result(entry->line_number, completion->response_id, &entry->output, completion->total_us,
+	                   completion->error, entry->request->timings == OPENAI_TIMINGS_DETAILED);
+	if (completion->error) *entry->exit_code = EXIT_FAILURE;
+	else {
+		history_record(entry->request, completion->response_id, &entry->output, completion->total_us);
+		stats_record(entry->request, &entry->output);
+	}
+
+	free(entry->output.text);
+	free(entry->output.timings);
+	openai_request_free(entry->request);
+	free(entry);
+}
+
+// up to parallel requests in flight at once, results are printed as they complete (tagged by line)
+static int run_batch_parallel(const openai_request* defaults, FILE* batch_file, const size_t parallel) {
+	openai_scheduler* scheduler = openai_scheduler_new(defaults->api_key, parallel);
+	if (!scheduler) {
+		fprintf(stderr, "Could not initialize CURL\n");
+		return EXIT_FAILURE;
+	}
+
+	int exit_code = EXIT_SUCCESS;
+
+	char* line = NULL;
+	size_t line_capacity = 0;
+	size_t line_number = 0;
+	while (getline(&line, &line_capacity, batch_file) != -1) {
+		line_number++;
+
+		openai_request* request = batch_parse_line(defaults, line, line_number, &exit_code);
+		if (!request) continue;
+
+		batch_entry* entry = calloc(1, sizeof(batch_entry));
+		entry->line_number = line_number;
+		entry->request = request;
+		entry->output.first_delta_us = -1;
+		entry->exit_code = &exit_code;
+		clock_gettime(CLOCK_MONOTONIC, &entry->output.start);
+
+		if (!openai_scheduler_submit(scheduler, request, openai_stream_callback_collect,
+		                             openai_completion_callback_print, entry)) {
+			fprintf(stderr, "Memory allocation failed!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	free(line);
+
+	char* error = openai_scheduler_run(scheduler);
+	if (error) {
+		fprintf(stderr, "Error: %s\n", error);
+		free(error);
+		exit_code = EXIT_FAILURE;
+	}
+
+	openai_scheduler_free(scheduler);
+
+	return exit_code;
+}
+
+// returns the exit code, failed lines are reported in the output rather than stopping the batch
+static int run_batch(const openai_request* defaults, const chatgpt_cli_options* cli_options) {
+	FILE* batch_file = strcmp(cli_options->batch_path, "-") == 0 ? stdin : fopen(cli_options->batch_path, "rb");
+	if (!batch_file) {
+		fprintf(stderr, "Unable to open batch file %s\n", cli_options->batch_path);
+		return EXIT_FAILURE;
+	}
+
+	const int exit_code = cli_options->parallel > 1
+		? run_batch_parallel(defaults, batch_file, cli_options->parallel)
+		: run_batch_sequential(defaults, batch_file);
+
+	if (batch_file != stdin) fclose(batch_file);
+	return exit_code;
+}
+
+// a daemon already has a warm connection, if its socket is there it's most likely running
+static bool daemon_socket_exists() {
+	char* path = chatgpt_cli_daemon_get_socket_path();
+	struct stat socket_stat;
+	const bool exists = stat(path, &socket_stat) == 0;
+	free(path);
+	return exists;
+}
+
+// one request over the warmed-up connection if there is one, otherwise a fresh one. *response_id is set if it
+// completed (caller frees)
+static char* stream_response_direct(openai_request* request, openai_session_warmup* warmup,
+                                    const openai_delta_callback callback, void* user_data, char** response_id) {
+	openai_session* session = warmup ? openai_session_warmup_finish(warmup, request->api_key) : NULL;
+	if (!session) session = openai_session_new(request->api_key);
+	if (!session) {
+		return strdup("Could not initialize CURL");
+	}
+
+	char* error = openai_session_stream_response(session, request, callback, user_data);
+	const char* session_response_id = openai_session_get_last_response_id(session);
+	*response_id = session_response_id ? strdup(session_response_id) : NULL;
+
+	openai_session_free(session);
+	return error;
+}
+
+// whether a request will be streamed from this process, so a connection is worth warming up for it. parsed with the
+// same options as openai_generate_request_from_options (abbreviations and all), quietly: that reports the errors.
+// local verbs and --count-tokens send nothing, batches and the daemon open connections of their own
+static bool will_stream_request(const int argc, char* argv[]) {
+	bool streams = true;
+	opterr = 0;
+	int opt;
+	while ((opt = getopt_long(argc, argv, SHORT_OPTIONS, long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'h':
+		case 'v':
+		case 'l':
+		case 's':
+		case 'b':
+		case 'd':
+		case CHATGPT_CLI_OPTION_SEARCH:
+		case CHATGPT_CLI_OPTION_STATS:
+		case CHATGPT_CLI_OPTION_CACHE_STATS:
+		case CHATGPT_CLI_OPTION_COUNT_TOKENS:
+			streams = false;
+			break;
+		default:
+			break;
+		}
+	}
+	opterr = 1;
+	optind = 0; // parse again from the start, 0 also resets getopt_long's own state
+	return streams;
 }
 
 int main(int argc, char* argv[]) {
-	openai_request* request = openai_generate_request_from_options(argc, argv);
+	chatgpt_cli_output_init();
+
+	// DNS, TCP and TLS happen on a thread of their own while the options, config and input are read below, the URL
+	// is all it needs. it's thrown away if --api-url sends the request elsewhere
+	chatgpt_cli_config* config = chatgpt_cli_config_load();
+	openai_set_api_url(getenv(ENV_API_URL) ? getenv(ENV_API_URL) : chatgpt_cli_config_get(config, "api-url"));
+	const char* config_connection_cache = chatgpt_cli_config_get(config, "connection-cache");
+	chatgpt_cli_connection_set_enabled(!config_connection_cache || strcmp(config_connection_cache, "false") != 0);
+	const char* config_cache_max_size = chatgpt_cli_config_get(config, "cache-max-size");
+	if (config_cache_max_size) chatgpt_cli_cache_set_max_size(strtoull(config_cache_max_size, NULL, 10));
+	openai_session_warmup* warmup = will_stream_request(argc, argv) && !daemon_socket_exists()
+		                                ? openai_session_warmup_start(getenv(ENV_API_KEY))
+		                                : NULL;
+
+	chatgpt_cli_options cli_options = {0};
+	openai_request* request = openai_generate_request_from_options(argc, argv, config, &cli_options);
+	chatgpt_cli_config_free(config);
+
+	if (cli_options.batch_path != NULL) {
+		openai_session_warmup_cancel(warmup);
+		const int exit_code = run_batch(request, &cli_options);
+		openai_request_free(request);
+		return exit_code;
+	}
+
+	if (cli_options.daemon) {
+		openai_session_warmup_cancel(warmup);
+		const int exit_code = chatgpt_cli_daemon_run(request->api_key, cli_options.parallel
+			? cli_options.parallel : CHATGPT_CLI_DAEMON_DEFAULT_POOL_SIZE);
+		openai_request_free(request);
+		return exit_code;
+	}
+
+	stream_output output = {.first_delta_us = -1};
+	clock_gettime(CLOCK_MONOTONIC, &output.start);
+
+	// the deltas are printed (and written to any other sinks) on a thread of their own, so the stream keeps being
+	// read while the terminal catches up
+	chatgpt_cli_fanout* fanout = chatgpt_cli_fanout_new(CHATGPT_CLI_FANOUT_DEFAULT_CAPACITY);
+	if (!fanout) {
+		fprintf(stderr, "Could not start the output thread\n");
+		exit(EXIT_FAILURE);
+	}
+	chatgpt_cli_fanout_add_sink(fanout, openai_stream_callback_print, &output);
+
+	FILE* transcript = NULL;
+	if (cli_options.transcript_path) {
+		transcript = sink_file_open(cli_options.transcript_path);
+		fprintf(transcript, "> %s\n\n", request->input);
+		chatgpt_cli_fanout_add_sink(fanout, transcript_sink, transcript);
+	}
+	jsonl_sink_data jsonl = {.start = &output.start};
+	if (cli_options.jsonl_path) {
+		jsonl.file = sink_file_open(cli_options.jsonl_path);
+		chatgpt_cli_fanout_add_sink(fanout, jsonl_sink, &jsonl);
+	}
+
+	// a running daemon already has a warm connection, otherwise open one ourselves
+	char* response_id = NULL;
+	char* error = NULL;
+	if (cli_options.no_daemon || !chatgpt_cli_daemon_stream_response(request, chatgpt_cli_fanout_push, fanout,
+	                                                                  &response_id, &error)) {
+		error = stream_response_direct(request, warmup, chatgpt_cli_fanout_push, fanout, &response_id);
+	} else {
+		openai_session_warmup_cancel(warmup);
+	}
+	chatgpt_cli_fanout_finish(fanout);
+
+	if (transcript) {
+		fprintf(transcript, "\n\n");
+		fclose(transcript);
+	}
+	if (jsonl.file) fclose(jsonl.file);
 
-	char* error = openai_stream_response(request, openai_stream_callback_print, 0);
 	if (error != NULL) {
 		printf("\nError: %s", error);
+		chatgpt_cli_output_flush();
+		timings_print(output.timings, cli_options.timings);
 		exit(EXIT_FAILURE);
 	}
-	printf("\n");
+	if (request->raw != OPENAI_RAW_STREAM) printf("\n"); // every line is complete already
+	chatgpt_cli_output_flush();
+	timings_print(output.timings, cli_options.timings);
+
+	history_record(request, response_id, &output, stream_elapsed_us(&output.start));
+	stats_record(request, &output);
 
+	free(response_id);
+	free(output.text);
+	free(output.timings);
 	openai_request_free(request);
 
 	return 0;
 }
 
 
-openai_request* openai_generate_request_from_options(int argc, char* argv[]) {
-	openai_request* func_request = malloc(sizeof(openai_request));
+// prefix followed by the whole of a file (or stdin for "-"), NUL-terminated. NULL if it couldn't be read, which has
+// been reported already
+static char* read_input_file(const char* path, const char* prefix, size_t* length_out) {
+	FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "Unable to open input file %s\n", path);
+		return NULL;
+	}
+
+	// sized for the whole file up front if it's a regular one, so it's never copied around while growing
+	const size_t prefix_length = strlen(prefix);
+	size_t capacity = prefix_length + 64 * 1024;
+	struct stat file_stat;
+	if (fstat(fileno(file), &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+		capacity = prefix_length + (size_t)file_stat.st_size + 2; // + 1 to notice it's at the end without growing
+	}
+
+	size_t length = prefix_length;
+	char* input = malloc(capacity);
+	if (input) memcpy(input, prefix, prefix_length);
+	while (input) {
+		length += fread(input + length, 1, capacity - length - 1, file);
+		if (length < capacity - 1) break; // end of the file (or an error, checked below)
+
+		capacity *= 2;
+		char* new_input = realloc(input, capacity);
+		if (!new_input) free(input);
+		input = new_input;
+	}
+
+	const bool failed = input && ferror(file);
+	if (file != stdin) fclose(file);
+	if (!input) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		return NULL;
+	}
+	if (failed) {
+		fprintf(stderr, "Unable to read input file %s\n", path);
+		free(input);
+		return NULL;
+	}
+
+	// the prompt is a C string from here on, a NUL would quietly cut it short
+	if (memchr(input + prefix_length, '\0', length - prefix_length)) {
+		fprintf(stderr, "Input file %s isn't text\n", path);
+		free(input);
+		return NULL;
+	}
+
+	input[length] = '\0';
+	*length_out = length;
+	return input;
+}
+
+// the tokens in everything sent as text: the instructions, the input and any text attachments. *uncounted is set to
+// how many attachments aren't text, which the API counts its own way. false if the encoding couldn't be opened,
+// which has been reported already
+static bool count_input_tokens(const openai_request* request, size_t* tokens, size_t* uncounted) {
+	char* error = NULL;
+	chatgpt_cli_tokenizer* tokenizer =
+		chatgpt_cli_tokenizer_open(chatgpt_cli_tokenizer_encoding_for_model(request->model), &error);
+	if (!tokenizer) {
+		fprintf(stderr, "%s\n", error);
+		free(error);
+		return false;
+	}
+
+	*tokens = 0;
+	*uncounted = 0;
+	if (request->instructions) {
+		*tokens += chatgpt_cli_tokenizer_count(tokenizer, request->instructions, strlen(request->instructions));
+	}
+	*tokens += chatgpt_cli_tokenizer_count(tokenizer, request->input, strlen(request->input));
+	for (size_t i = 0; i < request->attachment_count; i++) {
+		const openai_attachment* attachment = &request->attachments[i];
+		if (attachment->image || strcmp(attachment->mime_type, "application/pdf") == 0) {
+			(*uncounted)++;
+		} else if (attachment->data) {
+			*tokens += chatgpt_cli_tokenizer_count(tokenizer, (const char*)attachment->data, attachment->size);
+		}
+	}
+
+	chatgpt_cli_tokenizer_close(tokenizer);
+	return true;
+}
+
+openai_request* openai_generate_request_from_options(int argc, char* argv[], const chatgpt_cli_config* config,
+                                                     chatgpt_cli_options* cli_options) {
+	openai_request* func_request = calloc(1, sizeof(openai_request));
 	func_request->input = NULL;
 
 	if (getenv(ENV_API_KEY)) {
@@ -78,43 +1128,43 @@ openai_request* openai_generate_request_from_options(int argc, char* argv[]) {
 	} else func_request->api_key = NULL;
 
 	// fine if NULL/0
-	func_request->model = chatgpt_cli_config_read_value("model");
-	func_request->instructions = chatgpt_cli_config_read_value("instructions");
-	func_request->raw = false;
+	const char* config_model = chatgpt_cli_config_get(config, "model");
+	func_request->model = config_model ? strdup(config_model) : NULL;
+	const char* config_instructions = chatgpt_cli_config_get(config, "instructions");
+	func_request->instructions = config_instructions ? strdup(config_instructions) : NULL;
+	func_request->raw = OPENAI_RAW_OFF;
 	func_request->echo_response_id = false;
+	func_request->timings = OPENAI_TIMINGS_SUMMARY; // for --stats, --timings asks for more
 	func_request->previous_response_id = NULL;
+	const char* config_cache = chatgpt_cli_config_get(config, "cache");
+	func_request->cache = config_cache && strcmp(config_cache, "true") == 0 ? OPENAI_CACHE_ON : OPENAI_CACHE_OFF;
+
+	// true waits for the model's p95 time to first delta (hedge_ms 0), a number is the deadline in ms
+	const char* config_hedge = chatgpt_cli_config_get(config, "hedge");
+	bool hedge = config_hedge && strcmp(config_hedge, "false") != 0;
+	int64_t hedge_ms = config_hedge && strcmp(config_hedge, "true") != 0 ? strtoll(config_hedge, NULL, 10) : 0;
 
 	// strtoul with NULL input has undefined behaviour
-	const char* config_max_tokens = chatgpt_cli_config_read_value("max_tokens");
+	const char* config_max_tokens = chatgpt_cli_config_get(config, "max_tokens");
 	if (config_max_tokens != NULL) {
 		func_request->max_tokens = strtoul(config_max_tokens, NULL, 10);
 	} else func_request->max_tokens = OPENAI_REQUEST_MAX_TOKENS_NOT_SET;
 
 	// 0 is actually a valid input for temperature, and we're not setting a pointer, so check first,
 	// and just put the value outside the normal range if it doesn't exist
-	const char* config_temperature = chatgpt_cli_config_read_value("temperature");
+	const char* config_temperature = chatgpt_cli_config_get(config, "temperature");
 	if (config_temperature != NULL) {
 		func_request->temperature = strtod(config_temperature, NULL);
 	} else func_request->temperature = OPENAI_REQUEST_TEMPERATURE_NOT_SET;
 
-	char* prompt = strdup("");
-
-	const struct option long_options[] = {
-		{"model", required_argument, 0, 'm'},
-		{"key", required_argument, 0, 'k'},
-		{"instructions", required_argument, 0, 'i'},
-		{"temperature", required_argument, 0, 't'},
-		{"max-tokens", required_argument, 0, 'T'},
-		{"raw", no_argument, 0, 'r'},
-		{"help", no_argument, 0, 'h'},
-		{"version", no_argument, 0, 'v'},
-		{"history", optional_argument, 0, 'H'},
-		{"response-id", no_argument, 0, 'R'},
-		{0, 0, 0, 0}
-	};
+	const char* config_max_input_tokens = chatgpt_cli_config_get(config, "max-input-tokens");
+	if (config_max_input_tokens) cli_options->max_input_tokens = strtoul(config_max_input_tokens, NULL, 10);
+
+	const char* input_path = NULL; // --input-file
+
 
 	int opt; // usually a char, the current option. (with arg optarg)
-	while ((opt = getopt_long(argc, argv, "m:k:i:t:T:rRhvH::", long_options, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, SHORT_OPTIONS, long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'm':
 			func_request->model = strdup(optarg);
@@ -134,8 +1184,29 @@ openai_request* openai_generate_request_from_options(int argc, char* argv[]) {
 			// ignored if set to 0
 			func_request->max_tokens = strtoul(optarg, NULL, 10);
 			break;
+		case 'f':
+			input_path = optarg;
+			break;
+		case 'a': {
+			char* error = openai_request_attach(func_request, optarg);
+			if (error) {
+				fprintf(stderr, "%s\n", error);
+				free(error);
+				openai_request_free(func_request);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		}
 		case 'r':
-			func_request->raw = true;
+			if (!optarg || strcmp(optarg, "final") == 0) {
+				func_request->raw = OPENAI_RAW_FINAL;
+			} else if (strcmp(optarg, "stream") == 0) {
+				func_request->raw = OPENAI_RAW_STREAM;
+			} else {
+				fprintf(stderr, "Unknown raw mode %s, use final or stream\n", optarg);
+				openai_request_free(func_request);
+				exit(EXIT_FAILURE);
+			}
 			break;
 		case 'h':
 			openai_request_free(func_request);
@@ -151,15 +1222,100 @@ openai_request* openai_generate_request_from_options(int argc, char* argv[]) {
 			if (!optarg) {
 				func_request->previous_response_id = chatgpt_cli_history_get_previous_response_id();
 			} else {
-				func_request->previous_response_id = optarg;
+				func_request->previous_response_id = strdup(optarg);
 			}
 			break;
 		case 'R':
 			func_request->echo_response_id = true;
 			break;
+		case 'l':
+			openai_request_free(func_request);
+			history_print_log(optarg ? strtoul(optarg, NULL, 10) : CHATGPT_CLI_HISTORY_LOG_DEFAULT_COUNT);
+			exit(EXIT_SUCCESS);
+		case 's':
+			openai_request_free(func_request);
+			exit(history_print_thread(optarg));
+		case CHATGPT_CLI_OPTION_SEARCH:
+			openai_request_free(func_request);
+			exit(search_print_results(optarg));
+		case CHATGPT_CLI_OPTION_STATS:
+			openai_request_free(func_request);
+			exit(stats_print(optarg));
+		case 'b':
+			cli_options->batch_path = optarg;
+			break;
+		case 'P':
+			cli_options->parallel = strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			cli_options->daemon = true;
+			break;
+		case 'D':
+			cli_options->no_daemon = true;
+			break;
+		case CHATGPT_CLI_OPTION_CACHE:
+			func_request->cache = OPENAI_CACHE_ON;
+			break;
+		case CHATGPT_CLI_OPTION_NO_CACHE:
+			func_request->cache = OPENAI_CACHE_OFF;
+			break;
+		case CHATGPT_CLI_OPTION_CACHE_ONLY:
+			func_request->cache = OPENAI_CACHE_ONLY;
+			break;
+		case CHATGPT_CLI_OPTION_TIMINGS:
+			if (!optarg || strcmp(optarg, "text") == 0) {
+				cli_options->timings = CHATGPT_CLI_TIMINGS_TEXT;
+			} else if (strcmp(optarg, "json") == 0) {
+				cli_options->timings = CHATGPT_CLI_TIMINGS_JSON;
+			} else {
+				fprintf(stderr, "Unknown timings format %s, use text or json\n", optarg);
+				openai_request_free(func_request);
+				exit(EXIT_FAILURE);
+			}
+			func_request->timings = OPENAI_TIMINGS_DETAILED;
+			break;
+		case CHATGPT_CLI_OPTION_API_URL:
+			openai_set_api_url(optarg);
+			break;
+		case CHATGPT_CLI_OPTION_TRANSCRIPT:
+			cli_options->transcript_path = optarg;
+			break;
+		case CHATGPT_CLI_OPTION_JSONL:
+			cli_options->jsonl_path = optarg;
+			break;
+		case CHATGPT_CLI_OPTION_HEDGE:
+			hedge = !optarg || strcmp(optarg, "off") != 0;
+			hedge_ms = optarg && hedge ? strtoll(optarg, NULL, 10) : 0;
+			if (hedge && optarg && hedge_ms <= 0) {
+				fprintf(stderr, "Invalid hedge deadline %s, use a number of ms or off\n", optarg);
+				openai_request_free(func_request);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case CHATGPT_CLI_OPTION_COUNT_TOKENS:
+			cli_options->count_tokens = true;
+			break;
+		case CHATGPT_CLI_OPTION_MAX_INPUT_TOKENS:
+			// 0 turns off a limit from the config
+			cli_options->max_input_tokens = strtoul(optarg, NULL, 10);
+			break;
+
+		case CHATGPT_CLI_OPTION_CACHE_STATS: {
+			openai_request_free(func_request);
+			chatgpt_cli_cache_stats stats;
+			chatgpt_cli_cache_get_stats(&stats);
+			printf("Hits:    %llu\n", (unsigned long long)stats.hits);
+			printf("Misses:  %llu\n", (unsigned long long)stats.misses);
+			printf("Entries: %zu\n", stats.entries);
+			printf("Size:    %.1f / %.1f MiB\n", (double)stats.size / (1024 * 1024),
+			       (double)stats.max_size / (1024 * 1024));
+			exit(EXIT_SUCCESS);
+		}
 		}
 	}
-	if (!func_request->model) {
+	// batch lines can bring their own model, the daemon gets it with each request. counting tokens without one
+	// counts them for recent models
+	if (!func_request->model && !cli_options->batch_path && !cli_options->daemon && !cli_options->count_tokens) {
 		char* config_path = chatgpt_cli_config_get_config_path();
 		fprintf(stderr, "Model not provided. Specify with --model or in %s\n", config_path);
 		free(config_path);
@@ -167,7 +1323,7 @@ openai_request* openai_generate_request_from_options(int argc, char* argv[]) {
 		exit(EXIT_FAILURE);
 	}
 
-	if (!func_request->api_key) {
+	if (!func_request->api_key && !cli_options->count_tokens) {
 		fprintf(stderr, "OpenAI API key not provided. Specify with %s environment variable or --key\n",
 		        ENV_API_KEY);
 		free(func_request);
@@ -182,35 +1338,82 @@ openai_request* openai_generate_request_from_options(int argc, char* argv[]) {
 		exit(EXIT_FAILURE);
 	}
 
-	// non-option args
-	size_t prompt_length = 1; // terminator
-	for (int i = optind; i < argc; i++) {
-		size_t argLength = strlen(argv[i]);
-		prompt_length += argLength + 1; // +1 for space
+	if (hedge) func_request->hedge_after_us = hedge_deadline_us(func_request->model, hedge_ms);
 
-		char* new_prompt = realloc(prompt, prompt_length * sizeof(char));
-		if (new_prompt == NULL) {
-			fprintf(stderr, "Memory allocation failed!\n");
-			free(prompt);
-			exit(EXIT_FAILURE);
-		}
+	if (cli_options->batch_path || cli_options->daemon) {
+		// prompts come from the batch file or the daemon's clients, anything given here is ignored
+		return func_request;
+	}
 
-		prompt = new_prompt;
+	// a lone - reads the prompt from stdin, like --input-file -
+	int word_count = argc - optind;
+	if (word_count == 1 && strcmp(argv[optind], "-") == 0 && !input_path) {
+		input_path = "-";
+		word_count = 0;
+	}
 
-		strcat(prompt, argv[i]);
+	// non-option args joined by spaces, sized up front so it's linear
+	size_t prompt_length = 0;
+	for (int i = optind; i < optind + word_count; i++) prompt_length += strlen(argv[i]) + 1;
 
-		if (i != argc - 1) {
-			strcat(prompt, " "); // alloc space
+	char* prompt = malloc(prompt_length + 2);
+	if (prompt == NULL) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	size_t length = 0;
+	for (int i = optind; i < optind + word_count; i++) {
+		const size_t word_length = strlen(argv[i]);
+		memcpy(prompt + length, argv[i], word_length);
+		length += word_length;
+		prompt[length++] = ' ';
+	}
+	if (length > 0) length--; // no space after the last word
+	prompt[length] = '\0';
+
+	// then the input file after a blank line, read in right behind them
+	if (input_path) {
+		if (length > 0) strcpy(prompt + length, "\n\n");
+		char* input = read_input_file(input_path, prompt, &length);
+		free(prompt);
+		if (!input) {
+			openai_request_free(func_request);
+			exit(EXIT_FAILURE);
 		}
+		prompt = input;
 	}
 
 	if (prompt[0] == '\0') {
 		fprintf(stderr, "Prompt not specified. Use --help for usage.\n");
+		free(prompt);
 		free(func_request);
 		exit(EXIT_FAILURE);
 	}
 
 	func_request->input = prompt;
 
+	// counted here so nothing is sent for a prompt that's too long, there'd be no point
+	if (cli_options->count_tokens || cli_options->max_input_tokens) {
+		size_t tokens, uncounted;
+		if (!count_input_tokens(func_request, &tokens, &uncounted)) {
+			openai_request_free(func_request);
+			exit(EXIT_FAILURE);
+		}
+
+		if (cli_options->count_tokens) {
+			printf("%zu\n", tokens);
+			if (uncounted) fprintf(stderr, "Not counting %zu image or PDF attachments\n", uncounted);
+			openai_request_free(func_request);
+			exit(EXIT_SUCCESS);
+		}
+		if (tokens > cli_options->max_input_tokens) {
+			fprintf(stderr, "The prompt is %zu tokens, more than the %zu allowed by --max-input-tokens\n", tokens,
+			        cli_options->max_input_tokens);
+			openai_request_free(func_request);
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	return func_request;
 }
@@ -4,7 +4,29 @@
 
 #ifndef CHATGPT_CLI_MAIN_H
 #define CHATGPT_CLI_MAIN_H
+#include "config.h"
 #include "openai-wrapper.h"
 
-openai_request* openai_generate_request_from_options(int argc, char* argv[]);
+typedef enum {
+	CHATGPT_CLI_TIMINGS_OFF,
+	CHATGPT_CLI_TIMINGS_TEXT,
+	CHATGPT_CLI_TIMINGS_JSON, // one line, for collecting into something else
+} chatgpt_cli_timings_format;
+
+// options which only concern the CLI itself, not the request
+typedef struct {
+	char* batch_path; // run each JSONL line of this file as its own request, "-" for stdin. NULL if not batching
+	size_t parallel; // batch requests in flight at once, 0 or 1 sends them one after another. pool size with daemon
+	bool daemon; // serve requests on the daemon socket instead of sending one
+	bool no_daemon; // don't try a running daemon first
+	chatgpt_cli_timings_format timings; // how the request's timings are printed to stderr
+	char* transcript_path; // the prompt and response are appended to this file as text, NULL if not
+	char* jsonl_path; // every delta is appended to this file as a JSON line, NULL if not
+	bool count_tokens; // print how many tokens the prompt is and exit, it's never sent
+	size_t max_input_tokens; // prompts of more tokens than this aren't sent, 0 for no limit
+} chatgpt_cli_options;
+
+// config is the loaded config file, it's only read from
+openai_request* openai_generate_request_from_options(int argc, char* argv[], const chatgpt_cli_config* config,
+                                                     chatgpt_cli_options* cli_options);
 #endif //CHATGPT_CLI_MAIN_H
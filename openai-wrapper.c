@@ -5,280 +5,2854 @@
 #include "openai-wrapper.h"
 
 #include <curl/curl.h>
+#include <errno.h>
 #include <json-c/json.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <threads.h>
+#include <time.h>
 
-#include "history.h"
+#include "cache.h"
+#include "config.h"
+#include "connection.h"
+
+#ifdef _WIN32
+#include <winsock2.h> // WSAPoll and its struct pollfd
+#define strcasecmp _stricmp
+#define poll WSAPoll
+#else
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <strings.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <tmmintrin.h>
+#define BASE64_SSSE3 // picked at runtime, the rest of the build doesn't need to target it
+#endif
 
 #define OPENAI_RESPONSES_API_URL "https://api.openai.com/v1/responses"
 
+// NULL while requests go to OPENAI_RESPONSES_API_URL
+static char* openai_api_url = NULL;
+
+void openai_set_api_url(const char* url) {
+	free(openai_api_url);
+	openai_api_url = url && strcmp(url, OPENAI_RESPONSES_API_URL) != 0 ? strdup(url) : NULL;
+}
+
+const char* openai_get_api_url() {
+	return openai_api_url ? openai_api_url : OPENAI_RESPONSES_API_URL;
+}
+
 void openai_request_free(openai_request* request) {
 	free(request->api_key);
 	free(request->input);
 	free(request->model);
 	free(request->instructions);
 	free(request->previous_response_id);
+	for (size_t i = 0; i < request->attachment_count; i++) {
+		free(request->attachments[i].path);
+		if (request->attachments[i].data) {
+			#ifdef _WIN32
+			free((void*)request->attachments[i].data);
+			#else
+			munmap((void*)request->attachments[i].data, request->attachments[i].size);
+			#endif
+		}
+	}
+	free(request->attachments);
 	free(request);
 }
 
+// what an attachment is sent as, by its extension. anything else goes as text, which is what logs and code are
+static const struct {
+	const char* extension;
+	const char* mime_type;
+	bool image;
+} attachment_types[] = {
+	{"png", "image/png", true},
+	{"jpg", "image/jpeg", true},
+	{"jpeg", "image/jpeg", true},
+	{"gif", "image/gif", true},
+	{"webp", "image/webp", true},
+	{"pdf", "application/pdf", false},
+	{"json", "application/json", false},
+	{"csv", "text/csv", false},
+	{"md", "text/markdown", false},
+	{"html", "text/html", false},
+};
+
+// caller frees
+static char* attachment_error(const char* format, const char* path) {
+	const size_t len = snprintf(NULL, 0, format, path) + 1;
+	char* message = malloc(len);
+	if (message) snprintf(message, len, format, path);
+	return message;
+}
+
+char* openai_request_attach(openai_request* request, const char* path) {
+	if (request->attachment_count == OPENAI_REQUEST_MAX_ATTACHMENTS) {
+		return strdup("Too many attachments");
+	}
+	if (!request->attachments) {
+		request->attachments = calloc(OPENAI_REQUEST_MAX_ATTACHMENTS, sizeof(openai_attachment));
+		if (!request->attachments) return strdup("Failed to allocate memory for attachments");
+	}
+
+	openai_attachment attachment = {.mime_type = "text/plain"};
+	#ifdef _WIN32
+	attachment.path = _fullpath(NULL, path, 0);
+	if (!attachment.path) return attachment_error("Unable to find attachment %s", path);
+
+	// no mmap here, read it whole instead
+	FILE* file = fopen(attachment.path, "rb");
+	if (!file) {
+		free(attachment.path);
+		return attachment_error("Unable to open attachment %s", path);
+	}
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (length > 0) {
+		unsigned char* data = malloc(length);
+		attachment.size = data ? fread(data, 1, length, file) : 0;
+		if (!data || attachment.size != (size_t)length) {
+			free(data);
+			fclose(file);
+			free(attachment.path);
+			return attachment_error("Unable to read attachment %s", path);
+		}
+		attachment.data = data;
+	}
+	fclose(file);
+	#else
+	attachment.path = realpath(path, NULL);
+	if (!attachment.path) return attachment_error("Unable to find attachment %s", path);
+
+	const int fd = open(attachment.path, O_RDONLY);
+	struct stat file_stat;
+	if (fd < 0 || fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+		if (fd >= 0) close(fd);
+		free(attachment.path);
+		return attachment_error("Unable to open attachment %s", path);
+	}
+
+	// mapped rather than read: pages are only touched as the upload gets to them, and dropped again after
+	attachment.size = (size_t)file_stat.st_size;
+	if (attachment.size > 0) {
+		void* data = mmap(NULL, attachment.size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			free(attachment.path);
+			return attachment_error("Unable to map attachment %s", path);
+		}
+		madvise(data, attachment.size, MADV_SEQUENTIAL);
+		attachment.data = data;
+	}
+	close(fd);
+	#endif
+
+	const char* name = strrchr(attachment.path, PATH_SEPARATOR) + 1;
+	const char* extension = strrchr(name, '.');
+	for (size_t i = 0; extension && i < sizeof(attachment_types) / sizeof(attachment_types[0]); i++) {
+		if (strcasecmp(extension + 1, attachment_types[i].extension) == 0) {
+			attachment.mime_type = attachment_types[i].mime_type;
+			attachment.image = attachment_types[i].image;
+			break;
+		}
+	}
+
+	request->attachments[request->attachment_count++] = attachment;
+	return NULL;
+}
+
+// longest event name kept by the framer, anything longer can't be a Responses event and is left unnamed
+#define SSE_EVENT_NAME_MAX_LENGTH 63
+
+#define SSE_FRAMER_MIN_CAPACITY 4096
+
+// called once per complete event, data is NUL-terminated and may be modified in place.
+// return false to stop framing (the caller is expected to have recorded why).
+typedef bool (*sse_event_callback)(const char* name, size_t name_length, char* data, size_t data_length,
+                                   void* user_data);
+
+// incremental text/event-stream framer, see https://html.spec.whatwg.org/multipage/server-sent-events.html
+// every byte is scanned once, no matter how the stream is split into chunks.
 typedef struct {
-	openai_delta_callback callback; // pointer to a caller defined function
-	void* user_data;
-	char* error; // NULL if no error
+	char* buffer;
+	size_t length;
+	size_t capacity;
 
-	openai_request* request;
+	size_t line_start; // start of the first line which hasn't been fully received yet
+	size_t scan_position; // where to continue looking for the end of that line
+	bool skip_line_feed; // previous line ended in \r, so a \n directly after it belongs to that line
 
-	// chunks sent back aren't guaranteed to contain a full response so store unfinished here
-	char* current_event_buffer;
-	size_t current_event_buffer_length;
-} curl_callback_stream_callback_data; // to pass as data into the CURL callback
+	// data lines of the current event are joined in place, starting at event_start
+	size_t event_start;
+	size_t data_length;
+	bool has_data;
 
-static json_object* curl_callback_openai_stream_extract_data_json(json_tokener* tok, const char* event_name_end,
-                                                                  const char* event_end,
-                                                                  curl_callback_stream_callback_data* callback_data) {
-	const char* json_prefix = "data: "; // after event_name_end and before the JSON
-	const char* json_string = strstr(event_name_end + strlen(json_prefix) + 1, "{");
-	const size_t json_string_length = event_end - json_string;
+	char event_name[SSE_EVENT_NAME_MAX_LENGTH + 1];
+	size_t event_name_length;
+} sse_framer;
 
-	json_tokener_reset(tok);
-	json_object* data_json = json_tokener_parse_ex(tok, json_string, (int)json_string_length);
+static void sse_framer_init(sse_framer* framer) {
+	memset(framer, 0, sizeof(sse_framer));
+}
 
-	if (data_json == NULL) {
-		fprintf(stderr, "\nJSON parse error: %s\n", json_tokener_error_desc(json_tokener_get_error(tok)));
-		json_tokener_free(tok);
-		callback_data->error = strdup("Malformed response (JSON)");
-		return NULL;
+static void sse_framer_free(sse_framer* framer) {
+	free(framer->buffer);
+	framer->buffer = NULL;
+}
+
+static bool sse_framer_reserve(sse_framer* framer, const size_t extra) {
+	// +1 so there is always room for a terminator
+	if (framer->length + extra + 1 <= framer->capacity) return true;
+
+	size_t new_capacity = framer->capacity ? framer->capacity : SSE_FRAMER_MIN_CAPACITY;
+	while (new_capacity < framer->length + extra + 1) {
+		new_capacity *= 2;
 	}
 
-	return data_json;
+	char* new_buffer = realloc(framer->buffer, new_capacity);
+	if (!new_buffer) return false;
+
+	framer->buffer = new_buffer;
+	framer->capacity = new_capacity;
+	return true;
 }
 
-// returns number of bytes handled, as specified in CURL docs
-static size_t curl_callback_openai_stream_response(const char* content_ptr, const size_t size_atomic,
-                                                   const size_t n_elements,
-                                                   curl_callback_stream_callback_data** user_callback_addr) {
-	const size_t total_chunk_size = size_atomic * n_elements; // = length of content_ptr
-	curl_callback_stream_callback_data* callback_data = *user_callback_addr;
+// handles one complete line (without its terminator), returns false if the callback asked to stop
+static bool sse_framer_process_line(sse_framer* framer, const size_t line_start, const size_t line_length,
+                                    const sse_event_callback callback, void* user_data) {
+	char* line = framer->buffer + line_start;
 
-	// don't process further if we've already seen an error
-	if (callback_data->error != NULL) {
-		return total_chunk_size;
+	if (line_length == 0) {
+		// blank line dispatches the event, events without any data are dropped as per spec
+		bool keep_going = true;
+		if (framer->has_data) {
+			char* data = framer->buffer + framer->event_start;
+			data[framer->data_length] = '\0';
+			keep_going = callback(framer->event_name, framer->event_name_length, data, framer->data_length,
+			                      user_data);
+		}
+
+		framer->event_name_length = 0;
+		framer->event_name[0] = '\0';
+		framer->data_length = 0;
+		framer->has_data = false;
+		return keep_going;
 	}
 
-	json_tokener* tok = json_tokener_new();
+	if (line[0] == ':') return true; // comment
 
-	// if OpenAI immediately errors, it just returns a full JSON object, check for this:
-	json_object* potential_error = json_tokener_parse_ex(tok, content_ptr, (int)total_chunk_size);
-	if (potential_error != NULL) {
-		const json_object* error_json = json_object_object_get(potential_error, "error");
-		if (error_json != NULL) {
-			callback_data->error =
-				strdup(json_object_get_string(json_object_object_get(error_json, "message")));
-			json_object_put(potential_error);
-			return 0;
+	// "field: value", the space after the colon is optional and a line without a colon is a field with no value
+	const char* colon = memchr(line, ':', line_length);
+	const size_t field_length = colon ? (size_t)(colon - line) : line_length;
+	const char* value = colon ? colon + 1 : line + line_length;
+	if (colon && value < line + line_length && *value == ' ') value++;
+	const size_t value_length = line + line_length - value;
+
+	#define IS_FIELD(field) (field_length == strlen(field) && memcmp(line, field, field_length) == 0)
+
+	if (IS_FIELD("data")) {
+		// joining always moves bytes backwards (each line has at least "data" and a terminator), so memmove is safe
+		char* data_end = framer->buffer + framer->event_start + framer->data_length;
+		if (framer->has_data) {
+			*data_end++ = '\n';
+			framer->data_length++;
 		}
+		memmove(data_end, value, value_length);
+		framer->data_length += value_length;
+		framer->has_data = true;
+	} else if (IS_FIELD("event")) {
+		if (value_length <= SSE_EVENT_NAME_MAX_LENGTH) {
+			memcpy(framer->event_name, value, value_length);
+			framer->event_name_length = value_length;
+		} else framer->event_name_length = 0;
+		framer->event_name[framer->event_name_length] = '\0';
 	}
+	// id and retry fields aren't used by the API
 
-	// copy new chunk onto buffer
-	const size_t new_event_length = callback_data->current_event_buffer_length + total_chunk_size;
-	char* new_event_buffer = realloc(callback_data->current_event_buffer, new_event_length);
-	if (!new_event_buffer) {
-		callback_data->error = strdup("Failed to allocate memory for delta");
-		return 0;
+	#undef IS_FIELD
+
+	return true;
+}
+
+// append a chunk and dispatch every event it completes, returns false on allocation failure or if stopped early
+static bool sse_framer_feed(sse_framer* framer, const char* chunk, const size_t chunk_length,
+                            const sse_event_callback callback, void* user_data) {
+	if (!sse_framer_reserve(framer, chunk_length)) return false;
+
+	memcpy(framer->buffer + framer->length, chunk, chunk_length);
+	framer->length += chunk_length;
+
+	while (framer->scan_position < framer->length) {
+		const char current_char = framer->buffer[framer->scan_position];
+
+		if (framer->skip_line_feed) {
+			framer->skip_line_feed = false;
+			if (current_char == '\n' && framer->scan_position == framer->line_start) {
+				framer->line_start++;
+				framer->scan_position++;
+				continue;
+			}
+		}
+
+		if (current_char != '\n' && current_char != '\r') {
+			framer->scan_position++;
+			continue;
+		}
+
+		const size_t line_start = framer->line_start;
+		const size_t line_length = framer->scan_position - line_start;
+
+		framer->scan_position++;
+		framer->line_start = framer->scan_position;
+		framer->skip_line_feed = current_char == '\r';
+
+		// a blank line starts the next event straight after itself
+		const bool ends_event = line_length == 0;
+
+		if (!sse_framer_process_line(framer, line_start, line_length, callback, user_data)) return false;
+
+		if (ends_event) framer->event_start = framer->line_start;
 	}
-	callback_data->current_event_buffer = new_event_buffer;
-	memcpy(callback_data->current_event_buffer + callback_data->current_event_buffer_length, // append to end
-	       content_ptr, total_chunk_size);
-	callback_data->current_event_buffer_length = callback_data->current_event_buffer_length + total_chunk_size;
 
-	// complete events are formatted:
-	// event: whatever.event\ndata: {some json object}\n\n
-	// any \n's etc. inside of the json are escaped which makes parsing much easier
-	// i.e. delimiting by \n\n should be safe.
+	// drop everything belonging to dispatched events, at most one partial event is moved
+	if (framer->event_start > 0) {
+		const size_t shift = framer->event_start;
+		memmove(framer->buffer, framer->buffer + shift, framer->length - shift);
+		framer->length -= shift;
+		framer->line_start -= shift;
+		framer->scan_position -= shift;
+		framer->event_start = 0;
+	}
 
-	char* next_event_start = callback_data->current_event_buffer;
+	return true;
+}
+
+char* openai_delta_copy(const char* delta, const size_t length) {
+	char* copy = malloc(length + 1);
+	if (!copy) return NULL;
+
+	memcpy(copy, delta, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+// fast path for output_text.delta events, which are nearly every event in a stream.
+// finds the top-level "delta" string and unescapes it in place, anything unexpected is left to json-c.
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define DELTA_SCAN_SWAR
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+// high bit set in each byte of x which is zero (exact up to the first zero byte, which is all we use)
+#define SWAR_ZERO_BYTES(x) (((x) - SWAR_ONES) & ~(x) & SWAR_HIGHS)
+#endif
+
+// first '"' or '\\' in [start, end), or end if there is none
+static char* delta_scan_find_quote_or_escape(char* start, const char* end) {
+	char* current = start;
+
+#ifdef DELTA_SCAN_SWAR
+	// 8 bytes at a time
+	while (end - current >= 8) {
+		uint64_t word;
+		memcpy(&word, current, sizeof(word));
+		const uint64_t matches = SWAR_ZERO_BYTES(word ^ (SWAR_ONES * '"')) |
+			SWAR_ZERO_BYTES(word ^ (SWAR_ONES * '\\'));
+		if (matches) return current + (__builtin_ctzll(matches) >> 3);
+		current += 8;
+	}
+#endif
+
+	while (current < end && *current != '"' && *current != '\\') current++;
+	return current;
+}
+
+static char* delta_scan_skip_whitespace(char* current, const char* end) {
+	while (current < end && (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r')) current++;
+	return current;
+}
+
+// current points at an opening quote, returns just past the closing quote or NULL if the string never ends
+static char* delta_scan_skip_string(char* current, const char* end) {
+	current++;
 	while (true) {
-		char* event_end = strstr(next_event_start, "\n\n");
-		if (!event_end) break; // event isn't complete, split and wait for new chunks to finish it
-
-		// get event type
-		char* event_name_start = strstr(next_event_start, "event: ") + strlen("event: ");
-		char* event_name_end = strstr(next_event_start, "\n");
-		if (!event_name_start || !event_name_end || event_name_end < event_name_start) {
-			callback_data->error = strdup("Malformed response");
-			return 0;
-		}
-		const size_t event_name_length = (event_name_end) - (event_name_start);
+		current = delta_scan_find_quote_or_escape(current, end);
+		if (current >= end) return NULL;
+		if (*current == '"') return current + 1;
+		current += 2; // skip the escaped character, \uXXXX needs no special handling here
+	}
+}
 
-		// refer to https://platform.openai.com/docs/api-reference/responses_streaming/response for event details
-		#define IS_EVENT(ev) \
-			(strlen(ev) == event_name_length && \
-			strncmp(ev, event_name_start, strlen(ev)) == 0)
+// skips any JSON value, returns NULL if it's malformed
+static char* delta_scan_skip_value(char* current, const char* end) {
+	if (current >= end) return NULL;
+	if (*current == '"') return delta_scan_skip_string(current, end);
 
-		if (callback_data->request->echo_response_id
-			&& !(callback_data->request->raw) && IS_EVENT("response.created")) {
-			json_object* data_json = curl_callback_openai_stream_extract_data_json(tok, event_name_end, event_end, callback_data);
-			if (data_json == NULL) {
-				return 0;
+	if (*current == '{' || *current == '[') {
+		size_t depth = 0;
+		while (current < end) {
+			if (*current == '"') {
+				current = delta_scan_skip_string(current, end);
+				if (!current) return NULL;
+				continue;
+			}
+			if (*current == '{' || *current == '[') depth++;
+			if (*current == '}' || *current == ']') {
+				if (--depth == 0) return current + 1;
 			}
+			current++;
+		}
+		return NULL;
+	}
+
+	// number, true, false or null
+	while (current < end && *current != ',' && *current != '}' && *current != ']' &&
+		*current != ' ' && *current != '\t' && *current != '\n' && *current != '\r') current++;
+	return current;
+}
 
-			json_object* response_json = json_object_object_get(data_json, "response");
+static int delta_scan_hex_digit(const char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
 
-			printf("# Response ID: %s\n", json_object_get_string(json_object_object_get(response_json, "id")));
-			json_object_put(data_json);
-		}
+// reads the 4 hex digits of a \u escape, -1 if invalid
+static long delta_scan_read_u_escape(const char* digits, const char* end) {
+	if (end - digits < 4) return -1;
 
-		if (!callback_data->request->raw && // don't pass deltas to raw responses, we just pass the final full output
-			IS_EVENT("response.output_text.delta")) {
-			// extract delta
-			json_object* data_json = curl_callback_openai_stream_extract_data_json(
-				tok, event_name_end, event_end, callback_data);
-			if (data_json == NULL) {
-				return 0;
+	long code_unit = 0;
+	for (int i = 0; i < 4; i++) {
+		const int digit = delta_scan_hex_digit(digits[i]);
+		if (digit < 0) return -1;
+		code_unit = code_unit << 4 | digit;
+	}
+	return code_unit;
+}
+
+static char* delta_scan_write_utf8(char* out, const unsigned long code_point) {
+	if (code_point < 0x80) {
+		*out++ = (char)code_point;
+	} else if (code_point < 0x800) {
+		*out++ = (char)(0xC0 | code_point >> 6);
+		*out++ = (char)(0x80 | (code_point & 0x3F));
+	} else if (code_point < 0x10000) {
+		*out++ = (char)(0xE0 | code_point >> 12);
+		*out++ = (char)(0x80 | (code_point >> 6 & 0x3F));
+		*out++ = (char)(0x80 | (code_point & 0x3F));
+	} else {
+		*out++ = (char)(0xF0 | code_point >> 18);
+		*out++ = (char)(0x80 | (code_point >> 12 & 0x3F));
+		*out++ = (char)(0x80 | (code_point >> 6 & 0x3F));
+		*out++ = (char)(0x80 | (code_point & 0x3F));
+	}
+	return out;
+}
+
+// current points at an opening quote. unescapes the string in place (the result is never longer than the escaped
+// form) and returns its start and length, false if the string is malformed.
+static bool delta_scan_unescape_string(char* current, const char* end, char** string_out, size_t* length_out) {
+	char* read = current + 1;
+	char* write = read;
+	*string_out = write;
+
+	while (true) {
+		char* special = delta_scan_find_quote_or_escape(read, end);
+		if (special >= end) return false;
+
+		// plain run, only needs moving once an escape has shrunk the output
+		const size_t run_length = special - read;
+		if (write != read) memmove(write, read, run_length);
+		write += run_length;
+		read = special;
+
+		if (*read == '"') break;
+
+		if (end - read < 2) return false;
+		const char escaped = read[1];
+		read += 2;
+
+		switch (escaped) {
+		case '"': *write++ = '"'; break;
+		case '\\': *write++ = '\\'; break;
+		case '/': *write++ = '/'; break;
+		case 'b': *write++ = '\b'; break;
+		case 'f': *write++ = '\f'; break;
+		case 'n': *write++ = '\n'; break;
+		case 'r': *write++ = '\r'; break;
+		case 't': *write++ = '\t'; break;
+		case 'u': {
+			long code_point = delta_scan_read_u_escape(read, end);
+			if (code_point < 0) return false;
+			read += 4;
+
+			if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+				// high surrogate, only valid when a low surrogate escape follows
+				long low_surrogate = -1;
+				if (end - read >= 6 && read[0] == '\\' && read[1] == 'u') {
+					low_surrogate = delta_scan_read_u_escape(read + 2, end);
+				}
+
+				if (low_surrogate >= 0xDC00 && low_surrogate <= 0xDFFF) {
+					code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low_surrogate - 0xDC00);
+					read += 6;
+				} else code_point = 0xFFFD; // unpaired, same replacement json-c uses
+			} else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+				code_point = 0xFFFD;
 			}
 
-			json_object* delta_json = json_object_object_get(data_json, "delta");
+			write = delta_scan_write_utf8(write, code_point);
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+
+	*length_out = write - *string_out;
+	return true;
+}
+
+// finds the top-level "delta" string of an event's data and unescapes it in place, false if json-c should handle it
+static bool delta_scan_extract(char* data, const size_t data_length, char** delta_out, size_t* delta_length_out) {
+	const char* end = data + data_length;
+	const char* delta_key = "\"delta\"";
+	const size_t delta_key_length = strlen(delta_key);
 
-			callback_data->callback(strdup(json_object_get_string(delta_json)), json_object_get_string_len(delta_json),
-			                        callback_data->user_data);
+	char* current = delta_scan_skip_whitespace(data, end);
+	if (current >= end || *current != '{') return false;
+	current++;
 
-			json_object_put(data_json);
+	while (true) {
+		current = delta_scan_skip_whitespace(current, end);
+		if (current >= end || *current != '"') return false;
+
+		char* key_end = delta_scan_skip_string(current, end);
+		if (!key_end) return false;
+		const bool is_delta = (size_t)(key_end - current) == delta_key_length &&
+			memcmp(current, delta_key, delta_key_length) == 0;
+
+		current = delta_scan_skip_whitespace(key_end, end);
+		if (current >= end || *current != ':') return false;
+		current = delta_scan_skip_whitespace(current + 1, end);
+
+		if (is_delta) {
+			if (current >= end || *current != '"') return false;
+			return delta_scan_unescape_string(current, end, delta_out, delta_length_out);
 		}
 
-		// the final event is only sent once at the end, just 'stream' back the whole json here instead of in deltas
-		if (IS_EVENT("response.completed") || IS_EVENT("response.incomplete") || IS_EVENT("response.failed")) {
-			json_object* data_json = curl_callback_openai_stream_extract_data_json(
-				tok, event_name_end, event_end, callback_data);
-			if (data_json == NULL) {
-				return 0;
-			}
+		current = delta_scan_skip_value(current, end);
+		if (!current) return false;
+
+		current = delta_scan_skip_whitespace(current, end);
+		if (current >= end || *current != ',') return false; // object ended without a delta
+		current++;
+	}
+}
+
+// rate limit state as reported by the API's response headers
+typedef struct {
+	bool updated; // set whenever one of the values below changes
 
-			json_object* response_json = json_object_object_get(data_json, "response");
+	long remaining_requests; // -1 if not sent
+	double reset_requests_seconds; // until remaining_requests is replenished
+	long remaining_tokens; // -1 if not sent
+	double reset_tokens_seconds;
+	double retry_after_seconds; // 0 if not sent
+} openai_rate_limit;
 
-			if (callback_data->request->raw) {
-				const char* response = json_object_to_json_string_ext(response_json, JSON_C_TO_STRING_PRETTY);
-				callback_data->callback(strdup(response), strlen(response),
-										callback_data->user_data);
-			}
+typedef struct {
+	openai_delta_callback callback; // pointer to a caller defined function
+	void* user_data;
+	char* error; // NULL if no error
 
-			char* resp_id = strdup(json_object_get_string(json_object_object_get(response_json, "id")));
-			chatgpt_cli_history_set_previous_response_id(resp_id);
-			free(resp_id);
+	openai_request* request;
+	char* response_id; // set once the final event arrives
+
+	// chunks sent back aren't guaranteed to contain a full event, the framer keeps anything unfinished
+	sse_framer framer;
+	json_tokener* tok; // reused for every event in the response
+
+	// taken from the response headers, anything other than a successful event stream is an error body
+	long http_status;
+	bool is_event_stream;
+
+	char* error_body;
+	size_t error_body_length;
+
+	openai_rate_limit rate_limit;
+
+	// what arrived when, relative to the transfer starting. gaps and CPU time are only measured for detailed timings
+	struct timespec started;
+	int64_t created_us; // -1 until response.created arrives
+	int64_t first_delta_us; // -1 until the first response.output_text.delta arrives
+	int64_t last_delta_us; // of any kind, -1 before the first one
+	size_t event_count;
+	size_t delta_count;
+	uint32_t* delta_gaps_us;
+	size_t delta_gap_count;
+	size_t delta_gap_capacity;
+	int64_t parser_cpu_ns;
+	int64_t input_tokens; // -1 if the response didn't report usage
+	int64_t output_tokens;
+	int64_t hedge_us; // -1 unless the request was hedged and a hedge was sent
+	bool hedge_won;
+	int64_t warmup_us; // -1 unless the connection was opened by a warm-up, see openai_session_warmup
+	int64_t warmup_hidden_us;
+
+	bool flush_pending; // deltas were sent since the last OPENAI_DELTA_FLUSH
+	bool content_seen; // streamed content arrived, raw or not. what decides a hedged race
+	const bool* cancelled; // the session's, see openai_session_cancel. NULL if nothing can cancel the stream
+	bool delta_fast_path; // off leaves every delta to json-c, see openai_stream_parser_set_fast_path
+} curl_callback_stream_callback_data; // to pass as data into the CURL callback
 
-			json_object_put(data_json);
+static int64_t stream_context_elapsed_us(const curl_callback_stream_callback_data* callback_data) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)(now.tv_sec - callback_data->started.tv_sec) * 1000000 +
+		(now.tv_nsec - callback_data->started.tv_nsec) / 1000;
+}
+
+static int64_t thread_cpu_ns() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+// passes a delta on to the callback, noting when it arrived. time spent in the callback isn't parsing
+static void stream_context_emit(curl_callback_stream_callback_data* callback_data, const openai_delta_type type,
+                                const char* delta, const size_t length) {
+	const bool timings = callback_data->request->timings == OPENAI_TIMINGS_DETAILED;
+	callback_data->flush_pending = true;
+
+	if (type <= OPENAI_DELTA_FUNCTION_CALL_ARGUMENTS) { // streamed content, rather than something about the response
+		callback_data->content_seen = true;
+		callback_data->delta_count++;
+		if (timings) {
+			const int64_t now_us = stream_context_elapsed_us(callback_data);
+			if (type == OPENAI_DELTA_OUTPUT_TEXT && callback_data->first_delta_us < 0) {
+				callback_data->first_delta_us = now_us;
+			}
+
+			if (callback_data->last_delta_us >= 0) {
+				if (callback_data->delta_gap_count == callback_data->delta_gap_capacity) {
+					const size_t new_capacity = callback_data->delta_gap_capacity
+						? callback_data->delta_gap_capacity * 2 : 256;
+					uint32_t* new_gaps = realloc(callback_data->delta_gaps_us, new_capacity * sizeof(uint32_t));
+					if (new_gaps) {
+						callback_data->delta_gaps_us = new_gaps;
+						callback_data->delta_gap_capacity = new_capacity;
+					}
+				}
+				if (callback_data->delta_gap_count < callback_data->delta_gap_capacity) {
+					const int64_t gap_us = now_us - callback_data->last_delta_us;
+					callback_data->delta_gaps_us[callback_data->delta_gap_count++] =
+						gap_us > UINT32_MAX ? UINT32_MAX : (uint32_t)gap_us;
+				}
+			}
+			callback_data->last_delta_us = now_us;
+		} else if (type == OPENAI_DELTA_OUTPUT_TEXT && callback_data->first_delta_us < 0) {
+			callback_data->first_delta_us = stream_context_elapsed_us(callback_data);
 		}
+	}
+
+	if (!timings) {
+		callback_data->callback(type, delta, length, callback_data->user_data);
+		return;
+	}
+
+	const int64_t callback_start = thread_cpu_ns();
+	callback_data->callback(type, delta, length, callback_data->user_data);
+	callback_data->parser_cpu_ns -= thread_cpu_ns() - callback_start;
+}
 
+static json_object* curl_callback_openai_stream_extract_data_json(const char* data, const size_t data_length,
+                                                                  curl_callback_stream_callback_data* callback_data) {
+	json_tokener_reset(callback_data->tok);
+	json_object* data_json = json_tokener_parse_ex(callback_data->tok, data, (int)data_length);
 
-		next_event_start = event_end + 2;
-		#undef IS_EVENT
+	if (data_json == NULL) {
+		fprintf(stderr, "\nJSON parse error: %s\n",
+		        json_tokener_error_desc(json_tokener_get_error(callback_data->tok)));
+		callback_data->error = strdup("Malformed response (JSON)");
+		return NULL;
 	}
-	json_tokener_free(tok);
 
-	// update buffer to remove processed events
+	return data_json;
+}
 
-	if (next_event_start >= callback_data->current_event_buffer + callback_data->current_event_buffer_length) {
-		// there's nothing else in the buffer -> free it
-		free(callback_data->current_event_buffer);
-		callback_data->current_event_buffer = NULL;
-		callback_data->current_event_buffer_length = 0;
-		return total_chunk_size;
+// refer to https://platform.openai.com/docs/api-reference/responses_streaming/response for event details
+
+typedef struct stream_event_handler_entry stream_event_handler_entry;
+
+// handles one event of a known type, returns false to stop processing the stream
+typedef bool (*stream_event_handler)(const stream_event_handler_entry* entry, char* data, size_t data_length,
+                                     curl_callback_stream_callback_data* callback_data);
+
+struct stream_event_handler_entry {
+	const char* name;
+	stream_event_handler handler;
+	openai_delta_type delta_type; // only used by stream_event_handle_delta, the others leave OPENAI_DELTA_OUTPUT_TEXT
+};
+
+static bool stream_event_handle_created(const stream_event_handler_entry* entry, char* data, const size_t data_length,
+                                        curl_callback_stream_callback_data* callback_data) {
+	(void)entry;
+	callback_data->created_us = stream_context_elapsed_us(callback_data);
+	if (!callback_data->request->echo_response_id || callback_data->request->raw) return true;
+
+	json_object* data_json = curl_callback_openai_stream_extract_data_json(data, data_length, callback_data);
+	if (data_json == NULL) {
+		return false;
+	}
+
+	json_object* id_json = json_object_object_get(json_object_object_get(data_json, "response"), "id");
+	if (id_json != NULL) {
+		stream_context_emit(callback_data, OPENAI_DELTA_RESPONSE_ID, json_object_get_string(id_json),
+		                    json_object_get_string_len(id_json));
 	}
 
-	// unprocessed data remains, move it to the start of the buffer:
+	json_object_put(data_json);
+	return true;
+}
 
-	// size_t is unsigned so not safe to do this before the comparison in the proceeding if
-	const size_t leftover_length = callback_data->current_event_buffer + callback_data->current_event_buffer_length -
-		next_event_start;
+static bool stream_event_handle_delta(const stream_event_handler_entry* entry, char* data, const size_t data_length,
+                                      curl_callback_stream_callback_data* callback_data) {
+	// raw responses get the final full output or the events themselves instead
+	if (callback_data->request->raw) return true;
 
-	memmove(callback_data->current_event_buffer, next_event_start, leftover_length);
-	callback_data->current_event_buffer_length = leftover_length;
+	char* delta = NULL;
+	size_t delta_length = 0;
+	if (callback_data->delta_fast_path && delta_scan_extract(data, data_length, &delta, &delta_length)) {
+		stream_context_emit(callback_data, entry->delta_type, delta, delta_length);
+		return true;
+	}
 
-	return total_chunk_size;
+	// the fast path bailed out, let json-c deal with whatever this is
+	json_object* data_json = curl_callback_openai_stream_extract_data_json(data, data_length, callback_data);
+	if (data_json == NULL) {
+		return false;
+	}
+
+	json_object* delta_json = json_object_object_get(data_json, "delta");
+
+	stream_context_emit(callback_data, entry->delta_type, json_object_get_string(delta_json),
+	                    json_object_get_string_len(delta_json));
+
+	json_object_put(data_json);
+	return true;
 }
 
+// the final event is only sent once at the end, just 'stream' back the whole json here instead of in deltas
+static bool stream_event_handle_final(const stream_event_handler_entry* entry, char* data, const size_t data_length,
+                                      curl_callback_stream_callback_data* callback_data) {
+	(void)entry;
+	json_object* data_json = curl_callback_openai_stream_extract_data_json(data, data_length, callback_data);
+	if (data_json == NULL) {
+		return false;
+	}
 
-char* openai_stream_response(openai_request* request, openai_delta_callback callback, void* user_data) {
-	CURL* curl = curl_easy_init();
-	if (!curl) {
-		return strdup("Could not initialize CURL");
+	json_object* response_json = json_object_object_get(data_json, "response");
+
+	if (callback_data->request->raw == OPENAI_RAW_FINAL) {
+		const char* response = json_object_to_json_string_ext(response_json, JSON_C_TO_STRING_PRETTY);
+		stream_context_emit(callback_data, OPENAI_DELTA_RAW_RESPONSE, response, strlen(response));
 	}
 
-	curl_easy_setopt(curl, CURLOPT_URL, OPENAI_RESPONSES_API_URL);
+	json_object* usage_json = json_object_object_get(response_json, "usage");
+	json_object* tokens_json;
+	if (json_object_object_get_ex(usage_json, "input_tokens", &tokens_json)) {
+		callback_data->input_tokens = json_object_get_int64(tokens_json);
+	}
+	if (json_object_object_get_ex(usage_json, "output_tokens", &tokens_json)) {
+		callback_data->output_tokens = json_object_get_int64(tokens_json);
+	}
 
-	// set CURL request headers
-	struct curl_slist* header_list = NULL;
-	header_list = curl_slist_append(header_list, "Content-Type: application/json");
+	const char* resp_id = json_object_get_string(json_object_object_get(response_json, "id"));
+	if (resp_id != NULL) {
+		free(callback_data->response_id);
+		callback_data->response_id = strdup(resp_id);
+	}
 
-	const char* auth_prefix = "Authorization: Bearer ";
-	char* auth_header = malloc(1 + strlen(auth_prefix) + strlen(request->api_key));
-	strcpy(auth_header, auth_prefix);
-	strcat(auth_header, request->api_key);
-	header_list = curl_slist_append(header_list, auth_header);
+	json_object_put(data_json);
+	return true;
+}
+
+// sent instead of (or in the middle of) a response when something goes wrong server side
+static bool stream_event_handle_error(const stream_event_handler_entry* entry, char* data, const size_t data_length,
+                                      curl_callback_stream_callback_data* callback_data) {
+	(void)entry;
+	json_object* data_json = curl_callback_openai_stream_extract_data_json(data, data_length, callback_data);
+	if (data_json == NULL) {
+		return false;
+	}
 
-	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+	json_object* message_json = NULL;
+	if (json_object_object_get_ex(data_json, "message", &message_json)) {
+		callback_data->error = strdup(json_object_get_string(message_json));
+	} else callback_data->error = strdup("Unknown error event");
 
-	// set CURL request content
-	json_object* json_request_data = json_object_new_object();
+	json_object_put(data_json);
+	return false;
+}
 
-	json_object_object_add(json_request_data, "stream", json_object_new_boolean(true));
-	json_object_object_add(json_request_data, "model", json_object_new_string(request->model));
-	json_object_object_add(json_request_data, "input", json_object_new_string(request->input));
-	if (request->instructions != NULL) {
-		json_object_object_add(json_request_data, "instructions", json_object_new_string(request->instructions));
+// every event we react to, anything not listed here is ignored. adding an event only needs an entry.
+static const stream_event_handler_entry stream_event_handlers[] = {
+	{"response.created", stream_event_handle_created, OPENAI_DELTA_OUTPUT_TEXT},
+	{"response.output_text.delta", stream_event_handle_delta, OPENAI_DELTA_OUTPUT_TEXT},
+	{"response.refusal.delta", stream_event_handle_delta, OPENAI_DELTA_REFUSAL},
+	{"response.reasoning_summary_text.delta", stream_event_handle_delta, OPENAI_DELTA_REASONING_SUMMARY},
+	{"response.function_call_arguments.delta", stream_event_handle_delta, OPENAI_DELTA_FUNCTION_CALL_ARGUMENTS},
+	{"response.completed", stream_event_handle_final, OPENAI_DELTA_OUTPUT_TEXT},
+	{"response.incomplete", stream_event_handle_final, OPENAI_DELTA_OUTPUT_TEXT},
+	{"response.failed", stream_event_handle_final, OPENAI_DELTA_OUTPUT_TEXT},
+	{"error", stream_event_handle_error, OPENAI_DELTA_OUTPUT_TEXT},
+};
+
+#define STREAM_EVENT_HANDLER_COUNT (sizeof(stream_event_handlers) / sizeof(stream_event_handlers[0]))
+
+// open addressing index into stream_event_handlers, kept at most half full so probes stay short
+#define STREAM_EVENT_INDEX_SIZE 64
+_Static_assert(STREAM_EVENT_HANDLER_COUNT * 2 <= STREAM_EVENT_INDEX_SIZE, "grow STREAM_EVENT_INDEX_SIZE");
+
+static unsigned char stream_event_index[STREAM_EVENT_INDEX_SIZE]; // entry index + 1, 0 if empty
+static once_flag stream_event_index_once = ONCE_FLAG_INIT;
+
+// FNV-1a
+static uint32_t stream_event_hash(const char* name, const size_t name_length) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < name_length; i++) {
+		hash ^= (unsigned char)name[i];
+		hash *= 16777619u;
 	}
+	return hash;
+}
 
-	if (request->previous_response_id != NULL) {
-		json_object_object_add(json_request_data, "previous_response_id", json_object_new_string(request->previous_response_id));
+static void stream_event_index_build(void) {
+	for (size_t i = 0; i < STREAM_EVENT_HANDLER_COUNT; i++) {
+		const char* name = stream_event_handlers[i].name;
+		size_t slot = stream_event_hash(name, strlen(name)) & (STREAM_EVENT_INDEX_SIZE - 1);
+		while (stream_event_index[slot] != 0) slot = (slot + 1) & (STREAM_EVENT_INDEX_SIZE - 1);
+		stream_event_index[slot] = (unsigned char)(i + 1);
 	}
+}
 
-	if (request->temperature != OPENAI_REQUEST_TEMPERATURE_NOT_SET) {
-		json_object_object_add(json_request_data, "temperature", json_object_new_double(request->temperature));
+static const stream_event_handler_entry* stream_event_lookup(const char* name, const size_t name_length) {
+	call_once(&stream_event_index_once, stream_event_index_build);
+
+	size_t slot = stream_event_hash(name, name_length) & (STREAM_EVENT_INDEX_SIZE - 1);
+	while (stream_event_index[slot] != 0) {
+		const stream_event_handler_entry* entry = &stream_event_handlers[stream_event_index[slot] - 1];
+		if (strlen(entry->name) == name_length && memcmp(entry->name, name, name_length) == 0) return entry;
+		slot = (slot + 1) & (STREAM_EVENT_INDEX_SIZE - 1);
 	}
-	if (request->max_tokens != OPENAI_REQUEST_MAX_TOKENS_NOT_SET) {
-		json_object_object_add(json_request_data, "max_output_tokens", json_object_new_uint64(request->max_tokens));
+	return NULL;
+}
+
+// passes an event's data on as it is for OPENAI_RAW_STREAM, known or not. the JSON is never parsed, only kept on one
+// line: data split over several data: lines arrives joined by newlines, which can only be whitespace between tokens
+static void stream_event_pass_raw(const stream_event_handler_entry* entry, char* data, const size_t data_length,
+                                  curl_callback_stream_callback_data* callback_data) {
+	if (data_length == 0) return;
+
+	for (char* newline = memchr(data, '\n', data_length); newline;
+	     newline = memchr(newline + 1, '\n', data_length - (size_t)(newline + 1 - data))) {
+		*newline = ' ';
+	}
+
+	if (entry && entry->handler == stream_event_handle_delta) {
+		callback_data->content_seen = true;
+		if (entry->delta_type == OPENAI_DELTA_OUTPUT_TEXT && callback_data->first_delta_us < 0) {
+			callback_data->first_delta_us = stream_context_elapsed_us(callback_data);
+		}
 	}
+	stream_context_emit(callback_data, OPENAI_DELTA_RAW_EVENT, data, data_length);
+}
 
-	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_object_to_json_string(json_request_data));
+// handles a single complete event, returns false to stop processing the stream
+static bool curl_callback_openai_stream_dispatch_event(const char* event_name, const size_t event_name_length,
+                                                       char* data, const size_t data_length, void* user_data) {
+	curl_callback_stream_callback_data* callback_data = user_data;
+	callback_data->event_count++;
 
-	curl_callback_stream_callback_data* curl_callback_data = malloc(sizeof(curl_callback_stream_callback_data));
-	curl_callback_data->callback = callback;
-	curl_callback_data->user_data = user_data;
-	curl_callback_data->error = NULL;
-	curl_callback_data->current_event_buffer = NULL;
-	curl_callback_data->current_event_buffer_length = 0;
-	curl_callback_data->request = request;
+	const stream_event_handler_entry* entry = stream_event_lookup(event_name, event_name_length);
+	if (callback_data->request->raw == OPENAI_RAW_STREAM) {
+		stream_event_pass_raw(entry, data, data_length, callback_data);
+	}
+	if (entry == NULL) return true;
 
-	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_callback_openai_stream_response);
-	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &curl_callback_data);
-	// copy of pointer is passed through, so just pass address in to get actual reference
+	return entry->handler(entry, data, data_length, user_data);
+}
 
-	const CURLcode curl_response = curl_easy_perform(curl);
+// value of a header line if it's the named header (case-insensitive, name includes the colon), NULL otherwise.
+// the value isn't NUL-terminated, value_end is set to its end (without the trailing CRLF).
+static const char* header_value(const char* header, const size_t header_length, const char* name,
+                                const char** value_end) {
+	const size_t name_length = strlen(name);
+	if (header_length <= name_length || strncasecmp(header, name, name_length) != 0) return NULL;
 
+	const char* value = header + name_length;
+	const char* end = header + header_length;
+	while (value < end && (*value == ' ' || *value == '\t')) value++;
+	while (end > value && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ')) end--;
 
-	// duplicate to be able to free curl_callback_data
-	char* potential_error = NULL;
-	if (curl_callback_data->error != NULL) {
-		potential_error = strdup(curl_callback_data->error);
+	*value_end = end;
+	return value;
+}
+
+// durations as used by the x-ratelimit-reset-* headers, e.g. "1s", "6m0s", "20ms" or "1h2m3.5s"
+static double header_parse_duration(const char* value, const char* value_end) {
+	double seconds = 0;
+	const char* current = value;
+	while (current < value_end) {
+		char* unit = NULL;
+		const double amount = strtod(current, &unit);
+		if (unit == current || unit > value_end) break;
+
+		if (unit + 1 < value_end && unit[0] == 'm' && unit[1] == 's') {
+			seconds += amount / 1000;
+			current = unit + 2;
+			continue;
+		}
+
+		switch (unit < value_end ? *unit : 's') {
+		case 'h': seconds += amount * 3600; break;
+		case 'm': seconds += amount * 60; break;
+		default: seconds += amount; break;
+		}
+		current = unit + 1;
 	}
+	return seconds;
+}
 
-	// finalize
-	curl_slist_free_all(header_list);
-	memset(auth_header, 0, strlen(auth_header)); // let's not let an API key sit in memory
-	free(auth_header);
-	free(curl_callback_data->error);
-	free(curl_callback_data->current_event_buffer);
-	free(curl_callback_data);
-	json_object_put(json_request_data);
+static void header_parse_rate_limit(const char* header, const size_t header_length, openai_rate_limit* rate_limit) {
+	const char* value_end = NULL;
+	const char* value = NULL;
 
-	if (potential_error != NULL) {
-		return potential_error;
+	if ((value = header_value(header, header_length, "x-ratelimit-remaining-requests:", &value_end))) {
+		rate_limit->remaining_requests = strtol(value, NULL, 10);
+	} else if ((value = header_value(header, header_length, "x-ratelimit-reset-requests:", &value_end))) {
+		rate_limit->reset_requests_seconds = header_parse_duration(value, value_end);
+	} else if ((value = header_value(header, header_length, "x-ratelimit-remaining-tokens:", &value_end))) {
+		rate_limit->remaining_tokens = strtol(value, NULL, 10);
+	} else if ((value = header_value(header, header_length, "x-ratelimit-reset-tokens:", &value_end))) {
+		rate_limit->reset_tokens_seconds = header_parse_duration(value, value_end);
+	} else if ((value = header_value(header, header_length, "retry-after-ms:", &value_end))) {
+		rate_limit->retry_after_seconds = strtod(value, NULL) / 1000;
+	} else if ((value = header_value(header, header_length, "retry-after:", &value_end))) {
+		// can also be an HTTP date, which isn't something the API sends
+		if (rate_limit->retry_after_seconds == 0) rate_limit->retry_after_seconds = strtod(value, NULL);
+	} else return;
+
+	rate_limit->updated = true;
+}
+
+// called once per header line (including the status line), returns number of bytes handled
+static size_t curl_callback_openai_stream_header(const char* header, const size_t size_atomic, const size_t n_elements,
+                                                 curl_callback_stream_callback_data* callback_data) {
+	const size_t header_length = size_atomic * n_elements; // not NUL-terminated
+
+	// a new status line starts a new set of headers (e.g. after a redirect or 100 Continue)
+	const char* status_prefix = "HTTP/";
+	if (header_length > strlen(status_prefix) && strncmp(header, status_prefix, strlen(status_prefix)) == 0) {
+		const char* status_start = memchr(header, ' ', header_length);
+		callback_data->http_status = status_start ? strtol(status_start + 1, NULL, 10) : 0;
+		callback_data->is_event_stream = false;
+		return header_length;
 	}
 
-	if (curl_response != CURLE_OK) {
-		return strdup(curl_easy_strerror(curl_response));
+	const char* value_end = NULL;
+	const char* value = header_value(header, header_length, "content-type:", &value_end);
+	if (value != NULL) {
+		const char* event_stream_type = "text/event-stream";
+		callback_data->is_event_stream = (size_t)(value_end - value) >= strlen(event_stream_type) &&
+			strncasecmp(value, event_stream_type, strlen(event_stream_type)) == 0;
+		return header_length;
 	}
 
-	curl_easy_cleanup(curl);
+	header_parse_rate_limit(header, header_length, &callback_data->rate_limit);
 
-	return NULL;
+	return header_length;
+}
+
+// turns a collected error body into a message, caller frees
+static char* curl_callback_openai_stream_error_message(curl_callback_stream_callback_data* callback_data) {
+	char* message = NULL;
+
+	if (callback_data->error_body != NULL) {
+		json_tokener_reset(callback_data->tok);
+		json_object* error_response = json_tokener_parse_ex(callback_data->tok, callback_data->error_body,
+		                                                    (int)callback_data->error_body_length);
+		json_object* error_json = NULL;
+		json_object* message_json = NULL;
+		if (error_response != NULL && json_object_object_get_ex(error_response, "error", &error_json) &&
+			json_object_object_get_ex(error_json, "message", &message_json)) {
+			message = strdup(json_object_get_string(message_json));
+		}
+		json_object_put(error_response);
+	}
+
+	if (message == NULL) {
+		const char* format = "Unexpected response (HTTP %ld)";
+		const size_t len = snprintf(NULL, 0, format, callback_data->http_status) + 1;
+		message = malloc(len);
+		snprintf(message, len, format, callback_data->http_status);
+	}
+
+	return message;
+}
+
+// returns number of bytes handled, as specified in CURL docs
+static size_t curl_callback_openai_stream_response(const char* content_ptr, const size_t size_atomic,
+                                                   const size_t n_elements,
+                                                   curl_callback_stream_callback_data* callback_data) {
+	const size_t total_chunk_size = size_atomic * n_elements; // = length of content_ptr
+
+	// don't process further if we've already seen an error
+	if (callback_data->error != NULL) {
+		return total_chunk_size;
+	}
+
+	// OpenAI errors are a single JSON object with a non-2xx status, collect it and parse once the transfer is done
+	if (callback_data->http_status >= 300 || !callback_data->is_event_stream) {
+		char* new_error_body = realloc(callback_data->error_body,
+		                               callback_data->error_body_length + total_chunk_size + 1);
+		if (!new_error_body) {
+			callback_data->error = strdup("Failed to allocate memory for error response");
+			return 0;
+		}
+		callback_data->error_body = new_error_body;
+		memcpy(callback_data->error_body + callback_data->error_body_length, content_ptr, total_chunk_size);
+		callback_data->error_body_length += total_chunk_size;
+		callback_data->error_body[callback_data->error_body_length] = '\0';
+		return total_chunk_size;
+	}
+
+	// complete events are formatted:
+	// event: whatever.event\ndata: {some json object}\n\n
+	// the framer splits them out as they complete and keeps any partial event for the next chunk
+	const bool framed = sse_framer_feed(&callback_data->framer, content_ptr, total_chunk_size,
+	                                    curl_callback_openai_stream_dispatch_event, callback_data);
+
+	if (!framed) {
+		if (callback_data->error == NULL) {
+			callback_data->error = strdup("Failed to allocate memory for event");
+		}
+		return 0;
+	}
+
+	return total_chunk_size;
+}
+
+// what's registered with CURL, measures the CPU time of parsing for detailed timings. everything in the chunk has
+// been passed on afterward, so the callback gets to flush its output once per chunk instead of once per delta
+static size_t curl_callback_openai_stream_response_timed(const char* content_ptr, const size_t size_atomic,
+                                                         const size_t n_elements,
+                                                         curl_callback_stream_callback_data* callback_data) {
+	size_t handled;
+	if (callback_data->request->timings != OPENAI_TIMINGS_DETAILED) {
+		handled = curl_callback_openai_stream_response(content_ptr, size_atomic, n_elements, callback_data);
+	} else {
+		const int64_t start = thread_cpu_ns();
+		handled = curl_callback_openai_stream_response(content_ptr, size_atomic, n_elements, callback_data);
+		callback_data->parser_cpu_ns += thread_cpu_ns() - start;
+	}
+
+	if (callback_data->flush_pending) {
+		callback_data->flush_pending = false;
+		callback_data->callback(OPENAI_DELTA_FLUSH, "", 0, callback_data->user_data);
+	}
+	return handled;
+}
+
+
+// the request body is written straight into CURL's upload buffer as it asks for more, so a big input is never copied
+// into a JSON object and a serialized string first. it's a handful of pieces: JSON as is, strings which are escaped
+// on the way out and attachments which are base64 encoded on the way out
+#define REQUEST_BODY_MAX_PIECES (24 + 8 * OPENAI_REQUEST_MAX_ATTACHMENTS)
+
+// uploaded parts of an attachment are dropped from memory in blocks this big (a multiple of any page size), and read
+// back from the file if CURL rewinds
+#define REQUEST_BODY_RELEASE_SIZE (8 * 1024 * 1024)
+
+typedef enum {
+	REQUEST_BODY_JSON,
+	REQUEST_BODY_STRING, // a string's contents, the quotes are in the pieces around it
+	REQUEST_BODY_BASE64, // an attachment's bytes, inside a string
+} request_body_piece_kind;
+
+typedef struct {
+	const char* text;
+	size_t length; // before escaping or encoding
+	request_body_piece_kind kind;
+} request_body_piece;
+
+typedef struct {
+	request_body_piece pieces[REQUEST_BODY_MAX_PIECES];
+	size_t piece_count;
+	curl_off_t length; // of the whole body once written out
+
+	// where the next read carries on from
+	size_t piece;
+	size_t offset;
+	size_t released; // of the current attachment, see REQUEST_BODY_RELEASE_SIZE
+
+	char numbers[2][32]; // temperature and max tokens, formatted
+} request_body;
+
+// what each byte needs to look like inside a JSON string: 0 as it is, 1 for \u00XX, otherwise the escape character
+static const unsigned char json_escapes[256] = {
+	1, 1, 1, 1, 1, 1, 1, 1, 'b', 't', 'n', 1, 'f', 'r', 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	['"'] = '"', ['\\'] = '\\',
+};
+
+static size_t json_escaped_length(const char* text, const size_t length) {
+	size_t escaped_length = length;
+	for (size_t i = 0; i < length; i++) {
+		const unsigned char escape = json_escapes[(unsigned char)text[i]];
+		if (escape) escaped_length += escape == 1 ? 5 : 1;
+	}
+	return escaped_length;
+}
+
+static const char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t base64_encoded_length(const size_t length) {
+	return (length + 2) / 3 * 4;
+}
+
+// 3 bytes at a time, padding the last group. returns the characters written
+static size_t base64_encode_scalar(char* out, const unsigned char* in, const size_t length) {
+	size_t written = 0;
+	size_t i = 0;
+	for (; i + 3 <= length; i += 3) {
+		const uint32_t group = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2];
+		out[written] = base64_alphabet[group >> 18];
+		out[written + 1] = base64_alphabet[group >> 12 & 0x3f];
+		out[written + 2] = base64_alphabet[group >> 6 & 0x3f];
+		out[written + 3] = base64_alphabet[group & 0x3f];
+		written += 4;
+	}
+
+	if (i < length) {
+		const uint32_t group = (uint32_t)in[i] << 16 | (i + 1 < length ? (uint32_t)in[i + 1] << 8 : 0);
+		out[written] = base64_alphabet[group >> 18];
+		out[written + 1] = base64_alphabet[group >> 12 & 0x3f];
+		out[written + 2] = i + 1 < length ? base64_alphabet[group >> 6 & 0x3f] : '=';
+		out[written + 3] = '=';
+		written += 4;
+	}
+	return written;
+}
+
+#ifdef BASE64_SSSE3
+// 12 bytes into 16 characters per step, all lanes at once (Wojciech Muła's pshufb method). every step loads 16 bytes,
+// so it stops while at least that many are left. returns the bytes consumed, a multiple of 12
+__attribute__((target("ssse3")))
+static size_t base64_encode_ssse3(char* out, const unsigned char* in, const size_t length) {
+	// each 32 bit lane gets 3 input bytes, arranged so the 4 sextets can be shifted into place with two multiplies
+	const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	// added to each sextet by which range of the alphabet it falls in: A-Z, a-z, 0-9, + and /
+	const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	                                      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	size_t i = 0;
+	for (; i + 16 <= length; i += 12) {
+		__m128i bytes = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i)), shuffle);
+
+		const __m128i high = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)),
+		                                     _mm_set1_epi32(0x04000040));
+		const __m128i low = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)),
+		                                    _mm_set1_epi32(0x01000010));
+		const __m128i sextets = _mm_or_si128(high, low);
+
+		// 0-51 becomes 0, 52-61 becomes 1-10, 62 and 63 become 11 and 12. then 0-25 is told apart from 26-51 as 13
+		__m128i range = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+		const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets);
+		range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+
+		_mm_storeu_si128((__m128i*)(out + i / 3 * 4),
+		                 _mm_add_epi8(sextets, _mm_shuffle_epi8(offsets, range)));
+	}
+	return i;
+}
+#endif
+
+// returns the characters written, base64_encoded_length(length) of them
+static size_t base64_encode(char* out, const unsigned char* in, const size_t length) {
+	size_t consumed = 0;
+#ifdef BASE64_SSSE3
+	if (length >= 16 && __builtin_cpu_supports("ssse3")) consumed = base64_encode_ssse3(out, in, length);
+#endif
+	return consumed / 3 * 4 + base64_encode_scalar(out + consumed / 3 * 4, in + consumed, length - consumed);
+}
+
+// gives pages of an attachment which have been uploaded (or hashed) back, up to offset, in whole release blocks
+static void attachment_release(const unsigned char* data, size_t* released, const size_t offset) {
+	const size_t end = offset - offset % REQUEST_BODY_RELEASE_SIZE;
+	if (end <= *released) return;
+
+	#ifdef _WIN32
+	(void)data; // read into memory, nothing to give back until it's freed
+	#else
+	madvise((void*)(data + *released), end - *released, MADV_DONTNEED);
+	#endif
+	*released = end;
+}
+
+// stands in for an attachment's bytes in the response cache's key, instead of all of them encoded
+static void attachment_fingerprint(char* out, const size_t out_size, const unsigned char* data, const size_t size) {
+	uint64_t hash = 0x9e3779b97f4a7c15ull ^ size;
+	size_t released = 0;
+	for (size_t block = 0; block < size; block += REQUEST_BODY_RELEASE_SIZE) {
+		const size_t block_end = size - block < REQUEST_BODY_RELEASE_SIZE ? size : block + REQUEST_BODY_RELEASE_SIZE;
+
+		size_t i = block;
+		for (; i + 8 <= block_end; i += 8) {
+			uint64_t word;
+			memcpy(&word, data + i, sizeof(word));
+			hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+			hash ^= hash >> 32;
+		}
+		for (; i < block_end; i++) {
+			hash = (hash ^ data[i]) * 0xff51afd7ed558ccdull;
+			hash ^= hash >> 32;
+		}
+		attachment_release(data, &released, block_end);
+	}
+	snprintf(out, out_size, "attachment:%016llx:%zu", (unsigned long long)hash, size);
+}
+
+static void request_body_append_bytes(request_body* body, const char* text, const size_t length,
+                                      const request_body_piece_kind kind) {
+	body->pieces[body->piece_count++] = (request_body_piece){.text = text, .length = length, .kind = kind};
+	body->length += (curl_off_t)(kind == REQUEST_BODY_STRING ? json_escaped_length(text, length)
+		: kind == REQUEST_BODY_BASE64 ? base64_encoded_length(length) : length);
+}
+
+static void request_body_append(request_body* body, const char* text, const request_body_piece_kind kind) {
+	request_body_append_bytes(body, text, strlen(text), kind);
+}
+
+// ,"key":"value"
+static void request_body_append_string(request_body* body, const char* key_prefix, const char* value) {
+	request_body_append(body, key_prefix, REQUEST_BODY_JSON);
+	request_body_append(body, value, REQUEST_BODY_STRING);
+	request_body_append(body, "\"", REQUEST_BODY_JSON);
+}
+
+// shortest form which reads back as the same double
+static void json_format_double(char* out, const size_t out_size, const double value) {
+	snprintf(out, out_size, "%.15g", value);
+	if (strtod(out, NULL) != value) snprintf(out, out_size, "%.17g", value);
+}
+
+// the input on its own, or as the first content part of a user message with one part per attachment after it
+static void request_body_append_input(request_body* body, const openai_request* request) {
+	if (request->attachment_count == 0) {
+		request_body_append_string(body, ",\"input\":\"", request->input);
+		return;
+	}
+
+	request_body_append_string(body, ",\"input\":[{\"role\":\"user\",\"content\":[{\"type\":\"input_text\",\"text\":\"",
+	                           request->input);
+	request_body_append(body, "}", REQUEST_BODY_JSON);
+
+	for (size_t i = 0; i < request->attachment_count; i++) {
+		const openai_attachment* attachment = &request->attachments[i];
+		if (attachment->image) {
+			request_body_append(body, ",{\"type\":\"input_image\",\"image_url\":\"data:", REQUEST_BODY_JSON);
+		} else {
+			request_body_append_string(body, ",{\"type\":\"input_file\",\"filename\":\"",
+			                           strrchr(attachment->path, PATH_SEPARATOR) + 1);
+			request_body_append(body, ",\"file_data\":\"data:", REQUEST_BODY_JSON);
+		}
+		request_body_append(body, attachment->mime_type, REQUEST_BODY_JSON);
+		request_body_append(body, ";base64,", REQUEST_BODY_JSON);
+		request_body_append_bytes(body, (const char*)attachment->data, attachment->size, REQUEST_BODY_BASE64);
+		request_body_append(body, "\"}", REQUEST_BODY_JSON);
+	}
+
+	request_body_append(body, "]}]", REQUEST_BODY_JSON);
+}
+
+// the body borrows the request's strings, keep it around for as long as the body is
+static void request_body_init(request_body* body, const openai_request* request) {
+	*body = (request_body){0};
+
+	request_body_append_string(body, "{\"stream\":true,\"model\":\"", request->model);
+	request_body_append_input(body, request);
+	if (request->instructions != NULL) {
+		request_body_append_string(body, ",\"instructions\":\"", request->instructions);
+	}
+	if (request->previous_response_id != NULL) {
+		request_body_append_string(body, ",\"previous_response_id\":\"", request->previous_response_id);
+	}
+
+	if (request->temperature != OPENAI_REQUEST_TEMPERATURE_NOT_SET) {
+		json_format_double(body->numbers[0], sizeof(body->numbers[0]), request->temperature);
+		request_body_append(body, ",\"temperature\":", REQUEST_BODY_JSON);
+		request_body_append(body, body->numbers[0], REQUEST_BODY_JSON);
+	}
+	if (request->max_tokens != OPENAI_REQUEST_MAX_TOKENS_NOT_SET) {
+		snprintf(body->numbers[1], sizeof(body->numbers[1]), "%zu", request->max_tokens);
+		request_body_append(body, ",\"max_output_tokens\":", REQUEST_BODY_JSON);
+		request_body_append(body, body->numbers[1], REQUEST_BODY_JSON);
+	}
+
+	request_body_append(body, "}", REQUEST_BODY_JSON);
+}
+
+// CURLOPT_READFUNCTION, fills the buffer with as much of the body as fits
+static size_t request_body_read(char* buffer, const size_t size, const size_t n_items, void* body_ptr) {
+	request_body* body = body_ptr;
+	const size_t capacity = size * n_items;
+	size_t written = 0;
+
+	while (body->piece < body->piece_count) {
+		const request_body_piece* piece = &body->pieces[body->piece];
+
+		if (piece->kind == REQUEST_BODY_JSON) {
+			size_t count = piece->length - body->offset;
+			if (count > capacity - written) count = capacity - written;
+			memcpy(buffer + written, piece->text + body->offset, count);
+			written += count;
+			body->offset += count;
+		} else if (piece->kind == REQUEST_BODY_BASE64) {
+			// whole groups of 3 bytes at a time, so a read never ends in the middle of one
+			size_t count = piece->length - body->offset;
+			const size_t room = (capacity - written) / 4 * 3;
+			if (count > room) count = room;
+			const unsigned char* data = (const unsigned char*)piece->text;
+			written += base64_encode(buffer + written, data + body->offset, count);
+			body->offset += count;
+			attachment_release(data, &body->released, body->offset);
+		} else {
+			while (body->offset < piece->length) {
+				// runs of characters which don't need escaping are copied as they are
+				size_t run = body->offset;
+				while (run < piece->length && !json_escapes[(unsigned char)piece->text[run]]) run++;
+				size_t count = run - body->offset;
+				if (count > capacity - written) count = capacity - written;
+				memcpy(buffer + written, piece->text + body->offset, count);
+				written += count;
+				body->offset += count;
+				if (body->offset == piece->length || written == capacity) break;
+
+				// an escape is never split between reads, there's always room for one in a fresh buffer
+				const unsigned char character = (unsigned char)piece->text[body->offset];
+				const unsigned char escape = json_escapes[character];
+				const size_t escape_length = escape == 1 ? 6 : 2;
+				if (capacity - written < escape_length) break;
+
+				buffer[written] = '\\';
+				if (escape == 1) {
+					static const char hex[] = "0123456789abcdef";
+					memcpy(buffer + written + 1, "u00", 3);
+					buffer[written + 4] = hex[character >> 4];
+					buffer[written + 5] = hex[character & 0xf];
+				} else buffer[written + 1] = (char)escape;
+				written += escape_length;
+				body->offset++;
+			}
+		}
+
+		if (body->offset < piece->length) break; // the buffer is full
+		body->piece++;
+		body->offset = 0;
+		body->released = 0;
+	}
+
+	return written;
+}
+
+// CURLOPT_SEEKFUNCTION, CURL may need to send the body again from the start (e.g. a retried HTTP/2 stream)
+static int request_body_seek(void* body_ptr, const curl_off_t offset, const int origin) {
+	if (offset != 0 || origin != SEEK_SET) return CURL_SEEKFUNC_CANTSEEK;
+
+	request_body* body = body_ptr;
+	body->piece = 0;
+	body->offset = 0;
+	body->released = 0;
+	return CURL_SEEKFUNC_OK;
+}
+
+// the whole body as one string. caller frees
+static char* request_body_to_string(request_body* body) {
+	char* string = malloc((size_t)body->length + 1);
+	if (!string) return NULL;
+
+	size_t length = 0;
+	while (length < (size_t)body->length) {
+		length += request_body_read(string + length, 1, (size_t)body->length - length, body);
+	}
+	string[length] = '\0';
+	request_body_seek(body, 0, SEEK_SET);
+	return string;
+}
+
+// the whole body as one string for the response cache's key, with attachments fingerprinted. caller frees
+static char* request_body_to_key(const request_body* body) {
+	request_body key = *body;
+	char fingerprints[OPENAI_REQUEST_MAX_ATTACHMENTS][64];
+	size_t attachment = 0;
+
+	for (size_t i = 0; i < key.piece_count; i++) {
+		request_body_piece* piece = &key.pieces[i];
+		if (piece->kind != REQUEST_BODY_BASE64) continue;
+
+		char* fingerprint = fingerprints[attachment++];
+		attachment_fingerprint(fingerprint, sizeof(fingerprints[0]), (const unsigned char*)piece->text, piece->length);
+		key.length -= (curl_off_t)base64_encoded_length(piece->length);
+		key.length += (curl_off_t)strlen(fingerprint);
+		*piece = (request_body_piece){.text = fingerprint, .length = strlen(fingerprint), .kind = REQUEST_BODY_JSON};
+	}
+
+	key.piece = 0;
+	key.offset = 0;
+	return request_body_to_string(&key);
+}
+
+// sends the body with the next transfer of the handle. POST, with a Content-Length rather than chunked
+static void request_body_attach(CURL* curl, request_body* body) {
+	curl_easy_setopt(curl, CURLOPT_POST, 1L);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, NULL);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, body->length);
+	curl_easy_setopt(curl, CURLOPT_READFUNCTION, request_body_read);
+	curl_easy_setopt(curl, CURLOPT_READDATA, body);
+	curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, request_body_seek);
+	curl_easy_setopt(curl, CURLOPT_SEEKDATA, body);
+}
+
+static curl_callback_stream_callback_data* stream_context_new(openai_request* request, openai_delta_callback callback,
+                                                              void* user_data) {
+	curl_callback_stream_callback_data* curl_callback_data = malloc(sizeof(curl_callback_stream_callback_data));
+	if (!curl_callback_data) return NULL;
+
+	curl_callback_data->callback = callback;
+	curl_callback_data->user_data = user_data;
+	curl_callback_data->error = NULL;
+	curl_callback_data->response_id = NULL;
+	sse_framer_init(&curl_callback_data->framer);
+	curl_callback_data->tok = json_tokener_new();
+	curl_callback_data->http_status = 0;
+	curl_callback_data->is_event_stream = false;
+	curl_callback_data->error_body = NULL;
+	curl_callback_data->error_body_length = 0;
+	curl_callback_data->request = request;
+	curl_callback_data->rate_limit = (openai_rate_limit){
+		.remaining_requests = -1,
+		.remaining_tokens = -1,
+	};
+
+	clock_gettime(CLOCK_MONOTONIC, &curl_callback_data->started);
+	curl_callback_data->created_us = -1;
+	curl_callback_data->first_delta_us = -1;
+	curl_callback_data->last_delta_us = -1;
+	curl_callback_data->event_count = 0;
+	curl_callback_data->delta_count = 0;
+	curl_callback_data->delta_gaps_us = NULL;
+	curl_callback_data->delta_gap_count = 0;
+	curl_callback_data->delta_gap_capacity = 0;
+	curl_callback_data->parser_cpu_ns = 0;
+	curl_callback_data->input_tokens = -1;
+	curl_callback_data->output_tokens = -1;
+	curl_callback_data->hedge_us = -1;
+	curl_callback_data->hedge_won = false;
+	curl_callback_data->warmup_us = -1;
+	curl_callback_data->warmup_hidden_us = -1;
+	curl_callback_data->flush_pending = false;
+	curl_callback_data->content_seen = false;
+	curl_callback_data->cancelled = NULL;
+	curl_callback_data->delta_fast_path = true;
+
+	return curl_callback_data;
+}
+
+static void stream_context_free(curl_callback_stream_callback_data* curl_callback_data) {
+	free(curl_callback_data->error);
+	free(curl_callback_data->response_id);
+	sse_framer_free(&curl_callback_data->framer);
+	json_tokener_free(curl_callback_data->tok);
+	free(curl_callback_data->error_body);
+	free(curl_callback_data->delta_gaps_us);
+	free(curl_callback_data);
+}
+
+// CURL calls it whenever data moves (and about once a second otherwise), a non-zero return aborts the transfer
+static int curl_callback_stream_progress(void* callback_data_ptr, const curl_off_t download_total,
+                                         const curl_off_t download_now, const curl_off_t upload_total,
+                                         const curl_off_t upload_now) {
+	(void)download_total;
+	(void)download_now;
+	(void)upload_total;
+	(void)upload_now;
+	const curl_callback_stream_callback_data* callback_data = callback_data_ptr;
+	return *callback_data->cancelled ? 1 : 0;
+}
+
+// point a handle's callbacks at a stream context
+static void stream_context_attach(CURL* curl, curl_callback_stream_callback_data* curl_callback_data) {
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, curl_callback_openai_stream_header);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, curl_callback_data);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_callback_openai_stream_response_timed);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, curl_callback_data);
+
+	// only sessions can be cancelled, the progress callback stays off for everything else
+	if (curl_callback_data->cancelled) {
+		curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+		curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, curl_callback_stream_progress);
+		curl_easy_setopt(curl, CURLOPT_XFERINFODATA, curl_callback_data);
+	} else {
+		curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+		curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, NULL);
+	}
+}
+
+// for a handle which outlives its stream context (a session's), so a warm-up in between doesn't call back into it
+static void stream_context_detach(CURL* curl) {
+	curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+	curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, NULL);
+}
+
+// error for a finished transfer, NULL if it was successful (caller frees)
+static char* stream_context_result(curl_callback_stream_callback_data* curl_callback_data, const CURLcode curl_response) {
+	if (curl_callback_data->cancelled && *curl_callback_data->cancelled) {
+		return strdup("Cancelled");
+	}
+
+	if (curl_callback_data->error != NULL) {
+		return strdup(curl_callback_data->error);
+	}
+
+	if (curl_response != CURLE_OK) {
+		return strdup(curl_easy_strerror(curl_response));
+	}
+
+	if (curl_callback_data->http_status >= 300 || !curl_callback_data->is_event_stream) {
+		return curl_callback_openai_stream_error_message(curl_callback_data);
+	}
+
+	return NULL;
+}
+
+struct openai_stream_parser {
+	curl_callback_stream_callback_data* context;
+};
+
+openai_stream_parser* openai_stream_parser_new(openai_request* request, const openai_delta_callback callback,
+                                               void* user_data) {
+	openai_stream_parser* parser = malloc(sizeof(openai_stream_parser));
+	if (!parser) return NULL;
+
+	parser->context = stream_context_new(request, callback, user_data);
+	if (!parser->context) {
+		free(parser);
+		return NULL;
+	}
+
+	// as if the headers of a successful response had arrived
+	parser->context->http_status = 200;
+	parser->context->is_event_stream = true;
+	return parser;
+}
+
+bool openai_stream_parser_feed(openai_stream_parser* parser, const char* chunk, const size_t length) {
+	const size_t handled = curl_callback_openai_stream_response_timed(chunk, 1, length, parser->context);
+	return handled == length && parser->context->error == NULL;
+}
+
+void openai_stream_parser_set_fast_path(openai_stream_parser* parser, const bool enabled) {
+	parser->context->delta_fast_path = enabled;
+}
+
+char* openai_stream_parser_finish(openai_stream_parser* parser) {
+	char* potential_error = stream_context_result(parser->context, CURLE_OK);
+	stream_context_free(parser->context);
+	free(parser);
+	return potential_error;
+}
+
+static int compare_uint32(const void* a, const void* b) {
+	const uint32_t first = *(const uint32_t*)a;
+	const uint32_t second = *(const uint32_t*)b;
+	return first < second ? -1 : first > second;
+}
+
+// one of CURL's microsecond timers or byte counters for the last transfer, 0 if it isn't available
+static int64_t curl_info_int64(CURL* curl, const CURLINFO info) {
+	curl_off_t value = 0;
+	if (curl_easy_getinfo(curl, info, &value) != CURLE_OK) return 0;
+	return (int64_t)value;
+}
+
+// sends OPENAI_DELTA_TIMINGS for a finished transfer, if the request asked for it
+static void stream_context_emit_timings(curl_callback_stream_callback_data* callback_data, CURL* curl) {
+	if (callback_data->request->timings == OPENAI_TIMINGS_OFF) return;
+
+	json_object* timings = json_object_new_object();
+	#define TIMINGS_FIELD(name, value) json_object_object_add(timings, name, json_object_new_int64(value))
+	#define TIMINGS_FIELD_IF_SET(name, value) if ((value) >= 0) TIMINGS_FIELD(name, value)
+
+	// CURL's times are each measured from the start of the transfer, and 0 if that phase didn't happen
+	const int64_t name_lookup_us = curl_info_int64(curl, CURLINFO_NAMELOOKUP_TIME_T);
+	const int64_t connect_us = curl_info_int64(curl, CURLINFO_CONNECT_TIME_T);
+	const int64_t tls_us = curl_info_int64(curl, CURLINFO_APPCONNECT_TIME_T);
+	TIMINGS_FIELD("dns_us", name_lookup_us);
+	TIMINGS_FIELD("connect_us", connect_us > name_lookup_us ? connect_us - name_lookup_us : 0);
+	TIMINGS_FIELD("tls_us", tls_us > connect_us ? tls_us - connect_us : 0);
+	TIMINGS_FIELD("ttfb_us", curl_info_int64(curl, CURLINFO_STARTTRANSFER_TIME_T));
+	TIMINGS_FIELD_IF_SET("created_us", callback_data->created_us);
+	TIMINGS_FIELD_IF_SET("first_delta_us", callback_data->first_delta_us);
+	TIMINGS_FIELD("total_us", stream_context_elapsed_us(callback_data));
+
+	if (callback_data->delta_gap_count > 0) {
+		const size_t count = callback_data->delta_gap_count;
+		qsort(callback_data->delta_gaps_us, count, sizeof(uint32_t), compare_uint32);
+		TIMINGS_FIELD("delta_gap_p50_us", callback_data->delta_gaps_us[count / 2]);
+		TIMINGS_FIELD("delta_gap_p95_us", callback_data->delta_gaps_us[count * 95 / 100]);
+		TIMINGS_FIELD("delta_gap_max_us", callback_data->delta_gaps_us[count - 1]);
+	}
+
+	TIMINGS_FIELD("deltas", (int64_t)callback_data->delta_count);
+	TIMINGS_FIELD("events", (int64_t)callback_data->event_count);
+	TIMINGS_FIELD("bytes", curl_info_int64(curl, CURLINFO_SIZE_DOWNLOAD_T));
+	if (callback_data->request->timings == OPENAI_TIMINGS_DETAILED) {
+		TIMINGS_FIELD("parser_cpu_us", callback_data->parser_cpu_ns > 0 ? callback_data->parser_cpu_ns / 1000 : 0);
+	}
+	TIMINGS_FIELD_IF_SET("input_tokens", callback_data->input_tokens);
+	TIMINGS_FIELD_IF_SET("output_tokens", callback_data->output_tokens);
+	if (callback_data->hedge_us >= 0) {
+		TIMINGS_FIELD("hedge_us", callback_data->hedge_us);
+		TIMINGS_FIELD("hedge_won", callback_data->hedge_won);
+	}
+	if (callback_data->warmup_us >= 0) {
+		TIMINGS_FIELD("warmup_us", callback_data->warmup_us);
+		TIMINGS_FIELD("warmup_hidden_us", callback_data->warmup_hidden_us);
+	}
+
+	#undef TIMINGS_FIELD_IF_SET
+	#undef TIMINGS_FIELD
+
+	const char* timings_string = json_object_to_json_string_ext(timings, JSON_C_TO_STRING_PLAIN);
+	callback_data->callback(OPENAI_DELTA_TIMINGS, timings_string, strlen(timings_string), callback_data->user_data);
+	json_object_put(timings);
+}
+
+// sits between a stream and its callback, recording the deltas for the response cache
+typedef struct {
+	openai_delta_callback callback;
+	void* user_data;
+
+	chatgpt_cli_cache_writer* writer;
+	char* key;
+	size_t key_length;
+} cache_tap;
+
+static void cache_tap_callback(const openai_delta_type type, const char* delta, const size_t length,
+                               void* user_data) {
+	cache_tap* tap = user_data;
+	// the id is kept separately, whether it's echoed isn't part of the key. timings and flushes only describe this
+	// one transfer
+	if (type != OPENAI_DELTA_RESPONSE_ID && type != OPENAI_DELTA_TIMINGS && type != OPENAI_DELTA_FLUSH) {
+		chatgpt_cli_cache_writer_append(tap->writer, type, delta, length);
+	}
+	tap->callback(type, delta, length, tap->user_data);
+}
+
+// looks the request up in the response cache. returns true if it doesn't need to be sent: either it was replayed
+// through the callback (*response_id_out set, caller frees) or it's a cache only miss (*error_out set, caller frees).
+// otherwise the tap is set up to record the response, send it through cache_tap_callback and end with cache_tap_end
+static bool cache_tap_begin(cache_tap* tap, const openai_request* request, const char* request_body,
+                            const openai_delta_callback callback, void* user_data, char** response_id_out,
+                            char** error_out) {
+	*tap = (cache_tap){.callback = callback, .user_data = user_data};
+	*response_id_out = NULL;
+	*error_out = NULL;
+
+	// raw requests stream something else back for the same body, and so does any other server
+	const char* key_suffix = request->raw == OPENAI_RAW_STREAM ? "\nraw-stream"
+		: request->raw == OPENAI_RAW_FINAL ? "\nraw" : "";
+	const char* key_url = openai_api_url ? openai_api_url : "";
+	tap->key_length = strlen(request_body) + strlen(key_suffix) + (openai_api_url ? 1 + strlen(key_url) : 0);
+	tap->key = malloc(tap->key_length + 1);
+	strcpy(tap->key, request_body);
+	strcat(tap->key, key_suffix);
+	if (openai_api_url) {
+		strcat(tap->key, "\n");
+		strcat(tap->key, key_url);
+	}
+
+	chatgpt_cli_cache_entry* entry = chatgpt_cli_cache_get(tap->key, tap->key_length);
+	if (entry) {
+		const char* response_id = chatgpt_cli_cache_entry_get_response_id(entry);
+		if (response_id && request->echo_response_id && !request->raw) {
+			callback(OPENAI_DELTA_RESPONSE_ID, response_id, strlen(response_id), user_data);
+		}
+		chatgpt_cli_cache_entry_replay(entry, callback, user_data);
+
+		if (response_id) *response_id_out = strdup(response_id);
+		chatgpt_cli_cache_entry_free(entry);
+		free(tap->key);
+		return true;
+	}
+
+	if (request->cache == OPENAI_CACHE_ONLY) {
+		*error_out = strdup("Response isn't cached");
+		free(tap->key);
+		return true;
+	}
+
+	tap->writer = chatgpt_cli_cache_writer_new();
+	return false;
+}
+
+// stores the recorded response if the request completed without an error
+static void cache_tap_end(cache_tap* tap, const char* response_id, const bool completed) {
+	if (completed) chatgpt_cli_cache_writer_commit(tap->writer, tap->key, tap->key_length, response_id);
+	else chatgpt_cli_cache_writer_free(tap->writer);
+	free(tap->key);
+	tap->writer = NULL;
+	tap->key = NULL;
+}
+
+// request headers shared by every request with this key, auth_header is kept so it can be wiped afterwards
+static struct curl_slist* openai_header_list_new(const char* api_key, char** auth_header_out) {
+	struct curl_slist* header_list = NULL;
+	header_list = curl_slist_append(header_list, "Content-Type: application/json");
+	// CURL would wait for a 100 Continue before sending a big body, that's a round trip (or a second) for nothing
+	header_list = curl_slist_append(header_list, "Expect:");
+
+	const char* auth_prefix = "Authorization: Bearer ";
+	char* auth_header = malloc(1 + strlen(auth_prefix) + strlen(api_key));
+	strcpy(auth_header, auth_prefix);
+	strcat(auth_header, api_key);
+	header_list = curl_slist_append(header_list, auth_header);
+
+	*auth_header_out = auth_header;
+	return header_list;
+}
+
+static void openai_header_list_free(struct curl_slist* header_list, char* auth_header) {
+	curl_slist_free_all(header_list);
+	memset(auth_header, 0, strlen(auth_header)); // let's not let an API key sit in memory
+	free(auth_header);
+}
+
+struct openai_session {
+	CURL* curl; // keeps its connections alive between requests
+	char* url; // openai_get_api_url when it was created, which a warm-up mustn't read while it changes
+	CURLSH* share; // its connections, DNS and TLS sessions, which a hedge can pick up too
+	chatgpt_cli_connection_hint connection; // addresses and TLS sessions earlier processes left behind
+
+	struct curl_slist* header_list;
+	char* auth_header;
+
+	char* last_response_id;
+
+	// how long the warm-up spent opening the connection, and how much of that was over before the request was
+	// ready. -1 once reported (or if there wasn't one)
+	int64_t warmup_us;
+	int64_t warmup_hidden_us;
+
+	bool cancelled; // by the callback of the request it's streaming, see openai_session_cancel
+};
+
+openai_session* openai_session_new(const char* api_key) {
+	openai_session* session = calloc(1, sizeof(openai_session));
+	if (!session) return NULL;
+
+	session->curl = curl_easy_init();
+	session->share = curl_share_init();
+	session->url = strdup(openai_get_api_url());
+	if (!session->curl || !session->share || !session->url) {
+		curl_easy_cleanup(session->curl);
+		curl_share_cleanup(session->share);
+		free(session->url);
+		free(session);
+		return NULL;
+	}
+	session->warmup_us = -1;
+	session->warmup_hidden_us = -1;
+
+	curl_share_setopt(session->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+	curl_share_setopt(session->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(session->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	curl_easy_setopt(session->curl, CURLOPT_SHARE, session->share);
+
+	curl_easy_setopt(session->curl, CURLOPT_URL, session->url);
+	curl_easy_setopt(session->curl, CURLOPT_TCP_KEEPALIVE, 1L);
+
+	session->header_list = openai_header_list_new(api_key, &session->auth_header);
+	curl_easy_setopt(session->curl, CURLOPT_HTTPHEADER, session->header_list);
+
+	return session;
+}
+
+void openai_session_free(openai_session* session) {
+	if (!session) return;
+
+	curl_easy_cleanup(session->curl);
+	curl_share_cleanup(session->share);
+	chatgpt_cli_connection_hint_free(&session->connection);
+	openai_header_list_free(session->header_list, session->auth_header);
+	free(session->url);
+	free(session->last_response_id);
+	free(session);
+}
+
+static size_t curl_callback_discard(const char* content_ptr, const size_t size_atomic, const size_t n_elements,
+                                    void* user_data) {
+	(void)content_ptr;
+	(void)user_data;
+	return size_atomic * n_elements;
+}
+
+// a remembered address which stopped working fails before anything is sent, so it's safe to send again
+static CURLcode session_perform(openai_session* session) {
+	chatgpt_cli_connection_prepare(&session->connection, session->curl, session->url);
+	CURLcode curl_response = curl_easy_perform(session->curl);
+	if (chatgpt_cli_connection_learn(&session->connection, session->curl, session->url, curl_response)) {
+		chatgpt_cli_connection_prepare(&session->connection, session->curl, session->url);
+		curl_response = curl_easy_perform(session->curl);
+		chatgpt_cli_connection_learn(&session->connection, session->curl, session->url, curl_response);
+	}
+	return curl_response;
+}
+
+bool openai_session_warm(openai_session* session) {
+	// any response will do, all we're after is the connection (DNS, TCP and TLS) staying in the handle's pool
+	curl_easy_setopt(session->curl, CURLOPT_NOBODY, 1L);
+	curl_easy_setopt(session->curl, CURLOPT_HEADERFUNCTION, curl_callback_discard);
+	curl_easy_setopt(session->curl, CURLOPT_HEADERDATA, NULL);
+	curl_easy_setopt(session->curl, CURLOPT_WRITEFUNCTION, curl_callback_discard);
+	curl_easy_setopt(session->curl, CURLOPT_WRITEDATA, NULL);
+
+	const CURLcode curl_response = session_perform(session);
+
+	// back to a POST, which attaching the next request's body sets up again
+	curl_easy_setopt(session->curl, CURLOPT_NOBODY, 0L);
+
+	return curl_response == CURLE_OK;
+}
+
+const char* openai_session_get_last_response_id(const openai_session* session) {
+	return session->last_response_id;
+}
+
+void openai_session_cancel(openai_session* session) {
+	session->cancelled = true;
+}
+
+struct openai_session_warmup {
+	thrd_t thread;
+	openai_session* session;
+	atomic_bool cancelled;
+
+	// written by the thread before it exits, read after joining it
+	struct timespec started;
+	bool connected;
+	int64_t setup_us; // DNS, TCP and TLS as CURL measured them, from started
+};
+
+// the warm-up still running, if any, so it can be stopped before exit() tears CURL (and OpenSSL) down under it
+static openai_session_warmup* pending_warmup = NULL;
+
+static int curl_callback_warmup_progress(void* warmup_ptr, const curl_off_t download_total,
+                                         const curl_off_t download_now, const curl_off_t upload_total,
+                                         const curl_off_t upload_now) {
+	(void)download_total;
+	(void)download_now;
+	(void)upload_total;
+	(void)upload_now;
+	const openai_session_warmup* warmup = warmup_ptr;
+	return atomic_load(&warmup->cancelled) ? 1 : 0;
+}
+
+static int session_warmup_run(void* warmup_ptr) {
+	openai_session_warmup* warmup = warmup_ptr;
+	CURL* curl = warmup->session->curl;
+	clock_gettime(CLOCK_MONOTONIC, &warmup->started);
+
+	curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+	curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, curl_callback_warmup_progress);
+	curl_easy_setopt(curl, CURLOPT_XFERINFODATA, warmup);
+	warmup->connected = openai_session_warm(warmup->session);
+	curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+	curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, NULL);
+
+	// plain HTTP has no TLS phase, then it's ready once connected
+	const int64_t tls_us = curl_info_int64(curl, CURLINFO_APPCONNECT_TIME_T);
+	warmup->setup_us = tls_us > 0 ? tls_us : curl_info_int64(curl, CURLINFO_CONNECT_TIME_T);
+	return 0;
+}
+
+static void session_warmup_cancel_pending(void) {
+	openai_session_warmup_cancel(pending_warmup);
+}
+
+openai_session_warmup* openai_session_warmup_start(const char* api_key) {
+	// CURL's global init isn't thread safe, and once it's done OpenSSL's exit handler is registered before ours
+	static bool exit_handler_registered = false;
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	if (!exit_handler_registered) {
+		exit_handler_registered = atexit(session_warmup_cancel_pending) == 0;
+		if (!exit_handler_registered) return NULL;
+	}
+	if (pending_warmup) return NULL; // one at a time
+
+	openai_session_warmup* warmup = calloc(1, sizeof(openai_session_warmup));
+	if (!warmup) return NULL;
+	warmup->session = openai_session_new(api_key ? api_key : "");
+	if (!warmup->session || thrd_create(&warmup->thread, session_warmup_run, warmup) != thrd_success) {
+		openai_session_free(warmup->session);
+		free(warmup);
+		return NULL;
+	}
+
+	pending_warmup = warmup;
+	return warmup;
+}
+
+static void session_warmup_join(openai_session_warmup* warmup) {
+	thrd_join(warmup->thread, NULL);
+	if (pending_warmup == warmup) pending_warmup = NULL;
+}
+
+openai_session* openai_session_warmup_finish(openai_session_warmup* warmup, const char* api_key) {
+	struct timespec ready;
+	clock_gettime(CLOCK_MONOTONIC, &ready);
+	session_warmup_join(warmup);
+
+	openai_session* session = warmup->session;
+	if (strcmp(session->url, openai_get_api_url()) != 0) {
+		// --api-url pointed somewhere else after all
+		openai_session_free(session);
+		free(warmup);
+		return NULL;
+	}
+
+	// it warmed up with whatever key was around at the start, the request may have been given another
+	openai_header_list_free(session->header_list, session->auth_header);
+	session->header_list = openai_header_list_new(api_key, &session->auth_header);
+	curl_easy_setopt(session->curl, CURLOPT_HTTPHEADER, session->header_list);
+
+	if (warmup->connected) {
+		const int64_t ready_us = (int64_t)(ready.tv_sec - warmup->started.tv_sec) * 1000000 +
+			(ready.tv_nsec - warmup->started.tv_nsec) / 1000;
+		session->warmup_us = warmup->setup_us;
+		session->warmup_hidden_us = ready_us < 0 ? 0 : ready_us < warmup->setup_us ? ready_us : warmup->setup_us;
+	}
+	free(warmup);
+	return session;
+}
+
+void openai_session_warmup_cancel(openai_session_warmup* warmup) {
+	if (!warmup) return;
+	atomic_store(&warmup->cancelled, true);
+	session_warmup_join(warmup);
+	openai_session_free(warmup->session);
+	free(warmup);
+}
+
+// hands the warm-up's timings to the stream reporting them, only the first request after it gets them
+static void session_take_warmup(openai_session* session, curl_callback_stream_callback_data* context) {
+	context->warmup_us = session->warmup_us;
+	context->warmup_hidden_us = session->warmup_hidden_us;
+	session->warmup_us = -1;
+	session->warmup_hidden_us = -1;
+}
+
+// a hedged request races a copy of itself once it's waited too long for its first delta. nothing reaches the
+// callback until one of the attempts sends a delta (or completes), after that only the winner's deltas do. raw events
+// before then (response.created etc) are held back and replayed if their attempt wins
+typedef struct hedge_race hedge_race;
+
+typedef struct {
+	hedge_race* race;
+	CURL* curl;
+	request_body body;
+	curl_callback_stream_callback_data* context;
+	char* response_id; // held back until the attempt wins
+	char* held; // raw events held back until it wins, each a size_t length followed by the event
+	size_t held_length;
+	size_t held_capacity;
+	bool running;
+	CURLcode result;
+} hedge_attempt;
+
+struct hedge_race {
+	openai_delta_callback callback;
+	void* user_data;
+	hedge_attempt attempts[2]; // the original request, then its hedge
+	hedge_attempt* winner;
+	const bool* cancelled; // the session's, both attempts stop with it
+};
+
+static void hedge_race_decide(hedge_race* race, hedge_attempt* winner) {
+	race->winner = winner;
+	if (winner->response_id) {
+		race->callback(OPENAI_DELTA_RESPONSE_ID, winner->response_id, strlen(winner->response_id), race->user_data);
+	}
+
+	for (size_t offset = 0; offset < winner->held_length;) {
+		size_t length;
+		memcpy(&length, winner->held + offset, sizeof(length));
+		offset += sizeof(length);
+		race->callback(OPENAI_DELTA_RAW_EVENT, winner->held + offset, length, race->user_data);
+		offset += length;
+	}
+}
+
+static void hedge_attempt_hold(hedge_attempt* attempt, const char* delta, const size_t length) {
+	const size_t needed = attempt->held_length + sizeof(length) + length;
+	if (needed > attempt->held_capacity) {
+		const size_t new_capacity = needed > attempt->held_capacity * 2 ? needed : attempt->held_capacity * 2;
+		char* new_held = realloc(attempt->held, new_capacity);
+		if (!new_held) return;
+		attempt->held = new_held;
+		attempt->held_capacity = new_capacity;
+	}
+	memcpy(attempt->held + attempt->held_length, &length, sizeof(length));
+	memcpy(attempt->held + attempt->held_length + sizeof(length), delta, length);
+	attempt->held_length = needed;
+}
+
+static void hedge_attempt_callback(const openai_delta_type type, const char* delta, const size_t length,
+                                   void* attempt_ptr) {
+	hedge_attempt* attempt = attempt_ptr;
+	hedge_race* race = attempt->race;
+
+	if (!race->winner) {
+		if (type == OPENAI_DELTA_FLUSH) return;
+		if (type == OPENAI_DELTA_RESPONSE_ID) {
+			free(attempt->response_id);
+			attempt->response_id = openai_delta_copy(delta, length);
+			return;
+		}
+		// only content decides it, not the events every response starts with
+		if (type == OPENAI_DELTA_RAW_EVENT && !attempt->context->content_seen) {
+			hedge_attempt_hold(attempt, delta, length);
+			return;
+		}
+		hedge_race_decide(race, attempt);
+	}
+
+	// the loser may still be in the middle of a chunk, it's cancelled as soon as CURL returns
+	if (race->winner == attempt) race->callback(type, delta, length, race->user_data);
+}
+
+static bool hedge_attempt_start(hedge_race* race, hedge_attempt* attempt, CURL* curl, openai_request* request,
+                                CURLM* multi) {
+	attempt->race = race;
+	attempt->curl = curl;
+	if (!curl) return false;
+	attempt->context = stream_context_new(request, hedge_attempt_callback, attempt);
+	if (!attempt->context) return false;
+	attempt->context->cancelled = race->cancelled;
+
+	request_body_init(&attempt->body, request);
+	request_body_attach(curl, &attempt->body);
+	stream_context_attach(curl, attempt->context);
+	curl_multi_add_handle(multi, curl);
+	attempt->running = true;
+	return true;
+}
+
+static void hedge_attempt_stop(hedge_attempt* attempt, CURLM* multi) {
+	if (!attempt->running) return;
+	curl_multi_remove_handle(multi, attempt->curl);
+	attempt->running = false;
+}
+
+// streams a request with the session's handle, and a hedge with a copy of it on a fresh connection. returns NULL
+// if successful or an error (caller frees), *response_id_out is the winner's (caller frees)
+static char* session_stream_hedged(openai_session* session, openai_request* request,
+                                   const openai_delta_callback callback, void* user_data, char** response_id_out) {
+	*response_id_out = NULL;
+	hedge_race race = {.callback = callback, .user_data = user_data, .cancelled = &session->cancelled};
+	hedge_attempt* original = &race.attempts[0];
+	hedge_attempt* hedge = &race.attempts[1];
+	int64_t hedge_us = -1;
+	chatgpt_cli_connection_prepare(&session->connection, session->curl, session->url);
+
+	CURLM* multi = curl_multi_init();
+	char* error = NULL;
+	if (!multi || !hedge_attempt_start(&race, original, session->curl, request, multi)) {
+		error = strdup("Failed to allocate memory for stream");
+	}
+
+	while (!error && (original->running || hedge->running)) {
+		int running_count;
+		curl_multi_perform(multi, &running_count);
+
+		CURLMsg* message;
+		int queued;
+		while ((message = curl_multi_info_read(multi, &queued))) {
+			if (message->msg != CURLMSG_DONE) continue;
+
+			hedge_attempt* attempt = message->easy_handle == original->curl ? original : hedge;
+			attempt->result = message->data.result;
+			hedge_attempt_stop(attempt, multi);
+
+			// a successful response without any deltas wins by completing, a failed one can't win
+			char* attempt_error = race.winner ? NULL : stream_context_result(attempt->context, attempt->result);
+			if (!race.winner && !attempt_error) hedge_race_decide(&race, attempt);
+			free(attempt_error);
+		}
+
+		// the loser is stopped once (a stopped attempt isn't running), after that the winner streams like any request
+		if (race.winner) hedge_attempt_stop(race.winner == original ? hedge : original, multi);
+		if (!original->running && !hedge->running) break; // both failed, or the original did before its deadline
+
+		// nothing from the original yet, and it's time: send the same request again on a connection of its own
+		const int64_t elapsed_us = stream_context_elapsed_us(original->context);
+		if (!race.winner && hedge_us < 0 && original->running && elapsed_us >= request->hedge_after_us) {
+			hedge_us = elapsed_us;
+			CURL* hedge_curl = curl_easy_duphandle(session->curl);
+			if (hedge_curl) {
+				curl_easy_setopt(hedge_curl, CURLOPT_SHARE, session->share);
+				curl_easy_setopt(hedge_curl, CURLOPT_FRESH_CONNECT, 1L);
+			}
+			if (hedge_attempt_start(&race, hedge, hedge_curl, request, multi)) {
+				hedge->context->started = original->context->started;
+			}
+			continue;
+		}
+
+		const int64_t wait_us = !race.winner && hedge_us < 0 && original->running
+			                        ? request->hedge_after_us - elapsed_us
+			                        : 1000000;
+		curl_multi_poll(multi, NULL, 0, (int)((wait_us + 999) / 1000), NULL);
+	}
+
+	if (!error) {
+		chatgpt_cli_connection_learn(&session->connection, session->curl, session->url, original->result);
+	}
+
+	// the winner's timings, or the original's if neither got anywhere
+	hedge_attempt* reported = race.winner ? race.winner : original;
+	if (!error) {
+		reported->context->hedge_us = hedge_us;
+		reported->context->hedge_won = reported == hedge;
+		session_take_warmup(session, reported->context);
+		stream_context_emit_timings(reported->context, reported->curl);
+		error = stream_context_result(reported->context, reported->result);
+		*response_id_out = reported->context->response_id;
+		reported->context->response_id = NULL;
+	}
+
+	stream_context_detach(session->curl);
+	for (size_t i = 0; i < 2; i++) {
+		hedge_attempt* attempt = &race.attempts[i];
+		hedge_attempt_stop(attempt, multi);
+		if (attempt->context) stream_context_free(attempt->context);
+		free(attempt->response_id);
+		free(attempt->held);
+	}
+	if (hedge->curl) curl_easy_cleanup(hedge->curl); // its connection stays in the session's share
+	curl_multi_cleanup(multi);
+	return error;
+}
+
+char* openai_session_stream_response(openai_session* session, openai_request* request,
+                                     openai_delta_callback callback, void* user_data) {
+	session->cancelled = false;
+
+	// set CURL request content
+	request_body body;
+	request_body_init(&body, request);
+
+	cache_tap tap = {0};
+	if (request->cache != OPENAI_CACHE_OFF) {
+		char* request_string = request_body_to_key(&body);
+		if (!request_string) return strdup("Failed to allocate memory for request");
+
+		char* response_id;
+		char* potential_error;
+		const bool served = cache_tap_begin(&tap, request, request_string, callback, user_data, &response_id,
+		                                    &potential_error);
+		free(request_string);
+		if (served) {
+			if (response_id) {
+				free(session->last_response_id);
+				session->last_response_id = response_id;
+			}
+			return potential_error;
+		}
+		callback = cache_tap_callback;
+		user_data = &tap;
+	}
+
+	if (request->hedge_after_us > 0) {
+		char* response_id;
+		char* potential_error = session_stream_hedged(session, request, callback, user_data, &response_id);
+		if (tap.writer) cache_tap_end(&tap, response_id, potential_error == NULL);
+
+		free(session->last_response_id);
+		session->last_response_id = response_id;
+		return potential_error;
+	}
+
+	request_body_attach(session->curl, &body);
+
+	curl_callback_stream_callback_data* curl_callback_data = stream_context_new(request, callback, user_data);
+	if (!curl_callback_data) {
+		if (tap.writer) cache_tap_end(&tap, NULL, false);
+		return strdup("Failed to allocate memory for stream");
+	}
+	curl_callback_data->cancelled = &session->cancelled;
+	stream_context_attach(session->curl, curl_callback_data);
+	session_take_warmup(session, curl_callback_data);
+
+	const CURLcode curl_response = session_perform(session);
+	stream_context_detach(session->curl);
+	stream_context_emit_timings(curl_callback_data, session->curl);
+
+	char* potential_error = stream_context_result(curl_callback_data, curl_response);
+	if (tap.writer) cache_tap_end(&tap, curl_callback_data->response_id, potential_error == NULL);
+
+	free(session->last_response_id);
+	session->last_response_id = curl_callback_data->response_id;
+	curl_callback_data->response_id = NULL; // now owned by the session
+
+	// finalize
+	stream_context_free(curl_callback_data);
+
+	return potential_error;
+}
+
+char* openai_stream_response(openai_request* request, openai_delta_callback callback, void* user_data) {
+	openai_session* session = openai_session_new(request->api_key);
+	if (!session) {
+		return strdup("Could not initialize CURL");
+	}
+
+	char* potential_error = openai_session_stream_response(session, request, callback, user_data);
+	openai_session_free(session);
+
+	return potential_error;
+}
+
+// attempts made for a request the API rate limited (429) before giving up on it
+#define SCHEDULER_MAX_ATTEMPTS 5
+
+// output tokens assumed for a request without max_tokens when checking it against the token budget
+#define SCHEDULER_DEFAULT_OUTPUT_TOKEN_ESTIMATE 1024
+
+typedef struct {
+	openai_request* request;
+	openai_delta_callback callback;
+	openai_completion_callback on_complete;
+	void* user_data;
+
+	int attempts;
+	double submitted_at;
+	double started_at;
+
+	bool cache_checked;
+	cache_tap tap; // recording for the response cache, writer is NULL if not caching
+
+	// only while running
+	CURL* curl;
+	chatgpt_cli_connection_hint connection;
+	request_body body;
+	curl_callback_stream_callback_data* context;
+} scheduler_job;
+
+struct openai_scheduler {
+	CURLM* multi;
+	struct curl_slist* header_list;
+	char* auth_header;
+	size_t max_concurrency;
+
+	// FIFO of jobs waiting to be admitted
+	scheduler_job** pending;
+	size_t pending_start;
+	size_t pending_count;
+	size_t pending_capacity;
+
+	scheduler_job** running;
+	size_t running_count;
+
+	// admission control, a token bucket refilled at the rate the API says we may still send requests
+	bool request_limit_known;
+	double request_tokens;
+	double request_token_capacity;
+	double request_token_rate; // per second
+	double last_refill;
+
+	long remaining_tokens; // -1 until known, counted down locally between updates
+	double tokens_reset_at;
+
+	double paused_until; // nothing is admitted before this (retry-after, exhausted windows)
+
+	// the event loop driving it, see openai_scheduler_set_event_callbacks
+	openai_socket_callback on_socket;
+	openai_timer_callback on_timer;
+	void* event_user_data;
+	double timer_deadline; // last handed to on_timer, -1 while no timer is set
+	bool unchecked; // something was submitted whose cache hasn't been checked yet
+
+	struct scheduler_poll_loop* poll_loop; // openai_scheduler_run's own loop, NULL until it first runs
+};
+
+// what openai_scheduler_run watches with poll(), kept between runs: CURL only says once which sockets it wants
+typedef struct scheduler_poll_loop {
+	struct pollfd* fds;
+	size_t count;
+	size_t capacity;
+	struct pollfd* ready; // copied out of fds before acting on them, acting on one can change fds
+	double deadline; // -1 if there's no timer
+} scheduler_poll_loop;
+
+static double scheduler_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int scheduler_curl_socket(CURL* curl, const curl_socket_t fd, const int what, void* user_data,
+                                 void* socket_data) {
+	const openai_scheduler* scheduler = user_data;
+	if (!scheduler->on_socket) return 0;
+
+	int events = 0;
+	if (what == CURL_POLL_REMOVE) events = OPENAI_POLL_REMOVE;
+	else {
+		if (what & CURL_POLL_IN) events |= OPENAI_POLL_IN;
+		if (what & CURL_POLL_OUT) events |= OPENAI_POLL_OUT;
+	}
+	scheduler->on_socket((int)fd, events, scheduler->event_user_data);
+
+	(void)curl;
+	(void)socket_data;
+	return 0;
+}
+
+openai_scheduler* openai_scheduler_new(const char* api_key, const size_t max_concurrency) {
+	openai_scheduler* scheduler = calloc(1, sizeof(openai_scheduler));
+	if (!scheduler) return NULL;
+
+	scheduler->multi = curl_multi_init();
+	if (!scheduler->multi) {
+		free(scheduler);
+		return NULL;
+	}
+
+	scheduler->max_concurrency = max_concurrency ? max_concurrency : 1;
+	scheduler->running = calloc(scheduler->max_concurrency, sizeof(scheduler_job*));
+	scheduler->header_list = openai_header_list_new(api_key, &scheduler->auth_header);
+	scheduler->remaining_tokens = -1;
+
+	// streams share connections where the server speaks HTTP/2, otherwise each gets its own
+	curl_multi_setopt(scheduler->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+	curl_multi_setopt(scheduler->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)scheduler->max_concurrency);
+	curl_multi_setopt(scheduler->multi, CURLMOPT_SOCKETFUNCTION, scheduler_curl_socket);
+	curl_multi_setopt(scheduler->multi, CURLMOPT_SOCKETDATA, scheduler);
+	scheduler->timer_deadline = -1;
+
+	return scheduler;
+}
+
+static void scheduler_job_release(scheduler_job* job) {
+	if (job->curl) curl_easy_cleanup(job->curl);
+	if (job->context) stream_context_free(job->context);
+	chatgpt_cli_connection_hint_free(&job->connection);
+	job->curl = NULL;
+	job->context = NULL;
+}
+
+void openai_scheduler_free(openai_scheduler* scheduler) {
+	if (!scheduler) return;
+
+	for (size_t i = 0; i < scheduler->running_count; i++) {
+		curl_multi_remove_handle(scheduler->multi, scheduler->running[i]->curl);
+		scheduler_job_release(scheduler->running[i]);
+		if (scheduler->running[i]->tap.writer) cache_tap_end(&scheduler->running[i]->tap, NULL, false);
+		free(scheduler->running[i]);
+	}
+	for (size_t i = 0; i < scheduler->pending_count; i++) {
+		scheduler_job* job = scheduler->pending[(scheduler->pending_start + i) % scheduler->pending_capacity];
+		if (job->tap.writer) cache_tap_end(&job->tap, NULL, false);
+		free(job);
+	}
+
+	curl_multi_cleanup(scheduler->multi);
+	openai_header_list_free(scheduler->header_list, scheduler->auth_header);
+	free(scheduler->pending);
+	free(scheduler->running);
+	if (scheduler->poll_loop) {
+		free(scheduler->poll_loop->fds);
+		free(scheduler->poll_loop->ready);
+		free(scheduler->poll_loop);
+	}
+	free(scheduler);
+}
+
+static bool scheduler_push(openai_scheduler* scheduler, scheduler_job* job, const bool front) {
+	if (scheduler->pending_count == scheduler->pending_capacity) {
+		const size_t new_capacity = scheduler->pending_capacity ? scheduler->pending_capacity * 2 : 16;
+		scheduler_job** new_pending = malloc(new_capacity * sizeof(scheduler_job*));
+		if (!new_pending) return false;
+
+		// unwrap the ring into the new array
+		for (size_t i = 0; i < scheduler->pending_count; i++) {
+			new_pending[i] = scheduler->pending[(scheduler->pending_start + i) % scheduler->pending_capacity];
+		}
+		free(scheduler->pending);
+		scheduler->pending = new_pending;
+		scheduler->pending_start = 0;
+		scheduler->pending_capacity = new_capacity;
+	}
+
+	if (front) {
+		scheduler->pending_start = (scheduler->pending_start + scheduler->pending_capacity - 1) %
+			scheduler->pending_capacity;
+		scheduler->pending[scheduler->pending_start] = job;
+	} else {
+		scheduler->pending[(scheduler->pending_start + scheduler->pending_count) % scheduler->pending_capacity] = job;
+	}
+	scheduler->pending_count++;
+	return true;
+}
+
+bool openai_scheduler_submit(openai_scheduler* scheduler, openai_request* request, openai_delta_callback callback,
+                             openai_completion_callback on_complete, void* user_data) {
+	scheduler_job* job = calloc(1, sizeof(scheduler_job));
+	if (!job) return false;
+
+	job->request = request;
+	job->callback = callback;
+	job->on_complete = on_complete;
+	job->user_data = user_data;
+	job->submitted_at = scheduler_now();
+
+	if (!scheduler_push(scheduler, job, false)) {
+		free(job);
+		return false;
+	}
+	scheduler->unchecked = true;
+
+	// let the event loop know there's something to admit
+	if (scheduler->on_timer && (scheduler->timer_deadline < 0 || scheduler->timer_deadline > job->submitted_at)) {
+		scheduler->timer_deadline = job->submitted_at;
+		scheduler->on_timer(0, scheduler->event_user_data);
+	}
+	return true;
+}
+
+// rough token cost of a request, which is how the API counts it against the token limit
+static long scheduler_estimate_tokens(const openai_request* request) {
+	size_t characters = request->input ? strlen(request->input) : 0;
+	if (request->instructions) characters += strlen(request->instructions);
+
+	const size_t output_tokens = request->max_tokens != OPENAI_REQUEST_MAX_TOKENS_NOT_SET
+		? request->max_tokens : SCHEDULER_DEFAULT_OUTPUT_TOKEN_ESTIMATE;
+	return (long)(characters / 4 + output_tokens);
+}
+
+// seconds until the next pending job may start, 0 if it can start now
+static double scheduler_admission_delay(openai_scheduler* scheduler, const double now) {
+	if (now < scheduler->paused_until) return scheduler->paused_until - now;
+
+	if (scheduler->request_limit_known) {
+		scheduler->request_tokens += (now - scheduler->last_refill) * scheduler->request_token_rate;
+		if (scheduler->request_tokens > scheduler->request_token_capacity) {
+			scheduler->request_tokens = scheduler->request_token_capacity;
+		}
+		scheduler->last_refill = now;
+
+		if (scheduler->request_tokens < 1) {
+			// only a window which ran out has no rate, it paused until the reset, so that's a new window now
+			// which the next response will tell about, waiting for an update with nothing running never ends
+			if (scheduler->request_token_rate <= 0) {
+				scheduler->request_limit_known = false;
+				return 0;
+			}
+			return (1 - scheduler->request_tokens) / scheduler->request_token_rate;
+		}
+	}
+
+	if (scheduler->remaining_tokens >= 0 && now < scheduler->tokens_reset_at) {
+		const scheduler_job* next = scheduler->pending[scheduler->pending_start];
+		// a request bigger than the whole budget would never start otherwise, let it through once it's full
+		if (scheduler_estimate_tokens(next->request) > scheduler->remaining_tokens) {
+			return scheduler->tokens_reset_at - now;
+		}
+	}
+
+	return 0;
+}
+
+static void scheduler_apply_rate_limit(openai_scheduler* scheduler, openai_rate_limit* rate_limit, const double now) {
+	rate_limit->updated = false;
+
+	if (rate_limit->remaining_requests >= 0 && rate_limit->reset_requests_seconds > 0) {
+		// spread what's left of the window evenly over the time until it resets
+		const double remaining = (double)rate_limit->remaining_requests;
+		if (!scheduler->request_limit_known) {
+			scheduler->request_tokens = remaining;
+			scheduler->last_refill = now;
+		}
+		scheduler->request_limit_known = true;
+		scheduler->request_token_rate = remaining / rate_limit->reset_requests_seconds;
+		scheduler->request_token_capacity = remaining < (double)scheduler->max_concurrency
+			? remaining : (double)scheduler->max_concurrency;
+		if (scheduler->request_tokens > remaining) scheduler->request_tokens = remaining;
+
+		if (rate_limit->remaining_requests == 0) {
+			const double reset_at = now + rate_limit->reset_requests_seconds;
+			if (reset_at > scheduler->paused_until) scheduler->paused_until = reset_at;
+		}
+	}
+
+	if (rate_limit->remaining_tokens >= 0) {
+		scheduler->remaining_tokens = rate_limit->remaining_tokens;
+		scheduler->tokens_reset_at = now + rate_limit->reset_tokens_seconds;
+	}
+
+	if (rate_limit->retry_after_seconds > 0) {
+		const double retry_at = now + rate_limit->retry_after_seconds;
+		if (retry_at > scheduler->paused_until) scheduler->paused_until = retry_at;
+	}
+}
+
+static bool scheduler_start(openai_scheduler* scheduler, scheduler_job* job, const double now) {
+	job->curl = curl_easy_init();
+	job->context = job->tap.writer
+		? stream_context_new(job->request, cache_tap_callback, &job->tap)
+		: stream_context_new(job->request, job->callback, job->user_data);
+	request_body_init(&job->body, job->request);
+	if (!job->curl || !job->context) {
+		scheduler_job_release(job);
+		return false;
+	}
+
+	curl_easy_setopt(job->curl, CURLOPT_URL, openai_get_api_url());
+	curl_easy_setopt(job->curl, CURLOPT_HTTPHEADER, scheduler->header_list);
+	request_body_attach(job->curl, &job->body);
+	curl_easy_setopt(job->curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt(job->curl, CURLOPT_PIPEWAIT, 1L); // prefer multiplexing over opening another connection
+	curl_easy_setopt(job->curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(job->curl, CURLOPT_PRIVATE, job);
+	stream_context_attach(job->curl, job->context);
+	chatgpt_cli_connection_prepare(&job->connection, job->curl, openai_get_api_url());
+
+	curl_multi_add_handle(scheduler->multi, job->curl);
+
+	job->attempts++;
+	job->started_at = now;
+	scheduler->running[scheduler->running_count++] = job;
+
+	if (scheduler->request_limit_known) scheduler->request_tokens -= 1;
+	if (scheduler->remaining_tokens >= 0) scheduler->remaining_tokens -= scheduler_estimate_tokens(job->request);
+
+	return true;
+}
+
+// completes a job from the response cache without sending it, true if it did (and the job is gone)
+static bool scheduler_serve_cached(scheduler_job* job, const double now) {
+	job->cache_checked = true;
+	if (job->request->cache == OPENAI_CACHE_OFF) return false;
+
+	request_body body;
+	request_body_init(&body, job->request);
+	char* request_string = request_body_to_key(&body);
+	if (!request_string) return false; // it can still be sent
+
+	char* response_id;
+	char* error;
+	const bool served = cache_tap_begin(&job->tap, job->request, request_string, job->callback, job->user_data,
+	                                    &response_id, &error);
+	free(request_string);
+	if (!served) return false;
+
+	const openai_completion completion = {
+		.response_id = response_id,
+		.error = error,
+		.queued_us = (int64_t)((now - job->submitted_at) * 1e6),
+		.total_us = 0,
+	};
+	if (job->on_complete) job->on_complete(&completion, job->user_data);
+
+	free(response_id);
+	free(error);
+	free(job);
+	return true;
+}
+
+static void scheduler_finish(openai_scheduler* scheduler, scheduler_job* job, const CURLcode curl_response,
+                             const double now) {
+	curl_multi_remove_handle(scheduler->multi, job->curl);
+
+	for (size_t i = 0; i < scheduler->running_count; i++) {
+		if (scheduler->running[i] == job) {
+			scheduler->running[i] = scheduler->running[--scheduler->running_count];
+			break;
+		}
+	}
+
+	curl_callback_stream_callback_data* context = job->context;
+	scheduler_apply_rate_limit(scheduler, &context->rate_limit, now);
+
+	// a remembered address which stopped working, nothing was sent so it can go again straight away
+	const bool reconnect = chatgpt_cli_connection_learn(&job->connection, job->curl, openai_get_api_url(),
+	                                                    curl_response);
+	if (reconnect && job->attempts < SCHEDULER_MAX_ATTEMPTS) {
+		scheduler_job_release(job);
+		if (scheduler_push(scheduler, job, true)) return;
+	}
+
+	// rate limited before anything was streamed, put it back at the front of the queue
+	if (job->context && context->http_status == 429 && job->attempts < SCHEDULER_MAX_ATTEMPTS) {
+		if (context->rate_limit.retry_after_seconds <= 0) {
+			// no hint from the API, back off exponentially
+			const double retry_at = now + (double)(1 << job->attempts);
+			if (retry_at > scheduler->paused_until) scheduler->paused_until = retry_at;
+		}
+
+		scheduler_job_release(job);
+		if (scheduler_push(scheduler, job, true)) return;
+	}
+
+	if (job->context) stream_context_emit_timings(context, job->curl);
+
+	char* error = job->context ? stream_context_result(context, curl_response) : strdup("Failed to requeue request");
+	if (job->tap.writer) cache_tap_end(&job->tap, job->context ? context->response_id : NULL, error == NULL);
+
+	const openai_completion completion = {
+		.response_id = job->context ? context->response_id : NULL,
+		.error = error,
+		.queued_us = (int64_t)((job->started_at - job->submitted_at) * 1e6),
+		.total_us = (int64_t)((now - job->started_at) * 1e6),
+	};
+	if (job->on_complete) job->on_complete(&completion, job->user_data);
+
+	free(error);
+	scheduler_job_release(job);
+	free(job);
+}
+
+// cached responses don't count against the rate limits, so don't wait on them behind requests which do
+static void scheduler_serve_cached_pending(openai_scheduler* scheduler) {
+	scheduler->unchecked = false;
+
+	const size_t queued_count = scheduler->pending_count;
+	for (size_t i = 0; i < queued_count; i++) {
+		scheduler_job* job = scheduler->pending[scheduler->pending_start];
+		scheduler->pending_start = (scheduler->pending_start + 1) % scheduler->pending_capacity;
+		scheduler->pending_count--;
+
+		if (job->cache_checked || !scheduler_serve_cached(job, scheduler_now())) scheduler_push(scheduler, job, false);
+	}
+}
+
+// sets the event loop's timer for whichever comes first, CURL's next timeout or the next job's admission
+static void scheduler_update_timer(openai_scheduler* scheduler, const double now) {
+	double deadline = -1;
+
+	long curl_timeout_ms = -1;
+	curl_multi_timeout(scheduler->multi, &curl_timeout_ms);
+	if (curl_timeout_ms >= 0) deadline = now + (double)curl_timeout_ms / 1000;
+
+	if (scheduler->pending_count > 0 && scheduler->running_count < scheduler->max_concurrency) {
+		const double admit_at = now + scheduler_admission_delay(scheduler, now);
+		if (deadline < 0 || admit_at < deadline) deadline = admit_at;
+	}
+
+	// the same timer to within a millisecond is already set
+	if (deadline < 0 && scheduler->timer_deadline < 0) return;
+	if (deadline >= 0 && scheduler->timer_deadline >= 0 && deadline - scheduler->timer_deadline < 0.001 &&
+		scheduler->timer_deadline - deadline < 0.001) {
+		return;
+	}
+
+	scheduler->timer_deadline = deadline;
+	long timeout_ms = -1;
+	if (deadline >= 0) timeout_ms = deadline > now ? (long)((deadline - now) * 1000) + 1 : 0;
+	scheduler->on_timer(timeout_ms, scheduler->event_user_data);
+}
+
+// one turn of the event loop: lets CURL move the transfers on fd along (every transfer whose timeout expired for
+// CURL_SOCKET_TIMEOUT), finishes those which are done and admits queued jobs into the slots that opened up
+static char* scheduler_step(openai_scheduler* scheduler, const curl_socket_t fd, const int curl_events) {
+	if (scheduler->unchecked) scheduler_serve_cached_pending(scheduler);
+
+	int running_handles = 0;
+	const CURLMcode multi_response = curl_multi_socket_action(scheduler->multi, fd, curl_events, &running_handles);
+	if (multi_response != CURLM_OK) {
+		return strdup(curl_multi_strerror(multi_response));
+	}
+
+	double now = scheduler_now();
+
+	// pick up rate limit headers as soon as they arrive rather than when a stream ends
+	for (size_t i = 0; i < scheduler->running_count; i++) {
+		openai_rate_limit* rate_limit = &scheduler->running[i]->context->rate_limit;
+		if (rate_limit->updated) scheduler_apply_rate_limit(scheduler, rate_limit, now);
+	}
+
+	CURLMsg* message;
+	int messages_left;
+	while ((message = curl_multi_info_read(scheduler->multi, &messages_left))) {
+		if (message->msg != CURLMSG_DONE) continue;
+
+		scheduler_job* job = NULL;
+		curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char**)&job);
+		scheduler_finish(scheduler, job, message->data.result, now);
+	}
+
+	// admission, into the slots which just opened up too
+	now = scheduler_now();
+	while (scheduler->pending_count > 0 && scheduler->running_count < scheduler->max_concurrency) {
+		if (scheduler_admission_delay(scheduler, now) > 0) break;
+
+		scheduler_job* job = scheduler->pending[scheduler->pending_start];
+		scheduler->pending_start = (scheduler->pending_start + 1) % scheduler->pending_capacity;
+		scheduler->pending_count--;
+
+		// submitted from a callback during this turn
+		if (!job->cache_checked && scheduler_serve_cached(job, now)) continue;
+
+		if (!scheduler_start(scheduler, job, now)) {
+			scheduler_push(scheduler, job, true);
+			return strdup("Could not initialize CURL");
+		}
+	}
+
+	if (scheduler->on_timer) scheduler_update_timer(scheduler, now);
+	return NULL;
+}
+
+void openai_scheduler_set_event_callbacks(openai_scheduler* scheduler, const openai_socket_callback on_socket,
+                                          const openai_timer_callback on_timer, void* user_data) {
+	scheduler->on_socket = on_socket;
+	scheduler->on_timer = on_timer;
+	scheduler->event_user_data = user_data;
+	scheduler->timer_deadline = -1;
+}
+
+char* openai_scheduler_socket_action(openai_scheduler* scheduler, const int fd, const int events) {
+	int curl_events = 0;
+	if (events & OPENAI_POLL_IN) curl_events |= CURL_CSELECT_IN;
+	if (events & OPENAI_POLL_OUT) curl_events |= CURL_CSELECT_OUT;
+	if (events & OPENAI_POLL_ERROR) curl_events |= CURL_CSELECT_ERR;
+	return scheduler_step(scheduler, (curl_socket_t)fd, curl_events);
+}
+
+char* openai_scheduler_timeout(openai_scheduler* scheduler) {
+	scheduler->timer_deadline = -1; // one-shot, it's gone now
+	return scheduler_step(scheduler, CURL_SOCKET_TIMEOUT, 0);
+}
+
+size_t openai_scheduler_active(const openai_scheduler* scheduler) {
+	return scheduler->pending_count + scheduler->running_count;
+}
+
+static void scheduler_poll_socket(const int fd, const int events, void* user_data) {
+	scheduler_poll_loop* loop = user_data;
+
+	size_t index = 0;
+	while (index < loop->count && loop->fds[index].fd != fd) index++;
+
+	if (events & OPENAI_POLL_REMOVE) {
+		if (index < loop->count) loop->fds[index] = loop->fds[--loop->count];
+		return;
+	}
+
+	if (index == loop->count) {
+		if (loop->count == loop->capacity) {
+			const size_t new_capacity = loop->capacity ? loop->capacity * 2 : 16;
+			struct pollfd* new_fds = realloc(loop->fds, new_capacity * sizeof(struct pollfd));
+			struct pollfd* new_ready = realloc(loop->ready, new_capacity * sizeof(struct pollfd));
+			if (new_fds) loop->fds = new_fds;
+			if (new_ready) loop->ready = new_ready;
+			if (!new_fds || !new_ready) return; // the transfer times out instead
+			loop->capacity = new_capacity;
+		}
+		loop->count++;
+	}
+
+	loop->fds[index] = (struct pollfd){
+		.fd = fd,
+		.events = (short)((events & OPENAI_POLL_IN ? POLLIN : 0) | (events & OPENAI_POLL_OUT ? POLLOUT : 0)),
+	};
+}
+
+static void scheduler_poll_timer(const long timeout_ms, void* user_data) {
+	scheduler_poll_loop* loop = user_data;
+	loop->deadline = timeout_ms < 0 ? -1 : scheduler_now() + (double)timeout_ms / 1000;
+}
+
+// the simplest event loop there is, poll() on the calling thread (WSAPoll on Windows, whose sockets CURL hands out too)
+char* openai_scheduler_run(openai_scheduler* scheduler) {
+	if (!scheduler->poll_loop) {
+		if (scheduler->on_socket) return strdup("The scheduler is driven by an event loop");
+
+		scheduler->poll_loop = calloc(1, sizeof(scheduler_poll_loop));
+		if (!scheduler->poll_loop) return strdup("Out of memory");
+		scheduler->poll_loop->deadline = -1;
+		openai_scheduler_set_event_callbacks(scheduler, scheduler_poll_socket, scheduler_poll_timer,
+		                                     scheduler->poll_loop);
+	}
+	scheduler_poll_loop* loop = scheduler->poll_loop;
+
+	loop->deadline = -1;
+	char* error = openai_scheduler_timeout(scheduler);
+	while (!error && openai_scheduler_active(scheduler) > 0) {
+		const double now = scheduler_now();
+		int wait_ms = 1000; // nothing due, but don't trust that forever
+		if (loop->deadline >= 0) wait_ms = loop->deadline > now ? (int)((loop->deadline - now) * 1000) + 1 : 0;
+
+		// only waiting to admit the next job. WSAPoll refuses an empty set, so just sleep
+		if (loop->count == 0) {
+			const struct timespec wait = {.tv_sec = wait_ms / 1000, .tv_nsec = (long)(wait_ms % 1000) * 1000000};
+			thrd_sleep(&wait, NULL);
+		}
+
+		const int ready_count = loop->count ? poll(loop->fds, loop->count, wait_ms) : 0;
+		#ifdef _WIN32
+		if (ready_count < 0) return strdup("Waiting for the network failed");
+		#else
+		if (ready_count < 0 && errno != EINTR) return strdup(strerror(errno));
+		#endif
+
+		size_t ready = 0;
+		for (size_t i = 0; ready_count > 0 && i < loop->count; i++) {
+			if (loop->fds[i].revents) loop->ready[ready++] = loop->fds[i];
+		}
+		for (size_t i = 0; !error && i < ready; i++) {
+			const short revents = loop->ready[i].revents;
+			error = openai_scheduler_socket_action(scheduler, (int)loop->ready[i].fd,
+			                                       (revents & POLLIN ? OPENAI_POLL_IN : 0) |
+			                                       (revents & POLLOUT ? OPENAI_POLL_OUT : 0) |
+			                                       (revents & (POLLERR | POLLHUP) ? OPENAI_POLL_ERROR : 0));
+		}
+
+		if (!error && loop->deadline >= 0 && scheduler_now() >= loop->deadline) {
+			loop->deadline = -1;
+			error = openai_scheduler_timeout(scheduler);
+		}
+	}
+
+	return error;
 }
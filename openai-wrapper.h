@@ -6,12 +6,44 @@
 #define CHATGPT_CLI_OPENAI_WRAPPER_H
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // some value outside valid interval: [0,2]
 #define OPENAI_REQUEST_TEMPERATURE_NOT_SET -1
 
 #define OPENAI_REQUEST_MAX_TOKENS_NOT_SET 0
 
+typedef enum {
+	OPENAI_CACHE_OFF, // always sent to the API
+	OPENAI_CACHE_ON, // replayed from the response cache if the same request was sent before, cached otherwise
+	OPENAI_CACHE_ONLY, // replayed from the response cache, fails instead of being sent if it isn't there
+} openai_cache_mode;
+
+typedef enum {
+	OPENAI_RAW_OFF, // parsed deltas
+	OPENAI_RAW_FINAL, // no deltas, just the whole final response object at the end
+	OPENAI_RAW_STREAM, // every event's data as it arrives, untouched
+} openai_raw_mode;
+
+typedef enum {
+	OPENAI_TIMINGS_OFF,
+	OPENAI_TIMINGS_SUMMARY, // connection phases, first delta, total and usage, which are nearly free to measure
+	OPENAI_TIMINGS_DETAILED, // also the gaps between deltas and parser CPU time, which cost a clock read per delta
+} openai_timings_mode;
+
+// files sent along with a request, more are refused by openai_request_attach
+#define OPENAI_REQUEST_MAX_ATTACHMENTS 16
+
+// a file sent after the input as an input_image content part (for the image types the API reads) or an input_file
+// one. it's mapped rather than read, and base64 encoded straight into the upload as CURL asks for more of the body
+typedef struct {
+	char* path; // absolute
+	const char* mime_type; // static, from the file's extension
+	bool image;
+	const unsigned char* data; // the mapping, NULL for an empty file
+	size_t size;
+} openai_attachment;
+
 typedef struct {
 	char* instructions;
 	double temperature;
@@ -20,15 +52,180 @@ typedef struct {
 	char* model;
 	char* api_key;
 	char* previous_response_id;
-	bool raw;
+	openai_raw_mode raw;
 	bool echo_response_id;
+	openai_cache_mode cache;
+	openai_timings_mode timings; // measure where the time went and send it as OPENAI_DELTA_TIMINGS at the end
+	openai_attachment* attachments; // see openai_request_attach
+	size_t attachment_count;
+	// sends the same request again if no delta arrived this many microseconds after it was sent, 0 never does.
+	// whichever of the two sends a delta first is streamed and the other is cancelled. only sessions hedge
+	int64_t hedge_after_us;
 } openai_request;
 
+// unmaps the request's attachments too
 void openai_request_free(openai_request* request);
 
-typedef void (*openai_delta_callback)(const char* delta, size_t length, void* user_data);
+// maps a file and adds it to the request's attachments, returns NULL if successful, or an error (caller frees)
+char* openai_request_attach(openai_request* request, const char* path);
+
+// sends every request to url instead of the OpenAI Responses API (e.g. a local mock server), NULL goes back to it.
+// only affects sessions and schedulers created afterwards, set it before starting any
+void openai_set_api_url(const char* url);
+
+// where requests are sent, owned by the wrapper
+const char* openai_get_api_url();
+
+typedef enum {
+	OPENAI_DELTA_OUTPUT_TEXT,
+	OPENAI_DELTA_REFUSAL,
+	OPENAI_DELTA_REASONING_SUMMARY,
+	OPENAI_DELTA_FUNCTION_CALL_ARGUMENTS,
+	OPENAI_DELTA_RAW_RESPONSE, // the whole final response object, only sent for OPENAI_RAW_FINAL requests
+	OPENAI_DELTA_RESPONSE_ID, // sent once the response is created, only for echo_response_id requests
+	OPENAI_DELTA_TIMINGS, // one JSON object, sent last and only for timings requests that went to the API, see below
+	OPENAI_DELTA_FLUSH, // empty, nothing more until the network delivers it: a good moment to write out buffered output
+	OPENAI_DELTA_RAW_EVENT, // one event's JSON data on a single line, only sent for OPENAI_RAW_STREAM requests
+} openai_delta_type;
+
+// keys of the OPENAI_DELTA_TIMINGS object, all in microseconds since the request was sent unless noted:
+// dns_us, connect_us, tls_us (how long each connection phase took, about 0 on a reused connection), ttfb_us,
+// created_us (response.created event), first_delta_us (first response.output_text.delta), total_us,
+// delta_gap_p50_us, delta_gap_p95_us, delta_gap_max_us (between consecutive deltas of any kind),
+// deltas, events, bytes (counts), parser_cpu_us (CPU time spent on the stream outside the callback),
+// input_tokens, output_tokens (from the response's usage), hedge_us (when a hedge was sent), hedge_won (1 if the
+// response came from it, 0 if not), warmup_us and warmup_hidden_us (the first request through a warmed-up
+// session, see openai_session_warmup_finish). times which never happened are left out, and so are the gaps and parser CPU
+// time unless the timings are detailed. a hedge's connection phases are its own, everything else is measured from
+// when the original request was sent
+
+// deltas are borrowed: they point into the stream's own buffers, aren't NUL-terminated and are only valid until
+// the callback returns. use openai_delta_copy to keep one around.
+typedef void (*openai_delta_callback)(openai_delta_type type, const char* delta, size_t length, void* user_data);
+
+// NUL-terminated copy of a delta, caller frees
+char* openai_delta_copy(const char* delta, size_t length);
 
 // stream response deltas into a callback, returns NULL if successful, or an error if one occurred (caller frees).
+// opens a new connection, use a session to send more than one request.
 char* openai_stream_response(openai_request* request, openai_delta_callback callback, void* user_data);
 
+// the parser a response's event stream goes through, fed by the caller instead of a transfer (e.g. to replay a
+// recorded stream, or to benchmark the parser on its own). the request is only read for its raw and timings modes
+typedef struct openai_stream_parser openai_stream_parser;
+
+// NULL if out of memory
+openai_stream_parser* openai_stream_parser_new(openai_request* request, openai_delta_callback callback,
+                                               void* user_data);
+
+// the next piece of the event stream, split anywhere. false once the stream failed, see openai_stream_parser_finish
+bool openai_stream_parser_feed(openai_stream_parser* parser, const char* chunk, size_t length);
+
+// off, deltas are taken out of their events by json-c like every other event instead of by the fast path for them
+// (on by default). they come out the same either way, it's for measuring the difference
+void openai_stream_parser_set_fast_path(openai_stream_parser* parser, bool enabled);
+
+// frees the parser, returns NULL if the stream was parsed successfully, or the error it stopped at (caller frees)
+char* openai_stream_parser_finish(openai_stream_parser* parser);
+
+// one reusable connection to the API, requests sent through it share the connection (and TLS session)
+typedef struct openai_session openai_session;
+
+// NULL if CURL couldn't be initialized
+openai_session* openai_session_new(const char* api_key);
+void openai_session_free(openai_session* session);
+
+// same as openai_stream_response, but sent through the session's connection. the request's api_key is ignored.
+char* openai_session_stream_response(openai_session* session, openai_request* request,
+                                     openai_delta_callback callback, void* user_data);
+
+// opens the session's connection ahead of its first request, false if the API couldn't be reached
+bool openai_session_warm(openai_session* session);
+
+// a session whose connection is opened on a thread of its own, while the caller is still getting the request ready
+typedef struct openai_session_warmup openai_session_warmup;
+
+// starts connecting to openai_get_api_url right away, with api_key if it's known yet (NULL if not). NULL if the
+// thread couldn't be started. one at a time, a warm-up still running at exit() is cancelled
+openai_session_warmup* openai_session_warmup_start(const char* api_key);
+
+// waits for the connection and hands over its session, now sending api_key (caller frees). NULL if
+// openai_get_api_url has changed since, the warm-up is freed either way. the first request through the session
+// reports warmup_us and warmup_hidden_us in its timings: how long opening the connection took, and how much of
+// that was already done by the time this was called
+openai_session* openai_session_warmup_finish(openai_session_warmup* warmup, const char* api_key);
+
+// stops the warm-up wherever it is and frees it, NULL is fine
+void openai_session_warmup_cancel(openai_session_warmup* warmup);
+
+// id of the last response completed through the session, NULL if there isn't one (owned by the session)
+const char* openai_session_get_last_response_id(const openai_session* session);
+
+// stops the request the session is streaming, from its callback (e.g. once there's nobody left to forward deltas to).
+// the transfer is aborted as soon as CURL gets back to it and the stream returns "Cancelled", the session can be used
+// again afterwards
+void openai_session_cancel(openai_session* session);
+
+// how a scheduled request ended, everything is borrowed for the duration of the callback
+typedef struct {
+	const char* response_id; // NULL if the response never completed
+	const char* error; // NULL if successful
+	int64_t queued_us; // waiting for admission (including rate limited attempts)
+	int64_t total_us; // from the request being sent to the end of the stream
+} openai_completion;
+
+typedef void (*openai_completion_callback)(const openai_completion* completion, void* user_data);
+
+// runs many requests at once over the curl multi interface (multiplexed over HTTP/2 where the server supports it),
+// pacing new requests by the rate limit headers the API sends back. everything runs on the calling thread: either
+// inside openai_scheduler_run, or the caller's own event loop (see openai_scheduler_set_event_callbacks)
+typedef struct openai_scheduler openai_scheduler;
+
+// NULL if CURL couldn't be initialized
+openai_scheduler* openai_scheduler_new(const char* api_key, size_t max_concurrency);
+void openai_scheduler_free(openai_scheduler* scheduler);
+
+// queue a request, nothing is sent until openai_scheduler_run (or, driven by an event loop, until the timer this
+// sets expires). the request must stay valid until it completes.
+// the request's api_key is ignored. returns false if it couldn't be queued.
+bool openai_scheduler_submit(openai_scheduler* scheduler, openai_request* request, openai_delta_callback callback,
+                             openai_completion_callback on_complete, void* user_data);
+
+// runs until every queued request has completed, deltas and completions are delivered from inside this call.
+// returns NULL, or an error if the scheduler itself failed (caller frees). failed requests are reported through
+// their completion instead.
+char* openai_scheduler_run(openai_scheduler* scheduler);
+
+// events for a socket the scheduler wants watched, and which of them happened
+#define OPENAI_POLL_IN 1
+#define OPENAI_POLL_OUT 2
+#define OPENAI_POLL_ERROR 4 // only passed to openai_scheduler_socket_action
+#define OPENAI_POLL_REMOVE 8 // only passed to the socket callback: stop watching fd, it may be closed next
+
+// watch fd for events (OPENAI_POLL_IN and/or OPENAI_POLL_OUT, replacing what it was watched for before), or stop
+// watching it for OPENAI_POLL_REMOVE
+typedef void (*openai_socket_callback)(int fd, int events, void* user_data);
+
+// call openai_scheduler_timeout once timeout_ms have passed (0: as soon as possible), replacing the timer set
+// before. -1 cancels it. the timer is one-shot
+typedef void (*openai_timer_callback)(long timeout_ms, void* user_data);
+
+// drives the scheduler from an event loop of the caller's (epoll, kqueue, libuv...) instead of
+// openai_scheduler_run: the callbacks say which sockets to watch and when to wake up, and the loop calls
+// openai_scheduler_socket_action and openai_scheduler_timeout back. nothing blocks, so one thread can keep hundreds
+// of streams going. set before submitting anything, a scheduler set up this way can't be run
+void openai_scheduler_set_event_callbacks(openai_scheduler* scheduler, openai_socket_callback on_socket,
+                                          openai_timer_callback on_timer, void* user_data);
+
+// fd is ready for events (OPENAI_POLL_*, 0 if unknown). deltas and completions are delivered from inside this call,
+// and from inside openai_scheduler_timeout. both return NULL, or an error if the scheduler itself failed (caller
+// frees), failed requests are reported through their completion instead
+char* openai_scheduler_socket_action(openai_scheduler* scheduler, int fd, int events);
+
+// the timer set through the timer callback expired
+char* openai_scheduler_timeout(openai_scheduler* scheduler);
+
+// requests submitted which haven't completed yet
+size_t openai_scheduler_active(const openai_scheduler* scheduler);
+
 #endif //CHATGPT_CLI_OPENAI_WRAPPER_H
@@ -0,0 +1,145 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "output.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <threads.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+	#include <unistd.h>
+#endif
+
+static struct {
+	bool tty;
+	int64_t deadline_us; // after the oldest byte waiting, at the latest
+
+	// the flusher thread writes out what the network left waiting once its deadline comes, it's only started if
+	// that ever happens
+	mtx_t lock; // everything below
+	cnd_t flush_at_changed;
+	bool flusher_started;
+	size_t waiting; // bytes written since the last flush
+	int64_t oldest_us; // when the first of them was written
+	int64_t last_flush_us;
+	int64_t flush_at_us; // when the flusher should write out what's waiting, 0 if it shouldn't
+} output;
+
+static int64_t output_now_us() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// caller holds the lock
+static void output_flush_locked(const int64_t now_us) {
+	fflush(stdout);
+	output.waiting = 0;
+	output.last_flush_us = now_us;
+	output.flush_at_us = 0;
+}
+
+static int output_flusher(void* unused) {
+	(void)unused;
+	mtx_lock(&output.lock);
+	while (true) {
+		if (output.flush_at_us == 0) {
+			cnd_wait(&output.flush_at_changed, &output.lock);
+			continue;
+		}
+
+		const int64_t now_us = output_now_us();
+		const int64_t remaining_us = output.flush_at_us - now_us;
+		if (remaining_us <= 0) {
+			output_flush_locked(now_us);
+			continue;
+		}
+
+		// the condition variable only waits until a wall clock time
+		struct timespec until;
+		timespec_get(&until, TIME_UTC);
+		const int64_t until_ns = (int64_t)until.tv_nsec + remaining_us * 1000;
+		until.tv_sec += (time_t)(until_ns / 1000000000);
+		until.tv_nsec = (long)(until_ns % 1000000000);
+		cnd_timedwait(&output.flush_at_changed, &output.lock, &until);
+	}
+	return 0;
+}
+
+void chatgpt_cli_output_init() {
+	output.tty = isatty(fileno(stdout));
+	output.deadline_us = (output.tty ? CHATGPT_CLI_OUTPUT_TTY_DEADLINE_MS : CHATGPT_CLI_OUTPUT_PIPE_DEADLINE_MS) * 1000;
+	mtx_init(&output.lock, mtx_plain);
+	cnd_init(&output.flush_at_changed);
+
+	// stdout is line buffered on a terminal, which would still write each line of a burst on its own
+	setvbuf(stdout, NULL, _IOFBF, CHATGPT_CLI_OUTPUT_BUFFER_SIZE);
+}
+
+void chatgpt_cli_output_flush() {
+	mtx_lock(&output.lock);
+	output_flush_locked(output_now_us());
+	mtx_unlock(&output.lock);
+}
+
+void chatgpt_cli_output_write(const char* text, const size_t length) {
+	if (length == 0) return;
+
+	mtx_lock(&output.lock);
+	fwrite(text, 1, length, stdout);
+
+	const int64_t now_us = output_now_us();
+	if (output.waiting == 0) output.oldest_us = now_us;
+	output.waiting += length;
+
+	if (output.waiting >= CHATGPT_CLI_OUTPUT_BUFFER_SIZE) {
+		// a full buffer was written out by stdio already, start over with what's left in it
+		output.waiting %= CHATGPT_CLI_OUTPUT_BUFFER_SIZE;
+		output.oldest_us = now_us;
+	} else if (output.tty && now_us - output.oldest_us >= output.deadline_us) {
+		// one long burst shouldn't sit in the buffer until the network goes quiet
+		output_flush_locked(now_us);
+	}
+	mtx_unlock(&output.lock);
+}
+
+void chatgpt_cli_output_idle() {
+	mtx_lock(&output.lock);
+	if (output.waiting == 0) {
+		mtx_unlock(&output.lock);
+		return;
+	}
+
+	// on a terminal, the first text after a pause is shown right away and anything quicker than the deadline is
+	// gathered up. a pipe or a file only gets what's waited long enough
+	const int64_t now_us = output_now_us();
+	const int64_t due_us = output.tty ? output.last_flush_us + output.deadline_us : output.oldest_us + output.deadline_us;
+	if (now_us >= due_us) {
+		output_flush_locked(now_us);
+		mtx_unlock(&output.lock);
+		return;
+	}
+
+	if (output.flush_at_us == 0 || due_us < output.flush_at_us) {
+		output.flush_at_us = due_us;
+		cnd_signal(&output.flush_at_changed);
+	}
+	if (!output.flusher_started) {
+		thrd_t flusher;
+		if (thrd_create(&flusher, output_flusher, NULL) == thrd_success) {
+			thrd_detach(flusher);
+			output.flusher_started = true;
+		} else {
+			output_flush_locked(now_us); // rather early than late
+		}
+	}
+	mtx_unlock(&output.lock);
+}
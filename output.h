@@ -0,0 +1,29 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+#include <stddef.h>
+
+// streamed text is gathered up in stdout's buffer and written in as few writes as possible, instead of one per delta.
+// on a terminal it's written whenever the network goes quiet (or every CHATGPT_CLI_OUTPUT_TTY_DEADLINE_MS within a
+// burst), so it shows up just as quickly as before. into a pipe or file it's written in big blocks, at most
+// CHATGPT_CLI_OUTPUT_PIPE_DEADLINE_MS late
+#define CHATGPT_CLI_OUTPUT_BUFFER_SIZE (64 * 1024)
+#define CHATGPT_CLI_OUTPUT_TTY_DEADLINE_MS 4
+#define CHATGPT_CLI_OUTPUT_PIPE_DEADLINE_MS 100
+
+// call before anything is printed to stdout
+void chatgpt_cli_output_init();
+
+void chatgpt_cli_output_write(const char* text, size_t length);
+
+// nothing more is coming until the network delivers it, writes out what's waiting if someone could be watching
+void chatgpt_cli_output_idle();
+
+// writes out everything now, e.g. once the response is done. printing to stdout directly in between is fine, it
+// goes through the same buffer
+void chatgpt_cli_output_flush();
+
+#endif //OUTPUT_H
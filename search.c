@@ -0,0 +1,668 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "search.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/locking.h>
+#else
+	#include <fcntl.h>
+	#include <sys/file.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// held while updating, so two processes don't index the same turns
+#define SEARCH_LOCK_FILE_NAME "search.lock"
+
+#define SEARCH_DICTIONARY_MAGIC 0x54434453 // "SDCT"
+#define SEARCH_POSTINGS_MAGIC "SPST" // so no block starts at offset 0, which means "no previous block"
+#define SEARCH_POSTINGS_MAGIC_LENGTH 4
+
+// slots in a new dictionary, it's rebuilt at twice the size once it's half full
+#define SEARCH_DICTIONARY_MIN_CAPACITY 4096
+
+// BM25 parameters, the usual ones
+#define SEARCH_BM25_K1 1.2
+#define SEARCH_BM25_B 0.75
+
+typedef struct {
+	uint32_t magic;
+	uint32_t reserved;
+	uint64_t capacity; // slots, a power of 2
+	uint64_t used;
+	uint64_t indexed_count; // history turns indexed so far
+	uint64_t total_length; // terms in all of them, for the average document length
+} search_dictionary_header;
+
+// terms are only known by their 64 bit hash, a collision would merge two words' postings
+typedef struct {
+	uint64_t term_hash; // 0 if empty
+	uint64_t head; // offset of the newest postings block
+	uint64_t document_count; // documents containing the term (a few more after an interrupted update)
+} search_dictionary_slot;
+
+// a postings block is all varints: distance back to the previous block (0 if none), number of postings,
+// then per posting the document (delta from the previous one in the block) and the term's frequency in it
+
+static char* search_path(const char* file_name) {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	const size_t len = strlen(app_folder) + strlen(file_name) + 2;
+	// 2 for path separator and \0
+
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s", app_folder, PATH_SEPARATOR, file_name);
+	free(app_folder);
+	return path;
+}
+
+// ---- terms ----
+
+static bool search_is_term_char(const unsigned char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+void chatgpt_cli_search_terms(const char* text, const chatgpt_cli_search_term_callback callback, void* user_data) {
+	const unsigned char* c = (const unsigned char*)text;
+	while (*c) {
+		if (!search_is_term_char(*c)) {
+			c++;
+			continue;
+		}
+
+		const unsigned char* start = c;
+		uint64_t hash = 14695981039346656037ULL;
+		for (; *c && search_is_term_char(*c); c++) {
+			hash ^= (*c >= 'A' && *c <= 'Z') ? *c + ('a' - 'A') : *c;
+			hash *= 1099511628211ULL;
+		}
+		if (hash == 0) hash = 1; // 0 marks empty slots
+
+		callback((const char*)start, c - start, hash, user_data);
+	}
+}
+
+// ---- varints ----
+
+static size_t search_varint_write(unsigned char* out, uint64_t value) {
+	size_t length = 0;
+	while (value >= 0x80) {
+		out[length++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	out[length++] = (unsigned char)value;
+	return length;
+}
+
+// false if it runs past end
+static bool search_varint_read(const unsigned char** in, const unsigned char* end, uint64_t* value) {
+	*value = 0;
+	for (int shift = 0; shift < 64 && *in < end; shift += 7) {
+		const unsigned char byte = *(*in)++;
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
+
+// ---- files ----
+
+typedef struct {
+	char* data;
+	size_t length;
+} search_map;
+
+// an empty map if the file doesn't exist
+static search_map search_map_file(const char* file_name) {
+	search_map map = {0};
+	char* path = search_path(file_name);
+
+	#ifdef _WIN32
+	// no mmap here, read it whole instead
+	FILE* file = fopen(path, "rb");
+	free(path);
+	if (!file) return map;
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (length > 0 && (map.data = malloc(length))) {
+		map.length = fread(map.data, 1, length, file);
+	}
+	fclose(file);
+	#else
+	const int fd = open(path, O_RDONLY);
+	free(path);
+	if (fd < 0) return map;
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+		void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED) {
+			map.data = data;
+			map.length = file_stat.st_size;
+		}
+	}
+	close(fd); // the mapping stays valid
+	#endif
+
+	return map;
+}
+
+static void search_unmap(search_map* map) {
+	if (!map->data) return;
+	#ifdef _WIN32
+	free(map->data);
+	#else
+	munmap(map->data, map->length);
+	#endif
+	map->data = NULL;
+	map->length = 0;
+}
+
+static FILE* search_lock() {
+	char* path = search_path(SEARCH_LOCK_FILE_NAME);
+	FILE* file = fopen(path, "ab");
+	free(path);
+	if (!file) return NULL;
+
+	#ifdef _WIN32
+	fseek(file, 0, SEEK_SET);
+	_locking(_fileno(file), _LK_LOCK, 1);
+	#else
+	flock(fileno(file), LOCK_EX);
+	#endif
+	return file;
+}
+
+static void search_unlock(FILE* file) {
+	#ifdef _WIN32
+	fseek(file, 0, SEEK_SET);
+	_locking(_fileno(file), _LK_UNLCK, 1);
+	#endif
+	fclose(file); // also drops the flock
+}
+
+// ---- updating ----
+
+// postings of one term for the turns being indexed, before they're written as a block
+typedef struct {
+	uint64_t term_hash; // 0 if empty
+	unsigned char* postings;
+	size_t length;
+	size_t capacity;
+	uint64_t count;
+
+	uint64_t last_document; // the last posting written, to delta encode the next one
+	bool has_current;
+	uint64_t current_document; // still being counted
+	uint64_t current_frequency;
+} search_pending_term;
+
+typedef struct {
+	search_pending_term* terms;
+	size_t capacity;
+	size_t used;
+	bool failed;
+
+	uint64_t document; // being tokenized
+	uint64_t document_length;
+} search_pending;
+
+static void search_pending_flush_current(search_pending* pending, search_pending_term* term) {
+	if (!term->has_current) return;
+
+	if (term->length + 20 > term->capacity) {
+		const size_t new_capacity = term->capacity ? term->capacity * 2 : 32;
+		unsigned char* new_postings = realloc(term->postings, new_capacity);
+		if (!new_postings) {
+			pending->failed = true;
+			return;
+		}
+		term->postings = new_postings;
+		term->capacity = new_capacity;
+	}
+
+	const uint64_t delta = term->count ? term->current_document - term->last_document : term->current_document;
+	term->length += search_varint_write(term->postings + term->length, delta);
+	term->length += search_varint_write(term->postings + term->length, term->current_frequency);
+	term->count++;
+	term->last_document = term->current_document;
+	term->has_current = false;
+}
+
+static search_pending_term* search_pending_find(search_pending* pending, const uint64_t term_hash) {
+	const size_t mask = pending->capacity - 1;
+	size_t slot = term_hash & mask;
+	while (pending->terms[slot].term_hash != 0 && pending->terms[slot].term_hash != term_hash) {
+		slot = (slot + 1) & mask;
+	}
+	return &pending->terms[slot];
+}
+
+static bool search_pending_grow(search_pending* pending) {
+	const size_t old_capacity = pending->capacity;
+	search_pending_term* old_terms = pending->terms;
+
+	pending->capacity = old_capacity ? old_capacity * 2 : 1024;
+	pending->terms = calloc(pending->capacity, sizeof(search_pending_term));
+	if (!pending->terms) {
+		pending->terms = old_terms;
+		pending->capacity = old_capacity;
+		return false;
+	}
+
+	for (size_t i = 0; i < old_capacity; i++) {
+		if (old_terms[i].term_hash) *search_pending_find(pending, old_terms[i].term_hash) = old_terms[i];
+	}
+	free(old_terms);
+	return true;
+}
+
+static void search_pending_add_term(const char* term, const size_t length, const uint64_t hash, void* user_data) {
+	(void)term;
+	(void)length;
+	search_pending* pending = user_data;
+	if (pending->failed) return;
+
+	if ((pending->used + 1) * 2 > pending->capacity && !search_pending_grow(pending)) {
+		pending->failed = true;
+		return;
+	}
+
+	search_pending_term* pending_term = search_pending_find(pending, hash);
+	if (pending_term->term_hash == 0) {
+		pending_term->term_hash = hash;
+		pending->used++;
+	}
+
+	if (pending_term->has_current && pending_term->current_document != pending->document) {
+		search_pending_flush_current(pending, pending_term);
+	}
+	if (!pending_term->has_current) {
+		pending_term->has_current = true;
+		pending_term->current_document = pending->document;
+		pending_term->current_frequency = 0;
+	}
+	pending_term->current_frequency++;
+	pending->document_length++;
+}
+
+static void search_pending_free(search_pending* pending) {
+	for (size_t i = 0; i < pending->capacity; i++) free(pending->terms[i].postings);
+	free(pending->terms);
+}
+
+// a new dictionary with room for at least used * 2 terms, the old one's slots rehashed into it
+static bool search_dictionary_rebuild(search_dictionary_header* header, const uint64_t used) {
+	uint64_t capacity = SEARCH_DICTIONARY_MIN_CAPACITY;
+	while (capacity < used * 4) capacity *= 2;
+
+	search_dictionary_slot* slots = calloc(capacity, sizeof(search_dictionary_slot));
+	if (!slots) return false;
+
+	search_map old = search_map_file(CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME);
+	if (old.length >= sizeof(search_dictionary_header) + header->capacity * sizeof(search_dictionary_slot)) {
+		const search_dictionary_slot* old_slots = (const search_dictionary_slot*)(old.data +
+			sizeof(search_dictionary_header));
+		for (uint64_t i = 0; i < header->capacity; i++) {
+			if (old_slots[i].term_hash == 0) continue;
+
+			uint64_t slot = old_slots[i].term_hash & (capacity - 1);
+			while (slots[slot].term_hash != 0) slot = (slot + 1) & (capacity - 1);
+			slots[slot] = old_slots[i];
+		}
+	}
+	search_unmap(&old);
+
+	header->magic = SEARCH_DICTIONARY_MAGIC;
+	header->capacity = capacity;
+
+	char* path = search_path(CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME);
+	char* tmp_path = search_path(CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME ".tmp");
+	FILE* file = fopen(tmp_path, "wb");
+	bool written = file != NULL;
+	if (file) {
+		written = fwrite(header, sizeof(search_dictionary_header), 1, file) == 1;
+		written = written && fwrite(slots, sizeof(search_dictionary_slot), capacity, file) == capacity;
+		written = fclose(file) == 0 && written;
+
+		#ifdef _WIN32
+		if (written) remove(path); // rename doesn't replace files here
+		#endif
+		written = written && rename(tmp_path, path) == 0;
+		if (!written) remove(tmp_path);
+	}
+
+	free(tmp_path);
+	free(path);
+	free(slots);
+	return written;
+}
+
+// appends each pending term's postings as a block and points its dictionary slot at it
+static bool search_write_postings(search_pending* pending, search_dictionary_header* header) {
+	if ((header->used + pending->used) * 2 > header->capacity &&
+		!search_dictionary_rebuild(header, header->used + pending->used)) {
+		return false;
+	}
+
+	char* postings_path = search_path(CHATGPT_CLI_SEARCH_POSTINGS_FILE_NAME);
+	FILE* postings_file = fopen(postings_path, "ab");
+	free(postings_path);
+	char* dictionary_path = search_path(CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME);
+	FILE* dictionary_file = fopen(dictionary_path, "r+b");
+	free(dictionary_path);
+	if (!postings_file || !dictionary_file) {
+		if (postings_file) fclose(postings_file);
+		if (dictionary_file) fclose(dictionary_file);
+		return false;
+	}
+
+	fseek(postings_file, 0, SEEK_END);
+	uint64_t offset = (uint64_t)ftell(postings_file);
+	bool written = true;
+	if (offset == 0) {
+		written = fwrite(SEARCH_POSTINGS_MAGIC, 1, SEARCH_POSTINGS_MAGIC_LENGTH, postings_file) ==
+			SEARCH_POSTINGS_MAGIC_LENGTH;
+		offset = SEARCH_POSTINGS_MAGIC_LENGTH;
+	}
+
+	const uint64_t mask = header->capacity - 1;
+	for (size_t i = 0; i < pending->capacity && written; i++) {
+		search_pending_term* term = &pending->terms[i];
+		if (term->term_hash == 0) continue;
+
+		// find the term's slot, or the empty one it goes into
+		uint64_t slot_position = term->term_hash & mask;
+		search_dictionary_slot slot;
+		while (true) {
+			fseek(dictionary_file, (long)(sizeof(search_dictionary_header) + slot_position * sizeof(slot)), SEEK_SET);
+			if (fread(&slot, sizeof(slot), 1, dictionary_file) != 1) {
+				written = false;
+				break;
+			}
+			if (slot.term_hash == 0 || slot.term_hash == term->term_hash) break;
+			slot_position = (slot_position + 1) & mask;
+		}
+		if (!written) break;
+
+		if (slot.term_hash == 0) {
+			slot = (search_dictionary_slot){.term_hash = term->term_hash};
+			header->used++;
+		}
+
+		unsigned char block_header[20];
+		size_t block_header_length = search_varint_write(block_header, slot.head ? offset - slot.head : 0);
+		block_header_length += search_varint_write(block_header + block_header_length, term->count);
+
+		written = fwrite(block_header, 1, block_header_length, postings_file) == block_header_length &&
+			fwrite(term->postings, 1, term->length, postings_file) == term->length;
+
+		slot.head = offset;
+		slot.document_count += term->count;
+		offset += block_header_length + term->length;
+
+		fseek(dictionary_file, (long)(sizeof(search_dictionary_header) + slot_position * sizeof(slot)), SEEK_SET);
+		written = written && fwrite(&slot, sizeof(slot), 1, dictionary_file) == 1;
+	}
+
+	// the postings have to be on disk before the slots pointing at them are
+	written = fclose(postings_file) == 0 && written;
+	written = fflush(dictionary_file) == 0 && written;
+	fclose(dictionary_file);
+	return written;
+}
+
+bool chatgpt_cli_search_update(const chatgpt_cli_history* history) {
+	FILE* lock_file = search_lock();
+	if (!lock_file) return false;
+
+	search_dictionary_header header = {0};
+	search_map dictionary = search_map_file(CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME);
+	if (dictionary.length >= sizeof(header)) memcpy(&header, dictionary.data, sizeof(header));
+	search_unmap(&dictionary);
+
+	const size_t count = chatgpt_cli_history_count(history);
+	if (header.magic != SEARCH_DICTIONARY_MAGIC || header.indexed_count > count) {
+		// nothing usable yet, start from scratch
+		char* postings_path = search_path(CHATGPT_CLI_SEARCH_POSTINGS_FILE_NAME);
+		remove(postings_path);
+		free(postings_path);
+
+		header = (search_dictionary_header){0};
+		if (!search_dictionary_rebuild(&header, 0)) {
+			search_unlock(lock_file);
+			return false;
+		}
+	}
+
+	if (header.indexed_count == count) {
+		search_unlock(lock_file);
+		return true;
+	}
+
+	char* documents_path = search_path(CHATGPT_CLI_SEARCH_DOCUMENTS_FILE_NAME);
+	FILE* documents_file = fopen(documents_path, "r+b");
+	if (!documents_file) documents_file = fopen(documents_path, "w+b");
+	free(documents_path);
+	if (!documents_file) {
+		search_unlock(lock_file);
+		return false;
+	}
+
+	search_pending pending = {0};
+	bool written = search_pending_grow(&pending);
+	for (size_t position = header.indexed_count; position < count && written; position++) {
+		pending.document = position;
+		pending.document_length = 0;
+
+		chatgpt_cli_history_turn turn;
+		if (chatgpt_cli_history_get(history, position, &turn)) {
+			chatgpt_cli_search_terms(turn.prompt, search_pending_add_term, &pending);
+			chatgpt_cli_search_terms(turn.output, search_pending_add_term, &pending);
+		}
+
+		const uint32_t document_length = (uint32_t)pending.document_length;
+		fseek(documents_file, (long)(position * sizeof(document_length)), SEEK_SET);
+		written = fwrite(&document_length, sizeof(document_length), 1, documents_file) == 1;
+		header.total_length += document_length;
+	}
+	for (size_t i = 0; i < pending.capacity; i++) search_pending_flush_current(&pending, &pending.terms[i]);
+
+	written = fclose(documents_file) == 0 && written && !pending.failed;
+	written = written && search_write_postings(&pending, &header);
+	search_pending_free(&pending);
+
+	// only now are the turns indexed, anything interrupted before this is indexed (again) next time
+	if (written) {
+		header.indexed_count = count;
+
+		char* dictionary_path = search_path(CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME);
+		FILE* dictionary_file = fopen(dictionary_path, "r+b");
+		free(dictionary_path);
+		written = dictionary_file && fwrite(&header, sizeof(header), 1, dictionary_file) == 1;
+		if (dictionary_file) written = fclose(dictionary_file) == 0 && written;
+	}
+
+	search_unlock(lock_file);
+	return written;
+}
+
+// ---- searching ----
+
+typedef struct {
+	uint64_t document; // + 1, 0 if empty
+	double score;
+	size_t last_term; // + 1, a document listed twice for a term (after an interrupted update) only counts once
+} search_score;
+
+typedef struct {
+	search_score* scores;
+	size_t capacity;
+	size_t used;
+} search_scores;
+
+static search_score* search_scores_find(search_scores* scores, const uint64_t document) {
+	const size_t mask = scores->capacity - 1;
+	size_t slot = (document * 0x9E3779B97F4A7C15ULL) >> 20 & mask;
+	while (scores->scores[slot].document != 0 && scores->scores[slot].document != document + 1) {
+		slot = (slot + 1) & mask;
+	}
+	return &scores->scores[slot];
+}
+
+static bool search_scores_grow(search_scores* scores) {
+	const size_t old_capacity = scores->capacity;
+	search_score* old_scores = scores->scores;
+
+	scores->capacity = old_capacity ? old_capacity * 2 : 1024;
+	scores->scores = calloc(scores->capacity, sizeof(search_score));
+	if (!scores->scores) {
+		scores->scores = old_scores;
+		scores->capacity = old_capacity;
+		return false;
+	}
+
+	for (size_t i = 0; i < old_capacity; i++) {
+		if (old_scores[i].document) *search_scores_find(scores, old_scores[i].document - 1) = old_scores[i];
+	}
+	free(old_scores);
+	return true;
+}
+
+typedef struct {
+	uint64_t* hashes;
+	size_t count;
+	size_t capacity;
+} search_query_terms;
+
+static void search_query_add_term(const char* term, const size_t length, const uint64_t hash, void* user_data) {
+	(void)term;
+	(void)length;
+	search_query_terms* terms = user_data;
+	for (size_t i = 0; i < terms->count; i++) {
+		if (terms->hashes[i] == hash) return; // repeating a word doesn't make it matter more
+	}
+
+	if (terms->count == terms->capacity) {
+		const size_t new_capacity = terms->capacity ? terms->capacity * 2 : 8;
+		uint64_t* new_hashes = realloc(terms->hashes, new_capacity * sizeof(uint64_t));
+		if (!new_hashes) return;
+		terms->hashes = new_hashes;
+		terms->capacity = new_capacity;
+	}
+	terms->hashes[terms->count++] = hash;
+}
+
+static int search_result_compare(const void* a, const void* b) {
+	const chatgpt_cli_search_result* a_result = a;
+	const chatgpt_cli_search_result* b_result = b;
+	if (a_result->score != b_result->score) return a_result->score < b_result->score ? 1 : -1;
+	return (a_result->position < b_result->position) - (a_result->position > b_result->position); // newer first
+}
+
+size_t chatgpt_cli_search(const chatgpt_cli_history* history, const char* query, const size_t max_results,
+                          chatgpt_cli_search_result** results) {
+	*results = NULL;
+	chatgpt_cli_search_update(history); // whatever isn't indexed yet, usually nothing
+
+	search_map dictionary = search_map_file(CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME);
+	search_map postings = search_map_file(CHATGPT_CLI_SEARCH_POSTINGS_FILE_NAME);
+	search_map documents = search_map_file(CHATGPT_CLI_SEARCH_DOCUMENTS_FILE_NAME);
+
+	search_query_terms terms = {0};
+	chatgpt_cli_search_terms(query, search_query_add_term, &terms);
+
+	search_scores scores = {0};
+	search_dictionary_header header;
+	const bool usable = dictionary.length >= sizeof(header) && search_scores_grow(&scores);
+	if (usable) memcpy(&header, dictionary.data, sizeof(header));
+
+	if (usable && header.magic == SEARCH_DICTIONARY_MAGIC && header.indexed_count > 0 &&
+		dictionary.length >= sizeof(header) + header.capacity * sizeof(search_dictionary_slot)) {
+		const search_dictionary_slot* slots = (const search_dictionary_slot*)(dictionary.data + sizeof(header));
+		const uint32_t* document_lengths = (const uint32_t*)documents.data;
+		const size_t documents_count = documents.length / sizeof(uint32_t);
+		const double average_length = (double)header.total_length / (double)header.indexed_count;
+
+		for (size_t term = 0; term < terms.count; term++) {
+			const uint64_t mask = header.capacity - 1;
+			uint64_t slot_position = terms.hashes[term] & mask;
+			while (slots[slot_position].term_hash != 0 && slots[slot_position].term_hash != terms.hashes[term]) {
+				slot_position = (slot_position + 1) & mask;
+			}
+			const search_dictionary_slot* slot = &slots[slot_position];
+			if (slot->term_hash == 0) continue;
+
+			// rarer words count for more
+			const double document_count = (double)slot->document_count;
+			const double idf = log(1 + ((double)header.indexed_count - document_count + 0.5) / (document_count + 0.5));
+
+			// newest block first
+			uint64_t block = slot->head;
+			while (block >= SEARCH_POSTINGS_MAGIC_LENGTH && block < postings.length) {
+				const unsigned char* in = (const unsigned char*)postings.data + block;
+				const unsigned char* end = (const unsigned char*)postings.data + postings.length;
+
+				uint64_t back, count;
+				if (!search_varint_read(&in, end, &back) || !search_varint_read(&in, end, &count)) break;
+
+				uint64_t document = 0;
+				for (uint64_t i = 0; i < count; i++) {
+					uint64_t delta, frequency;
+					if (!search_varint_read(&in, end, &delta) || !search_varint_read(&in, end, &frequency)) break;
+					document += delta;
+
+					if ((scores.used + 1) * 2 > scores.capacity && !search_scores_grow(&scores)) break;
+					search_score* score = search_scores_find(&scores, document);
+					if (score->document == 0) {
+						score->document = document + 1;
+						scores.used++;
+					}
+					if (score->last_term == term + 1) continue;
+					score->last_term = term + 1;
+
+					const double length = document < documents_count ? document_lengths[document] : average_length;
+					const double tf = (double)frequency;
+					score->score += idf * tf * (SEARCH_BM25_K1 + 1) /
+						(tf + SEARCH_BM25_K1 * (1 - SEARCH_BM25_B + SEARCH_BM25_B * length / average_length));
+				}
+
+				if (back == 0 || back > block) break;
+				block -= back;
+			}
+		}
+	}
+
+	size_t result_count = 0;
+	chatgpt_cli_search_result* all_results = malloc((scores.used ? scores.used : 1) * sizeof(chatgpt_cli_search_result));
+	for (size_t i = 0; i < scores.capacity && all_results; i++) {
+		if (scores.scores[i].document == 0) continue;
+		all_results[result_count++] = (chatgpt_cli_search_result){
+			.position = scores.scores[i].document - 1,
+			.score = scores.scores[i].score,
+		};
+	}
+	if (all_results) qsort(all_results, result_count, sizeof(chatgpt_cli_search_result), search_result_compare);
+	if (result_count > max_results) result_count = max_results;
+
+	free(scores.scores);
+	free(terms.hashes);
+	search_unmap(&dictionary);
+	search_unmap(&postings);
+	search_unmap(&documents);
+
+	*results = all_results;
+	return all_results ? result_count : 0;
+}
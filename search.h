@@ -0,0 +1,41 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef SEARCH_H
+#define SEARCH_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "history.h"
+
+// hash table from term to the newest block of its postings
+#define CHATGPT_CLI_SEARCH_DICTIONARY_FILE_NAME "search.dict"
+
+// blocks of compressed postings, each one pointing back to the term's previous block
+#define CHATGPT_CLI_SEARCH_POSTINGS_FILE_NAME "search.post"
+
+// number of terms in each indexed turn, by history position
+#define CHATGPT_CLI_SEARCH_DOCUMENTS_FILE_NAME "search.docs"
+
+// indexes the prompt and output of every turn in the history which isn't indexed yet.
+// false if the index couldn't be written
+bool chatgpt_cli_search_update(const chatgpt_cli_history* history);
+
+typedef struct {
+	size_t position; // in the history
+	double score;
+} chatgpt_cli_search_result;
+
+// turns matching any word of the query, best first (BM25). returns how many were found, at most max_results
+// (*results is set even if there are none, caller frees)
+size_t chatgpt_cli_search(const chatgpt_cli_history* history, const char* query, size_t max_results,
+                          chatgpt_cli_search_result** results);
+
+// calls back for every word of text (lowercased ASCII letters and digits, anything non-ASCII counts as a letter),
+// with the hash the index knows it by. used to find the words of a query again for snippets
+typedef void (*chatgpt_cli_search_term_callback)(const char* term, size_t length, uint64_t hash, void* user_data);
+void chatgpt_cli_search_terms(const char* text, chatgpt_cli_search_term_callback callback, void* user_data);
+
+#endif //SEARCH_H
@@ -0,0 +1,397 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "stats.h"
+
+#include <dirent.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "config.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#include <sys/locking.h>
+#else
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+#define STATS_FILE_MAGIC 0x54534843 // "CHST"
+#define STATS_FILE_VERSION 1
+#define STATS_FILE_EXTENSION ".hist"
+
+// values below 2 * STATS_SUB_BUCKET_COUNT get a bucket each, above that every power of 2 is split into
+// STATS_SUB_BUCKET_COUNT buckets, so a bucket is never more than 1/64 (1.6%) off
+#define STATS_SUB_BUCKET_BITS 6
+#define STATS_SUB_BUCKET_COUNT (1 << STATS_SUB_BUCKET_BITS)
+
+// anything bigger is counted as this (19 hours in microseconds)
+#define STATS_MAX_VALUE ((1ULL << 36) - 1)
+
+// enough for STATS_MAX_VALUE: (36 - 1 - STATS_SUB_BUCKET_BITS) * 64 + 128
+#define STATS_BUCKET_COUNT 1984
+
+// longest model name kept in the file, longer ones are cut short (their file name still tells them apart)
+#define STATS_MODEL_NAME_MAX_LENGTH 111
+
+typedef struct {
+	atomic_uint_least64_t count;
+	atomic_uint_least64_t sum;
+	atomic_int_least64_t min;
+	atomic_int_least64_t max;
+	atomic_uint_least64_t buckets[STATS_BUCKET_COUNT];
+} stats_histogram;
+
+typedef struct {
+	atomic_uint_least64_t armed;
+	atomic_uint_least64_t sent;
+	atomic_uint_least64_t won;
+} stats_hedges;
+
+// the whole file, mapped shared into every process recording to it and updated in place with atomics
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t metric_count;
+	uint32_t bucket_count;
+	char model[STATS_MODEL_NAME_MAX_LENGTH + 1];
+	stats_histogram histograms[CHATGPT_CLI_STATS_METRIC_COUNT];
+	stats_hedges hedges;
+} stats_file;
+
+// files from before hedges were counted end here. they're still valid, the counts read as 0 and the file grows to
+// hold them the next time it's recorded to
+#define STATS_FILE_MIN_SIZE offsetof(stats_file, hedges)
+
+static size_t stats_bucket_index(uint64_t value) {
+	if (value > STATS_MAX_VALUE) value = STATS_MAX_VALUE;
+	if (value < 2 * STATS_SUB_BUCKET_COUNT) return (size_t)value;
+
+	int highest_bit = 0;
+	while (value >> (highest_bit + 1)) highest_bit++;
+
+	const int shift = highest_bit - STATS_SUB_BUCKET_BITS;
+	return (size_t)shift * STATS_SUB_BUCKET_COUNT + (size_t)(value >> shift);
+}
+
+// middle of the range of values a bucket counts
+static int64_t stats_bucket_value(const size_t index) {
+	if (index < 2 * STATS_SUB_BUCKET_COUNT) return (int64_t)index;
+
+	const size_t shift = index / STATS_SUB_BUCKET_COUNT - 1;
+	const uint64_t mantissa = index - shift * STATS_SUB_BUCKET_COUNT;
+	return (int64_t)((mantissa << shift) + ((1ULL << shift) >> 1));
+}
+
+static char* stats_get_folder() {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	const size_t len = strlen(app_folder) + strlen(CHATGPT_CLI_STATS_FOLDER_NAME) + 2;
+	// 2 for path separator and \0
+
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s", app_folder, PATH_SEPARATOR, CHATGPT_CLI_STATS_FOLDER_NAME);
+	free(app_folder);
+	return path;
+}
+
+static void stats_mkdir(const char* path) {
+	#ifdef _WIN32
+	_mkdir(path);
+	#else
+	mkdir(path, 0700);
+	#endif
+}
+
+static void stats_create_folder(const char* folder) {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	stats_mkdir(app_folder);
+	free(app_folder);
+	stats_mkdir(folder);
+}
+
+// model names become file names as they are if they're safe to, otherwise with a hash of the real name added
+static char* stats_file_path(const char* folder, const char* model) {
+	const size_t model_length = strlen(model);
+	bool safe = model_length > 0 && model_length <= STATS_MODEL_NAME_MAX_LENGTH && model[0] != '.';
+
+	char name[STATS_MODEL_NAME_MAX_LENGTH + 32];
+	size_t name_length = 0;
+	for (size_t i = 0; i < model_length && name_length < STATS_MODEL_NAME_MAX_LENGTH; i++) {
+		const char c = model[i];
+		const bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+			c == '-' || c == '_' || c == '.';
+		name[name_length++] = allowed ? c : '_';
+		if (!allowed) safe = false;
+	}
+	name[name_length] = '\0';
+
+	if (!safe) {
+		uint64_t hash = 14695981039346656037ULL; // FNV-1a
+		for (size_t i = 0; i < model_length; i++) {
+			hash ^= (unsigned char)model[i];
+			hash *= 1099511628211ULL;
+		}
+		snprintf(name + name_length, sizeof(name) - name_length, "-%016llx", (unsigned long long)hash);
+	}
+
+	const size_t len = strlen(folder) + strlen(name) + strlen(STATS_FILE_EXTENSION) + 2;
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s%s", folder, PATH_SEPARATOR, name, STATS_FILE_EXTENSION);
+	return path;
+}
+
+static void stats_file_init(stats_file* file, const char* model) {
+	memset(file, 0, sizeof(stats_file));
+	file->magic = STATS_FILE_MAGIC;
+	file->version = STATS_FILE_VERSION;
+	file->metric_count = CHATGPT_CLI_STATS_METRIC_COUNT;
+	file->bucket_count = STATS_BUCKET_COUNT;
+	strncpy(file->model, model, STATS_MODEL_NAME_MAX_LENGTH);
+	for (size_t i = 0; i < CHATGPT_CLI_STATS_METRIC_COUNT; i++) {
+		atomic_init(&file->histograms[i].min, INT64_MAX);
+		atomic_init(&file->histograms[i].max, -1);
+	}
+}
+
+static bool stats_file_valid(const stats_file* file) {
+	return file->magic == STATS_FILE_MAGIC && file->version == STATS_FILE_VERSION &&
+		file->metric_count == CHATGPT_CLI_STATS_METRIC_COUNT && file->bucket_count == STATS_BUCKET_COUNT;
+}
+
+static void stats_histogram_add(stats_histogram* histogram, const int64_t value) {
+	atomic_fetch_add_explicit(&histogram->buckets[stats_bucket_index((uint64_t)value)], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->sum, (uint64_t)value, memory_order_relaxed);
+
+	int_least64_t min = atomic_load_explicit(&histogram->min, memory_order_relaxed);
+	while (value < min && !atomic_compare_exchange_weak(&histogram->min, &min, value)) {}
+	int_least64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	while (value > max && !atomic_compare_exchange_weak(&histogram->max, &max, value)) {}
+
+	// last, so a reader which sees the count also sees the sample in the buckets
+	atomic_fetch_add_explicit(&histogram->count, 1, memory_order_release);
+}
+
+static void stats_file_add(stats_file* file, const chatgpt_cli_stats_sample* sample) {
+	for (size_t i = 0; i < CHATGPT_CLI_STATS_METRIC_COUNT; i++) {
+		if (sample->values[i] >= 0) stats_histogram_add(&file->histograms[i], sample->values[i]);
+	}
+
+	if (sample->hedge == CHATGPT_CLI_STATS_HEDGE_OFF) return;
+	atomic_fetch_add_explicit(&file->hedges.armed, 1, memory_order_relaxed);
+	if (sample->hedge == CHATGPT_CLI_STATS_HEDGE_NOT_SENT) return;
+	atomic_fetch_add_explicit(&file->hedges.sent, 1, memory_order_relaxed);
+	if (sample->hedge == CHATGPT_CLI_STATS_HEDGE_WON) {
+		atomic_fetch_add_explicit(&file->hedges.won, 1, memory_order_relaxed);
+	}
+}
+
+// reads a whole file, false if it isn't a stats file
+static bool stats_file_read(FILE* file, stats_file* contents) {
+	memset(contents, 0, sizeof(stats_file));
+	return fread(contents, 1, sizeof(stats_file), file) >= STATS_FILE_MIN_SIZE && stats_file_valid(contents);
+}
+
+#ifdef _WIN32
+
+// no shared mappings here, the file is locked and rewritten instead
+bool chatgpt_cli_stats_record(const char* model, const chatgpt_cli_stats_sample* sample) {
+	char* folder = stats_get_folder();
+	char* path = stats_file_path(folder, model);
+
+	FILE* file = fopen(path, "r+b");
+	if (!file) {
+		stats_create_folder(folder);
+		file = fopen(path, "w+b");
+	}
+	free(path);
+	free(folder);
+	if (!file) return false;
+
+	_locking(_fileno(file), _LK_LOCK, 1);
+
+	stats_file* contents = malloc(sizeof(stats_file));
+	if (!stats_file_read(file, contents)) stats_file_init(contents, model);
+	stats_file_add(contents, sample);
+
+	fseek(file, 0, SEEK_SET);
+	const bool written = fwrite(contents, sizeof(stats_file), 1, file) == 1;
+	fflush(file);
+
+	fseek(file, 0, SEEK_SET);
+	_locking(_fileno(file), _LK_UNLCK, 1);
+	fclose(file);
+	free(contents);
+	return written;
+}
+
+#else
+
+// opens the model's file, creating it complete if it doesn't exist yet so nobody ever maps half a file
+static int stats_open(const char* folder, const char* path, const char* model) {
+	const int fd = open(path, O_RDWR);
+	if (fd >= 0 || errno != ENOENT) return fd;
+
+	stats_create_folder(folder);
+
+	const size_t tmp_path_length = strlen(path) + 32;
+	char* tmp_path = malloc(tmp_path_length);
+	snprintf(tmp_path, tmp_path_length, "%s.%d.tmp", path, (int)getpid());
+
+	stats_file* contents = malloc(sizeof(stats_file));
+	stats_file_init(contents, model);
+
+	FILE* tmp_file = fopen(tmp_path, "wb");
+	bool written = tmp_file && fwrite(contents, sizeof(stats_file), 1, tmp_file) == 1;
+	if (tmp_file && fclose(tmp_file) != 0) written = false;
+	free(contents);
+
+	// link fails if another process got there first, which is just as good
+	if (written) link(tmp_path, path);
+	remove(tmp_path);
+	free(tmp_path);
+
+	return open(path, O_RDWR);
+}
+
+bool chatgpt_cli_stats_record(const char* model, const chatgpt_cli_stats_sample* sample) {
+	char* folder = stats_get_folder();
+	char* path = stats_file_path(folder, model);
+	const int fd = stats_open(folder, path, model);
+	free(path);
+	free(folder);
+	if (fd < 0) return false;
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < STATS_FILE_MIN_SIZE ||
+		((size_t)file_stat.st_size < sizeof(stats_file) && ftruncate(fd, sizeof(stats_file)) != 0)) {
+		close(fd);
+		return false;
+	}
+
+	stats_file* file = mmap(NULL, sizeof(stats_file), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (file == MAP_FAILED) return false;
+
+	const bool valid = stats_file_valid(file);
+	if (valid) stats_file_add(file, sample);
+
+	munmap(file, sizeof(stats_file));
+	return valid;
+}
+
+#endif
+
+static void stats_summarize(const stats_histogram* histogram, chatgpt_cli_stats_summary* summary) {
+	memset(summary, 0, sizeof(chatgpt_cli_stats_summary));
+	summary->count = atomic_load(&histogram->count);
+	if (summary->count == 0) return;
+
+	summary->min = atomic_load(&histogram->min);
+	summary->max = atomic_load(&histogram->max);
+	summary->mean = (double)atomic_load(&histogram->sum) / (double)summary->count;
+
+	const double fractions[] = {0.5, 0.9, 0.95, 0.99, 0.999};
+	int64_t* percentiles[] = {&summary->p50, &summary->p90, &summary->p95, &summary->p99, &summary->p999};
+	const size_t percentile_count = sizeof(fractions) / sizeof(fractions[0]);
+
+	// a sample being recorded right now can be in the buckets but not the count yet, which is fine
+	size_t next = 0;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < STATS_BUCKET_COUNT && next < percentile_count; i++) {
+		seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+		while (next < percentile_count && (double)seen >= fractions[next] * (double)summary->count) {
+			int64_t value = stats_bucket_value(i);
+			if (value < summary->min) value = summary->min;
+			if (value > summary->max) value = summary->max;
+			*percentiles[next++] = value;
+		}
+	}
+	while (next < percentile_count) *percentiles[next++] = summary->max;
+}
+
+// false if none of the metrics has any samples
+static bool stats_file_summarize(const stats_file* contents, chatgpt_cli_stats_summary* summaries) {
+	bool any = false;
+	for (size_t i = 0; i < CHATGPT_CLI_STATS_METRIC_COUNT; i++) {
+		stats_summarize(&contents->histograms[i], &summaries[i]);
+		if (summaries[i].count) any = true;
+	}
+	return any;
+}
+
+bool chatgpt_cli_stats_get(const char* model, chatgpt_cli_stats_summary* summaries) {
+	char* folder = stats_get_folder();
+	char* path = stats_file_path(folder, model);
+	FILE* file = fopen(path, "rb");
+	free(path);
+	free(folder);
+	if (!file) return false;
+
+	stats_file* contents = malloc(sizeof(stats_file));
+	const bool read = stats_file_read(file, contents);
+	fclose(file);
+
+	const bool any = read && stats_file_summarize(contents, summaries);
+	free(contents);
+	return any;
+}
+
+size_t chatgpt_cli_stats_for_each(const chatgpt_cli_stats_model_callback callback, void* user_data) {
+	char* folder = stats_get_folder();
+	DIR* dir = opendir(folder);
+	if (!dir) {
+		free(folder);
+		return 0;
+	}
+
+	size_t model_count = 0;
+	stats_file* contents = malloc(sizeof(stats_file));
+
+	struct dirent* dir_entry;
+	while ((dir_entry = readdir(dir))) {
+		const size_t name_length = strlen(dir_entry->d_name);
+		const size_t extension_length = strlen(STATS_FILE_EXTENSION);
+		if (name_length <= extension_length ||
+			strcmp(dir_entry->d_name + name_length - extension_length, STATS_FILE_EXTENSION) != 0) {
+			continue;
+		}
+
+		const size_t path_length = strlen(folder) + name_length + 2;
+		char* path = malloc(path_length);
+		snprintf(path, path_length, "%s%c%s", folder, PATH_SEPARATOR, dir_entry->d_name);
+		FILE* file = fopen(path, "rb");
+		free(path);
+		if (!file) continue;
+
+		const bool read = stats_file_read(file, contents);
+		fclose(file);
+		if (!read) continue;
+
+		chatgpt_cli_stats_summary summaries[CHATGPT_CLI_STATS_METRIC_COUNT];
+		if (!stats_file_summarize(contents, summaries)) continue;
+
+		const chatgpt_cli_stats_hedges hedges = {
+			.armed = atomic_load(&contents->hedges.armed),
+			.sent = atomic_load(&contents->hedges.sent),
+			.won = atomic_load(&contents->hedges.won),
+		};
+		contents->model[STATS_MODEL_NAME_MAX_LENGTH] = '\0';
+		callback(contents->model, summaries, &hedges, user_data);
+		model_count++;
+	}
+
+	free(contents);
+	closedir(dir);
+	free(folder);
+	return model_count;
+}
@@ -0,0 +1,68 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef STATS_H
+#define STATS_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// folder (in the app folder) which holds one histogram file per model
+#define CHATGPT_CLI_STATS_FOLDER_NAME "stats"
+
+typedef enum {
+	CHATGPT_CLI_STATS_TTFB, // microseconds until the first byte of the response
+	CHATGPT_CLI_STATS_FIRST_DELTA, // microseconds until the first output text
+	CHATGPT_CLI_STATS_TOTAL, // microseconds until the response completed
+	CHATGPT_CLI_STATS_TOKENS_PER_SECOND, // output tokens per 1000 seconds, after the first delta
+	CHATGPT_CLI_STATS_METRIC_COUNT,
+} chatgpt_cli_stats_metric;
+
+// what became of a request's hedge, see openai_request.hedge_after_us
+typedef enum {
+	CHATGPT_CLI_STATS_HEDGE_OFF, // the request wasn't hedged
+	CHATGPT_CLI_STATS_HEDGE_NOT_SENT, // the first delta came before the deadline
+	CHATGPT_CLI_STATS_HEDGE_LOST, // a hedge was sent, the original request was first anyway
+	CHATGPT_CLI_STATS_HEDGE_WON, // a hedge was sent and was first
+} chatgpt_cli_stats_hedge;
+
+// one completed request, metrics which weren't measured are < 0
+typedef struct {
+	int64_t values[CHATGPT_CLI_STATS_METRIC_COUNT];
+	chatgpt_cli_stats_hedge hedge;
+} chatgpt_cli_stats_sample;
+
+// adds a sample to the model's histograms. safe to call from any number of processes at once, false if the
+// histograms couldn't be written
+bool chatgpt_cli_stats_record(const char* model, const chatgpt_cli_stats_sample* sample);
+
+typedef struct {
+	uint64_t count;
+	int64_t min;
+	int64_t max;
+	double mean;
+	int64_t p50;
+	int64_t p90;
+	int64_t p95;
+	int64_t p99;
+	int64_t p999;
+} chatgpt_cli_stats_summary;
+
+typedef struct {
+	uint64_t armed; // requests sent with a hedge deadline
+	uint64_t sent; // of those, how many sent a hedge
+	uint64_t won; // of those, how many got their response from the hedge
+} chatgpt_cli_stats_hedges;
+
+// summaries are indexed by chatgpt_cli_stats_metric, borrowed for the duration of the callback
+typedef void (*chatgpt_cli_stats_model_callback)(const char* model, const chatgpt_cli_stats_summary* summaries,
+                                                 const chatgpt_cli_stats_hedges* hedges, void* user_data);
+
+// calls back once per model with recorded samples, in no particular order. returns how many models there were
+size_t chatgpt_cli_stats_for_each(chatgpt_cli_stats_model_callback callback, void* user_data);
+
+// summaries of one model, indexed by chatgpt_cli_stats_metric. false if nothing was recorded for it
+bool chatgpt_cli_stats_get(const char* model, chatgpt_cli_stats_summary* summaries);
+
+#endif //STATS_H
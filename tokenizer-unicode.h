@@ -0,0 +1,360 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef TOKENIZER_UNICODE_H
+#define TOKENIZER_UNICODE_H
+#include <stdint.h>
+
+// generated from the Unicode 16.0 character database (General_Category and White_Space), the version of the regex
+// crate tiktoken splits with: text in scripts added since would be split differently. included by tokenizer.c only
+
+typedef enum {
+	TOKENIZER_CHAR_OTHER, // punctuation, symbols, controls and anything unassigned
+	TOKENIZER_CHAR_UPPER, // Lu and Lt
+	TOKENIZER_CHAR_LOWER, // Ll
+	TOKENIZER_CHAR_LETTER, // Lm and Lo, letters without case
+	TOKENIZER_CHAR_MARK, // M, not a letter to \p{L} but part of words in o200k
+	TOKENIZER_CHAR_NUMBER, // N
+	TOKENIZER_CHAR_SPACE, // White_Space except \r and \n
+	TOKENIZER_CHAR_NEWLINE, // \r and \n
+} tokenizer_char_class;
+
+static const uint8_t tokenizer_ascii_classes[128] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 7, 6, 6, 7, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 0, 0, 0, 0, 0, 0,
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+	0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,
+};
+
+// every code point from a range's start up to the next range's start is in its class: start << 3 | class
+#define TOKENIZER_UNICODE_RANGE_COUNT 3194
+
+static const uint32_t tokenizer_unicode_ranges[TOKENIZER_UNICODE_RANGE_COUNT] = {
+	0x0000000, 0x000004e, 0x0000057, 0x000005e, 0x000006f, 0x0000070, 0x0000106, 0x0000108, 0x0000185, 0x00001d0,
+	0x0000209, 0x00002d8, 0x000030a, 0x00003d8, 0x000042e, 0x0000430, 0x0000506, 0x0000508, 0x0000553, 0x0000558,
+	0x0000595, 0x00005a0, 0x00005aa, 0x00005b0, 0x00005cd, 0x00005d3, 0x00005d8, 0x00005e5, 0x00005f8, 0x0000601,
+	0x00006b8, 0x00006c1, 0x00006fa, 0x00007b8, 0x00007c2, 0x0000801, 0x000080a, 0x0000811, 0x000081a, 0x0000821,
+	0x000082a, 0x0000831, 0x000083a, 0x0000841, 0x000084a, 0x0000851, 0x000085a, 0x0000861, 0x000086a, 0x0000871,
+	0x000087a, 0x0000881, 0x000088a, 0x0000891, 0x000089a, 0x00008a1, 0x00008aa, 0x00008b1, 0x00008ba, 0x00008c1,
+	0x00008ca, 0x00008d1, 0x00008da, 0x00008e1, 0x00008ea, 0x00008f1, 0x00008fa, 0x0000901, 0x000090a, 0x0000911,
+	0x000091a, 0x0000921, 0x000092a, 0x0000931, 0x000093a, 0x0000941, 0x000094a, 0x0000951, 0x000095a, 0x0000961,
+	0x000096a, 0x0000971, 0x000097a, 0x0000981, 0x000098a, 0x0000991, 0x000099a, 0x00009a1, 0x00009aa, 0x00009b1,
+	0x00009ba, 0x00009c9, 0x00009d2, 0x00009d9, 0x00009e2, 0x00009e9, 0x00009f2, 0x00009f9, 0x0000a02, 0x0000a09,
+	0x0000a12, 0x0000a19, 0x0000a22, 0x0000a29, 0x0000a32, 0x0000a39, 0x0000a42, 0x0000a51, 0x0000a5a, 0x0000a61,
+	0x0000a6a, 0x0000a71, 0x0000a7a, 0x0000a81, 0x0000a8a, 0x0000a91, 0x0000a9a, 0x0000aa1, 0x0000aaa, 0x0000ab1,
+	0x0000aba, 0x0000ac1, 0x0000aca, 0x0000ad1, 0x0000ada, 0x0000ae1, 0x0000aea, 0x0000af1, 0x0000afa, 0x0000b01,
+	0x0000b0a, 0x0000b11, 0x0000b1a, 0x0000b21, 0x0000b2a, 0x0000b31, 0x0000b3a, 0x0000b41, 0x0000b4a, 0x0000b51,
+	0x0000b5a, 0x0000b61, 0x0000b6a, 0x0000b71, 0x0000b7a, 0x0000b81, 0x0000b8a, 0x0000b91, 0x0000b9a, 0x0000ba1,
+	0x0000baa, 0x0000bb1, 0x0000bba, 0x0000bc1, 0x0000bd2, 0x0000bd9, 0x0000be2, 0x0000be9, 0x0000bf2, 0x0000c09,
+	0x0000c1a, 0x0000c21, 0x0000c2a, 0x0000c31, 0x0000c42, 0x0000c49, 0x0000c62, 0x0000c71, 0x0000c92, 0x0000c99,
+	0x0000caa, 0x0000cb1, 0x0000cca, 0x0000ce1, 0x0000cf2, 0x0000cf9, 0x0000d0a, 0x0000d11, 0x0000d1a, 0x0000d21,
+	0x0000d2a, 0x0000d31, 0x0000d42, 0x0000d49, 0x0000d52, 0x0000d61, 0x0000d6a, 0x0000d71, 0x0000d82, 0x0000d89,
+	0x0000da2, 0x0000da9, 0x0000db2, 0x0000db9, 0x0000dca, 0x0000ddb, 0x0000de1, 0x0000dea, 0x0000e03, 0x0000e21,
+	0x0000e32, 0x0000e39, 0x0000e4a, 0x0000e51, 0x0000e62, 0x0000e69, 0x0000e72, 0x0000e79, 0x0000e82, 0x0000e89,
+	0x0000e92, 0x0000e99, 0x0000ea2, 0x0000ea9, 0x0000eb2, 0x0000eb9, 0x0000ec2, 0x0000ec9, 0x0000ed2, 0x0000ed9,
+	0x0000ee2, 0x0000ef1, 0x0000efa, 0x0000f01, 0x0000f0a, 0x0000f11, 0x0000f1a, 0x0000f21, 0x0000f2a, 0x0000f31,
+	0x0000f3a, 0x0000f41, 0x0000f4a, 0x0000f51, 0x0000f5a, 0x0000f61, 0x0000f6a, 0x0000f71, 0x0000f7a, 0x0000f89,
+	0x0000f9a, 0x0000fa1, 0x0000faa, 0x0000fb1, 0x0000fca, 0x0000fd1, 0x0000fda, 0x0000fe1, 0x0000fea, 0x0000ff1,
+	0x0000ffa, 0x0001001, 0x000100a, 0x0001011, 0x000101a, 0x0001021, 0x000102a, 0x0001031, 0x000103a, 0x0001041,
+	0x000104a, 0x0001051, 0x000105a, 0x0001061, 0x000106a, 0x0001071, 0x000107a, 0x0001081, 0x000108a, 0x0001091,
+	0x000109a, 0x00010a1, 0x00010aa, 0x00010b1, 0x00010ba, 0x00010c1, 0x00010ca, 0x00010d1, 0x00010da, 0x00010e1,
+	0x00010ea, 0x00010f1, 0x00010fa, 0x0001101, 0x000110a, 0x0001111, 0x000111a, 0x0001121, 0x000112a, 0x0001131,
+	0x000113a, 0x0001141, 0x000114a, 0x0001151, 0x000115a, 0x0001161, 0x000116a, 0x0001171, 0x000117a, 0x0001181,
+	0x000118a, 0x0001191, 0x000119a, 0x00011d1, 0x00011e2, 0x00011e9, 0x00011fa, 0x0001209, 0x0001212, 0x0001219,
+	0x000123a, 0x0001241, 0x000124a, 0x0001251, 0x000125a, 0x0001261, 0x000126a, 0x0001271, 0x000127a, 0x00014a3,
+	0x00014aa, 0x0001583, 0x0001610, 0x0001633, 0x0001690, 0x0001703, 0x0001728, 0x0001763, 0x0001768, 0x0001773,
+	0x0001778, 0x0001804, 0x0001b81, 0x0001b8a, 0x0001b91, 0x0001b9a, 0x0001ba3, 0x0001ba8, 0x0001bb1, 0x0001bba,
+	0x0001bc0, 0x0001bd3, 0x0001bda, 0x0001bf0, 0x0001bf9, 0x0001c00, 0x0001c31, 0x0001c38, 0x0001c41, 0x0001c58,
+	0x0001c61, 0x0001c68, 0x0001c71, 0x0001c82, 0x0001c89, 0x0001d10, 0x0001d19, 0x0001d62, 0x0001e79, 0x0001e82,
+	0x0001e91, 0x0001eaa, 0x0001ec1, 0x0001eca, 0x0001ed1, 0x0001eda, 0x0001ee1, 0x0001eea, 0x0001ef1, 0x0001efa,
+	0x0001f01, 0x0001f0a, 0x0001f11, 0x0001f1a, 0x0001f21, 0x0001f2a, 0x0001f31, 0x0001f3a, 0x0001f41, 0x0001f4a,
+	0x0001f51, 0x0001f5a, 0x0001f61, 0x0001f6a, 0x0001f71, 0x0001f7a, 0x0001fa1, 0x0001faa, 0x0001fb0, 0x0001fb9,
+	0x0001fc2, 0x0001fc9, 0x0001fda, 0x0001fe9, 0x0002182, 0x0002301, 0x000230a, 0x0002311, 0x000231a, 0x0002321,
+	0x000232a, 0x0002331, 0x000233a, 0x0002341, 0x000234a, 0x0002351, 0x000235a, 0x0002361, 0x000236a, 0x0002371,
+	0x000237a, 0x0002381, 0x000238a, 0x0002391, 0x000239a, 0x00023a1, 0x00023aa, 0x00023b1, 0x00023ba, 0x00023c1,
+	0x00023ca, 0x00023d1, 0x00023da, 0x00023e1, 0x00023ea, 0x00023f1, 0x00023fa, 0x0002401, 0x000240a, 0x0002410,
+	0x000241c, 0x0002451, 0x000245a, 0x0002461, 0x000246a, 0x0002471, 0x000247a, 0x0002481, 0x000248a, 0x0002491,
+	0x000249a, 0x00024a1, 0x00024aa, 0x00024b1, 0x00024ba, 0x00024c1, 0x00024ca, 0x00024d1, 0x00024da, 0x00024e1,
+	0x00024ea, 0x00024f1, 0x00024fa, 0x0002501, 0x000250a, 0x0002511, 0x000251a, 0x0002521, 0x000252a, 0x0002531,
+	0x000253a, 0x0002541, 0x000254a, 0x0002551, 0x000255a, 0x0002561, 0x000256a, 0x0002571, 0x000257a, 0x0002581,
+	0x000258a, 0x0002591, 0x000259a, 0x00025a1, 0x00025aa, 0x00025b1, 0x00025ba, 0x00025c1, 0x00025ca, 0x00025d1,
+	0x00025da, 0x00025e1, 0x00025ea, 0x00025f1, 0x00025fa, 0x0002601, 0x0002612, 0x0002619, 0x0002622, 0x0002629,
+	0x0002632, 0x0002639, 0x0002642, 0x0002649, 0x0002652, 0x0002659, 0x0002662, 0x0002669, 0x0002672, 0x0002681,
+	0x000268a, 0x0002691, 0x000269a, 0x00026a1, 0x00026aa, 0x00026b1, 0x00026ba, 0x00026c1, 0x00026ca, 0x00026d1,
+	0x00026da, 0x00026e1, 0x00026ea, 0x00026f1, 0x00026fa, 0x0002701, 0x000270a, 0x0002711, 0x000271a, 0x0002721,
+	0x000272a, 0x0002731, 0x000273a, 0x0002741, 0x000274a, 0x0002751, 0x000275a, 0x0002761, 0x000276a, 0x0002771,
+	0x000277a, 0x0002781, 0x000278a, 0x0002791, 0x000279a, 0x00027a1, 0x00027aa, 0x00027b1, 0x00027ba, 0x00027c1,
+	0x00027ca, 0x00027d1, 0x00027da, 0x00027e1, 0x00027ea, 0x00027f1, 0x00027fa, 0x0002801, 0x000280a, 0x0002811,
+	0x000281a, 0x0002821, 0x000282a, 0x0002831, 0x000283a, 0x0002841, 0x000284a, 0x0002851, 0x000285a, 0x0002861,
+	0x000286a, 0x0002871, 0x000287a, 0x0002881, 0x000288a, 0x0002891, 0x000289a, 0x00028a1, 0x00028aa, 0x00028b1,
+	0x00028ba, 0x00028c1, 0x00028ca, 0x00028d1, 0x00028da, 0x00028e1, 0x00028ea, 0x00028f1, 0x00028fa, 0x0002901,
+	0x000290a, 0x0002911, 0x000291a, 0x0002921, 0x000292a, 0x0002931, 0x000293a, 0x0002941, 0x000294a, 0x0002951,
+	0x000295a, 0x0002961, 0x000296a, 0x0002971, 0x000297a, 0x0002980, 0x0002989, 0x0002ab8, 0x0002acb, 0x0002ad0,
+	0x0002b02, 0x0002c48, 0x0002c8c, 0x0002df0, 0x0002dfc, 0x0002e00, 0x0002e0c, 0x0002e18, 0x0002e24, 0x0002e30,
+	0x0002e3c, 0x0002e40, 0x0002e83, 0x0002f58, 0x0002f7b, 0x0002f98, 0x0003084, 0x00030d8, 0x0003103, 0x000325c,
+	0x0003305, 0x0003350, 0x0003373, 0x0003384, 0x000338b, 0x00036a0, 0x00036ab, 0x00036b4, 0x00036e8, 0x00036fc,
+	0x000372b, 0x000373c, 0x0003748, 0x0003754, 0x0003773, 0x0003785, 0x00037d3, 0x00037e8, 0x00037fb, 0x0003800,
+	0x0003883, 0x000388c, 0x0003893, 0x0003984, 0x0003a58, 0x0003a6b, 0x0003d34, 0x0003d8b, 0x0003d90, 0x0003e05,
+	0x0003e53, 0x0003f5c, 0x0003fa3, 0x0003fb0, 0x0003fd3, 0x0003fd8, 0x0003fec, 0x0003ff0, 0x0004003, 0x00040b4,
+	0x00040d3, 0x00040dc, 0x0004123, 0x000412c, 0x0004143, 0x000414c, 0x0004170, 0x0004203, 0x00042cc, 0x00042e0,
+	0x0004303, 0x0004358, 0x0004383, 0x0004440, 0x000444b, 0x0004478, 0x00044bc, 0x0004503, 0x0004654, 0x0004710,
+	0x000471c, 0x0004823, 0x00049d4, 0x00049eb, 0x00049f4, 0x0004a83, 0x0004a8c, 0x0004ac3, 0x0004b14, 0x0004b20,
+	0x0004b35, 0x0004b80, 0x0004b8b, 0x0004c0c, 0x0004c20, 0x0004c2b, 0x0004c68, 0x0004c7b, 0x0004c88, 0x0004c9b,
+	0x0004d48, 0x0004d53, 0x0004d88, 0x0004d93, 0x0004d98, 0x0004db3, 0x0004dd0, 0x0004de4, 0x0004deb, 0x0004df4,
+	0x0004e28, 0x0004e3c, 0x0004e48, 0x0004e5c, 0x0004e73, 0x0004e78, 0x0004ebc, 0x0004ec0, 0x0004ee3, 0x0004ef0,
+	0x0004efb, 0x0004f14, 0x0004f20, 0x0004f35, 0x0004f83, 0x0004f90, 0x0004fa5, 0x0004fd0, 0x0004fe3, 0x0004fe8,
+	0x0004ff4, 0x0004ff8, 0x000500c, 0x0005020, 0x000502b, 0x0005058, 0x000507b, 0x0005088, 0x000509b, 0x0005148,
+	0x0005153, 0x0005188, 0x0005193, 0x00051a0, 0x00051ab, 0x00051b8, 0x00051c3, 0x00051d0, 0x00051e4, 0x00051e8,
+	0x00051f4, 0x0005218, 0x000523c, 0x0005248, 0x000525c, 0x0005270, 0x000528c, 0x0005290, 0x00052cb, 0x00052e8,
+	0x00052f3, 0x00052f8, 0x0005335, 0x0005384, 0x0005393, 0x00053ac, 0x00053b0, 0x000540c, 0x0005420, 0x000542b,
+	0x0005470, 0x000547b, 0x0005490, 0x000549b, 0x0005548, 0x0005553, 0x0005588, 0x0005593, 0x00055a0, 0x00055ab,
+	0x00055d0, 0x00055e4, 0x00055eb, 0x00055f4, 0x0005630, 0x000563c, 0x0005650, 0x000565c, 0x0005670, 0x0005683,
+	0x0005688, 0x0005703, 0x0005714, 0x0005720, 0x0005735, 0x0005780, 0x00057cb, 0x00057d4, 0x0005800, 0x000580c,
+	0x0005820, 0x000582b, 0x0005868, 0x000587b, 0x0005888, 0x000589b, 0x0005948, 0x0005953, 0x0005988, 0x0005993,
+	0x00059a0, 0x00059ab, 0x00059d0, 0x00059e4, 0x00059eb, 0x00059f4, 0x0005a28, 0x0005a3c, 0x0005a48, 0x0005a5c,
+	0x0005a70, 0x0005aac, 0x0005ac0, 0x0005ae3, 0x0005af0, 0x0005afb, 0x0005b14, 0x0005b20, 0x0005b35, 0x0005b80,
+	0x0005b8b, 0x0005b95, 0x0005bc0, 0x0005c14, 0x0005c1b, 0x0005c20, 0x0005c2b, 0x0005c58, 0x0005c73, 0x0005c88,
+	0x0005c93, 0x0005cb0, 0x0005ccb, 0x0005cd8, 0x0005ce3, 0x0005ce8, 0x0005cf3, 0x0005d00, 0x0005d1b, 0x0005d28,
+	0x0005d43, 0x0005d58, 0x0005d73, 0x0005dd0, 0x0005df4, 0x0005e18, 0x0005e34, 0x0005e48, 0x0005e54, 0x0005e70,
+	0x0005e83, 0x0005e88, 0x0005ebc, 0x0005ec0, 0x0005f35, 0x0005f98, 0x0006004, 0x000602b, 0x0006068, 0x0006073,
+	0x0006088, 0x0006093, 0x0006148, 0x0006153, 0x00061d0, 0x00061e4, 0x00061eb, 0x00061f4, 0x0006228, 0x0006234,
+	0x0006248, 0x0006254, 0x0006270, 0x00062ac, 0x00062b8, 0x00062c3, 0x00062d8, 0x00062eb, 0x00062f0, 0x0006303,
+	0x0006314, 0x0006320, 0x0006335, 0x0006380, 0x00063c5, 0x00063f8, 0x0006403, 0x000640c, 0x0006420, 0x000642b,
+	0x0006468, 0x0006473, 0x0006488, 0x0006493, 0x0006548, 0x0006553, 0x00065a0, 0x00065ab, 0x00065d0, 0x00065e4,
+	0x00065eb, 0x00065f4, 0x0006628, 0x0006634, 0x0006648, 0x0006654, 0x0006670, 0x00066ac, 0x00066b8, 0x00066eb,
+	0x00066f8, 0x0006703, 0x0006714, 0x0006720, 0x0006735, 0x0006780, 0x000678b, 0x000679c, 0x00067a0, 0x0006804,
+	0x0006823, 0x0006868, 0x0006873, 0x0006888, 0x0006893, 0x00069dc, 0x00069eb, 0x00069f4, 0x0006a28, 0x0006a34,
+	0x0006a48, 0x0006a54, 0x0006a73, 0x0006a78, 0x0006aa3, 0x0006abc, 0x0006ac5, 0x0006afb, 0x0006b14, 0x0006b20,
+	0x0006b35, 0x0006bc8, 0x0006bd3, 0x0006c00, 0x0006c0c, 0x0006c20, 0x0006c2b, 0x0006cb8, 0x0006cd3, 0x0006d90,
+	0x0006d9b, 0x0006de0, 0x0006deb, 0x0006df0, 0x0006e03, 0x0006e38, 0x0006e54, 0x0006e58, 0x0006e7c, 0x0006ea8,
+	0x0006eb4, 0x0006eb8, 0x0006ec4, 0x0006f00, 0x0006f35, 0x0006f80, 0x0006f94, 0x0006fa0, 0x000700b, 0x000718c,
+	0x0007193, 0x00071a4, 0x00071d8, 0x0007203, 0x000723c, 0x0007278, 0x0007285, 0x00072d0, 0x000740b, 0x0007418,
+	0x0007423, 0x0007428, 0x0007433, 0x0007458, 0x0007463, 0x0007520, 0x000752b, 0x0007530, 0x000753b, 0x000758c,
+	0x0007593, 0x00075a4, 0x00075eb, 0x00075f0, 0x0007603, 0x0007628, 0x0007633, 0x0007638, 0x0007644, 0x0007678,
+	0x0007685, 0x00076d0, 0x00076e3, 0x0007700, 0x0007803, 0x0007808, 0x00078c4, 0x00078d0, 0x0007905, 0x00079a0,
+	0x00079ac, 0x00079b0, 0x00079bc, 0x00079c0, 0x00079cc, 0x00079d0, 0x00079f4, 0x0007a03, 0x0007a40, 0x0007a4b,
+	0x0007b68, 0x0007b8c, 0x0007c28, 0x0007c34, 0x0007c43, 0x0007c6c, 0x0007cc0, 0x0007ccc, 0x0007de8, 0x0007e34,
+	0x0007e38, 0x0008003, 0x000815c, 0x00081fb, 0x0008205, 0x0008250, 0x0008283, 0x00082b4, 0x00082d3, 0x00082f4,
+	0x000830b, 0x0008314, 0x000832b, 0x000833c, 0x0008373, 0x000838c, 0x00083ab, 0x0008414, 0x0008473, 0x000847c,
+	0x0008485, 0x00084d4, 0x00084f0, 0x0008501, 0x0008630, 0x0008639, 0x0008640, 0x0008669, 0x0008670, 0x0008682,
+	0x00087d8, 0x00087e3, 0x00087ea, 0x0008803, 0x0009248, 0x0009253, 0x0009270, 0x0009283, 0x00092b8, 0x00092c3,
+	0x00092c8, 0x00092d3, 0x00092f0, 0x0009303, 0x0009448, 0x0009453, 0x0009470, 0x0009483, 0x0009588, 0x0009593,
+	0x00095b0, 0x00095c3, 0x00095f8, 0x0009603, 0x0009608, 0x0009613, 0x0009630, 0x0009643, 0x00096b8, 0x00096c3,
+	0x0009888, 0x0009893, 0x00098b0, 0x00098c3, 0x0009ad8, 0x0009aec, 0x0009b00, 0x0009b4d, 0x0009be8, 0x0009c03,
+	0x0009c80, 0x0009d01, 0x0009fb0, 0x0009fc2, 0x0009ff0, 0x000a00b, 0x000b368, 0x000b37b, 0x000b406, 0x000b40b,
+	0x000b4d8, 0x000b503, 0x000b758, 0x000b775, 0x000b78b, 0x000b7c8, 0x000b803, 0x000b894, 0x000b8b0, 0x000b8fb,
+	0x000b994, 0x000b9a8, 0x000ba03, 0x000ba94, 0x000baa0, 0x000bb03, 0x000bb68, 0x000bb73, 0x000bb88, 0x000bb94,
+	0x000bba0, 0x000bc03, 0x000bda4, 0x000bea0, 0x000bebb, 0x000bec0, 0x000bee3, 0x000beec, 0x000bef0, 0x000bf05,
+	0x000bf50, 0x000bf85, 0x000bfd0, 0x000c05c, 0x000c070, 0x000c07c, 0x000c085, 0x000c0d0, 0x000c103, 0x000c3c8,
+	0x000c403, 0x000c42c, 0x000c43b, 0x000c54c, 0x000c553, 0x000c558, 0x000c583, 0x000c7b0, 0x000c803, 0x000c8f8,
+	0x000c904, 0x000c960, 0x000c984, 0x000c9e0, 0x000ca35, 0x000ca83, 0x000cb70, 0x000cb83, 0x000cba8, 0x000cc03,
+	0x000cd60, 0x000cd83, 0x000ce50, 0x000ce85, 0x000ced8, 0x000d003, 0x000d0bc, 0x000d0e0, 0x000d103, 0x000d2ac,
+	0x000d2f8, 0x000d304, 0x000d3e8, 0x000d3fc, 0x000d405, 0x000d450, 0x000d485, 0x000d4d0, 0x000d53b, 0x000d540,
+	0x000d584, 0x000d678, 0x000d804, 0x000d82b, 0x000d9a4, 0x000da2b, 0x000da68, 0x000da85, 0x000dad0, 0x000db5c,
+	0x000dba0, 0x000dc04, 0x000dc1b, 0x000dd0c, 0x000dd73, 0x000dd85, 0x000ddd3, 0x000df34, 0x000dfa0, 0x000e003,
+	0x000e124, 0x000e1c0, 0x000e205, 0x000e250, 0x000e26b, 0x000e285, 0x000e2d3, 0x000e3f0, 0x000e402, 0x000e449,
+	0x000e452, 0x000e458, 0x000e481, 0x000e5d8, 0x000e5e9, 0x000e600, 0x000e684, 0x000e698, 0x000e6a4, 0x000e74b,
+	0x000e76c, 0x000e773, 0x000e7a4, 0x000e7ab, 0x000e7bc, 0x000e7d3, 0x000e7d8, 0x000e802, 0x000e963, 0x000eb5a,
+	0x000ebc3, 0x000ebca, 0x000ecdb, 0x000ee04, 0x000f001, 0x000f00a, 0x000f011, 0x000f01a, 0x000f021, 0x000f02a,
+	0x000f031, 0x000f03a, 0x000f041, 0x000f04a, 0x000f051, 0x000f05a, 0x000f061, 0x000f06a, 0x000f071, 0x000f07a,
+	0x000f081, 0x000f08a, 0x000f091, 0x000f09a, 0x000f0a1, 0x000f0aa, 0x000f0b1, 0x000f0ba, 0x000f0c1, 0x000f0ca,
+	0x000f0d1, 0x000f0da, 0x000f0e1, 0x000f0ea, 0x000f0f1, 0x000f0fa, 0x000f101, 0x000f10a, 0x000f111, 0x000f11a,
+	0x000f121, 0x000f12a, 0x000f131, 0x000f13a, 0x000f141, 0x000f14a, 0x000f151, 0x000f15a, 0x000f161, 0x000f16a,
+	0x000f171, 0x000f17a, 0x000f181, 0x000f18a, 0x000f191, 0x000f19a, 0x000f1a1, 0x000f1aa, 0x000f1b1, 0x000f1ba,
+	0x000f1c1, 0x000f1ca, 0x000f1d1, 0x000f1da, 0x000f1e1, 0x000f1ea, 0x000f1f1, 0x000f1fa, 0x000f201, 0x000f20a,
+	0x000f211, 0x000f21a, 0x000f221, 0x000f22a, 0x000f231, 0x000f23a, 0x000f241, 0x000f24a, 0x000f251, 0x000f25a,
+	0x000f261, 0x000f26a, 0x000f271, 0x000f27a, 0x000f281, 0x000f28a, 0x000f291, 0x000f29a, 0x000f2a1, 0x000f2aa,
+	0x000f2b1, 0x000f2ba, 0x000f2c1, 0x000f2ca, 0x000f2d1, 0x000f2da, 0x000f2e1, 0x000f2ea, 0x000f2f1, 0x000f2fa,
+	0x000f301, 0x000f30a, 0x000f311, 0x000f31a, 0x000f321, 0x000f32a, 0x000f331, 0x000f33a, 0x000f341, 0x000f34a,
+	0x000f351, 0x000f35a, 0x000f361, 0x000f36a, 0x000f371, 0x000f37a, 0x000f381, 0x000f38a, 0x000f391, 0x000f39a,
+	0x000f3a1, 0x000f3aa, 0x000f3b1, 0x000f3ba, 0x000f3c1, 0x000f3ca, 0x000f3d1, 0x000f3da, 0x000f3e1, 0x000f3ea,
+	0x000f3f1, 0x000f3fa, 0x000f401, 0x000f40a, 0x000f411, 0x000f41a, 0x000f421, 0x000f42a, 0x000f431, 0x000f43a,
+	0x000f441, 0x000f44a, 0x000f451, 0x000f45a, 0x000f461, 0x000f46a, 0x000f471, 0x000f47a, 0x000f481, 0x000f48a,
+	0x000f491, 0x000f49a, 0x000f4a1, 0x000f4aa, 0x000f4f1, 0x000f4fa, 0x000f501, 0x000f50a, 0x000f511, 0x000f51a,
+	0x000f521, 0x000f52a, 0x000f531, 0x000f53a, 0x000f541, 0x000f54a, 0x000f551, 0x000f55a, 0x000f561, 0x000f56a,
+	0x000f571, 0x000f57a, 0x000f581, 0x000f58a, 0x000f591, 0x000f59a, 0x000f5a1, 0x000f5aa, 0x000f5b1, 0x000f5ba,
+	0x000f5c1, 0x000f5ca, 0x000f5d1, 0x000f5da, 0x000f5e1, 0x000f5ea, 0x000f5f1, 0x000f5fa, 0x000f601, 0x000f60a,
+	0x000f611, 0x000f61a, 0x000f621, 0x000f62a, 0x000f631, 0x000f63a, 0x000f641, 0x000f64a, 0x000f651, 0x000f65a,
+	0x000f661, 0x000f66a, 0x000f671, 0x000f67a, 0x000f681, 0x000f68a, 0x000f691, 0x000f69a, 0x000f6a1, 0x000f6aa,
+	0x000f6b1, 0x000f6ba, 0x000f6c1, 0x000f6ca, 0x000f6d1, 0x000f6da, 0x000f6e1, 0x000f6ea, 0x000f6f1, 0x000f6fa,
+	0x000f701, 0x000f70a, 0x000f711, 0x000f71a, 0x000f721, 0x000f72a, 0x000f731, 0x000f73a, 0x000f741, 0x000f74a,
+	0x000f751, 0x000f75a, 0x000f761, 0x000f76a, 0x000f771, 0x000f77a, 0x000f781, 0x000f78a, 0x000f791, 0x000f79a,
+	0x000f7a1, 0x000f7aa, 0x000f7b1, 0x000f7ba, 0x000f7c1, 0x000f7ca, 0x000f7d1, 0x000f7da, 0x000f7e1, 0x000f7ea,
+	0x000f7f1, 0x000f7fa, 0x000f841, 0x000f882, 0x000f8b0, 0x000f8c1, 0x000f8f0, 0x000f902, 0x000f941, 0x000f982,
+	0x000f9c1, 0x000fa02, 0x000fa30, 0x000fa41, 0x000fa70, 0x000fa82, 0x000fac0, 0x000fac9, 0x000fad0, 0x000fad9,
+	0x000fae0, 0x000fae9, 0x000faf0, 0x000faf9, 0x000fb02, 0x000fb41, 0x000fb82, 0x000fbf0, 0x000fc02, 0x000fc41,
+	0x000fc82, 0x000fcc1, 0x000fd02, 0x000fd41, 0x000fd82, 0x000fda8, 0x000fdb2, 0x000fdc1, 0x000fde8, 0x000fdf2,
+	0x000fdf8, 0x000fe12, 0x000fe28, 0x000fe32, 0x000fe41, 0x000fe68, 0x000fe82, 0x000fea0, 0x000feb2, 0x000fec1,
+	0x000fee0, 0x000ff02, 0x000ff41, 0x000ff68, 0x000ff92, 0x000ffa8, 0x000ffb2, 0x000ffc1, 0x000ffe8, 0x0010006,
+	0x0010058, 0x0010146, 0x0010150, 0x001017e, 0x0010180, 0x00102fe, 0x0010300, 0x0010385, 0x001038b, 0x0010390,
+	0x00103a5, 0x00103d0, 0x00103fb, 0x0010405, 0x0010450, 0x0010483, 0x00104e8, 0x0010684, 0x0010788, 0x0010811,
+	0x0010818, 0x0010839, 0x0010840, 0x0010852, 0x0010859, 0x0010872, 0x0010881, 0x001089a, 0x00108a0, 0x00108a9,
+	0x00108b0, 0x00108c9, 0x00108f0, 0x0010921, 0x0010928, 0x0010931, 0x0010938, 0x0010941, 0x0010948, 0x0010951,
+	0x0010970, 0x001097a, 0x0010981, 0x00109a2, 0x00109ab, 0x00109ca, 0x00109d0, 0x00109e2, 0x00109f1, 0x0010a00,
+	0x0010a29, 0x0010a32, 0x0010a50, 0x0010a72, 0x0010a78, 0x0010a85, 0x0010c19, 0x0010c22, 0x0010c2d, 0x0010c50,
+	0x0012305, 0x00124e0, 0x0012755, 0x0012800, 0x0013bb5, 0x0013ca0, 0x0016001, 0x0016182, 0x0016301, 0x001630a,
+	0x0016311, 0x001632a, 0x0016339, 0x0016342, 0x0016349, 0x0016352, 0x0016359, 0x0016362, 0x0016369, 0x001638a,
+	0x0016391, 0x001639a, 0x00163a9, 0x00163b2, 0x00163e3, 0x00163f1, 0x001640a, 0x0016411, 0x001641a, 0x0016421,
+	0x001642a, 0x0016431, 0x001643a, 0x0016441, 0x001644a, 0x0016451, 0x001645a, 0x0016461, 0x001646a, 0x0016471,
+	0x001647a, 0x0016481, 0x001648a, 0x0016491, 0x001649a, 0x00164a1, 0x00164aa, 0x00164b1, 0x00164ba, 0x00164c1,
+	0x00164ca, 0x00164d1, 0x00164da, 0x00164e1, 0x00164ea, 0x00164f1, 0x00164fa, 0x0016501, 0x001650a, 0x0016511,
+	0x001651a, 0x0016521, 0x001652a, 0x0016531, 0x001653a, 0x0016541, 0x001654a, 0x0016551, 0x001655a, 0x0016561,
+	0x001656a, 0x0016571, 0x001657a, 0x0016581, 0x001658a, 0x0016591, 0x001659a, 0x00165a1, 0x00165aa, 0x00165b1,
+	0x00165ba, 0x00165c1, 0x00165ca, 0x00165d1, 0x00165da, 0x00165e1, 0x00165ea, 0x00165f1, 0x00165fa, 0x0016601,
+	0x001660a, 0x0016611, 0x001661a, 0x0016621, 0x001662a, 0x0016631, 0x001663a, 0x0016641, 0x001664a, 0x0016651,
+	0x001665a, 0x0016661, 0x001666a, 0x0016671, 0x001667a, 0x0016681, 0x001668a, 0x0016691, 0x001669a, 0x00166a1,
+	0x00166aa, 0x00166b1, 0x00166ba, 0x00166c1, 0x00166ca, 0x00166d1, 0x00166da, 0x00166e1, 0x00166ea, 0x00166f1,
+	0x00166fa, 0x0016701, 0x001670a, 0x0016711, 0x001671a, 0x0016728, 0x0016759, 0x0016762, 0x0016769, 0x0016772,
+	0x001677c, 0x0016791, 0x001679a, 0x00167a0, 0x00167ed, 0x00167f0, 0x0016802, 0x0016930, 0x001693a, 0x0016940,
+	0x001696a, 0x0016970, 0x0016983, 0x0016b40, 0x0016b7b, 0x0016b80, 0x0016bfc, 0x0016c03, 0x0016cb8, 0x0016d03,
+	0x0016d38, 0x0016d43, 0x0016d78, 0x0016d83, 0x0016db8, 0x0016dc3, 0x0016df8, 0x0016e03, 0x0016e38, 0x0016e43,
+	0x0016e78, 0x0016e83, 0x0016eb8, 0x0016ec3, 0x0016ef8, 0x0016f04, 0x0017000, 0x001717b, 0x0017180, 0x0018006,
+	0x0018008, 0x001802b, 0x001803d, 0x0018040, 0x001810d, 0x0018154, 0x0018180, 0x001818b, 0x00181b0, 0x00181c5,
+	0x00181db, 0x00181e8, 0x001820b, 0x00184b8, 0x00184cc, 0x00184d8, 0x00184eb, 0x0018500, 0x001850b, 0x00187d8,
+	0x00187e3, 0x0018800, 0x001882b, 0x0018980, 0x001898b, 0x0018c78, 0x0018c95, 0x0018cb0, 0x0018d03, 0x0018e00,
+	0x0018f83, 0x0019000, 0x0019105, 0x0019150, 0x0019245, 0x0019280, 0x001928d, 0x0019300, 0x0019405, 0x0019450,
+	0x001958d, 0x0019600, 0x001a003, 0x0026e00, 0x0027003, 0x0052468, 0x0052683, 0x00527f0, 0x0052803, 0x0053068,
+	0x0053083, 0x0053105, 0x0053153, 0x0053160, 0x0053201, 0x005320a, 0x0053211, 0x005321a, 0x0053221, 0x005322a,
+	0x0053231, 0x005323a, 0x0053241, 0x005324a, 0x0053251, 0x005325a, 0x0053261, 0x005326a, 0x0053271, 0x005327a,
+	0x0053281, 0x005328a, 0x0053291, 0x005329a, 0x00532a1, 0x00532aa, 0x00532b1, 0x00532ba, 0x00532c1, 0x00532ca,
+	0x00532d1, 0x00532da, 0x00532e1, 0x00532ea, 0x00532f1, 0x00532fa, 0x0053301, 0x005330a, 0x0053311, 0x005331a,
+	0x0053321, 0x005332a, 0x0053331, 0x005333a, 0x0053341, 0x005334a, 0x0053351, 0x005335a, 0x0053361, 0x005336a,
+	0x0053373, 0x005337c, 0x0053398, 0x00533a4, 0x00533f0, 0x00533fb, 0x0053401, 0x005340a, 0x0053411, 0x005341a,
+	0x0053421, 0x005342a, 0x0053431, 0x005343a, 0x0053441, 0x005344a, 0x0053451, 0x005345a, 0x0053461, 0x005346a,
+	0x0053471, 0x005347a, 0x0053481, 0x005348a, 0x0053491, 0x005349a, 0x00534a1, 0x00534aa, 0x00534b1, 0x00534ba,
+	0x00534c1, 0x00534ca, 0x00534d1, 0x00534da, 0x00534e3, 0x00534f4, 0x0053503, 0x0053735, 0x0053784, 0x0053790,
+	0x00538bb, 0x0053900, 0x0053911, 0x005391a, 0x0053921, 0x005392a, 0x0053931, 0x005393a, 0x0053941, 0x005394a,
+	0x0053951, 0x005395a, 0x0053961, 0x005396a, 0x0053971, 0x005397a, 0x0053991, 0x005399a, 0x00539a1, 0x00539aa,
+	0x00539b1, 0x00539ba, 0x00539c1, 0x00539ca, 0x00539d1, 0x00539da, 0x00539e1, 0x00539ea, 0x00539f1, 0x00539fa,
+	0x0053a01, 0x0053a0a, 0x0053a11, 0x0053a1a, 0x0053a21, 0x0053a2a, 0x0053a31, 0x0053a3a, 0x0053a41, 0x0053a4a,
+	0x0053a51, 0x0053a5a, 0x0053a61, 0x0053a6a, 0x0053a71, 0x0053a7a, 0x0053a81, 0x0053a8a, 0x0053a91, 0x0053a9a,
+	0x0053aa1, 0x0053aaa, 0x0053ab1, 0x0053aba, 0x0053ac1, 0x0053aca, 0x0053ad1, 0x0053ada, 0x0053ae1, 0x0053aea,
+	0x0053af1, 0x0053afa, 0x0053b01, 0x0053b0a, 0x0053b11, 0x0053b1a, 0x0053b21, 0x0053b2a, 0x0053b31, 0x0053b3a,
+	0x0053b41, 0x0053b4a, 0x0053b51, 0x0053b5a, 0x0053b61, 0x0053b6a, 0x0053b71, 0x0053b7a, 0x0053b83, 0x0053b8a,
+	0x0053bc9, 0x0053bd2, 0x0053bd9, 0x0053be2, 0x0053be9, 0x0053bfa, 0x0053c01, 0x0053c0a, 0x0053c11, 0x0053c1a,
+	0x0053c21, 0x0053c2a, 0x0053c31, 0x0053c3a, 0x0053c43, 0x0053c48, 0x0053c59, 0x0053c62, 0x0053c69, 0x0053c72,
+	0x0053c7b, 0x0053c81, 0x0053c8a, 0x0053c91, 0x0053c9a, 0x0053cb1, 0x0053cba, 0x0053cc1, 0x0053cca, 0x0053cd1,
+	0x0053cda, 0x0053ce1, 0x0053cea, 0x0053cf1, 0x0053cfa, 0x0053d01, 0x0053d0a, 0x0053d11, 0x0053d1a, 0x0053d21,
+	0x0053d2a, 0x0053d31, 0x0053d3a, 0x0053d41, 0x0053d4a, 0x0053d51, 0x0053d7a, 0x0053d81, 0x0053daa, 0x0053db1,
+	0x0053dba, 0x0053dc1, 0x0053dca, 0x0053dd1, 0x0053dda, 0x0053de1, 0x0053dea, 0x0053df1, 0x0053dfa, 0x0053e01,
+	0x0053e0a, 0x0053e11, 0x0053e1a, 0x0053e21, 0x0053e42, 0x0053e49, 0x0053e52, 0x0053e59, 0x0053e6a, 0x0053e70,
+	0x0053e81, 0x0053e8a, 0x0053e90, 0x0053e9a, 0x0053ea0, 0x0053eaa, 0x0053eb1, 0x0053eba, 0x0053ec1, 0x0053eca,
+	0x0053ed1, 0x0053eda, 0x0053ee1, 0x0053ee8, 0x0053f93, 0x0053fa9, 0x0053fb2, 0x0053fbb, 0x0053fd2, 0x0053fdb,
+	0x0054014, 0x005401b, 0x0054034, 0x005403b, 0x005405c, 0x0054063, 0x005411c, 0x0054140, 0x0054164, 0x0054168,
+	0x0054185, 0x00541b0, 0x0054203, 0x00543a0, 0x0054404, 0x0054413, 0x00545a4, 0x0054630, 0x0054685, 0x00546d0,
+	0x0054704, 0x0054793, 0x00547c0, 0x00547db, 0x00547e0, 0x00547eb, 0x00547fc, 0x0054805, 0x0054853, 0x0054934,
+	0x0054970, 0x0054983, 0x0054a3c, 0x0054aa0, 0x0054b03, 0x0054be8, 0x0054c04, 0x0054c23, 0x0054d9c, 0x0054e08,
+	0x0054e7b, 0x0054e85, 0x0054ed0, 0x0054f03, 0x0054f2c, 0x0054f33, 0x0054f85, 0x0054fd3, 0x0054ff8, 0x0055003,
+	0x005514c, 0x00551b8, 0x0055203, 0x005521c, 0x0055223, 0x0055264, 0x0055270, 0x0055285, 0x00552d0, 0x0055303,
+	0x00553b8, 0x00553d3, 0x00553dc, 0x00553f3, 0x0055584, 0x005558b, 0x0055594, 0x00555ab, 0x00555bc, 0x00555cb,
+	0x00555f4, 0x0055603, 0x005560c, 0x0055613, 0x0055618, 0x00556db, 0x00556f0, 0x0055703, 0x005575c, 0x0055780,
+	0x0055793, 0x00557ac, 0x00557b8, 0x005580b, 0x0055838, 0x005584b, 0x0055878, 0x005588b, 0x00558b8, 0x0055903,
+	0x0055938, 0x0055943, 0x0055978, 0x0055982, 0x0055ad8, 0x0055ae3, 0x0055b02, 0x0055b4b, 0x0055b50, 0x0055b82,
+	0x0055e03, 0x0055f1c, 0x0055f58, 0x0055f64, 0x0055f70, 0x0055f85, 0x0055fd0, 0x0056003, 0x006bd20, 0x006bd83,
+	0x006be38, 0x006be5b, 0x006bfe0, 0x007c803, 0x007d370, 0x007d383, 0x007d6d0, 0x007d802, 0x007d838, 0x007d89a,
+	0x007d8c0, 0x007d8eb, 0x007d8f4, 0x007d8fb, 0x007d948, 0x007d953, 0x007d9b8, 0x007d9c3, 0x007d9e8, 0x007d9f3,
+	0x007d9f8, 0x007da03, 0x007da10, 0x007da1b, 0x007da28, 0x007da33, 0x007dd90, 0x007de9b, 0x007e9f0, 0x007ea83,
+	0x007ec80, 0x007ec93, 0x007ee40, 0x007ef83, 0x007efe0, 0x007f004, 0x007f080, 0x007f104, 0x007f180, 0x007f383,
+	0x007f3a8, 0x007f3b3, 0x007f7e8, 0x007f885, 0x007f8d0, 0x007f909, 0x007f9d8, 0x007fa0a, 0x007fad8, 0x007fb33,
+	0x007fdf8, 0x007fe13, 0x007fe40, 0x007fe53, 0x007fe80, 0x007fe93, 0x007fec0, 0x007fed3, 0x007fee8, 0x0080003,
+	0x0080060, 0x008006b, 0x0080138, 0x0080143, 0x00801d8, 0x00801e3, 0x00801f0, 0x00801fb, 0x0080270, 0x0080283,
+	0x00802f0, 0x0080403, 0x00807d8, 0x008083d, 0x00809a0, 0x0080a05, 0x0080bc8, 0x0080c55, 0x0080c60, 0x0080fec,
+	0x0080ff0, 0x0081403, 0x00814e8, 0x0081503, 0x0081688, 0x0081704, 0x008170d, 0x00817e0, 0x0081803, 0x0081905,
+	0x0081920, 0x008196b, 0x0081a0d, 0x0081a13, 0x0081a55, 0x0081a58, 0x0081a83, 0x0081bb4, 0x0081bd8, 0x0081c03,
+	0x0081cf0, 0x0081d03, 0x0081e20, 0x0081e43, 0x0081e80, 0x0081e8d, 0x0081eb0, 0x0082001, 0x0082142, 0x0082283,
+	0x00824f0, 0x0082505, 0x0082550, 0x0082581, 0x00826a0, 0x00826c2, 0x00827e0, 0x0082803, 0x0082940, 0x0082983,
+	0x0082b20, 0x0082b81, 0x0082bd8, 0x0082be1, 0x0082c58, 0x0082c61, 0x0082c98, 0x0082ca1, 0x0082cb0, 0x0082cba,
+	0x0082d10, 0x0082d1a, 0x0082d90, 0x0082d9a, 0x0082dd0, 0x0082dda, 0x0082de8, 0x0082e03, 0x0082fa0, 0x0083003,
+	0x00839b8, 0x0083a03, 0x0083ab0, 0x0083b03, 0x0083b40, 0x0083c03, 0x0083c30, 0x0083c3b, 0x0083d88, 0x0083d93,
+	0x0083dd8, 0x0084003, 0x0084030, 0x0084043, 0x0084048, 0x0084053, 0x00841b0, 0x00841bb, 0x00841c8, 0x00841e3,
+	0x00841e8, 0x00841fb, 0x00842b0, 0x00842c5, 0x0084303, 0x00843b8, 0x00843cd, 0x0084403, 0x00844f8, 0x008453d,
+	0x0084580, 0x0084703, 0x0084798, 0x00847a3, 0x00847b0, 0x00847dd, 0x0084803, 0x00848b5, 0x00848e0, 0x0084903,
+	0x00849d0, 0x0084c03, 0x0084dc0, 0x0084de5, 0x0084df3, 0x0084e05, 0x0084e80, 0x0084e95, 0x0085003, 0x008500c,
+	0x0085020, 0x008502c, 0x0085038, 0x0085064, 0x0085083, 0x00850a0, 0x00850ab, 0x00850c0, 0x00850cb, 0x00851b0,
+	0x00851c4, 0x00851d8, 0x00851fc, 0x0085205, 0x0085248, 0x0085303, 0x00853ed, 0x00853f8, 0x0085403, 0x00854ed,
+	0x0085500, 0x0085603, 0x0085640, 0x008564b, 0x008572c, 0x0085738, 0x008575d, 0x0085780, 0x0085803, 0x00859b0,
+	0x0085a03, 0x0085ab0, 0x0085ac5, 0x0085b03, 0x0085b98, 0x0085bc5, 0x0085c03, 0x0085c90, 0x0085d4d, 0x0085d80,
+	0x0086003, 0x0086248, 0x0086401, 0x0086598, 0x0086602, 0x0086798, 0x00867d5, 0x0086803, 0x0086924, 0x0086940,
+	0x0086985, 0x00869d0, 0x0086a05, 0x0086a53, 0x0086a81, 0x0086b30, 0x0086b4c, 0x0086b70, 0x0086b7b, 0x0086b82,
+	0x0086c30, 0x0087305, 0x00873f8, 0x0087403, 0x0087550, 0x008755c, 0x0087568, 0x0087583, 0x0087590, 0x0087613,
+	0x0087628, 0x00877e4, 0x0087803, 0x00878ed, 0x008793b, 0x0087940, 0x0087983, 0x0087a34, 0x0087a8d, 0x0087aa8,
+	0x0087b83, 0x0087c14, 0x0087c30, 0x0087d83, 0x0087e2d, 0x0087e60, 0x0087f03, 0x0087fb8, 0x0088004, 0x008801b,
+	0x00881c4, 0x0088238, 0x0088295, 0x0088384, 0x008838b, 0x008839c, 0x00883ab, 0x00883b0, 0x00883fc, 0x008841b,
+	0x0088584, 0x00885d8, 0x0088614, 0x0088618, 0x0088683, 0x0088748, 0x0088785, 0x00887d0, 0x0088804, 0x008881b,
+	0x008893c, 0x00889a8, 0x00889b5, 0x0088a00, 0x0088a23, 0x0088a2c, 0x0088a3b, 0x0088a40, 0x0088a83, 0x0088b9c,
+	0x0088ba0, 0x0088bb3, 0x0088bb8, 0x0088c04, 0x0088c1b, 0x0088d9c, 0x0088e0b, 0x0088e28, 0x0088e4c, 0x0088e68,
+	0x0088e74, 0x0088e85, 0x0088ed3, 0x0088ed8, 0x0088ee3, 0x0088ee8, 0x0088f0d, 0x0088fa8, 0x0089003, 0x0089090,
+	0x008909b, 0x0089164, 0x00891c0, 0x00891f4, 0x00891fb, 0x008920c, 0x0089210, 0x0089403, 0x0089438, 0x0089443,
+	0x0089448, 0x0089453, 0x0089470, 0x008947b, 0x00894f0, 0x00894fb, 0x0089548, 0x0089583, 0x00896fc, 0x0089758,
+	0x0089785, 0x00897d0, 0x0089804, 0x0089820, 0x008982b, 0x0089868, 0x008987b, 0x0089888, 0x008989b, 0x0089948,
+	0x0089953, 0x0089988, 0x0089993, 0x00899a0, 0x00899ab, 0x00899d0, 0x00899dc, 0x00899eb, 0x00899f4, 0x0089a28,
+	0x0089a3c, 0x0089a48, 0x0089a5c, 0x0089a70, 0x0089a83, 0x0089a88, 0x0089abc, 0x0089ac0, 0x0089aeb, 0x0089b14,
+	0x0089b20, 0x0089b34, 0x0089b68, 0x0089b84, 0x0089ba8, 0x0089c03, 0x0089c50, 0x0089c5b, 0x0089c60, 0x0089c73,
+	0x0089c78, 0x0089c83, 0x0089db0, 0x0089dbb, 0x0089dc4, 0x0089e08, 0x0089e14, 0x0089e18, 0x0089e2c, 0x0089e30,
+	0x0089e3c, 0x0089e58, 0x0089e64, 0x0089e8b, 0x0089e94, 0x0089e9b, 0x0089ea0, 0x0089f0c, 0x0089f18, 0x008a003,
+	0x008a1ac, 0x008a23b, 0x008a258, 0x008a285, 0x008a2d0, 0x008a2f4, 0x008a2fb, 0x008a310, 0x008a403, 0x008a584,
+	0x008a623, 0x008a630, 0x008a63b, 0x008a640, 0x008a685, 0x008a6d0, 0x008ac03, 0x008ad7c, 0x008adb0, 0x008adc4,
+	0x008ae08, 0x008aec3, 0x008aee4, 0x008aef0, 0x008b003, 0x008b184, 0x008b208, 0x008b223, 0x008b228, 0x008b285,
+	0x008b2d0, 0x008b403, 0x008b55c, 0x008b5c3, 0x008b5c8, 0x008b605, 0x008b650, 0x008b685, 0x008b720, 0x008b803,
+	0x008b8d8, 0x008b8ec, 0x008b960, 0x008b985, 0x008b9e0, 0x008ba03, 0x008ba38, 0x008c003, 0x008c164, 0x008c1d8,
+	0x008c501, 0x008c602, 0x008c705, 0x008c798, 0x008c7fb, 0x008c838, 0x008c84b, 0x008c850, 0x008c863, 0x008c8a0,
+	0x008c8ab, 0x008c8b8, 0x008c8c3, 0x008c984, 0x008c9b0, 0x008c9bc, 0x008c9c8, 0x008c9dc, 0x008c9fb, 0x008ca04,
+	0x008ca0b, 0x008ca14, 0x008ca20, 0x008ca85, 0x008cad0, 0x008cd03, 0x008cd40, 0x008cd53, 0x008ce8c, 0x008cec0,
+	0x008ced4, 0x008cf0b, 0x008cf10, 0x008cf1b, 0x008cf24, 0x008cf28, 0x008d003, 0x008d00c, 0x008d05b, 0x008d19c,
+	0x008d1d3, 0x008d1dc, 0x008d1f8, 0x008d23c, 0x008d240, 0x008d283, 0x008d28c, 0x008d2e3, 0x008d454, 0x008d4d0,
+	0x008d4eb, 0x008d4f0, 0x008d583, 0x008d7c8, 0x008de03, 0x008df08, 0x008df85, 0x008dfd0, 0x008e003, 0x008e048,
+	0x008e053, 0x008e17c, 0x008e1b8, 0x008e1c4, 0x008e203, 0x008e208, 0x008e285, 0x008e368, 0x008e393, 0x008e480,
+	0x008e494, 0x008e540, 0x008e54c, 0x008e5b8, 0x008e803, 0x008e838, 0x008e843, 0x008e850, 0x008e85b, 0x008e98c,
+	0x008e9b8, 0x008e9d4, 0x008e9d8, 0x008e9e4, 0x008e9f0, 0x008e9fc, 0x008ea33, 0x008ea3c, 0x008ea40, 0x008ea85,
+	0x008ead0, 0x008eb03, 0x008eb30, 0x008eb3b, 0x008eb48, 0x008eb53, 0x008ec54, 0x008ec78, 0x008ec84, 0x008ec90,
+	0x008ec9c, 0x008ecc3, 0x008ecc8, 0x008ed05, 0x008ed50, 0x008f703, 0x008f79c, 0x008f7b8, 0x008f804, 0x008f813,
+	0x008f81c, 0x008f823, 0x008f888, 0x008f893, 0x008f9a4, 0x008f9d8, 0x008f9f4, 0x008fa18, 0x008fa85, 0x008fad4,
+	0x008fad8, 0x008fd83, 0x008fd88, 0x008fe05, 0x008fea8, 0x0090003, 0x0091cd0, 0x0092005, 0x0092378, 0x0092403,
+	0x0092a20, 0x0097c83, 0x0097f88, 0x0098003, 0x009a180, 0x009a204, 0x009a20b, 0x009a23c, 0x009a2b0, 0x009a303,
+	0x00a1fd8, 0x00a2003, 0x00a3238, 0x00b0803, 0x00b08f4, 0x00b0985, 0x00b09d0, 0x00b4003, 0x00b51c8, 0x00b5203,
+	0x00b52f8, 0x00b5305, 0x00b5350, 0x00b5383, 0x00b55f8, 0x00b5605, 0x00b5650, 0x00b5683, 0x00b5770, 0x00b5784,
+	0x00b57a8, 0x00b5803, 0x00b5984, 0x00b59b8, 0x00b5a03, 0x00b5a20, 0x00b5a85, 0x00b5ad0, 0x00b5add, 0x00b5b10,
+	0x00b5b1b, 0x00b5bc0, 0x00b5beb, 0x00b5c80, 0x00b6a03, 0x00b6b68, 0x00b6b85, 0x00b6bd0, 0x00b7201, 0x00b7302,
+	0x00b7405, 0x00b74b8, 0x00b7803, 0x00b7a58, 0x00b7a7c, 0x00b7a83, 0x00b7a8c, 0x00b7c40, 0x00b7c7c, 0x00b7c9b,
+	0x00b7d00, 0x00b7f03, 0x00b7f10, 0x00b7f1b, 0x00b7f24, 0x00b7f28, 0x00b7f84, 0x00b7f90, 0x00b8003, 0x00c3fc0,
+	0x00c4003, 0x00c66b0, 0x00c67fb, 0x00c6848, 0x00d7f83, 0x00d7fa0, 0x00d7fab, 0x00d7fe0, 0x00d7feb, 0x00d7ff8,
+	0x00d8003, 0x00d8918, 0x00d8993, 0x00d8998, 0x00d8a83, 0x00d8a98, 0x00d8aab, 0x00d8ab0, 0x00d8b23, 0x00d8b40,
+	0x00d8b83, 0x00d97e0, 0x00de003, 0x00de358, 0x00de383, 0x00de3e8, 0x00de403, 0x00de448, 0x00de483, 0x00de4d0,
+	0x00de4ec, 0x00de4f8, 0x00e6785, 0x00e67d0, 0x00e7804, 0x00e7970, 0x00e7984, 0x00e7a38, 0x00e8b2c, 0x00e8b50,
+	0x00e8b6c, 0x00e8b98, 0x00e8bdc, 0x00e8c18, 0x00e8c2c, 0x00e8c60, 0x00e8d54, 0x00e8d70, 0x00e9214, 0x00e9228,
+	0x00e9605, 0x00e96a0, 0x00e9705, 0x00e97a0, 0x00e9b05, 0x00e9bc8, 0x00ea001, 0x00ea0d2, 0x00ea1a1, 0x00ea272,
+	0x00ea2a8, 0x00ea2b2, 0x00ea341, 0x00ea412, 0x00ea4e1, 0x00ea4e8, 0x00ea4f1, 0x00ea500, 0x00ea511, 0x00ea518,
+	0x00ea529, 0x00ea538, 0x00ea549, 0x00ea568, 0x00ea571, 0x00ea5b2, 0x00ea5d0, 0x00ea5da, 0x00ea5e0, 0x00ea5ea,
+	0x00ea620, 0x00ea62a, 0x00ea681, 0x00ea752, 0x00ea821, 0x00ea830, 0x00ea839, 0x00ea858, 0x00ea869, 0x00ea8a8,
+	0x00ea8b1, 0x00ea8e8, 0x00ea8f2, 0x00ea9c1, 0x00ea9d0, 0x00ea9d9, 0x00ea9f8, 0x00eaa01, 0x00eaa28, 0x00eaa31,
+	0x00eaa38, 0x00eaa51, 0x00eaa88, 0x00eaa92, 0x00eab61, 0x00eac32, 0x00ead01, 0x00eadd2, 0x00eaea1, 0x00eaf72,
+	0x00eb041, 0x00eb112, 0x00eb1e1, 0x00eb2b2, 0x00eb381, 0x00eb452, 0x00eb530, 0x00eb541, 0x00eb608, 0x00eb612,
+	0x00eb6d8, 0x00eb6e2, 0x00eb711, 0x00eb7d8, 0x00eb7e2, 0x00eb8a8, 0x00eb8b2, 0x00eb8e1, 0x00eb9a8, 0x00eb9b2,
+	0x00eba78, 0x00eba82, 0x00ebab1, 0x00ebb78, 0x00ebb82, 0x00ebc48, 0x00ebc52, 0x00ebc81, 0x00ebd48, 0x00ebd52,
+	0x00ebe18, 0x00ebe22, 0x00ebe51, 0x00ebe5a, 0x00ebe60, 0x00ebe75, 0x00ec000, 0x00ed004, 0x00ed1b8, 0x00ed1dc,
+	0x00ed368, 0x00ed3ac, 0x00ed3b0, 0x00ed424, 0x00ed428, 0x00ed4dc, 0x00ed500, 0x00ed50c, 0x00ed580, 0x00ef802,
+	0x00ef853, 0x00ef85a, 0x00ef8f8, 0x00ef92a, 0x00ef958, 0x00f0004, 0x00f0038, 0x00f0044, 0x00f00c8, 0x00f00dc,
+	0x00f0110, 0x00f011c, 0x00f0128, 0x00f0134, 0x00f0158, 0x00f0183, 0x00f0370, 0x00f047c, 0x00f0480, 0x00f0803,
+	0x00f0968, 0x00f0984, 0x00f09bb, 0x00f09f0, 0x00f0a05, 0x00f0a50, 0x00f0a73, 0x00f0a78, 0x00f1483, 0x00f1574,
+	0x00f1578, 0x00f1603, 0x00f1764, 0x00f1785, 0x00f17d0, 0x00f2683, 0x00f2764, 0x00f2785, 0x00f27d0, 0x00f2e83,
+	0x00f2f74, 0x00f2f83, 0x00f2f8d, 0x00f2fd8, 0x00f3f03, 0x00f3f38, 0x00f3f43, 0x00f3f60, 0x00f3f6b, 0x00f3f78,
+	0x00f3f83, 0x00f3ff8, 0x00f4003, 0x00f4628, 0x00f463d, 0x00f4684, 0x00f46b8, 0x00f4801, 0x00f4912, 0x00f4a24,
+	0x00f4a5b, 0x00f4a60, 0x00f4a85, 0x00f4ad0, 0x00f638d, 0x00f6560, 0x00f656d, 0x00f6580, 0x00f658d, 0x00f65a8,
+	0x00f680d, 0x00f6970, 0x00f697d, 0x00f69f0, 0x00f7003, 0x00f7020, 0x00f702b, 0x00f7100, 0x00f710b, 0x00f7118,
+	0x00f7123, 0x00f7128, 0x00f713b, 0x00f7140, 0x00f714b, 0x00f7198, 0x00f71a3, 0x00f71c0, 0x00f71cb, 0x00f71d0,
+	0x00f71db, 0x00f71e0, 0x00f7213, 0x00f7218, 0x00f723b, 0x00f7240, 0x00f724b, 0x00f7250, 0x00f725b, 0x00f7260,
+	0x00f726b, 0x00f7280, 0x00f728b, 0x00f7298, 0x00f72a3, 0x00f72a8, 0x00f72bb, 0x00f72c0, 0x00f72cb, 0x00f72d0,
+	0x00f72db, 0x00f72e0, 0x00f72eb, 0x00f72f0, 0x00f72fb, 0x00f7300, 0x00f730b, 0x00f7318, 0x00f7323, 0x00f7328,
+	0x00f733b, 0x00f7358, 0x00f7363, 0x00f7398, 0x00f73a3, 0x00f73c0, 0x00f73cb, 0x00f73e8, 0x00f73f3, 0x00f73f8,
+	0x00f7403, 0x00f7450, 0x00f745b, 0x00f74e0, 0x00f750b, 0x00f7520, 0x00f752b, 0x00f7550, 0x00f755b, 0x00f75e0,
+	0x00f8805, 0x00f8868, 0x00fdf85, 0x00fdfd0, 0x0100003, 0x0153700, 0x0153803, 0x015b9d0, 0x015ba03, 0x015c0f0,
+	0x015c103, 0x0167510, 0x0167583, 0x0175f08, 0x0175f83, 0x01772f0, 0x017c003, 0x017d0f0, 0x0180003, 0x0189a58,
+	0x0189a83, 0x0191d80, 0x0700804, 0x0700f80,
+};
+
+#endif //TOKENIZER_UNICODE_H
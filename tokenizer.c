@@ -0,0 +1,818 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#include "tokenizer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#include "tokenizer-unicode.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+// the compiled table: this header, then slots[slot_count] and the token bytes. written in the machine's byte order,
+// byte_order says which
+#define TOKENIZER_FILE_MAGIC "CGBPE2\0"
+#define TOKENIZER_FILE_MAGIC_LENGTH 8
+#define TOKENIZER_BYTE_ORDER 0x01020304u
+
+#define TOKENIZER_NO_RANK UINT32_MAX
+
+// a slot is the top 12 bits of the token's hash, its length, where its bytes are and its rank, so a lookup is the slot
+// and the bytes it's compared with, and most misses don't get as far as the bytes. 0 is an empty slot
+#define TOKENIZER_SLOT_TAG_SHIFT 52
+#define TOKENIZER_SLOT_LENGTH_SHIFT 44
+#define TOKENIZER_SLOT_OFFSET_SHIFT 20
+#define TOKENIZER_MAX_TOKEN_LENGTH 0xff
+#define TOKENIZER_MAX_OFFSET 0xffffff
+#define TOKENIZER_MAX_RANK 0xfffff
+
+// pieces up to this long are merged without allocating, by scanning for the lowest rank after every merge. longer
+// ones (a minified file, a run of one letter) would make that quadratic, so they keep the ranks in a heap instead
+#define TOKENIZER_STACK_PIECE_LENGTH 256
+
+// a part marked as merged into the one before it
+#define TOKENIZER_MERGED UINT32_MAX
+
+// past the end of the text, in no class mask
+#define TOKENIZER_CHAR_END (TOKENIZER_CHAR_NEWLINE + 1)
+
+#define TOKENIZER_LETTERS (1u << TOKENIZER_CHAR_UPPER | 1u << TOKENIZER_CHAR_LOWER | 1u << TOKENIZER_CHAR_LETTER)
+#define TOKENIZER_PUNCTUATION (1u << TOKENIZER_CHAR_OTHER | 1u << TOKENIZER_CHAR_MARK) // [^\s\p{L}\p{N}]
+#define TOKENIZER_PREFIX (TOKENIZER_PUNCTUATION | 1u << TOKENIZER_CHAR_SPACE) // [^\r\n\p{L}\p{N}]
+#define TOKENIZER_WHITESPACE (1u << TOKENIZER_CHAR_SPACE | 1u << TOKENIZER_CHAR_NEWLINE)
+
+// o200k splits words before a capital: [\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}] and [\p{Ll}\p{Lm}\p{Lo}\p{M}]
+#define TOKENIZER_O200K_UPPER (1u << TOKENIZER_CHAR_UPPER | 1u << TOKENIZER_CHAR_LETTER | 1u << TOKENIZER_CHAR_MARK)
+#define TOKENIZER_O200K_LOWER (1u << TOKENIZER_CHAR_LOWER | 1u << TOKENIZER_CHAR_LETTER | 1u << TOKENIZER_CHAR_MARK)
+
+typedef struct {
+	char magic[TOKENIZER_FILE_MAGIC_LENGTH];
+	uint32_t byte_order;
+	uint32_t token_count;
+	uint32_t slot_count; // a power of 2, at most 3/4 full
+	uint32_t bytes_length;
+	uint64_t source_size; // of the .tiktoken it was compiled from, in case it's replaced by an older file
+} tokenizer_file_header;
+
+struct chatgpt_cli_tokenizer {
+	chatgpt_cli_tokenizer_encoding encoding;
+	const uint64_t* slots;
+	const unsigned char* bytes;
+	uint32_t bytes_length;
+	size_t slot_mask;
+
+	void* data; // what the pointers above point into
+	size_t data_length;
+	bool mapped;
+};
+
+chatgpt_cli_tokenizer_encoding chatgpt_cli_tokenizer_encoding_for_model(const char* model) {
+	if (!model) return CHATGPT_CLI_TOKENIZER_O200K_BASE;
+
+	// gpt-4 and gpt-3.5 models, but not gpt-4o or gpt-4.1
+	if (strncmp(model, "gpt-3.5", 7) == 0 || strncmp(model, "text-embedding-", 15) == 0) {
+		return CHATGPT_CLI_TOKENIZER_CL100K_BASE;
+	}
+	if (strncmp(model, "gpt-4", 5) == 0 && (model[5] == '\0' || model[5] == '-')) {
+		return CHATGPT_CLI_TOKENIZER_CL100K_BASE;
+	}
+	return CHATGPT_CLI_TOKENIZER_O200K_BASE;
+}
+
+const char* chatgpt_cli_tokenizer_encoding_name(const chatgpt_cli_tokenizer_encoding encoding) {
+	switch (encoding) {
+	case CHATGPT_CLI_TOKENIZER_CL100K_BASE:
+		return "cl100k_base";
+	case CHATGPT_CLI_TOKENIZER_O200K_BASE:
+	default:
+		return "o200k_base";
+	}
+}
+
+// ---- merge table ----
+
+// compiled tables are laid out by it, so changing it needs a new TOKENIZER_FILE_MAGIC
+static uint64_t tokenizer_hash(const unsigned char* bytes, size_t length) {
+	uint64_t hash = (uint64_t)length * 0x9e3779b97f4a7c15ull;
+	while (length > 8) {
+		uint64_t word;
+		memcpy(&word, bytes, 8);
+		hash = (hash ^ word) * 0xbf58476d1ce4e5b9ull;
+		hash ^= hash >> 31;
+		bytes += 8;
+		length -= 8;
+	}
+
+	uint64_t word = 0;
+	memcpy(&word, bytes, length);
+	hash ^= word;
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebull;
+	return hash ^ hash >> 31;
+}
+
+static uint32_t tokenizer_rank(const chatgpt_cli_tokenizer* tokenizer, const unsigned char* bytes,
+                               const size_t length) {
+	if (length > TOKENIZER_MAX_TOKEN_LENGTH) return TOKENIZER_NO_RANK;
+
+	const uint64_t hash = tokenizer_hash(bytes, length);
+	const uint64_t key = (hash >> TOKENIZER_SLOT_TAG_SHIFT << TOKENIZER_SLOT_TAG_SHIFT) |
+		(uint64_t)length << TOKENIZER_SLOT_LENGTH_SHIFT;
+	size_t slot = (size_t)hash & tokenizer->slot_mask;
+	for (;;) {
+		const uint64_t entry = tokenizer->slots[slot];
+		if (entry == 0) return TOKENIZER_NO_RANK;
+
+		// the bounds check is for a damaged file, which is mapped without reading all of it first
+		if (entry >> TOKENIZER_SLOT_LENGTH_SHIFT == key >> TOKENIZER_SLOT_LENGTH_SHIFT) {
+			const uint32_t offset = (uint32_t)(entry >> TOKENIZER_SLOT_OFFSET_SHIFT) & TOKENIZER_MAX_OFFSET;
+			if (offset + length <= tokenizer->bytes_length && memcmp(tokenizer->bytes + offset, bytes, length) == 0) {
+				return (uint32_t)entry & TOKENIZER_MAX_RANK;
+			}
+		}
+		slot = (slot + 1) & tokenizer->slot_mask;
+	}
+}
+
+// tiktoken's byte pair merge: starting from single bytes, the adjacent pair making the lowest ranked token is merged
+// until no pair makes a token, the leftmost pair first on a tie. only the number of parts left matters here
+static size_t tokenizer_merge_short(const chatgpt_cli_tokenizer* tokenizer, const unsigned char* piece,
+                                    const size_t length) {
+	uint32_t starts[TOKENIZER_STACK_PIECE_LENGTH + 1];
+	uint32_t ranks[TOKENIZER_STACK_PIECE_LENGTH + 1];
+
+	// parts[i] runs from starts[i] to starts[i + 1], ranks[i] is the rank of parts i and i + 1 merged
+	size_t parts = length + 1;
+	for (size_t i = 0; i < parts; i++) starts[i] = (uint32_t)i;
+	for (size_t i = 0; i + 2 < parts; i++) ranks[i] = tokenizer_rank(tokenizer, piece + i, 2);
+	ranks[parts - 2] = TOKENIZER_NO_RANK;
+	ranks[parts - 1] = TOKENIZER_NO_RANK;
+
+	for (;;) {
+		uint32_t min_rank = TOKENIZER_NO_RANK;
+		size_t i = 0;
+		for (size_t j = 0; j + 1 < parts; j++) {
+			if (ranks[j] < min_rank) {
+				min_rank = ranks[j];
+				i = j;
+			}
+		}
+		if (min_rank == TOKENIZER_NO_RANK) break;
+
+		// part i swallows part i + 1, so its pairs with both neighbours change
+		ranks[i] = i + 3 < parts
+			           ? tokenizer_rank(tokenizer, piece + starts[i], starts[i + 3] - starts[i])
+			           : TOKENIZER_NO_RANK;
+		if (i > 0) {
+			ranks[i - 1] = tokenizer_rank(tokenizer, piece + starts[i - 1], starts[i + 2] - starts[i - 1]);
+		}
+		memmove(starts + i + 1, starts + i + 2, (parts - i - 2) * sizeof(uint32_t));
+		memmove(ranks + i + 1, ranks + i + 2, (parts - i - 2) * sizeof(uint32_t));
+		parts--;
+	}
+	return parts - 1;
+}
+
+// a pair in the heap: rank in the high half, the left part's start in the low one, so the smallest is the lowest rank
+// and the leftmost of equal ones, the same pair as the scan above picks
+static void tokenizer_heap_push(uint64_t* heap, size_t* count, const uint32_t rank, const uint32_t start) {
+	const uint64_t pair = (uint64_t)rank << 32 | start;
+	size_t i = (*count)++;
+	while (i > 0 && heap[(i - 1) / 2] > pair) {
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap[i] = pair;
+}
+
+static uint64_t tokenizer_heap_pop(uint64_t* heap, size_t* count) {
+	const uint64_t top = heap[0];
+	const uint64_t last = heap[--*count];
+	size_t i = 0;
+	for (;;) {
+		size_t child = i * 2 + 1;
+		if (child >= *count) break;
+		if (child + 1 < *count && heap[child + 1] < heap[child]) child++;
+		if (heap[child] >= last) break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = last;
+	return top;
+}
+
+// the same merges for long pieces. parts are a linked list by their start, pairs whose parts have changed since
+// they were pushed are skipped when they come out of the heap
+static size_t tokenizer_merge_long(const chatgpt_cli_tokenizer* tokenizer, const unsigned char* piece,
+                                   const size_t length) {
+	uint32_t* next = malloc((length + 1) * sizeof(uint32_t)); // where the part starting here ends
+	uint32_t* previous = malloc(length * sizeof(uint32_t));
+	uint32_t* ranks = malloc(length * sizeof(uint32_t)); // of the part starting here merged with the next
+	uint64_t* heap = malloc(length * 3 * sizeof(uint64_t)); // every merge pushes at most 2 pairs
+	if (!next || !previous || !ranks || !heap) {
+		// can't merge, so every byte would be its own token. an overestimate at worst
+		free(next);
+		free(previous);
+		free(ranks);
+		free(heap);
+		return length;
+	}
+
+	size_t heap_count = 0;
+	for (uint32_t i = 0; i < length; i++) {
+		next[i] = i + 1;
+		previous[i] = i - 1;
+		ranks[i] = i + 1 < length ? tokenizer_rank(tokenizer, piece + i, 2) : TOKENIZER_NO_RANK;
+		if (ranks[i] != TOKENIZER_NO_RANK) tokenizer_heap_push(heap, &heap_count, ranks[i], i);
+	}
+
+	size_t parts = length;
+	while (heap_count > 0) {
+		const uint64_t pair = tokenizer_heap_pop(heap, &heap_count);
+		const uint32_t start = (uint32_t)pair;
+		if (next[start] == TOKENIZER_MERGED || ranks[start] != (uint32_t)(pair >> 32)) continue;
+
+		const uint32_t merged = next[start];
+		const uint32_t end = next[merged];
+		next[start] = end;
+		if (end < length) previous[end] = start;
+		next[merged] = TOKENIZER_MERGED;
+		parts--;
+
+		ranks[start] = end < length ? tokenizer_rank(tokenizer, piece + start, next[end] - start) : TOKENIZER_NO_RANK;
+		if (ranks[start] != TOKENIZER_NO_RANK) tokenizer_heap_push(heap, &heap_count, ranks[start], start);
+		if (start > 0) {
+			const uint32_t before = previous[start];
+			ranks[before] = tokenizer_rank(tokenizer, piece + before, end - before);
+			if (ranks[before] != TOKENIZER_NO_RANK) tokenizer_heap_push(heap, &heap_count, ranks[before], before);
+		}
+	}
+
+	free(next);
+	free(previous);
+	free(ranks);
+	free(heap);
+	return parts;
+}
+
+static size_t tokenizer_count_piece(const chatgpt_cli_tokenizer* tokenizer, const unsigned char* piece,
+                                    const size_t length) {
+	if (length == 1) return 1;
+	if (tokenizer_rank(tokenizer, piece, length) != TOKENIZER_NO_RANK) return 1;
+	return length <= TOKENIZER_STACK_PIECE_LENGTH
+		       ? tokenizer_merge_short(tokenizer, piece, length)
+		       : tokenizer_merge_long(tokenizer, piece, length);
+}
+
+// ---- splitting ----
+
+static int tokenizer_class_of(const uint32_t code_point) {
+	// the last range starting at or before the code point
+	size_t low = 0;
+	size_t high = TOKENIZER_UNICODE_RANGE_COUNT;
+	while (high - low > 1) {
+		const size_t middle = (low + high) / 2;
+		if (tokenizer_unicode_ranges[middle] >> 3 <= code_point) low = middle;
+		else high = middle;
+	}
+	return (int)(tokenizer_unicode_ranges[low] & 7);
+}
+
+// invalid UTF-8 is taken a byte at a time, as punctuation
+static int tokenizer_class_utf8(const unsigned char* text, const size_t remaining, size_t* size) {
+	*size = 1;
+	size_t length;
+	uint32_t code_point;
+	if (text[0] >= 0xc2 && text[0] < 0xe0) {
+		length = 2;
+		code_point = text[0] & 0x1f;
+	} else if (text[0] >= 0xe0 && text[0] < 0xf0) {
+		length = 3;
+		code_point = text[0] & 0x0f;
+	} else if (text[0] >= 0xf0 && text[0] < 0xf5) {
+		length = 4;
+		code_point = text[0] & 0x07;
+	} else {
+		return TOKENIZER_CHAR_OTHER;
+	}
+	if (length > remaining) return TOKENIZER_CHAR_OTHER;
+
+	for (size_t i = 1; i < length; i++) {
+		if ((text[i] & 0xc0) != 0x80) return TOKENIZER_CHAR_OTHER;
+		code_point = code_point << 6 | (text[i] & 0x3f);
+	}
+	*size = length;
+	return tokenizer_class_of(code_point);
+}
+
+// the class of the character at position and its length in bytes. most text is ASCII, which is one table lookup
+static inline int tokenizer_class_at(const unsigned char* text, const size_t length, const size_t position,
+                                     size_t* size) {
+	if (position >= length) {
+		*size = 0;
+		return TOKENIZER_CHAR_END;
+	}
+	if (text[position] < 0x80) {
+		*size = 1;
+		return tokenizer_ascii_classes[text[position]];
+	}
+	return tokenizer_class_utf8(text + position, length - position, size);
+}
+
+// the end of the run of characters from position whose classes are in mask
+static size_t tokenizer_scan(const unsigned char* text, const size_t length, size_t position, const unsigned mask) {
+	// ASCII words are most of the scanning, so they get their own loop
+	if (mask & 1u << TOKENIZER_CHAR_LOWER) {
+		while (position < length && text[position] < 0x80 &&
+			tokenizer_ascii_classes[text[position]] == TOKENIZER_CHAR_LOWER) {
+			position++;
+		}
+	}
+
+	size_t size;
+	while (1u << tokenizer_class_at(text, length, position, &size) & mask) position += size;
+	return position;
+}
+
+// (?i:'s|'t|'re|'ve|'m|'ll|'d), the length matched at position or 0
+static size_t tokenizer_contraction(const unsigned char* text, const size_t length, const size_t position) {
+	if (position >= length || text[position] != '\'') return 0;
+	const unsigned char* rest = text + position + 1;
+	const size_t rest_length = length - position - 1;
+	if (rest_length == 0) return 0;
+
+	const unsigned char first = rest[0] | 0x20; // lowercases ASCII letters, nothing else becomes a letter
+	if (first == 's' || first == 't' || first == 'm' || first == 'd') return 2;
+	if (rest_length < 2) return 0;
+
+	const unsigned char second = rest[1] | 0x20;
+	if ((first == 'r' || first == 'v') && second == 'e') return 3;
+	if (first == 'l' && second == 'l') return 3;
+	if (rest[0] == 0xc5 && rest[1] == 0xbf) return 3; // long s, which case folds to s
+	return 0;
+}
+
+// \p{N}{1,3}
+static size_t tokenizer_split_number(const unsigned char* text, const size_t length, size_t position) {
+	size_t size;
+	for (int digits = 0; digits < 3; digits++) {
+		if (tokenizer_class_at(text, length, position, &size) != TOKENIZER_CHAR_NUMBER) break;
+		position += size;
+	}
+	return position;
+}
+
+// ` ?[^\s\p{L}\p{N}]+` followed by any of trailing, or 0 if there's no punctuation at position
+static size_t tokenizer_split_punctuation(const unsigned char* text, const size_t length, size_t position,
+                                          const char* trailing) {
+	size_t size;
+	if (text[position] == ' ' &&
+		1u << tokenizer_class_at(text, length, position + 1, &size) & TOKENIZER_PUNCTUATION) {
+		position++;
+	}
+	if (!(1u << tokenizer_class_at(text, length, position, &size) & TOKENIZER_PUNCTUATION)) return 0;
+
+	position = tokenizer_scan(text, length, position + size, TOKENIZER_PUNCTUATION);
+	while (position < length && text[position] != '\0' && strchr(trailing, text[position])) position++;
+	return position;
+}
+
+// \s*[\r\n]+|\s+(?!\S)|\s+, the same in both encodings
+static size_t tokenizer_split_whitespace(const unsigned char* text, const size_t length, const size_t position) {
+	size_t end = position;
+	size_t last_start = position;
+	size_t after_newline = 0;
+	size_t characters = 0;
+	size_t size;
+	int class;
+	while (1u << (class = tokenizer_class_at(text, length, end, &size)) & TOKENIZER_WHITESPACE) {
+		last_start = end;
+		end += size;
+		characters++;
+		if (class == TOKENIZER_CHAR_NEWLINE) after_newline = end;
+	}
+
+	// up to the last newline, or all but the space before the next word so it goes with the word
+	if (after_newline) return after_newline;
+	if (end == length || characters == 1) return end;
+	return last_start;
+}
+
+// the end of the piece starting at position, for cl100k_base:
+// (?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+
+static size_t tokenizer_split_cl100k(const unsigned char* text, const size_t length, const size_t position) {
+	const size_t contraction = tokenizer_contraction(text, length, position);
+	if (contraction) return position + contraction;
+
+	size_t size, next_size;
+	const int class = tokenizer_class_at(text, length, position, &size);
+	if (1u << class & TOKENIZER_LETTERS) return tokenizer_scan(text, length, position + size, TOKENIZER_LETTERS);
+	if (1u << class & TOKENIZER_PREFIX &&
+		1u << tokenizer_class_at(text, length, position + size, &next_size) & TOKENIZER_LETTERS) {
+		return tokenizer_scan(text, length, position + size + next_size, TOKENIZER_LETTERS);
+	}
+	if (class == TOKENIZER_CHAR_NUMBER) return tokenizer_split_number(text, length, position);
+
+	const size_t punctuation = tokenizer_split_punctuation(text, length, position, "\r\n");
+	if (punctuation) return punctuation;
+	return tokenizer_split_whitespace(text, length, position);
+}
+
+// [\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+ from start, 0 if it doesn't match
+static size_t tokenizer_o200k_lower_word(const unsigned char* text, const size_t length, size_t position) {
+	size_t after_caseless = 0;
+	size_t size;
+	int class;
+	while (1u << (class = tokenizer_class_at(text, length, position, &size)) & TOKENIZER_O200K_UPPER) {
+		position += size;
+		if (class != TOKENIZER_CHAR_UPPER) after_caseless = position;
+	}
+	if (class == TOKENIZER_CHAR_LOWER) return tokenizer_scan(text, length, position, TOKENIZER_O200K_LOWER);
+
+	// no lowercase after the capitals, so the second half backtracks into them: it can only be caseless letters and
+	// marks, and ends with the last of them
+	return after_caseless;
+}
+
+// [\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]* from start, 0 if it doesn't match
+static size_t tokenizer_o200k_upper_word(const unsigned char* text, const size_t length, const size_t start) {
+	const size_t position = tokenizer_scan(text, length, start, TOKENIZER_O200K_UPPER);
+	if (position == start) return 0;
+	return tokenizer_scan(text, length, position, TOKENIZER_O200K_LOWER);
+}
+
+// the end of the piece starting at position, for o200k_base (with the contraction after each of the first two):
+// [^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]*[\p{Ll}\p{Lm}\p{Lo}\p{M}]+|
+// [^\r\n\p{L}\p{N}]?[\p{Lu}\p{Lt}\p{Lm}\p{Lo}\p{M}]+[\p{Ll}\p{Lm}\p{Lo}\p{M}]*|
+// \p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n/]*|\s*[\r\n]+|\s+(?!\S)|\s+
+static size_t tokenizer_split_o200k(const unsigned char* text, const size_t length, const size_t position) {
+	size_t size;
+	const int class = tokenizer_class_at(text, length, position, &size);
+	const bool prefix = 1u << class & TOKENIZER_PREFIX;
+
+	size_t end = 0;
+	if (prefix) end = tokenizer_o200k_lower_word(text, length, position + size);
+	if (!end) end = tokenizer_o200k_lower_word(text, length, position);
+	if (!end && prefix) end = tokenizer_o200k_upper_word(text, length, position + size);
+	if (!end) end = tokenizer_o200k_upper_word(text, length, position);
+	if (end) return end + tokenizer_contraction(text, length, end);
+
+	if (class == TOKENIZER_CHAR_NUMBER) return tokenizer_split_number(text, length, position);
+
+	const size_t punctuation = tokenizer_split_punctuation(text, length, position, "\r\n/");
+	if (punctuation) return punctuation;
+	return tokenizer_split_whitespace(text, length, position);
+}
+
+size_t chatgpt_cli_tokenizer_count(const chatgpt_cli_tokenizer* tokenizer, const char* text, const size_t length) {
+	const unsigned char* bytes = (const unsigned char*)text;
+	size_t count = 0;
+	size_t position = 0;
+	while (position < length) {
+		const size_t end = tokenizer->encoding == CHATGPT_CLI_TOKENIZER_CL100K_BASE
+			                   ? tokenizer_split_cl100k(bytes, length, position)
+			                   : tokenizer_split_o200k(bytes, length, position);
+		count += tokenizer_count_piece(tokenizer, bytes + position, end - position);
+		position = end;
+	}
+	return count;
+}
+
+// ---- compiling ----
+
+static size_t tokenizer_data_size(const tokenizer_file_header* header) {
+	return sizeof(tokenizer_file_header) + (size_t)header->slot_count * sizeof(uint64_t) + header->bytes_length;
+}
+
+// points the tokenizer into data, false if it isn't a table this build can use
+static bool tokenizer_use_data(chatgpt_cli_tokenizer* tokenizer, void* data, const size_t length,
+                               const uint64_t source_size) {
+	if (length < sizeof(tokenizer_file_header)) return false;
+	const tokenizer_file_header* header = data;
+	if (memcmp(header->magic, TOKENIZER_FILE_MAGIC, TOKENIZER_FILE_MAGIC_LENGTH) != 0) return false;
+	if (header->byte_order != TOKENIZER_BYTE_ORDER) return false;
+	if (source_size && header->source_size != source_size) return false;
+	if (header->slot_count == 0 || (header->slot_count & (header->slot_count - 1)) != 0) return false;
+	if (header->slot_count <= header->token_count) return false; // there has to be an empty slot to stop at
+	if (tokenizer_data_size(header) != length) return false;
+
+	tokenizer->slots = (const uint64_t*)((const unsigned char*)data + sizeof(tokenizer_file_header));
+	tokenizer->bytes = (const unsigned char*)(tokenizer->slots + header->slot_count);
+	tokenizer->bytes_length = header->bytes_length;
+	tokenizer->slot_mask = header->slot_count - 1;
+	tokenizer->data = data;
+	tokenizer->data_length = length;
+	return true;
+}
+
+static int tokenizer_base64_value(const char c) {
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+// decodes in place, the decoded bytes are never longer. -1 if it isn't base64
+static long tokenizer_base64_decode(char* text, const size_t length) {
+	uint32_t bits = 0;
+	int bit_count = 0;
+	long decoded = 0;
+	for (size_t i = 0; i < length && text[i] != '='; i++) {
+		const int value = tokenizer_base64_value(text[i]);
+		if (value < 0) return -1;
+		bits = bits << 6 | (uint32_t)value;
+		bit_count += 6;
+		if (bit_count >= 8) {
+			bit_count -= 8;
+			text[decoded++] = (char)(bits >> bit_count);
+		}
+	}
+	return decoded;
+}
+
+typedef struct {
+	uint32_t offset; // in the decoded source
+	uint32_t length;
+} tokenizer_source_token;
+
+// the compiled table for a .tiktoken file's contents ("base64 rank" lines), which is decoded in place
+static void* tokenizer_compile(char* source, const size_t source_length, size_t* compiled_length, char** error) {
+	size_t capacity = 1024;
+	size_t token_count = 0;
+	tokenizer_source_token* tokens = calloc(capacity, sizeof(tokenizer_source_token));
+	uint64_t bytes_length = 0;
+
+	size_t line_start = 0;
+	size_t line_number = 0;
+	while (line_start < source_length) {
+		char* line = source + line_start;
+		char* newline = memchr(line, '\n', source_length - line_start);
+		const size_t line_length = newline ? (size_t)(newline - line) : source_length - line_start;
+		line_start += line_length + 1;
+		line_number++;
+		if (line_length == 0) continue;
+
+		char* space = memchr(line, ' ', line_length);
+		long decoded = space ? tokenizer_base64_decode(line, space - line) : -1;
+		char* rank_end = NULL;
+		const unsigned long rank = space ? strtoul(space + 1, &rank_end, 10) : 0;
+		if (decoded <= 0 || rank_end == space + 1) {
+			size_t length = 64;
+			*error = malloc(length);
+			snprintf(*error, length, "Line %zu isn't a token and its rank", line_number);
+			free(tokens);
+			return NULL;
+		}
+
+		if (decoded > TOKENIZER_MAX_TOKEN_LENGTH || rank > TOKENIZER_MAX_RANK) {
+			size_t length = 64;
+			*error = malloc(length);
+			snprintf(*error, length, "Line %zu is a bigger token than fits", line_number);
+			free(tokens);
+			return NULL;
+		}
+
+		if (rank >= capacity) {
+			size_t new_capacity = capacity;
+			while (rank >= new_capacity) new_capacity *= 2;
+			tokens = realloc(tokens, new_capacity * sizeof(tokenizer_source_token));
+			memset(tokens + capacity, 0, (new_capacity - capacity) * sizeof(tokenizer_source_token));
+			capacity = new_capacity;
+		}
+		tokens[rank].offset = (uint32_t)(line - source);
+		tokens[rank].length = (uint32_t)decoded;
+		if (rank >= token_count) token_count = rank + 1;
+		bytes_length += decoded;
+	}
+	if (token_count == 0) {
+		*error = strdup("No tokens in the encoding");
+		free(tokens);
+		return NULL;
+	}
+	if (bytes_length > TOKENIZER_MAX_OFFSET) {
+		*error = strdup("The encoding's tokens are too big to fit");
+		free(tokens);
+		return NULL;
+	}
+
+	tokenizer_file_header header = {
+		.magic = TOKENIZER_FILE_MAGIC,
+		.byte_order = TOKENIZER_BYTE_ORDER,
+		.token_count = (uint32_t)token_count,
+		.slot_count = 1024,
+		.bytes_length = (uint32_t)bytes_length,
+		.source_size = source_length,
+	};
+	while ((uint64_t)header.slot_count * 3 < (uint64_t)token_count * 4) header.slot_count *= 2;
+
+	*compiled_length = tokenizer_data_size(&header);
+	unsigned char* data = calloc(1, *compiled_length);
+	if (!data) {
+		*error = strdup("Out of memory");
+		free(tokens);
+		return NULL;
+	}
+	memcpy(data, &header, sizeof(header));
+	uint64_t* slots = (uint64_t*)(data + sizeof(tokenizer_file_header));
+	unsigned char* bytes = (unsigned char*)(slots + header.slot_count);
+
+	// ranks missing from the file are skipped
+	uint64_t offset = 0;
+	for (size_t rank = 0; rank < token_count; rank++) {
+		const uint64_t length = tokens[rank].length;
+		if (length == 0) continue;
+
+		memcpy(bytes + offset, source + tokens[rank].offset, length);
+		const uint64_t hash = tokenizer_hash(bytes + offset, length);
+		size_t slot = (size_t)hash & (header.slot_count - 1);
+		while (slots[slot]) slot = (slot + 1) & (header.slot_count - 1);
+		slots[slot] = hash >> TOKENIZER_SLOT_TAG_SHIFT << TOKENIZER_SLOT_TAG_SHIFT |
+			length << TOKENIZER_SLOT_LENGTH_SHIFT | offset << TOKENIZER_SLOT_OFFSET_SHIFT | rank;
+		offset += length;
+	}
+
+	free(tokens);
+	return data;
+}
+
+// the whole file, NULL if it can't be read
+static char* tokenizer_read_file(const char* path, size_t* length) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return NULL;
+
+	fseek(file, 0, SEEK_END);
+	const long file_length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char* data = file_length >= 0 ? malloc(file_length + 1) : NULL;
+	if (data) *length = fread(data, 1, file_length, file);
+	fclose(file);
+	return data;
+}
+
+// replaces the file in one go, so another process never maps half of it. false if it couldn't be written
+static bool tokenizer_write_file(const char* path, const void* data, const size_t length) {
+	const size_t tmp_path_length = strlen(path) + 8;
+	char* tmp_path = malloc(tmp_path_length);
+
+	#ifdef _WIN32
+	snprintf(tmp_path, tmp_path_length, "%s.tmp", path);
+	FILE* file = fopen(tmp_path, "wb");
+	#else
+	snprintf(tmp_path, tmp_path_length, "%s.XXXXXX", path);
+	const int fd = mkstemp(tmp_path);
+	FILE* file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+	if (!file && fd >= 0) close(fd);
+	#endif
+	if (!file) {
+		remove(tmp_path);
+		free(tmp_path);
+		return false;
+	}
+
+	bool written = fwrite(data, 1, length, file) == length;
+	written = fclose(file) == 0 && written;
+	#ifdef _WIN32
+	if (written) remove(path);
+	#endif
+	if (!written || rename(tmp_path, path) != 0) {
+		remove(tmp_path);
+		written = false;
+	}
+	free(tmp_path);
+	return written;
+}
+
+// maps the compiled table if it's there, and was compiled from a file of source_size bytes (0 for any)
+static bool tokenizer_map(chatgpt_cli_tokenizer* tokenizer, const char* path, const uint64_t source_size) {
+	#ifdef _WIN32
+	// no mmap here, read it whole instead
+	size_t length = 0;
+	char* data = tokenizer_read_file(path, &length);
+	if (!data) return false;
+	if (!tokenizer_use_data(tokenizer, data, length, source_size)) {
+		free(data);
+		return false;
+	}
+	return true;
+	#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat file_stat;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+		data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd); // the mapping stays valid
+	if (data == MAP_FAILED) return false;
+
+	if (!tokenizer_use_data(tokenizer, data, file_stat.st_size, source_size)) {
+		munmap(data, file_stat.st_size);
+		return false;
+	}
+	tokenizer->mapped = true;
+	return true;
+	#endif
+}
+
+chatgpt_cli_tokenizer* chatgpt_cli_tokenizer_open_file(const chatgpt_cli_tokenizer_encoding encoding,
+                                                       const char* source_path, const char* compiled_path,
+                                                       char** error) {
+	*error = NULL;
+	chatgpt_cli_tokenizer* tokenizer = calloc(1, sizeof(chatgpt_cli_tokenizer));
+	tokenizer->encoding = encoding;
+
+	// the compiled table is good for as long as the source is older than it, or without a source at all
+	struct stat source_stat, compiled_stat;
+	const bool has_source = stat(source_path, &source_stat) == 0;
+	const bool has_compiled = stat(compiled_path, &compiled_stat) == 0;
+	if (has_compiled && (!has_source || compiled_stat.st_mtime >= source_stat.st_mtime) &&
+		tokenizer_map(tokenizer, compiled_path, has_source ? (uint64_t)source_stat.st_size : 0)) {
+		return tokenizer;
+	}
+
+	size_t source_length = 0;
+	char* source = has_source ? tokenizer_read_file(source_path, &source_length) : NULL;
+	if (!source) {
+		const char* name = chatgpt_cli_tokenizer_encoding_name(encoding);
+		const size_t length = strlen(source_path) + strlen(CHATGPT_CLI_TOKENIZER_DOWNLOAD_URL) + strlen(name) * 2 +
+			128;
+		*error = malloc(length);
+		snprintf(*error, length, "Could not read the %s encoding at %s, it can be downloaded from %s%s.tiktoken",
+		         name, source_path, CHATGPT_CLI_TOKENIZER_DOWNLOAD_URL, name);
+		free(tokenizer);
+		return NULL;
+	}
+
+	size_t compiled_length = 0;
+	char* compile_error = NULL;
+	void* compiled = tokenizer_compile(source, source_length, &compiled_length, &compile_error);
+	free(source);
+	if (!compiled) {
+		const size_t length = strlen(source_path) + strlen(compile_error) + 32;
+		*error = malloc(length);
+		snprintf(*error, length, "%s: %s", source_path, compile_error);
+		free(compile_error);
+		free(tokenizer);
+		return NULL;
+	}
+
+	// mapped from the file when it could be written, so the pages are shared with later runs. otherwise the copy
+	// in memory does for this one
+	if (tokenizer_write_file(compiled_path, compiled, compiled_length) &&
+		tokenizer_map(tokenizer, compiled_path, source_length)) {
+		free(compiled);
+		return tokenizer;
+	}
+	tokenizer_use_data(tokenizer, compiled, compiled_length, 0);
+	return tokenizer;
+}
+
+static char* tokenizer_path(const char* folder, const char* name, const char* extension) {
+	const size_t len = strlen(folder) + strlen(name) + strlen(extension) + 2;
+	char* path = malloc(len);
+	snprintf(path, len, "%s%c%s%s", folder, PATH_SEPARATOR, name, extension);
+	return path;
+}
+
+chatgpt_cli_tokenizer* chatgpt_cli_tokenizer_open(const chatgpt_cli_tokenizer_encoding encoding, char** error) {
+	char* app_folder = chatgpt_cli_config_get_app_folder();
+	char* folder = tokenizer_path(app_folder, CHATGPT_CLI_TOKENIZER_FOLDER_NAME, "");
+	free(app_folder);
+
+	const char* name = chatgpt_cli_tokenizer_encoding_name(encoding);
+	char* source_path = tokenizer_path(folder, name, ".tiktoken");
+	char* compiled_path = tokenizer_path(folder, name, ".bpe");
+	free(folder);
+
+	chatgpt_cli_tokenizer* tokenizer = chatgpt_cli_tokenizer_open_file(encoding, source_path, compiled_path, error);
+	free(source_path);
+	free(compiled_path);
+	return tokenizer;
+}
+
+void chatgpt_cli_tokenizer_close(chatgpt_cli_tokenizer* tokenizer) {
+	if (!tokenizer) return;
+	#ifndef _WIN32
+	if (tokenizer->mapped) munmap(tokenizer->data, tokenizer->data_length);
+	else free(tokenizer->data);
+	#else
+	free(tokenizer->data);
+	#endif
+	free(tokenizer);
+}
@@ -0,0 +1,41 @@
+//
+// Created by mia on 18/10/2026.
+//
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+#include <stddef.h>
+
+// counts tokens the way the API will, without asking it: the split patterns and byte pair merges of tiktoken's
+// encodings. the merge table comes from the encoding's .tiktoken file in this folder of the app folder, compiled on
+// first use into a .bpe file next to it which later runs just map
+#define CHATGPT_CLI_TOKENIZER_FOLDER_NAME "encodings"
+#define CHATGPT_CLI_TOKENIZER_DOWNLOAD_URL "https://openaipublic.blob.core.windows.net/encodings/"
+
+typedef enum {
+	CHATGPT_CLI_TOKENIZER_O200K_BASE,
+	CHATGPT_CLI_TOKENIZER_CL100K_BASE,
+} chatgpt_cli_tokenizer_encoding;
+
+typedef struct chatgpt_cli_tokenizer chatgpt_cli_tokenizer;
+
+// the encoding a model counts with, models it doesn't know are assumed to be recent ones
+chatgpt_cli_tokenizer_encoding chatgpt_cli_tokenizer_encoding_for_model(const char* model);
+
+// "o200k_base" etc, also the name of its files
+const char* chatgpt_cli_tokenizer_encoding_name(chatgpt_cli_tokenizer_encoding encoding);
+
+// opens the encoding from the app folder. NULL with error set (caller frees) if its file isn't there
+chatgpt_cli_tokenizer* chatgpt_cli_tokenizer_open(chatgpt_cli_tokenizer_encoding encoding, char** error);
+
+// same with the paths given, compiled_path is (re)written from source_path when it's missing or older
+chatgpt_cli_tokenizer* chatgpt_cli_tokenizer_open_file(chatgpt_cli_tokenizer_encoding encoding,
+                                                       const char* source_path, const char* compiled_path,
+                                                       char** error);
+
+// tokens in text as ordinary text, special tokens like <|endoftext|> aren't recognized
+size_t chatgpt_cli_tokenizer_count(const chatgpt_cli_tokenizer* tokenizer, const char* text, size_t length);
+
+void chatgpt_cli_tokenizer_close(chatgpt_cli_tokenizer* tokenizer);
+
+#endif //TOKENIZER_H